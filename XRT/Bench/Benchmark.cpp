@@ -0,0 +1,324 @@
+#include <argparse/argparse.hpp> // C++ broken, this needs to be above Lexer
+#include "Language/Lexer.hpp"
+#include "Language/Parser.hpp"
+#include "Language/SourceEntry.hpp"
+#include "Server/Json.hpp"
+#include "CorpusGenerator.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <Log/Logger.hpp>
+#include <MemoryStats.hpp>
+#include <StringUtils.hpp>
+#include <Utils.hpp>
+
+using argparse::ArgumentParser;
+namespace fs = std::filesystem;
+using Clock  = std::chrono::steady_clock;
+
+/// Best-of-N timings of one source file
+struct FileResult {
+    fs::path path;
+    size_t bytes    = 0;
+    size_t tokens   = 0;
+    size_t nodes    = 0;
+    double read_s   = 0; // file read + utf8 -> utf16
+    double lex_s    = 0;
+    double parse_s  = 0;
+    double total_s  = 0;
+    bool ok         = true;
+};
+
+struct Metric {
+    const char* name;
+    double value;
+    bool higher_is_better;
+};
+
+static double Seconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+/// "64KB", "10MB", "1GB" or plain bytes
+static std::optional<size_t> ParseSize(const std::string& str) {
+    char* end   = nullptr;
+    auto value  = std::strtod(str.c_str(), &end);
+    auto suffix = std::string{end};
+    std::transform(suffix.begin(), suffix.end(), suffix.begin(), [](char c) {
+        return static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    });
+    double scale = 1;
+    if (suffix == "KB" || suffix == "K") {
+        scale = 1024.0;
+    } else if (suffix == "MB" || suffix == "M") {
+        scale = 1024.0 * 1024.0;
+    } else if (suffix == "GB" || suffix == "G") {
+        scale = 1024.0 * 1024.0 * 1024.0;
+    } else if (!suffix.empty() && suffix != "B") {
+        return {};
+    }
+    if (end == str.c_str() || value <= 0)
+        return {};
+    return static_cast<size_t>(value * scale);
+}
+
+/// Run the frontend over one file - stage times are the best of all iterations
+static FileResult MeasureFile(const fs::path& path, uint32_t iterations) {
+    FileResult result;
+    result.path = path;
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        auto t0 = Clock::now();
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            LOG_ERROR("Failed to open \"{}\"", path.string());
+            result.ok = false;
+            return result;
+        }
+        std::stringstream ss;
+        ss << file.rdbuf();
+        auto source_entry = CreateRef<XRT::SourceEntry>(StringUtils::utf8_to_utf16(ss.str()), path);
+        auto t1           = Clock::now();
+
+        auto lexer = CreateScope<XRT::Lexer>(source_entry);
+        auto parser = CreateScope<XRT::Parser>();
+        try {
+            lexer->ProcessSource();
+        } catch (const XRT::Lexer::UnknownTokenException& e) {
+            LOG_ERROR("{}: [{}]", path.string(), e.what());
+            result.ok = false;
+            return result;
+        }
+        auto t2 = Clock::now();
+
+        try {
+            parser->Parse(lexer);
+        } catch (const XRT::Parser::ParseException& e) {
+            LOG_ERROR("{}:{}:{}: {}", path.string(), e.GetLine(), e.GetColumn(), e.what());
+            result.ok = false;
+            return result;
+        }
+        auto t3 = Clock::now();
+
+        bool first = i == 0;
+        if (first) {
+            result.bytes  = source_entry->GetContent().size();
+            result.tokens = lexer->GetTokens().size();
+            result.nodes  = parser->GetAST()->CountNodes();
+        }
+        auto best = [first](double& current, double value) {
+            current = first ? value : std::min(current, value);
+        };
+        best(result.read_s, Seconds(t1 - t0));
+        best(result.lex_s, Seconds(t2 - t1));
+        best(result.parse_s, Seconds(t3 - t2));
+        best(result.total_s, Seconds(t3 - t0));
+    }
+    return result;
+}
+
+static double Percentile(std::vector<double> values, double p) {
+    if (values.empty())
+        return 0;
+    std::sort(values.begin(), values.end());
+    auto index = static_cast<size_t>(p * static_cast<double>(values.size() - 1) + 0.5);
+    return values[std::min(index, values.size() - 1)];
+}
+
+/// Read the flat "metrics" object of a previous --json-out
+static std::optional<double> ReadBaselineMetric(const std::string& json, const char* name) {
+    auto metrics = json.find("\"metrics\"");
+    if (metrics == std::string::npos)
+        return {};
+    auto key = json.find(fmt::format("\"{}\"", name), metrics);
+    if (key == std::string::npos)
+        return {};
+    auto colon = json.find(':', key);
+    if (colon == std::string::npos)
+        return {};
+    char* end  = nullptr;
+    auto value = std::strtod(json.c_str() + colon + 1, &end);
+    if (end == json.c_str() + colon + 1)
+        return {};
+    return value;
+}
+
+static bool WriteJSON(const fs::path& path, const std::vector<Metric>& metrics, const std::vector<FileResult>& files, uint32_t iterations) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) {
+        LOG_ERROR("Failed to open \"{}\"", path.string());
+        return false;
+    }
+
+    out << "{\n";
+    out << fmt::format("  \"version\": \"{}\",\n  \"iterations\": {},\n", CFXS_VERSION_STRING, iterations);
+    out << "  \"metrics\": {\n";
+    for (size_t i = 0; i < metrics.size(); i++)
+        out << fmt::format("    \"{}\": {:.4f}{}\n", metrics[i].name, metrics[i].value, i + 1 < metrics.size() ? "," : "");
+    out << "  },\n  \"per_file\": [\n";
+    for (size_t i = 0; i < files.size(); i++) {
+        auto& f = files[i];
+        out << fmt::format("    {{\"path\": \"{}\", \"ok\": {}, \"bytes\": {}, \"tokens\": {}, \"nodes\": {}, "
+                           "\"read_ms\": {:.4f}, \"lex_ms\": {:.4f}, \"parse_ms\": {:.4f}, \"total_ms\": {:.4f}}}{}\n",
+                           XRT::Json::Escape(f.path.generic_string()),
+                           f.ok,
+                           f.bytes,
+                           f.tokens,
+                           f.nodes,
+                           f.read_s * 1000.0,
+                           f.lex_s * 1000.0,
+                           f.parse_s * 1000.0,
+                           f.total_s * 1000.0,
+                           i + 1 < files.size() ? "," : "");
+    }
+    out << "  ]\n}\n";
+
+    if (!out.good()) {
+        LOG_ERROR("Failed to write \"{}\"", path.string());
+        return false;
+    }
+    return true;
+}
+
+/// Compare against a stored --json-out - returns false if any metric is worse than tolerance
+static bool CompareBaseline(const fs::path& path, const std::vector<Metric>& metrics, double tolerance) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        LOG_ERROR("Failed to open baseline \"{}\"", path.string());
+        return false;
+    }
+    std::stringstream ss;
+    ss << file.rdbuf();
+    auto json = ss.str();
+
+    bool ok = true;
+    for (auto& m : metrics) {
+        auto base = ReadBaselineMetric(json, m.name);
+        if (!base) {
+            LOG_WARN("[Bench] {} missing from baseline", m.name);
+            continue;
+        }
+        double change = *base ? (m.value - *base) / *base * 100.0 : 0.0;
+        bool regressed = m.higher_is_better ? change < -tolerance : change > tolerance;
+        if (regressed) {
+            LOG_ERROR("[Bench] {:<22} {:>12.3f} -> {:>12.3f} ({:+.1f}%) regression", m.name, *base, m.value, change);
+            ok = false;
+        } else {
+            LOG_INFO("[Bench] {:<22} {:>12.3f} -> {:>12.3f} ({:+.1f}%)", m.name, *base, m.value, change);
+        }
+    }
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    ArgumentParser program("XRT_bench", CFXS_VERSION_STRING);
+    program.add_argument("--generate").help("Write a synthetic corpus to directory and exit").default_value(std::string{});
+    program.add_argument("--files").help("Number of files for --generate").scan<'u', uint32_t>().default_value(uint32_t{8});
+    program.add_argument("--size").help("Size of each generated file (e.g. 64KB, 10MB, 1GB)").default_value(std::string{"256KB"});
+    program.add_argument("--seed").help("Corpus generator seed").scan<'u', uint64_t>().default_value(uint64_t{1});
+    program.add_argument("--iterations").help("Runs per file - the fastest is reported").scan<'u', uint32_t>().default_value(uint32_t{3});
+    program.add_argument("--json-out").help("Write results as JSON to file").default_value(std::string{});
+    program.add_argument("--baseline").help("Compare against a previous --json-out, non-zero exit on regression").default_value(std::string{});
+    program.add_argument("--tolerance").help("Allowed regression against --baseline in percent").scan<'g', double>().default_value(10.0);
+    program.add_argument("files").help("Source files or directories of .xdl files to measure").remaining();
+
+    Logger::Options log_options;
+    log_options.level = spdlog::level::info;
+    log_options.file  = "";
+    Logger::Initialize(log_options);
+
+    try {
+        program.parse_args(argc, argv);
+    } catch (const std::runtime_error& e) {
+        std::stringstream ss;
+        ss << program;
+        LOG_ERROR("{}", e.what());
+        LOG_INFO("{}", ss.str());
+        return -1;
+    }
+
+    auto generate = program.get<std::string>("--generate");
+    if (!generate.empty()) {
+        auto size = ParseSize(program.get<std::string>("--size"));
+        if (!size) {
+            LOG_ERROR("Invalid size \"{}\"", program.get<std::string>("--size"));
+            return -1;
+        }
+        auto start = Clock::now();
+        XRT::CorpusGenerator generator(program.get<uint64_t>("--seed"));
+        auto paths = generator.WriteCorpus(generate, program.get<uint32_t>("--files"), *size);
+        if (paths.empty())
+            return -1;
+        LOG_INFO("[Bench] Generated {} files in \"{}\" ({:.3f}s)", paths.size(), generate, Seconds(Clock::now() - start));
+        return 0;
+    }
+
+    std::vector<fs::path> files;
+    for (auto& arg : program.present<std::vector<std::string>>("files").value_or(std::vector<std::string>{})) {
+        if (fs::is_directory(arg)) {
+            for (const auto& e : fs::directory_iterator(arg)) {
+                if (e.is_regular_file() && e.path().extension() == ".xdl")
+                    files.push_back(e.path());
+            }
+        } else {
+            files.emplace_back(arg);
+        }
+    }
+    std::sort(files.begin(), files.end());
+    if (files.empty()) {
+        LOG_ERROR("No files to measure");
+        return -1;
+    }
+
+    auto iterations = std::max(program.get<uint32_t>("--iterations"), uint32_t{1});
+    std::vector<FileResult> results;
+    size_t failed = 0;
+    for (auto& path : files) {
+        results.push_back(MeasureFile(path, iterations));
+        failed += !results.back().ok;
+    }
+
+    size_t bytes = 0, tokens = 0, nodes = 0;
+    double lex_s = 0, parse_s = 0;
+    std::vector<double> latency_ms;
+    for (auto& r : results) {
+        if (!r.ok)
+            continue;
+        bytes += r.bytes;
+        tokens += r.tokens;
+        nodes += r.nodes;
+        lex_s += r.lex_s;
+        parse_s += r.parse_s;
+        latency_ms.push_back(r.total_s * 1000.0);
+    }
+    auto rate = [](double amount, double seconds) {
+        return seconds > 0 ? amount / seconds : 0.0;
+    };
+
+    std::vector<Metric> metrics = {
+        {"lexer_mb_per_s", rate(static_cast<double>(bytes) / (1024.0 * 1024.0), lex_s), true},
+        {"tokens_per_s", rate(static_cast<double>(tokens), lex_s), true},
+        {"parser_nodes_per_s", rate(static_cast<double>(nodes), parse_s), true},
+        {"latency_p50_ms", Percentile(latency_ms, 0.50), false},
+        {"latency_p95_ms", Percentile(latency_ms, 0.95), false},
+        {"latency_max_ms", latency_ms.empty() ? 0.0 : *std::max_element(latency_ms.begin(), latency_ms.end()), false},
+        {"peak_rss_mb", static_cast<double>(XRT::MemoryStats::GetPeakRSS()) / (1024.0 * 1024.0), false},
+    };
+
+    LOG_INFO("[Bench] {} files, {} failed, {:.3f} MB, {} tokens, {} AST nodes", results.size(), failed, static_cast<double>(bytes) / (1024.0 * 1024.0), tokens, nodes);
+    for (auto& m : metrics)
+        LOG_INFO("[Bench] {:<22} {:>14.3f}", m.name, m.value);
+
+    auto json_out = program.get<std::string>("--json-out");
+    if (!json_out.empty() && !WriteJSON(json_out, metrics, results, iterations))
+        return -1;
+
+    auto baseline = program.get<std::string>("--baseline");
+    if (!baseline.empty() && !CompareBaseline(baseline, metrics, program.get<double>("--tolerance")))
+        return 1;
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,245 @@
+#include "CorpusGenerator.hpp"
+#include <fstream>
+#include <Log/Logger.hpp>
+
+namespace XRT {
+
+    static constexpr const char* s_Words[] = {"pulse", "counter", "edge",  "trigger", "state", "idle", "phase", "divider",
+                                              "latch", "sample",  "cycle", "output",  "input", "reset", "carry", "overflow"};
+    static constexpr const char* s_BinaryOperators[] = {"+", "-", "*", "&", "|", "^", "==", "!=", "<", "<=", ">", ">=", "<<", ">>", "&&", "||"};
+    static constexpr const char* s_AssignOperators[] = {"=", "=", "=", "+=", "-=", "&=", "|=", "^="};
+
+    template<typename T, size_t N>
+    static const T& Pick(const T (&items)[N], uint32_t index) {
+        return items[index % N];
+    }
+
+    CorpusGenerator::CorpusGenerator(uint64_t seed) : m_State(seed ? seed : 0x9E3779B97F4A7C15ull) {
+    }
+
+    uint64_t CorpusGenerator::Random() {
+        // xorshift64*
+        m_State ^= m_State >> 12;
+        m_State ^= m_State << 25;
+        m_State ^= m_State >> 27;
+        return m_State * 0x2545F4914F6CDD1Dull;
+    }
+
+    void CorpusGenerator::Line(std::string& out, const std::string& text) {
+        if (!text.empty())
+            out.append(m_Indent * 4, ' ');
+        out += text;
+        out += '\n';
+    }
+
+    void CorpusGenerator::Comment(std::string& out) {
+        std::string text;
+        auto words = 3 + Random(8);
+        for (uint32_t i = 0; i < words; i++) {
+            text += i ? " " : "";
+            text += Pick(s_Words, Random(64));
+        }
+        if (Chance(25)) {
+            Line(out, "/* " + text);
+            Line(out, " * " + std::string{Pick(s_Words, Random(64))} + " */");
+        } else {
+            Line(out, "// " + text);
+        }
+    }
+
+    std::string CorpusGenerator::Literal() {
+        switch (Random(5)) {
+            case 0: return std::to_string(Random(2));
+            case 1: return std::to_string(Random(256));
+            case 2: return "0x" + fmt::format("{:X}", Random(0x10000));
+            case 3: return std::to_string(1 + Random(9)) + "_" + fmt::format("{:03}", Random(1000));
+            default: return std::to_string(Random(16));
+        }
+    }
+
+    std::string CorpusGenerator::Operand() {
+        switch (Random(4)) {
+            case 0: return m_Registers[Random(static_cast<uint32_t>(m_Registers.size()))];
+            case 1: return m_Inputs[Random(static_cast<uint32_t>(m_Inputs.size()))];
+            case 2: return m_Parameters[Random(static_cast<uint32_t>(m_Parameters.size()))];
+            default: return Literal();
+        }
+    }
+
+    std::string CorpusGenerator::Expression(uint32_t depth) {
+        if (!depth || Chance(20))
+            return Operand();
+
+        switch (Random(10)) {
+            case 0: return "!" + Expression(depth - 1);
+            case 1: return "(" + Expression(depth - 1) + " ? " + Expression(depth - 1) + " : " + Expression(depth - 1) + ")";
+            case 2: return "(" + Expression(depth - 1) + ")";
+            case 3: return "std::pow(2, " + Expression(depth - 1) + ")";
+            case 4: return m_Registers[Random(static_cast<uint32_t>(m_Registers.size()))] + "(" + Literal() + ")";
+            default: return Expression(depth - 1) + " " + Pick(s_BinaryOperators, Random(64)) + " " + Expression(depth - 1);
+        }
+    }
+
+    void CorpusGenerator::Statement(std::string& out, uint32_t depth) {
+        if (Chance(10))
+            Comment(out);
+
+        if (depth && Chance(35)) {
+            Line(out, "if (" + Expression(2 + Random(3)) + ") {");
+            m_Indent++;
+            for (uint32_t i = 1 + Random(3); i > 0; i--)
+                Statement(out, depth - 1);
+            m_Indent--;
+            if (Chance(40)) {
+                Line(out, "} else {");
+                m_Indent++;
+                for (uint32_t i = 1 + Random(2); i > 0; i--)
+                    Statement(out, depth - 1);
+                m_Indent--;
+            }
+            Line(out, "}");
+            return;
+        }
+
+        auto& target = m_Registers[Random(static_cast<uint32_t>(m_Registers.size()))];
+        if (Chance(15)) {
+            Line(out, target + (Chance(50) ? "++;" : "--;"));
+        } else {
+            Line(out, target + " " + Pick(s_AssignOperators, Random(64)) + " " + Expression(3 + Random(4)) + ";");
+        }
+    }
+
+    void CorpusGenerator::Component(std::string& out) {
+        auto name = "Unit" + std::to_string(m_ComponentIndex++);
+
+        // template parameters
+        static constexpr const char* types[] = {"logic", "unsigned", "bool"};
+        m_Parameters.clear();
+        auto parameter_count = 1 + Random(5);
+        for (uint32_t i = 0; i < parameter_count; i++)
+            m_Parameters.push_back(std::string{"P"} + Pick(s_Words, i * 7 + Random(3)) + std::to_string(i));
+        m_Parameters[0] = "WIDTH";
+
+        if (Chance(60))
+            Comment(out);
+        for (uint32_t i = 0; i < parameter_count; i++) {
+            std::string text = (i ? "         " : "template<") + std::string{i ? Pick(types, Random(3)) : "unsigned"} + " " + m_Parameters[i];
+            if (Chance(50))
+                text += " = " + Literal();
+            text += i + 1 < parameter_count ? "," : ">";
+            if (Chance(30))
+                text += " // " + std::string{Pick(s_Words, Random(64))};
+            Line(out, text);
+        }
+        Line(out, "component " + name + " : std::clockable {");
+
+        m_Indent++;
+        if (Chance(40))
+            Line(out, "using SCALE = std::pow(2, " + m_Parameters[Random(parameter_count)] + ");");
+
+        // registers
+        m_Indent--;
+        Line(out, "registers:");
+        m_Indent++;
+        m_Registers.clear();
+        for (uint32_t i = 1 + Random(6); i > 0; i--) {
+            auto reg = "reg_" + std::string{Pick(s_Words, Random(64))} + std::to_string(m_Registers.size());
+            std::string type;
+            switch (Random(3)) {
+                case 0: type = "unsigned<WIDTH..>"; break;
+                case 1: type = "unsigned<" + std::to_string(1 + Random(32)) + ">"; break;
+                default: type = "logic"; break;
+            }
+            Line(out, type + " " + reg + " = " + Literal() + ";");
+            m_Registers.push_back(std::move(reg));
+        }
+
+        // constructor
+        m_Indent--;
+        Line(out, "");
+        Line(out, "implementation:");
+        m_Indent++;
+        m_Inputs.clear();
+        m_Outputs.clear();
+        std::string ports;
+        for (uint32_t i = 1 + Random(4); i > 0; i--) {
+            auto port = std::string{Pick(s_Words, Random(64))} + "_in" + std::to_string(m_Inputs.size());
+            ports += (ports.empty() ? "" : ", ") + std::string{Chance(50) ? "in<logic> " : "in<unsigned<8>> "} + port;
+            m_Inputs.push_back(std::move(port));
+        }
+        for (uint32_t i = 1 + Random(3); i > 0; i--) {
+            auto port = std::string{Pick(s_Words, Random(64))} + "_out" + std::to_string(m_Outputs.size());
+            ports += ", " + std::string{Chance(50) ? "out<logic> " : "out logic "} + port;
+            m_Outputs.push_back(std::move(port));
+        }
+        Line(out, name + "(" + ports + ") {");
+        m_Indent++;
+        for (auto& o : m_Outputs)
+            Line(out, o + " = " + Expression(2 + Random(5)) + ";");
+        m_Indent--;
+        Line(out, "}");
+        Line(out, "");
+
+        // clocked logic
+        Line(out, "Event<auto>(EventSource e) {");
+        m_Indent++;
+        for (uint32_t i = 2 + Random(6); i > 0; i--)
+            Statement(out, 3);
+        m_Indent--;
+        Line(out, "}");
+
+        m_Indent--;
+        Line(out, "};");
+    }
+
+    void CorpusGenerator::Generate(std::string& out, size_t target_bytes) {
+        m_Indent = 0;
+        while (out.size() < target_bytes) {
+            if (Chance(30))
+                Comment(out);
+            Line(out, "namespace Bench::Group" + std::to_string(m_ComponentIndex) + " {");
+            m_Indent++;
+            for (uint32_t i = 1 + Random(4); i > 0; i--) {
+                Line(out, "");
+                Component(out);
+            }
+            m_Indent--;
+            Line(out, "} // namespace Bench::Group");
+            Line(out, "");
+        }
+    }
+
+    std::vector<std::filesystem::path> CorpusGenerator::WriteCorpus(const std::filesystem::path& directory, uint32_t file_count, size_t file_bytes) {
+        // generate in chunks so GB sized files do not need the whole text in memory
+        static constexpr size_t CHUNK_SIZE = 4 * 1024 * 1024;
+
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+
+        std::vector<std::filesystem::path> paths;
+        std::string chunk;
+        for (uint32_t f = 0; f < file_count; f++) {
+            auto path = directory / fmt::format("corpus_{:04}.xdl", f);
+            std::ofstream file(path, std::ios::binary);
+            if (!file.is_open()) {
+                LOG_ERROR("Failed to open \"{}\"", path.string());
+                return {};
+            }
+
+            size_t written = 0;
+            while (written < file_bytes) {
+                chunk.clear();
+                Generate(chunk, std::min(CHUNK_SIZE, file_bytes - written));
+                file.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+                written += chunk.size();
+            }
+            if (!file.good()) {
+                LOG_ERROR("Failed to write \"{}\"", path.string());
+                return {};
+            }
+            paths.push_back(std::move(path));
+        }
+        return paths;
+    }
+
+} // namespace XRT
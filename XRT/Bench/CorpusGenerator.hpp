@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace XRT {
+
+    /// Deterministic synthetic .xdl source generator for benchmarks.
+    /// Output is a sequence of namespaces holding template components in the style of Dev/PulseGenerator.xdl -
+    /// registers, ports, aliases, nested if/else event logic, deep expressions, literals and comments.
+    /// Uses its own PRNG so the same seed produces the same bytes on every platform.
+    class CorpusGenerator {
+    public:
+        CorpusGenerator(uint64_t seed);
+
+        /// Append whole components to out until it holds at least target_bytes
+        void Generate(std::string& out, size_t target_bytes);
+
+        /// Write file_count files of about file_bytes each into directory - returns the written paths
+        std::vector<std::filesystem::path> WriteCorpus(const std::filesystem::path& directory, uint32_t file_count, size_t file_bytes);
+
+    private:
+        uint64_t Random();
+        uint32_t Random(uint32_t bound) {
+            return static_cast<uint32_t>(Random() % bound);
+        }
+        bool Chance(uint32_t percent) {
+            return Random(100) < percent;
+        }
+
+        void Line(std::string& out, const std::string& text);
+        void Comment(std::string& out);
+        void Component(std::string& out);
+        void Statement(std::string& out, uint32_t depth);
+        std::string Expression(uint32_t depth);
+        std::string Literal();
+        std::string Operand();
+
+    private:
+        uint64_t m_State;
+        uint32_t m_Indent         = 0;
+        uint32_t m_ComponentIndex = 0;
+        std::vector<std::string> m_Registers; // current component names
+        std::vector<std::string> m_Inputs;
+        std::vector<std::string> m_Outputs;
+        std::vector<std::string> m_Parameters;
+    };
+
+} // namespace XRT
@@ -0,0 +1,21 @@
+// libFuzzer entry point for the lexer - also driven by XRT_lexer_stress.
+// Any input must either lex or be rejected with Lexer::UnknownTokenException; anything else is a finding.
+#include "Language/Lexer.hpp"
+#include "Language/SourceEntry.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <StringUtils.hpp>
+#include <Utils.hpp>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    std::string_view utf8{reinterpret_cast<const char*>(data), size};
+    auto source = CreateRef<XRT::SourceEntry>(StringUtils::utf8_to_utf16(utf8), "fuzz.xdl");
+    XRT::Lexer lexer(source);
+    try {
+        lexer.ProcessSource();
+    } catch (const XRT::Lexer::UnknownTokenException&) {
+        // malformed input is expected
+    }
+    return 0;
+}
@@ -0,0 +1,193 @@
+// Standalone driver of the lexer fuzz target.
+// Without inputs it lexes generated worst-case sources (unterminated comments and strings, deep nesting, long runs)
+// at growing sizes, reports time and heap use per byte and fails if the heap use per byte exceeds a bound.
+// Timing depends on the machine and its load - with --check-timing it also fails if time per byte grows with the
+// input size or exceeds an absolute bound. With inputs each file is run once through the fuzz target (corpus/crash replay).
+#include <argparse/argparse.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <Log/Logger.hpp>
+#include <MemoryStats.hpp>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+using argparse::ArgumentParser;
+using Clock = std::chrono::steady_clock;
+
+/// Worst-case input - prefix, a repeated unit up to the size, then suffix
+struct StressCase {
+    const char* name;
+    std::string prefix;
+    std::string unit;
+    std::string suffix;
+};
+
+static const std::vector<StressCase> s_Cases = {
+    {"unterminated_block_comment", "/*", "*", ""},
+    {"unterminated_comment_stars", "/* ", "** /", ""},
+    {"nested_comment_openers", "", "/*a", ""},
+    {"closed_nested_comment", "", "/*", "*/"},
+    {"comment_closers", "", "*/", ""},
+    {"long_line_comment", "//", "x", "\n"},
+    {"line_comment_runs", "", "//\n", ""},
+    {"unterminated_string", "\"", "a", ""},
+    {"unterminated_escapes", "\"", "\\\"", ""},
+    {"string_escape_run", "\"", "\\\\", "\""},
+    {"empty_string_run", "", "\"\"", ""},
+    {"string_line_breaks", "", "\"a\n", ""},
+    {"deep_parentheses", "", "(", ""},
+    {"deep_braces", "", "{", ""},
+    {"long_identifier", "", "a", ""},
+    {"long_number", "0x", "f", ""},
+    {"long_whitespace", "", " \t\n", ""},
+    {"mixed_openers", "", "/*\"//(", ""},
+};
+
+static std::string Generate(const StressCase& c, size_t size) {
+    std::string text;
+    text.reserve(size);
+    text += c.prefix;
+    while (text.size() + c.unit.size() + c.suffix.size() <= size)
+        text += c.unit;
+    text += c.suffix;
+    return text;
+}
+
+struct Measurement {
+    double ns_per_byte;
+    double heap_per_byte; // peak live heap bytes during the run per input byte
+};
+
+static Measurement Measure(const std::string& input, uint32_t iterations) {
+    auto data  = reinterpret_cast<const uint8_t*>(input.data());
+    auto best  = Clock::duration::max();
+    auto start = XRT::MemoryStats::GetSnapshot().live_bytes;
+    XRT::MemoryStats::ResetPeak();
+    for (uint32_t i = 0; i < iterations; i++) {
+        auto t = Clock::now();
+        LLVMFuzzerTestOneInput(data, input.size());
+        best = std::min(best, Clock::now() - t);
+    }
+    auto peak  = XRT::MemoryStats::GetSnapshot().peak_live_bytes - start;
+    auto bytes = static_cast<double>(std::max<size_t>(input.size(), 1));
+    return {static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(best).count()) / bytes, static_cast<double>(peak) / bytes};
+}
+
+static int ReplayFiles(const std::vector<std::string>& files) {
+    for (auto& path : files) {
+        std::ifstream stream(path, std::ios::binary);
+        if (!stream.is_open()) {
+            LOG_ERROR("Failed to open \"{}\"", path);
+            return -1;
+        }
+        std::stringstream ss;
+        ss << stream.rdbuf();
+        auto input = ss.str();
+        LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(input.data()), input.size());
+    }
+    LOG_INFO("[LexerStress] {} inputs replayed", files.size());
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    ArgumentParser program("XRT_lexer_stress", CFXS_VERSION_STRING);
+    program.add_argument("--min-size").help("Smallest generated input in bytes").scan<'u', uint32_t>().default_value(uint32_t{16 * 1024});
+    program.add_argument("--max-size").help("Largest generated input in bytes").scan<'u', uint32_t>().default_value(uint32_t{1024 * 1024});
+    program.add_argument("--iterations").help("Runs per input - the fastest is measured").scan<'u', uint32_t>().default_value(uint32_t{3});
+    program.add_argument("--check-timing").help("Fail on the time per byte bounds, not only report them").default_value(false).implicit_value(true);
+    program.add_argument("--max-growth").help("Allowed growth of time per byte from the smallest to the largest input").scan<'g', double>().default_value(4.0);
+    program.add_argument("--max-ns-per-byte").help("Time per byte bound of every input").scan<'g', double>().default_value(2000.0);
+    program.add_argument("--max-heap-per-byte").help("Peak heap bytes per input byte bound of every input").scan<'g', double>().default_value(256.0);
+    program.add_argument("files").help("Inputs to run through the fuzz target instead of the generated cases").remaining();
+
+    Logger::Options log_options;
+    log_options.level = spdlog::level::info;
+    log_options.file  = "";
+    Logger::Initialize(log_options);
+
+    try {
+        program.parse_args(argc, argv);
+    } catch (const std::runtime_error& e) {
+        std::stringstream ss;
+        ss << program;
+        LOG_ERROR("{}", e.what());
+        LOG_INFO("{}", ss.str());
+        return -1;
+    }
+
+    auto files = program.present<std::vector<std::string>>("files");
+    if (files && !files->empty())
+        return ReplayFiles(*files);
+
+    auto min_size        = std::max(program.get<uint32_t>("--min-size"), uint32_t{64});
+    auto max_size        = std::max(program.get<uint32_t>("--max-size"), min_size);
+    auto iterations      = std::max(program.get<uint32_t>("--iterations"), uint32_t{1});
+    auto max_growth      = program.get<double>("--max-growth");
+    auto max_ns_per_byte = program.get<double>("--max-ns-per-byte");
+    auto max_heap        = program.get<double>("--max-heap-per-byte");
+    auto check_timing    = program.get<bool>("--check-timing");
+
+    // below this the growth check compares timer noise
+    static constexpr double MIN_COMPARED_NS_PER_BYTE = 2.0;
+
+    XRT::MemoryStats::SetEnabled(true);
+    size_t failed = 0;
+    for (auto& c : s_Cases) {
+        Measurement smallest{};
+        Measurement largest{};
+        double worst_heap = 0;
+        bool ok           = true;
+        for (size_t size = min_size;; size = std::min<size_t>(size * 4, max_size)) {
+            auto m = Measure(Generate(c, size), iterations);
+            if (size == min_size)
+                smallest = m;
+            largest    = m;
+            worst_heap = std::max(worst_heap, m.heap_per_byte);
+            if (m.ns_per_byte > max_ns_per_byte) {
+                if (check_timing) {
+                    LOG_ERROR("[LexerStress] {} at {} bytes: {:.1f} ns/byte exceeds {:.1f}", c.name, size, m.ns_per_byte, max_ns_per_byte);
+                    ok = false;
+                } else {
+                    LOG_WARN("[LexerStress] {} at {} bytes: {:.1f} ns/byte exceeds {:.1f}", c.name, size, m.ns_per_byte, max_ns_per_byte);
+                }
+            }
+            if (m.heap_per_byte > max_heap) {
+                LOG_ERROR("[LexerStress] {} at {} bytes: {:.1f} heap bytes/byte exceeds {:.1f}", c.name, size, m.heap_per_byte, max_heap);
+                ok = false;
+            }
+            if (size == max_size)
+                break;
+        }
+
+        auto growth = largest.ns_per_byte / std::max(smallest.ns_per_byte, MIN_COMPARED_NS_PER_BYTE);
+        if (growth > max_growth) {
+            if (check_timing) {
+                LOG_ERROR("[LexerStress] {}: time per byte grew {:.1f}x from {} to {} bytes - not linear", c.name, growth, min_size, max_size);
+                ok = false;
+            } else {
+                LOG_WARN("[LexerStress] {}: time per byte grew {:.1f}x from {} to {} bytes", c.name, growth, min_size, max_size);
+            }
+        }
+
+        LOG_INFO("[LexerStress] {:<28} {:>8.2f} -> {:>8.2f} ns/byte, {:>6.1f} heap bytes/byte{}",
+                 c.name,
+                 smallest.ns_per_byte,
+                 largest.ns_per_byte,
+                 worst_heap,
+                 ok ? "" : " FAILED");
+        failed += !ok;
+    }
+    XRT::MemoryStats::SetEnabled(false);
+
+    if (failed) {
+        LOG_ERROR("[LexerStress] {}/{} cases failed", failed, s_Cases.size());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,165 @@
+// Checks BinaryWaveReader against BinaryWaveWriter.
+// Random changes over several blocks are written and read back in full and in time ranges. Truncated and corrupted
+// copies of the file must be rejected or read without crashing - size fields are bounded by the file length.
+#include "Waveform/BinaryWaveform.hpp"
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <tuple>
+#include <Log/Logger.hpp>
+
+using namespace XRT;
+namespace fs = std::filesystem;
+
+static constexpr uint32_t CHANGES = 30000;
+
+using Change = std::tuple<SimTime, uint32_t, uint64_t>;
+
+static std::vector<Change> ReadAll(BinaryWaveReader& reader, SimTime from, SimTime to, bool& ok) {
+    std::vector<Change> changes;
+    ok = reader.ReadChanges(from, to, [&](SimTime time, uint32_t signal, uint64_t value) {
+        changes.emplace_back(time, signal, value);
+    });
+    return changes;
+}
+
+static std::vector<char> Load(const fs::path& path) {
+    std::ifstream stream(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+}
+
+static void Store(const fs::path& path, const std::vector<char>& data) {
+    fs::remove(path); // a new file - rewriting a truncated one makes some file systems flush it to disk on close
+    std::ofstream stream(path, std::ios::binary);
+    stream.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+template<typename T>
+static void Patch(std::vector<char>& data, size_t offset, T value) {
+    std::memcpy(data.data() + offset, &value, sizeof(T));
+}
+
+int main() {
+    Logger::Options log_options;
+    log_options.level = spdlog::level::info;
+    log_options.file  = "";
+    Logger::Initialize(log_options);
+
+    auto path    = fs::temp_directory_path() / "xrt_binary_waveform_test.xwf";
+    auto corrupt = fs::temp_directory_path() / "xrt_binary_waveform_test_corrupt.xwf";
+
+    std::vector<WaveSignal> signals = {{"top.clock", 1, 0}, {"top.counter", 16, 5}, {"top.wide", 64, 0}};
+    std::vector<Change> expected;
+    std::mt19937_64 rng(1);
+
+    BinaryWaveWriter writer;
+    if (!writer.Open(path, signals)) {
+        LOG_ERROR("[BinaryWaveform] failed to create \"{}\"", path.string());
+        return 1;
+    }
+    SimTime time = 0;
+    for (uint32_t i = 0; i < CHANGES; i++) {
+        time += rng() % 4 == 0 ? rng() % 1000 : 0;
+        auto signal = static_cast<uint32_t>(rng() % signals.size());
+        auto value  = rng() & (signals[signal].width == 64 ? ~0ull : (1ull << signals[signal].width) - 1);
+        writer.Change(time, signal, value);
+        expected.emplace_back(time, signal, value);
+    }
+    auto end_time = time + 100;
+    if (!writer.Close(end_time)) {
+        LOG_ERROR("[BinaryWaveform] failed to write \"{}\"", path.string());
+        return 1;
+    }
+
+    // round trip
+    {
+        BinaryWaveReader reader;
+        if (!reader.Open(path)) {
+            LOG_ERROR("[BinaryWaveform] failed to read back \"{}\"", path.string());
+            return 1;
+        }
+        if (reader.GetEndTime() != end_time || reader.GetSignals().size() != signals.size()) {
+            LOG_ERROR("[BinaryWaveform] header mismatch");
+            return 1;
+        }
+        for (size_t i = 0; i < signals.size(); i++) {
+            auto& s = reader.GetSignals()[i];
+            if (s.name != signals[i].name || s.width != signals[i].width || s.initial != signals[i].initial) {
+                LOG_ERROR("[BinaryWaveform] signal {} mismatch", i);
+                return 1;
+            }
+        }
+
+        bool ok;
+        if (ReadAll(reader, 0, end_time, ok) != expected || !ok) {
+            LOG_ERROR("[BinaryWaveform] changes differ");
+            return 1;
+        }
+        for (uint32_t i = 0; i < 32; i++) {
+            auto from = rng() % end_time;
+            auto to   = from + rng() % (end_time / 8);
+            std::vector<Change> range;
+            for (auto& c : expected) {
+                if (std::get<0>(c) >= from && std::get<0>(c) <= to)
+                    range.push_back(c);
+            }
+            if (ReadAll(reader, from, to, ok) != range || !ok) {
+                LOG_ERROR("[BinaryWaveform] changes in [{}, {}] differ", from, to);
+                return 1;
+            }
+        }
+    }
+
+    // damaged files - must not crash or allocate beyond the file size
+    auto data         = Load(path);
+    auto name_size_at = sizeof(BinaryWaveform::MAGIC) + sizeof(uint32_t) + sizeof(uint32_t) + sizeof(uint64_t);
+    auto footer_size  = sizeof(SimTime) + sizeof(uint64_t) + sizeof(BinaryWaveform::INDEX_MAGIC);
+    uint64_t index_at = 0;
+    std::memcpy(&index_at, data.data() + data.size() - sizeof(BinaryWaveform::INDEX_MAGIC) - sizeof(uint64_t), sizeof(uint64_t));
+
+    std::vector<std::pair<const char*, std::vector<char>>> rejected;
+    auto patched = [&](const char* name, auto offset, auto value) {
+        auto copy = data;
+        Patch(copy, offset, value);
+        rejected.emplace_back(name, std::move(copy));
+    };
+    patched("signal count", sizeof(BinaryWaveform::MAGIC), uint32_t{0xFFFFFFFF});
+    patched("name size", name_size_at, uint32_t{0x7FFFFFFF});
+    patched("index offset", data.size() - sizeof(BinaryWaveform::INDEX_MAGIC) - sizeof(uint64_t), uint64_t{1} << 60);
+    patched("block count", index_at, uint32_t{0xFFFFFFFF});
+    patched("block raw size", index_at + sizeof(uint32_t) + sizeof(SimTime) * 2 + sizeof(uint64_t) + sizeof(uint32_t), uint32_t{0xFFFFFFFF});
+    patched("block offset", index_at + sizeof(uint32_t) + sizeof(SimTime) * 2, uint64_t{1} << 60);
+    for (size_t size : {size_t{0}, size_t{3}, name_size_at + 2, index_at + 8, data.size() - footer_size / 2, data.size() - 1})
+        rejected.emplace_back("truncated", std::vector<char>(data.begin(), data.begin() + static_cast<ptrdiff_t>(size)));
+
+    Logger::GetCoreLogger()->set_level(spdlog::level::off); // every rejected file is logged
+    for (auto& [name, bytes] : rejected) {
+        Store(corrupt, bytes);
+        BinaryWaveReader reader;
+        if (reader.Open(corrupt)) {
+            Logger::GetCoreLogger()->set_level(spdlog::level::info);
+            LOG_ERROR("[BinaryWaveform] file with bad {} ({} bytes) was accepted", name, bytes.size());
+            return 1;
+        }
+    }
+
+    // random damage - reading may fail but must stay within bounds
+    for (uint32_t i = 0; i < 100; i++) {
+        auto copy = data;
+        for (uint32_t k = 1 + rng() % 8; k > 0; k--)
+            copy[rng() % copy.size()] = static_cast<char>(rng());
+        Store(corrupt, copy);
+        BinaryWaveReader reader;
+        if (reader.Open(corrupt)) {
+            bool ok;
+            ReadAll(reader, 0, ~0ull, ok);
+        }
+    }
+
+    Logger::GetCoreLogger()->set_level(spdlog::level::info);
+
+    fs::remove(path);
+    fs::remove(corrupt);
+    LOG_INFO("[BinaryWaveform] {} changes read back, {} damaged files rejected", expected.size(), rejected.size());
+    return 0;
+}
@@ -0,0 +1,91 @@
+// Checks EventSimulator against CycleSimulator on clock-dependent register inputs.
+// Registers must sample D after the logic reading the clock has settled on the new clock level (post-edge view),
+// so a both-edge register with D = clock ? q + 1 : q counts rising edges like a rising-edge register.
+#include "Netlist/Netlist.hpp"
+#include "Simulation/CycleSimulator.hpp"
+#include "Simulation/EventSimulator.hpp"
+#include <Log/Logger.hpp>
+
+using namespace XRT;
+
+static constexpr uint32_t WIDTH = 8;
+static constexpr uint32_t STEPS = 64;
+static constexpr SimTime PERIOD = 10;
+static constexpr SimTime HALF   = PERIOD / 2;
+
+struct TestNetlist {
+    Scope<Netlist> netlist = CreateScope<Netlist>("SimulatorCompare");
+    PortID clock_port;
+    std::vector<NetID> counters;
+
+    TestNetlist() {
+        auto& nl   = *netlist;
+        auto clock = nl.AddNet(1, "clock");
+        clock_port = nl.AddPort("clock", PortDirection::IN, clock);
+        auto one   = nl.AddNet(WIDTH);
+        nl.AddCell(CellType::CONST, one, {}, 1);
+
+        auto add_counter = [&](std::string_view name, NetID clock_net, ClockEdge edge, bool gated) {
+            auto q    = nl.AddNet(WIDTH, name);
+            auto next = nl.AddNet(WIDTH);
+            nl.AddCell(CellType::ADD, next, {q, one});
+            auto d = next;
+            if (gated) {
+                d = nl.AddNet(WIDTH);
+                nl.AddCell(CellType::MUX, d, {clock_net, next, q});
+            }
+            nl.AddRegister(name, q, d, clock_net, edge, 0);
+            counters.push_back(q);
+        };
+
+        // Event<clock> { if (clock) count++; } unoptimized and optimized
+        add_counter("both_gated", clock, ClockEdge::BOTH, true);
+        add_counter("rising", clock, ClockEdge::RISING, false);
+        add_counter("falling_gated", clock, ClockEdge::FALLING, true);
+
+        // divided clock - registers clocked by a register output see its new value the same way
+        auto divided = nl.AddNet(1, "divided");
+        auto toggled = nl.AddNet(1);
+        nl.AddCell(CellType::NOT, toggled, {divided});
+        nl.AddRegister("divided", divided, toggled, clock, ClockEdge::RISING, 0);
+        counters.push_back(divided);
+        add_counter("divided_both_gated", divided, ClockEdge::BOTH, true);
+        add_counter("divided_rising", divided, ClockEdge::RISING, false);
+
+        nl.Finalize();
+    }
+};
+
+int main() {
+    Logger::Options log_options;
+    log_options.level = spdlog::level::info;
+    log_options.file  = "";
+    Logger::Initialize(log_options);
+
+    TestNetlist design;
+    auto& nl = *design.netlist;
+
+    CycleSimulator cycle(nl);
+    cycle.Settle();
+
+    EventSimulator event(nl);
+    event.AddClock(design.clock_port, PERIOD, HALF);
+
+    for (uint32_t step = 1; step <= STEPS; step++) {
+        cycle.Step();
+        event.RunUntil(step * HALF);
+        for (auto net : design.counters) {
+            if (cycle.GetValue(net, 0) != event.GetValue(net)) {
+                LOG_ERROR("[SimulatorCompare] step {}: {} = {} (cycle) / {} (event)", step, nl.GetNetName(net), cycle.GetValue(net, 0), event.GetValue(net));
+                return 1;
+            }
+        }
+        if (event.GetValue(design.counters[0]) != event.GetValue(design.counters[1])) {
+            LOG_ERROR("[SimulatorCompare] step {}: both-edge counter gated by the clock differs from the rising-edge counter", step);
+            return 1;
+        }
+    }
+
+    LOG_INFO("[SimulatorCompare] {} steps match", STEPS);
+    return 0;
+}
@@ -0,0 +1,202 @@
+// Checks SourceDocument::Edit against Open of the same text.
+// Random edits are applied to one document and undone again; after every step a second document opens the full text.
+// Error free texts must give the same tokens and AST entries. Texts with errors must agree on having errors, and the
+// tokens the incremental document keeps must still match the text at their locations.
+#include "Language/SourceDocument.hpp"
+#include <random>
+#include <Log/Logger.hpp>
+
+using namespace XRT;
+
+static constexpr uint32_t EDITS = 2000;
+
+static const wchar_t* BASE_TEXT = LR"(namespace Test {
+    template<bool POLARITY = true, unsigned WIDTH = 8>
+    component Counter : std::clockable {
+    registers:
+        unsigned<WIDTH..> reg_Count = 0; // count
+        logic reg_Last              = !POLARITY;
+
+    implementation:
+        Counter(in<logic> enable, out<logic> overflow) {
+            overflow = reg_Count == 0 ? POLARITY : !POLARITY;
+        }
+
+        Event<auto>(EventSource e) {
+            if (enable != reg_Last) {
+                reg_Count++;
+            }
+            reg_Last = enable;
+        }
+    };
+} // namespace Test
+
+/* block
+   comment */
+namespace Test::Nested {}
+
+namespace Test {
+    component Toggle : std::clockable {
+    registers:
+        logic reg_State = 0;
+
+    implementation:
+        Toggle(out logic state) {
+            state = reg_State;
+        }
+
+        Event<auto, rising>(EventSource e) {
+            reg_State = !reg_State;
+        }
+    };
+} // namespace Test
+)";
+
+static const wchar_t* SNIPPETS[] = {
+    L"",  L" ",  L"\n", L"x",  L"_1", L"{",  L"}",  L"(",  L")",    L";",          L"::",    L"/*",
+    L"*/", L"//", L"\"", L"<",  L">",  L"0x", L"==", L"if", L"else", L"namespace", L"component Extra {};\n",
+};
+
+/// Location of every offset - line/column of the character at the offset
+struct LineMap {
+    std::vector<std::pair<size_t, size_t>> locations;
+
+    explicit LineMap(const std::wstring& text) {
+        size_t line = 1, column = 1;
+        for (auto c : text) {
+            locations.emplace_back(line, column);
+            if (c == '\n') {
+                line++;
+                column = 1;
+            } else {
+                column++;
+            }
+        }
+        locations.emplace_back(line, column);
+    }
+};
+
+static bool SameTokens(const std::vector<const Token*>& a, const std::vector<const Token*>& b) {
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i]->type != b[i]->type || a[i]->value != b[i]->value || a[i]->offset != b[i]->offset || a[i]->line != b[i]->line ||
+            a[i]->column != b[i]->column)
+            return false;
+    }
+    return true;
+}
+
+static bool SameAST(const AST& a, const AST& b) {
+    auto& x = a.GetEntries();
+    auto& y = b.GetEntries();
+    if (x.size() != y.size() || a.CountNodes() != b.CountNodes())
+        return false;
+    for (size_t i = 0; i < x.size(); i++) {
+        if (x[i]->type != y[i]->type)
+            return false;
+        if (x[i]->type == AST_Type::NAMESPACE && x[i]->Cast<AST_Element::Namespace>().name != y[i]->Cast<AST_Element::Namespace>().name)
+            return false;
+        if (x[i]->type == AST_Type::COMPONENT) {
+            auto& c = x[i]->Cast<AST_Element::Component>();
+            auto& d = y[i]->Cast<AST_Element::Component>();
+            if (c.name != d.name || c.token->offset != d.token->offset || c.token->line != d.token->line || c.token->column != d.token->column)
+                return false;
+        }
+    }
+    return true;
+}
+
+/// Tokens kept by the document must match its text at their locations
+static bool TokensMatchText(SourceDocument& document) {
+    auto text = document.GetText();
+    LineMap map(text);
+    for (auto tok : document.GetTokens()) {
+        if (tok->offset + tok->value.size() > text.size() || text.compare(tok->offset, tok->value.size(), tok->value) != 0)
+            return false;
+        if (map.locations[tok->offset] != std::make_pair(tok->line, tok->column))
+            return false;
+    }
+    return true;
+}
+
+static bool Check(SourceDocument& incremental, const std::wstring& text, uint32_t step, bool expect_clean) {
+    if (incremental.GetText() != text) {
+        LOG_ERROR("[SourceDocumentIncremental] step {}: text differs", step);
+        return false;
+    }
+
+    SourceDocument fresh("test.xdl");
+    fresh.Open(text);
+    if (incremental.HasErrors() != fresh.HasErrors()) {
+        LOG_ERROR("[SourceDocumentIncremental] step {}: errors {} (incremental) / {} (open)", step, incremental.HasErrors(), fresh.HasErrors());
+        return false;
+    }
+    if (expect_clean && fresh.HasErrors()) {
+        LOG_ERROR("[SourceDocumentIncremental] step {}: {}", step, fresh.GetDiagnostics().front().message);
+        return false;
+    }
+    if (!TokensMatchText(incremental)) {
+        LOG_ERROR("[SourceDocumentIncremental] step {}: token locations do not match the text", step);
+        return false;
+    }
+    if (!fresh.HasErrors()) {
+        if (!SameTokens(incremental.GetTokens(), fresh.GetTokens())) {
+            LOG_ERROR("[SourceDocumentIncremental] step {}: tokens differ", step);
+            return false;
+        }
+        if (!SameAST(*incremental.GetAST(), *fresh.GetAST())) {
+            LOG_ERROR("[SourceDocumentIncremental] step {}: AST differs", step);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    Logger::Options log_options;
+    log_options.level = spdlog::level::info;
+    log_options.file  = "";
+    Logger::Initialize(log_options);
+
+    std::wstring text = BASE_TEXT;
+    SourceDocument incremental("test.xdl");
+    incremental.Open(text);
+    if (!Check(incremental, text, 0, true))
+        return 1;
+
+    std::mt19937 rng(1);
+    size_t relexed = 0;
+    for (uint32_t step = 1; step <= EDITS; step++) {
+        // random edit - usually breaks the text
+        auto offset  = rng() % (text.size() + 1);
+        auto length  = std::min<size_t>(rng() % 8, text.size() - offset);
+        auto removed = text.substr(offset, length);
+        std::wstring inserted = SNIPPETS[rng() % std::size(SNIPPETS)];
+        incremental.Edit(offset, length, inserted);
+        relexed += incremental.GetLastRelexLength();
+        text.replace(offset, length, inserted);
+        if (!Check(incremental, text, step, false))
+            return 1;
+
+        // undo - the text is valid again
+        incremental.Edit(offset, inserted.size(), removed);
+        text.replace(offset, inserted.size(), removed);
+        if (!Check(incremental, text, step, true))
+            return 1;
+
+        // valid edit that is kept - a comment line
+        if (step % 16 == 0) {
+            auto line = text.find('\n', rng() % text.size());
+            if (line != std::wstring::npos) {
+                incremental.Edit(line + 1, 0, L"// edit\n");
+                text.insert(line + 1, L"// edit\n");
+                if (!Check(incremental, text, step, true))
+                    return 1;
+            }
+        }
+    }
+
+    LOG_INFO("[SourceDocumentIncremental] {} edits match Open - {} characters relexed on average", EDITS, relexed / EDITS);
+    return 0;
+}
@@ -1,8 +1,76 @@
-set(sources
-  "${CMAKE_CURRENT_SOURCE_DIR}/src/main.cpp"
+# xrt_core - everything except the executable entry points
+set(core_sources
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Compiler/CompilationSession.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Compiler/DiagnosticRenderer.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Compiler/FileDiscovery.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Compiler/FileWatcher.cpp"
   "${CMAKE_CURRENT_SOURCE_DIR}/src/Language/Lexer.cpp"
   "${CMAKE_CURRENT_SOURCE_DIR}/src/Language/Parser.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Language/Preprocessor.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Language/SourceDocument.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Language/SymbolIndex.cpp"
   "${CMAKE_CURRENT_SOURCE_DIR}/src/Language/Token.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Language/TypeContext.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Netlist/Netlist.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Netlist/Elaborator.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Netlist/Optimizer/PassManager.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Netlist/Optimizer/ConstantPropagation.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Netlist/Optimizer/CommonSubexpressionElimination.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Netlist/Optimizer/DeadLogicElimination.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Netlist/Timing/DelayModel.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Netlist/Timing/TimingAnalysis.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Backend/CppModelBackend.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Backend/StreamWriter.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Backend/VHDLBackend.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Server/CompileServer.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Server/Json.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Server/LanguageServer.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Server/Protocol.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Simulation/Coverage.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Simulation/CycleSimulator.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Simulation/EventSimulator.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Simulation/Partitioner.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Simulation/TimingWheel.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Simulation/WorkerPool.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Waveform/BinaryWaveform.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Waveform/BlockCodec.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Waveform/VCDWriter.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Waveform/WaveformRecorder.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/MemoryStats.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/Profiler.cpp"
   "${CMAKE_CURRENT_SOURCE_DIR}/src/StringUtils.cpp"
   "${CMAKE_CURRENT_SOURCE_DIR}/src/Log/Logger.cpp"
-)
\ No newline at end of file
+)
+
+set(sources
+  "${CMAKE_CURRENT_SOURCE_DIR}/src/main.cpp"
+)
+
+set(bench_sources
+  "${CMAKE_CURRENT_SOURCE_DIR}/Bench/Benchmark.cpp"
+  "${CMAKE_CURRENT_SOURCE_DIR}/Bench/CorpusGenerator.cpp"
+)
+
+set(timing_test_sources
+  "${CMAKE_CURRENT_SOURCE_DIR}/Tests/TimingIncremental.cpp"
+)
+
+set(simulator_test_sources
+  "${CMAKE_CURRENT_SOURCE_DIR}/Tests/SimulatorCompare.cpp"
+)
+
+set(source_document_test_sources
+  "${CMAKE_CURRENT_SOURCE_DIR}/Tests/SourceDocumentIncremental.cpp"
+)
+
+set(waveform_test_sources
+  "${CMAKE_CURRENT_SOURCE_DIR}/Tests/BinaryWaveformRoundTrip.cpp"
+)
+
+set(lexer_fuzz_sources
+  "${CMAKE_CURRENT_SOURCE_DIR}/Fuzz/LexerFuzz.cpp"
+)
+
+set(lexer_stress_sources
+  "${CMAKE_CURRENT_SOURCE_DIR}/Fuzz/LexerStress.cpp"
+)
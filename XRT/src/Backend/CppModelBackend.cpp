@@ -0,0 +1,419 @@
+#include "CppModelBackend.hpp"
+#include <algorithm>
+#include <array>
+#include <Log/Logger.hpp>
+#include "Profiler.hpp"
+
+namespace XRT {
+
+    static constexpr std::array<std::string_view, 56> s_Keywords{
+        "and",      "auto",   "bool",     "break",    "case",      "catch",   "char",     "class",    "const",    "continue",
+        "default",  "delete", "do",       "double",   "else",      "enum",    "explicit", "extern",   "false",    "float",
+        "for",      "friend", "goto",     "if",       "inline",    "int",     "long",     "namespace", "new",     "not",
+        "operator", "or",     "private",  "protected", "public",   "register", "return",  "short",    "signed",   "sizeof",
+        "static",   "struct", "switch",   "template", "this",      "throw",   "true",     "try",      "typename", "union",
+        "unsigned", "using",  "virtual",  "void",     "volatile",  "xor",
+    };
+
+    /// Valid C++ identifier from the last segment of a qualified name
+    static std::string MakeIdentifier(std::string_view name) {
+        auto sep = name.rfind("::");
+        if (sep != std::string_view::npos)
+            name.remove_prefix(sep + 2);
+
+        std::string id;
+        id.reserve(name.size() + 1);
+        for (auto c : name) {
+            bool valid = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+            id += valid ? c : '_';
+        }
+        if (id.empty() || (id[0] >= '0' && id[0] <= '9'))
+            id.insert(0, "m");
+        if (std::find(s_Keywords.begin(), s_Keywords.end(), id) != s_Keywords.end() || id.starts_with("__"))
+            id += '_';
+        return id;
+    }
+
+    CppModelBackend::CppModelBackend(const Netlist& netlist) : m_Netlist(netlist), m_ClassName(MakeIdentifier(netlist.GetName())) {
+        for (PortID p = 0; p < netlist.GetPortCount(); p++)
+            m_PortNames.push_back(MakeIdentifier(netlist.GetPortName(p)));
+        for (RegisterID r = 0; r < netlist.GetRegisterCount(); r++)
+            m_RegisterNames.push_back("r" + std::to_string(r) + "_" + MakeIdentifier(netlist.GetRegisterName(r)));
+    }
+
+    void CppModelBackend::Net(StreamWriter& out, NetID net) const {
+        if (m_Netlist.GetNetDriverKind(net) == DriverKind::REGISTER) {
+            out << "m_State." << m_RegisterNames[m_Netlist.GetNetDriver(net)];
+        } else {
+            out << "m_Nets[" << net << ']';
+        }
+    }
+
+    void CppModelBackend::Cell(StreamWriter& out, CellID cell) const {
+        auto& nl  = m_Netlist;
+        auto type = nl.GetCellType(cell);
+        auto o    = nl.GetCellOutput(cell);
+        auto in   = nl.GetCellInputs(cell);
+
+        out << "            m_Nets[" << o << "] = Trunc<" << nl.GetNetWidth(o) << ">(";
+        auto binary = [&](const char* op) {
+            Net(out, in[0]);
+            out << op;
+            Net(out, in[1]);
+        };
+        switch (type) {
+            case CellType::CONST: out << nl.GetCellParam(cell) << "ull"; break;
+            case CellType::BUF: Net(out, in[0]); break;
+            case CellType::NOT:
+                out << '~';
+                Net(out, in[0]);
+                break;
+            case CellType::AND: binary(" & "); break;
+            case CellType::OR: binary(" | "); break;
+            case CellType::XOR: binary(" ^ "); break;
+            case CellType::ADD: binary(" + "); break;
+            case CellType::SUB: binary(" - "); break;
+            case CellType::MUL: binary(" * "); break;
+            case CellType::EQ: binary(" == "); break;
+            case CellType::NE: binary(" != "); break;
+            case CellType::LT: binary(" < "); break;
+            case CellType::LE: binary(" <= "); break;
+            case CellType::GT: binary(" > "); break;
+            case CellType::GE: binary(" >= "); break;
+            case CellType::LSL:
+            case CellType::LSR:
+                out << (type == CellType::LSL ? "ShiftLeft(" : "ShiftRight(");
+                binary(", ");
+                out << ')';
+                break;
+            case CellType::MUX:
+                Net(out, in[0]);
+                out << " ? ";
+                Net(out, in[1]);
+                out << " : ";
+                Net(out, in[2]);
+                break;
+            case CellType::SLICE:
+                if (nl.GetCellParam(cell) >= 64) {
+                    out << '0';
+                } else {
+                    Net(out, in[0]);
+                    out << " >> " << nl.GetCellParam(cell);
+                }
+                break;
+            case CellType::REDUCE_OR:
+                Net(out, in[0]);
+                out << " != 0";
+                break;
+            default: out << '0'; break;
+        }
+        out << ");\n";
+    }
+
+    bool CppModelBackend::EmitModel(StreamWriter& out) const {
+        auto& nl = m_Netlist;
+
+        // levelize - Kahn's algorithm, same order as the interpreter
+        std::vector<uint32_t> pending(nl.GetCellCount(), 0);
+        std::vector<CellID> order;
+        order.reserve(nl.GetCellCount());
+        for (CellID c = 0; c < nl.GetCellCount(); c++) {
+            for (auto net : nl.GetCellInputs(c)) {
+                if (nl.GetNetDriverKind(net) == DriverKind::CELL)
+                    pending[c]++;
+            }
+            if (!pending[c])
+                order.push_back(c);
+        }
+        for (size_t i = 0; i < order.size(); i++) {
+            for (auto user : nl.GetNetFanout(nl.GetCellOutput(order[i]))) {
+                if (--pending[user] == 0)
+                    order.push_back(user);
+            }
+        }
+        if (order.size() != nl.GetCellCount()) {
+            LOG_ERROR("[CppModel] {}: combinational loop - can not generate a model", nl.GetName());
+            return false;
+        }
+
+        // clock domains - registers grouped by clock net and edge
+        std::vector<NetID> clocks;
+        std::vector<RegisterID> regs;
+        for (RegisterID r = 0; r < nl.GetRegisterCount(); r++) {
+            auto clock = nl.GetRegisterClock(r);
+            if (clock == INVALID_ID || nl.GetRegisterD(r) == INVALID_ID)
+                continue;
+            regs.push_back(r);
+            if (std::find(clocks.begin(), clocks.end(), clock) == clocks.end())
+                clocks.push_back(clock);
+        }
+        auto clock_index = [&](RegisterID r) {
+            return static_cast<uint32_t>(std::find(clocks.begin(), clocks.end(), nl.GetRegisterClock(r)) - clocks.begin());
+        };
+        std::stable_sort(regs.begin(), regs.end(), [&](RegisterID a, RegisterID b) {
+            if (clock_index(a) != clock_index(b))
+                return clock_index(a) < clock_index(b);
+            return nl.GetRegisterEdge(a) < nl.GetRegisterEdge(b);
+        });
+        auto domain_name = [&](uint32_t clock, ClockEdge edge) {
+            return "Clock" + std::to_string(clock) + "_" + ClockEdge_ToString(edge);
+        };
+
+        auto clock_port = nl.FindPort("clock");
+        if (clock_port != INVALID_ID && nl.GetPortDirection(clock_port) != PortDirection::IN)
+            clock_port = INVALID_ID;
+
+        out << "// " << nl.GetName() << " - generated by " CFXS_PROGRAM_NAME " " CFXS_VERSION_STRING "\n";
+        for (auto& [name, value] : nl.GetParameters())
+            out << "//     " << nl.GetNames().Get(name) << " = " << value << '\n';
+        out << "#pragma once\n#include <cstdint>\n#include <optional>\n#include <string_view>\n\n";
+        out << "namespace xrt_model {\n\n";
+        out << "    class " << m_ClassName << " {\n    public:\n";
+
+        // Ports and probes
+        out << "        enum class Port : uint32_t {\n";
+        for (PortID p = 0; p < nl.GetPortCount(); p++)
+            out << "            " << m_PortNames[p] << ",\n";
+        out << "        };\n\n";
+
+        out << "        struct NetInfo {\n"
+               "            std::string_view name;\n"
+               "            uint32_t net;\n"
+               "            uint32_t width;\n"
+               "        };\n";
+        out << "        static constexpr NetInfo NETS[] = {\n";
+        for (NetID n = 0; n < nl.GetNetCount(); n++) {
+            if (!nl.GetNetName(n).empty())
+                out << "            {\"" << nl.GetNetName(n) << "\", " << n << ", " << nl.GetNetWidth(n) << "},\n";
+        }
+        out << "            {{}, 0, 0},\n        };\n\n";
+
+        out << "        static constexpr uint32_t NET_COUNT             = " << std::max(1u, nl.GetNetCount()) << ";\n";
+        out << "        static constexpr uint32_t CLOCK_COUNT           = " << std::max<size_t>(1, clocks.size()) << ";\n";
+        out << "        static constexpr uint32_t MAX_SETTLE_ITERATIONS = 64;\n\n";
+
+        out << "        struct State {\n";
+        for (RegisterID r = 0; r < nl.GetRegisterCount(); r++)
+            out << "            uint64_t " << m_RegisterNames[r] << "; // " << nl.GetNetWidth(nl.GetRegisterQ(r)) << " bit\n";
+        out << "        };\n\n";
+
+        // Harness API
+        out << "    public:\n        " << m_ClassName << "() {\n            Reset();\n        }\n\n";
+
+        out << "        void Reset() {\n            for (auto& n : m_Nets)\n                n = 0;\n";
+        for (RegisterID r = 0; r < nl.GetRegisterCount(); r++) {
+            out << "            m_State." << m_RegisterNames[r] << " = Trunc<" << nl.GetNetWidth(nl.GetRegisterQ(r)) << ">("
+                << nl.GetRegisterInit(r) << "ull);\n";
+        }
+        out << "            Evaluate();\n";
+        for (uint32_t i = 0; i < clocks.size(); i++) {
+            out << "            m_ClockLevel[" << i << "] = (";
+            Net(out, clocks[i]);
+            out << " & 1) != 0;\n";
+        }
+        out << "            m_Steps = 0;\n        }\n\n";
+
+        out << "        void Set(Port port, uint64_t value) {\n            switch (port) {\n";
+        for (PortID p = 0; p < nl.GetPortCount(); p++) {
+            auto net = nl.GetPortNet(p);
+            if (nl.GetPortDirection(p) != PortDirection::IN || nl.GetNetDriverKind(net) == DriverKind::REGISTER)
+                continue;
+            out << "                case Port::" << m_PortNames[p] << ": m_Nets[" << net << "] = Trunc<" << nl.GetNetWidth(net)
+                << ">(value); break;\n";
+        }
+        out << "                default: break;\n            }\n        }\n\n";
+
+        out << "        uint64_t Get(Port port) const {\n            switch (port) {\n";
+        for (PortID p = 0; p < nl.GetPortCount(); p++) {
+            out << "                case Port::" << m_PortNames[p] << ": return ";
+            Net(out, nl.GetPortNet(p));
+            out << ";\n";
+        }
+        out << "                default: return 0;\n            }\n        }\n\n";
+
+        out << "        uint64_t GetNet(uint32_t net) const {\n            switch (net) {\n";
+        for (RegisterID r = 0; r < nl.GetRegisterCount(); r++)
+            out << "                case " << nl.GetRegisterQ(r) << ": return m_State." << m_RegisterNames[r] << ";\n";
+        out << "                default: return net < NET_COUNT ? m_Nets[net] : 0;\n            }\n        }\n\n";
+
+        out << "        /// Value of a named net\n"
+               "        std::optional<uint64_t> Probe(std::string_view name) const {\n"
+               "            for (auto& info : NETS) {\n"
+               "                if (info.width && info.name == name)\n"
+               "                    return GetNet(info.net);\n"
+               "            }\n"
+               "            return std::nullopt;\n"
+               "        }\n\n";
+
+        out << "        const State& GetState() const {\n            return m_State;\n        }\n";
+        out << "        uint64_t GetStepCount() const {\n            return m_Steps;\n        }\n\n";
+
+        out << "        /// Toggle the clock port and propagate\n        void Step() {\n";
+        if (clock_port != INVALID_ID)
+            out << "            m_Nets[" << nl.GetPortNet(clock_port) << "] ^= 1;\n";
+        out << "            Settle();\n            m_Steps++;\n        }\n\n";
+        out << "        void Cycle(uint64_t count = 1) {\n"
+               "            for (uint64_t i = 0; i < count; i++) {\n"
+               "                Step();\n"
+               "                Step();\n"
+               "            }\n"
+               "        }\n\n";
+
+        out << "        /// Evaluate logic and clock registers until no clock edge is left\n"
+               "        void Settle() {\n"
+               "            for (uint32_t iteration = 0; iteration < MAX_SETTLE_ITERATIONS; iteration++) {\n"
+               "                Evaluate();\n"
+               "                bool fired = false;\n"
+               "                State next = m_State;\n";
+        for (uint32_t i = 0; i < clocks.size(); i++) {
+            bool has_edge[3]{};
+            for (auto r : regs) {
+                if (clock_index(r) == i)
+                    has_edge[static_cast<size_t>(nl.GetRegisterEdge(r))] = true;
+            }
+            out << "                {\n                    bool level   = (";
+            Net(out, clocks[i]);
+            out << " & 1) != 0;\n";
+            bool both = has_edge[static_cast<size_t>(ClockEdge::BOTH)];
+            if (both || has_edge[static_cast<size_t>(ClockEdge::RISING)])
+                out << "                    bool rising  = level && !m_ClockLevel[" << i << "];\n";
+            if (both || has_edge[static_cast<size_t>(ClockEdge::FALLING)])
+                out << "                    bool falling = !level && m_ClockLevel[" << i << "];\n";
+            out << "                    m_ClockLevel[" << i << "] = level;\n";
+            for (auto edge : {ClockEdge::RISING, ClockEdge::FALLING, ClockEdge::BOTH}) {
+                if (!has_edge[static_cast<size_t>(edge)])
+                    continue;
+                const char* condition = edge == ClockEdge::RISING ? "rising" : edge == ClockEdge::FALLING ? "falling" : "rising || falling";
+                out << "                    if (" << condition << ") {\n";
+                out << "                        " << domain_name(i, edge) << "(next);\n";
+                out << "                        fired = true;\n                    }\n";
+            }
+            out << "                }\n";
+        }
+        out << "                if (!fired)\n"
+               "                    return;\n"
+               "                m_State = next;\n"
+               "            }\n"
+               "        }\n\n";
+
+        // Generated logic
+        out << "    private:\n";
+        out << "        template<uint32_t W>\n"
+               "        static constexpr uint64_t Trunc(uint64_t value) {\n"
+               "            if constexpr (W >= 64)\n"
+               "                return value;\n"
+               "            else\n"
+               "                return value & ((1ull << W) - 1);\n"
+               "        }\n"
+               "        static constexpr uint64_t ShiftLeft(uint64_t a, uint64_t b) {\n"
+               "            return b >= 64 ? 0 : a << b;\n"
+               "        }\n"
+               "        static constexpr uint64_t ShiftRight(uint64_t a, uint64_t b) {\n"
+               "            return b >= 64 ? 0 : a >> b;\n"
+               "        }\n\n";
+
+        uint32_t chunks = static_cast<uint32_t>((order.size() + MAX_STATEMENTS_PER_FUNCTION - 1) / MAX_STATEMENTS_PER_FUNCTION);
+        out << "        void Evaluate() {\n";
+        for (uint32_t i = 0; i < chunks; i++)
+            out << "            Evaluate" << i << "();\n";
+        out << "        }\n";
+        for (uint32_t i = 0; i < chunks; i++) {
+            out << "\n        void Evaluate" << i << "() {\n";
+            auto end = std::min<size_t>(order.size(), (i + 1) * size_t{MAX_STATEMENTS_PER_FUNCTION});
+            for (size_t c = i * size_t{MAX_STATEMENTS_PER_FUNCTION}; c < end; c++)
+                Cell(out, order[c]);
+            out << "        }\n";
+        }
+
+        for (size_t i = 0; i < regs.size();) {
+            auto clock = clock_index(regs[i]);
+            auto edge  = nl.GetRegisterEdge(regs[i]);
+            out << "\n        void " << domain_name(clock, edge) << "(State& next) const {\n";
+            for (; i < regs.size() && clock_index(regs[i]) == clock && nl.GetRegisterEdge(regs[i]) == edge; i++) {
+                auto r = regs[i];
+                out << "            next." << m_RegisterNames[r] << " = Trunc<" << nl.GetNetWidth(nl.GetRegisterQ(r)) << ">(";
+                Net(out, nl.GetRegisterD(r));
+                out << ");\n";
+            }
+            out << "        }\n";
+        }
+
+        out << "\n    private:\n";
+        out << "        uint64_t m_Nets[NET_COUNT];\n";
+        out << "        State m_State;\n";
+        out << "        bool m_ClockLevel[CLOCK_COUNT]{};\n";
+        out << "        uint64_t m_Steps = 0;\n";
+        out << "    };\n\n} // namespace xrt_model\n";
+        return true;
+    }
+
+    void CppModelBackend::EmitHarness(StreamWriter& out) const {
+        auto& nl        = m_Netlist;
+        auto clock_port = nl.FindPort("clock");
+
+        out << "// " << nl.GetName() << " - random stimulus runner, same stimulus as lane 0 of --simulate\n";
+        out << "#include <cinttypes>\n#include <cstdio>\n#include <cstdlib>\n#include \"" << m_ClassName << ".hpp\"\n\n";
+        out << "int main(int argc, char** argv) {\n";
+        out << "    uint64_t cycles = argc > 1 ? strtoull(argv[1], nullptr, 0) : 100;\n";
+        out << "    bool quiet      = argc > 2;\n";
+        out << "    [[maybe_unused]] uint64_t seed = 0x9E3779B97F4A7C15ull;\n";
+        out << "    xrt_model::" << m_ClassName << " model;\n";
+        out << "    using Port = xrt_model::" << m_ClassName << "::Port;\n\n";
+        out << "    for (uint64_t cycle = 0; cycle < cycles; cycle++) {\n";
+        for (PortID p = 0; p < nl.GetPortCount(); p++) {
+            if (p == clock_port || nl.GetPortDirection(p) != PortDirection::IN)
+                continue;
+            out << "        seed ^= seed << 13;\n        seed ^= seed >> 7;\n        seed ^= seed << 17;\n";
+            out << "        model.Set(Port::" << m_PortNames[p] << ", seed);\n";
+        }
+        out << "        model.Cycle();\n";
+        out << "        if (quiet)\n            continue;\n";
+        out << "        printf(\"cycle %\" PRIu64 \":\", cycle);\n";
+        for (PortID p = 0; p < nl.GetPortCount(); p++) {
+            if (nl.GetPortDirection(p) == PortDirection::IN)
+                continue;
+            out << "        printf(\" " << nl.GetPortName(p) << "=%\" PRIu64, model.Get(Port::" << m_PortNames[p] << "));\n";
+        }
+        out << "        printf(\"\\n\");\n    }\n    return 0;\n}\n";
+    }
+
+    bool CppModelBackend::Emit(const std::filesystem::path& output_directory) {
+        XRT_PROFILE_SCOPE("CppModelBackend::Emit");
+
+        if (m_Netlist.GetInstanceCount()) {
+            LOG_ERROR("[CppModel] {}: netlist has instances - model generation requires a flat netlist", m_Netlist.GetName());
+            return false;
+        }
+
+        std::error_code ec;
+        std::filesystem::create_directories(output_directory, ec);
+        if (ec) {
+            LOG_ERROR("Failed to create output directory \"{}\": {}", output_directory.string(), ec.message());
+            return false;
+        }
+
+        StreamWriter out;
+        auto model_path = output_directory / (m_ClassName + ".hpp");
+        if (!out.Open(model_path))
+            return false;
+        bool ok = EmitModel(out);
+        if (!out.Close() || !ok) {
+            if (ok)
+                LOG_ERROR("Failed to write \"{}\"", model_path.string());
+            return false;
+        }
+
+        auto harness_path = output_directory / (m_ClassName + "_harness.cpp");
+        if (!out.Open(harness_path))
+            return false;
+        EmitHarness(out);
+        if (!out.Close()) {
+            LOG_ERROR("Failed to write \"{}\"", harness_path.string());
+            return false;
+        }
+
+        LOG_DEBUG("Emitted C++ model of {} to \"{}\"", m_Netlist.GetName(), output_directory.string());
+        return true;
+    }
+
+} // namespace XRT
@@ -0,0 +1,46 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "Netlist/Netlist.hpp"
+#include "StreamWriter.hpp"
+
+namespace XRT {
+
+    /// Emits a standalone C++ simulation model of a flat netlist.
+    /// Combinational logic becomes straight-line code in levelized order, registers live in a state struct and
+    /// every clock net/edge pair gets its own update function. Net widths are template arguments so all masking
+    /// is resolved at compile time. Cycle semantics match CycleSimulator (lane 0).
+    class CppModelBackend {
+    public:
+        /// Cells per generated Evaluate function - keeps huge models compilable
+        static constexpr uint32_t MAX_STATEMENTS_PER_FUNCTION = 4096;
+
+    public:
+        /// Netlist must be flat (no instances)
+        CppModelBackend(const Netlist& netlist);
+
+        /// Write <class>.hpp (model) and <class>_harness.cpp (random stimulus runner) into output_directory
+        bool Emit(const std::filesystem::path& output_directory);
+
+        /// Returns false if the netlist has a combinational loop
+        bool EmitModel(StreamWriter& out) const;
+        void EmitHarness(StreamWriter& out) const;
+
+        const std::string& GetClassName() const {
+            return m_ClassName;
+        }
+
+    private:
+        /// Reference to a net value in generated code - register outputs read the state struct
+        void Net(StreamWriter& out, NetID net) const;
+        void Cell(StreamWriter& out, CellID cell) const;
+
+    private:
+        const Netlist& m_Netlist;
+        std::string m_ClassName;
+        std::vector<std::string> m_PortNames;     // [port] -> Port enum member
+        std::vector<std::string> m_RegisterNames; // [register] -> State member
+    };
+
+} // namespace XRT
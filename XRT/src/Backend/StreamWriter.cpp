@@ -0,0 +1,62 @@
+#include "StreamWriter.hpp"
+#include <Log/Logger.hpp>
+
+namespace XRT {
+
+    StreamWriter::StreamWriter(size_t buffer_size) : m_Buffer(new char[buffer_size]), m_Capacity(buffer_size) {
+    }
+
+    StreamWriter::~StreamWriter() {
+        Close();
+    }
+
+    bool StreamWriter::Open(const std::filesystem::path& path) {
+        Close();
+        m_File  = std::fopen(path.string().c_str(), "wb");
+        m_Size  = 0;
+        m_Error = m_File == nullptr;
+        if (!m_File)
+            LOG_ERROR("Failed to open output file \"{}\"", path.string());
+        return m_File != nullptr;
+    }
+
+    bool StreamWriter::Close() {
+        if (!m_File)
+            return !m_Error;
+        Flush();
+        if (std::fclose(m_File) != 0)
+            m_Error = true;
+        m_File = nullptr;
+        return !m_Error;
+    }
+
+    void StreamWriter::Flush() {
+        if (m_Size) {
+            WriteDirect({m_Buffer.get(), m_Size});
+            m_Size = 0;
+        }
+    }
+
+    void StreamWriter::WriteDirect(std::string_view str) {
+        if (m_File && std::fwrite(str.data(), 1, str.size(), m_File) != str.size())
+            m_Error = true;
+    }
+
+    StreamWriter& StreamWriter::WriteBinary(uint64_t value, uint32_t width) {
+        char tmp[64];
+        for (uint32_t i = 0; i < width; i++)
+            tmp[i] = (value >> (width - 1 - i)) & 1 ? '1' : '0';
+        return *this << std::string_view{tmp, width};
+    }
+
+    StreamWriter& StreamWriter::Indent(uint32_t level) {
+        static constexpr std::string_view s_Spaces = "                                ";
+        for (uint32_t n = level * 4; n;) {
+            auto count = n < s_Spaces.size() ? n : static_cast<uint32_t>(s_Spaces.size());
+            *this << s_Spaces.substr(0, count);
+            n -= count;
+        }
+        return *this;
+    }
+
+} // namespace XRT
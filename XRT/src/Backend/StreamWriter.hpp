@@ -0,0 +1,82 @@
+#pragma once
+#include <charconv>
+#include <concepts>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string_view>
+#include <Utils.hpp>
+
+namespace XRT {
+
+    /// Buffered file writer - output is collected in a single large buffer that is
+    /// written out whenever it fills up, no intermediate string allocations
+    class StreamWriter {
+    public:
+        static constexpr size_t DEFAULT_BUFFER_SIZE = 1024 * 1024;
+
+    public:
+        StreamWriter(size_t buffer_size = DEFAULT_BUFFER_SIZE);
+        ~StreamWriter();
+
+        StreamWriter(const StreamWriter&)            = delete;
+        StreamWriter& operator=(const StreamWriter&) = delete;
+
+        bool Open(const std::filesystem::path& path);
+        /// Flush and close - returns false if any write failed
+        bool Close();
+
+        bool IsOpen() const {
+            return m_File != nullptr;
+        }
+
+        StreamWriter& operator<<(std::string_view str) {
+            if (str.size() > m_Capacity - m_Size) {
+                Flush();
+                if (str.size() > m_Capacity) {
+                    WriteDirect(str);
+                    return *this;
+                }
+            }
+            std::memcpy(m_Buffer.get() + m_Size, str.data(), str.size());
+            m_Size += str.size();
+            return *this;
+        }
+
+        StreamWriter& operator<<(const char* str) {
+            return *this << std::string_view{str};
+        }
+
+        StreamWriter& operator<<(char c) {
+            if (m_Size == m_Capacity)
+                Flush();
+            m_Buffer[m_Size++] = c;
+            return *this;
+        }
+
+        template<std::unsigned_integral T>
+        StreamWriter& operator<<(T value) {
+            char tmp[24];
+            auto res = std::to_chars(tmp, tmp + sizeof(tmp), value);
+            return *this << std::string_view{tmp, static_cast<size_t>(res.ptr - tmp)};
+        }
+
+        /// Write "width" binary digits of value, MSB first
+        StreamWriter& WriteBinary(uint64_t value, uint32_t width);
+
+        /// Write 4 spaces per indentation level
+        StreamWriter& Indent(uint32_t level);
+
+    private:
+        void Flush();
+        void WriteDirect(std::string_view str);
+
+    private:
+        FILE* m_File = nullptr;
+        Scope<char[]> m_Buffer;
+        size_t m_Capacity;
+        size_t m_Size = 0;
+        bool m_Error  = false;
+    };
+
+} // namespace XRT
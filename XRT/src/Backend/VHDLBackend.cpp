@@ -0,0 +1,497 @@
+#include "VHDLBackend.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <span>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <Log/Logger.hpp>
+#include "Profiler.hpp"
+
+namespace XRT {
+
+    /// Valid VHDL identifier from the last segment of a qualified name
+    static std::string MakeIdentifier(std::string_view name) {
+        auto sep = name.rfind("::");
+        if (sep != std::string_view::npos)
+            name.remove_prefix(sep + 2);
+
+        std::string id;
+        id.reserve(name.size());
+        for (auto c : name) {
+            bool valid = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+            if (!valid)
+                c = '_';
+            if (c == '_' && (id.empty() || id.back() == '_'))
+                continue; // no leading or double underscores
+            id += c;
+        }
+        while (!id.empty() && id.back() == '_')
+            id.pop_back();
+        if (id.empty() || (id[0] >= '0' && id[0] <= '9'))
+            id.insert(0, "m");
+        return id;
+    }
+
+    static std::string ToLower(std::string_view str) {
+        std::string lower{str};
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](char c) {
+            return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        });
+        return lower;
+    }
+
+    /// VHDL-2008 reserved words
+    static bool IsReserved(std::string_view name) {
+        static const std::unordered_set<std::string_view> reserved{
+            "abs", "access", "after", "alias", "all", "and", "architecture", "array", "assert", "assume", "assume_guarantee",
+            "attribute", "begin", "block", "body", "buffer", "bus", "case", "component", "configuration", "constant", "context",
+            "cover", "default", "disconnect", "downto", "else", "elsif", "end", "entity", "exit", "fairness", "file", "for",
+            "force", "function", "generate", "generic", "group", "guarded", "if", "impure", "in", "inertial", "inout", "is",
+            "label", "library", "linkage", "literal", "loop", "map", "mod", "nand", "new", "next", "nor", "not", "null", "of",
+            "on", "open", "or", "others", "out", "package", "parameter", "port", "postponed", "procedure", "process", "property",
+            "protected", "pure", "range", "record", "register", "reject", "release", "rem", "report", "restrict",
+            "restrict_guarantee", "return", "rol", "ror", "select", "sequence", "severity", "shared", "signal", "sla", "sll",
+            "sra", "srl", "strong", "subtype", "then", "to", "transport", "type", "unaffected", "units", "until", "use",
+            "variable", "vmode", "vprop", "vunit", "wait", "when", "while", "with", "xnor", "xor",
+        };
+        return reserved.contains(ToLower(name));
+    }
+
+    /// Port names are kept - reserved words and names that are not basic identifiers become \extended\ identifiers
+    static std::string PortIdentifier(std::string_view name) {
+        bool basic = !name.empty() && std::isalpha(static_cast<unsigned char>(name[0])) && name.back() != '_';
+        for (size_t i = 0; basic && i < name.size(); i++) {
+            auto c = static_cast<unsigned char>(name[i]);
+            basic  = (std::isalnum(c) || c == '_') && !(c == '_' && name[i - 1] == '_');
+        }
+        if (basic && !IsReserved(name))
+            return std::string{name};
+
+        std::string id = "\\";
+        for (auto c : name) {
+            id += c;
+            if (c == '\\')
+                id += c;
+        }
+        return id + '\\';
+    }
+
+    VHDLBackend::VHDLBackend(const Design& design) : m_Design(design) {
+        // VHDL identifiers are case insensitive - specializations of the same component get a module suffix
+        std::unordered_map<std::string, uint32_t> counts;
+        m_EntityNames.reserve(design.GetModuleCount());
+        for (ModuleID m = 0; m < design.GetModuleCount(); m++) {
+            auto id = MakeIdentifier(design.GetModule(m).GetName());
+            if (counts[ToLower(id)]++ || IsReserved(id))
+                id += "_" + std::to_string(m);
+            m_EntityNames.push_back(std::move(id));
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    namespace {
+
+        /// Every net is an unsigned vector - 1 bit ports are bridged to STD_LOGIC
+        class ModuleWriter {
+        public:
+            ModuleWriter(const Netlist& netlist, StreamWriter& out) : m_Netlist(netlist), m_Out(out) {
+                // net signals are <prefix><id> - no port may start with the prefix (names are case insensitive)
+                std::vector<std::string> ports;
+                for (PortID p = 0; p < netlist.GetPortCount(); p++)
+                    ports.push_back(ToLower(netlist.GetPortName(p)));
+                while (std::any_of(ports.begin(), ports.end(), [&](const std::string& port) {
+                    return port.starts_with(m_NetPrefix);
+                })) {
+                    m_NetPrefix += 'x';
+                }
+            }
+
+            StreamWriter& Net(NetID net) {
+                return m_Out << m_NetPrefix << net;
+            }
+
+            /// Net zero extended/truncated to width
+            void Resized(NetID net, uint32_t width) {
+                if (m_Netlist.GetNetWidth(net) == width) {
+                    Net(net);
+                } else {
+                    m_Out << "resize(";
+                    Net(net) << ", " << width << ')';
+                }
+            }
+
+            /// Port side of a net - 1 bit nets are STD_LOGIC ports
+            void PortActual(NetID net) {
+                Net(net);
+                if (m_Netlist.GetNetWidth(net) == 1)
+                    m_Out << "(0)";
+            }
+
+            void Literal(uint64_t value, uint32_t width) {
+                m_Out << '"';
+                m_Out.WriteBinary(value, width) << '"';
+            }
+
+            void Cell(CellID cell);
+            void Registers();
+
+        private:
+            void EdgeProcess(NetID clock, bool rising, std::span<const RegisterID> regs, const char* half, const char* other_half);
+
+        private:
+            const Netlist& m_Netlist;
+            StreamWriter& m_Out;
+            std::string m_NetPrefix = "n";
+        };
+
+        void ModuleWriter::Cell(CellID cell) {
+            auto& nl   = m_Netlist;
+            auto type  = nl.GetCellType(cell);
+            auto o     = nl.GetCellOutput(cell);
+            auto w     = nl.GetNetWidth(o);
+            auto in    = nl.GetCellInputs(cell);
+            auto width = [&](size_t i) {
+                return nl.GetNetWidth(in[i]);
+            };
+
+            m_Out.Indent(1);
+            Net(o) << " <= ";
+
+            switch (type) {
+                case CellType::CONST: Literal(nl.GetCellParam(cell), w); break;
+                case CellType::BUF: Resized(in[0], w); break;
+                case CellType::NOT: {
+                    auto op_width = std::max(width(0), w);
+                    m_Out << (op_width == w ? "NOT " : "resize(NOT ");
+                    Resized(in[0], op_width);
+                    if (op_width != w)
+                        m_Out << ", " << w << ')';
+                    break;
+                }
+                case CellType::AND:
+                case CellType::OR:
+                case CellType::XOR:
+                case CellType::ADD:
+                case CellType::SUB:
+                case CellType::MUL: {
+                    const char* op = nullptr;
+                    switch (type) {
+                        case CellType::AND: op = " AND "; break;
+                        case CellType::OR: op = " OR "; break;
+                        case CellType::XOR: op = " XOR "; break;
+                        case CellType::ADD: op = " + "; break;
+                        case CellType::SUB: op = " - "; break;
+                        default: op = " * "; break;
+                    }
+                    // unsigned "*" result is the sum of operand widths - always resized
+                    auto op_width = std::max({width(0), width(1), w});
+                    bool resize   = op_width != w || type == CellType::MUL;
+                    if (resize)
+                        m_Out << "resize(";
+                    Resized(in[0], op_width);
+                    m_Out << op;
+                    Resized(in[1], op_width);
+                    if (resize)
+                        m_Out << ", " << w << ')';
+                    break;
+                }
+                case CellType::EQ:
+                case CellType::NE:
+                case CellType::LT:
+                case CellType::LE:
+                case CellType::GT:
+                case CellType::GE: {
+                    const char* op = nullptr;
+                    switch (type) {
+                        case CellType::EQ: op = " = "; break;
+                        case CellType::NE: op = " /= "; break;
+                        case CellType::LT: op = " < "; break;
+                        case CellType::LE: op = " <= "; break;
+                        case CellType::GT: op = " > "; break;
+                        default: op = " >= "; break;
+                    }
+                    Literal(1, w);
+                    m_Out << " WHEN ";
+                    Net(in[0]) << op;
+                    Net(in[1]) << " ELSE ";
+                    Literal(0, w);
+                    break;
+                }
+                case CellType::LSL:
+                case CellType::LSR: {
+                    auto op_width = std::max(width(0), w);
+                    m_Out << "resize(" << (type == CellType::LSL ? "shift_left(" : "shift_right(");
+                    Resized(in[0], op_width);
+                    m_Out << ", to_integer(";
+                    Net(in[1]) << ")), " << w << ')';
+                    break;
+                }
+                case CellType::MUX: {
+                    Resized(in[1], w);
+                    m_Out << " WHEN ";
+                    Net(in[0]) << " /= 0 ELSE ";
+                    Resized(in[2], w);
+                    break;
+                }
+                case CellType::SLICE: {
+                    m_Out << "resize(shift_right(";
+                    Net(in[0]) << ", " << nl.GetCellParam(cell) << "), " << w << ')';
+                    break;
+                }
+                case CellType::REDUCE_OR: {
+                    Literal(1, w);
+                    m_Out << " WHEN ";
+                    Net(in[0]) << " /= 0 ELSE ";
+                    Literal(0, w);
+                    break;
+                }
+                default: m_Out << "(OTHERS => '0')"; break;
+            }
+            m_Out << ";\n";
+        }
+
+        void ModuleWriter::Registers() {
+            auto& nl = m_Netlist;
+
+            // one process per clock net and edge
+            std::vector<RegisterID> regs;
+            regs.reserve(nl.GetRegisterCount());
+            for (RegisterID r = 0; r < nl.GetRegisterCount(); r++) {
+                if (nl.GetRegisterClock(r) != INVALID_ID && nl.GetRegisterD(r) != INVALID_ID)
+                    regs.push_back(r);
+            }
+            std::stable_sort(regs.begin(), regs.end(), [&](RegisterID a, RegisterID b) {
+                if (nl.GetRegisterClock(a) != nl.GetRegisterClock(b))
+                    return nl.GetRegisterClock(a) < nl.GetRegisterClock(b);
+                return nl.GetRegisterEdge(a) < nl.GetRegisterEdge(b);
+            });
+
+            for (size_t i = 0; i < regs.size();) {
+                auto clock = nl.GetRegisterClock(regs[i]);
+                auto edge  = nl.GetRegisterEdge(regs[i]);
+                auto first = i;
+                while (i < regs.size() && nl.GetRegisterClock(regs[i]) == clock && nl.GetRegisterEdge(regs[i]) == edge)
+                    i++;
+                std::span<const RegisterID> group{regs.data() + first, i - first};
+
+                if (edge != ClockEdge::BOTH) {
+                    EdgeProcess(clock, edge == ClockEdge::RISING, group, "", nullptr);
+                    continue;
+                }
+
+                // dual edge register as a rising and a falling half - Q = Q_r XOR Q_f
+                EdgeProcess(clock, true, group, "_r", "_f");
+                EdgeProcess(clock, false, group, "_f", "_r");
+                m_Out << '\n';
+                for (auto r : group) {
+                    auto q = nl.GetRegisterQ(r);
+                    m_Out.Indent(1);
+                    Net(q) << " <= ";
+                    Net(q) << "_r XOR ";
+                    Net(q) << "_f;\n";
+                }
+            }
+        }
+
+        void ModuleWriter::EdgeProcess(NetID clock, bool rising, std::span<const RegisterID> regs, const char* half, const char* other_half) {
+            auto& nl = m_Netlist;
+            m_Out << "\n    PROCESS (";
+            Net(clock) << ")\n    BEGIN\n        IF " << (rising ? "rising_edge(" : "falling_edge(");
+            Net(clock) << "(0)) THEN\n";
+
+            for (auto r : regs) {
+                auto q = nl.GetRegisterQ(r);
+                m_Out.Indent(3);
+                Net(q) << half << " <= ";
+                if (other_half)
+                    m_Out << '(';
+                Resized(nl.GetRegisterD(r), nl.GetNetWidth(q));
+                if (other_half) {
+                    m_Out << " XOR ";
+                    Net(q) << other_half << ')';
+                }
+                m_Out << ";\n";
+            }
+
+            m_Out << "        END IF;\n    END PROCESS;\n";
+        }
+
+    } // namespace
+
+    void VHDLBackend::EmitModule(ModuleID module, StreamWriter& out) const {
+        auto& nl     = m_Design.GetModule(module);
+        auto& entity = m_EntityNames[module];
+        ModuleWriter w(nl, out);
+
+        out << "LIBRARY ieee;\nUSE ieee.std_logic_1164.ALL;\nUSE ieee.numeric_std.ALL;\n\n";
+
+        out << "-- " << nl.GetName() << '\n';
+        for (auto& [name, value] : nl.GetParameters()) {
+            out << "--     " << nl.GetNames().Get(name) << " = " << value << '\n';
+        }
+
+        // Entity
+        out << "ENTITY " << entity << " IS\n";
+        if (nl.GetPortCount()) {
+            out << "    PORT (\n";
+            for (PortID p = 0; p < nl.GetPortCount(); p++) {
+                auto width = nl.GetNetWidth(nl.GetPortNet(p));
+                out << "        " << PortIdentifier(nl.GetPortName(p)) << " : ";
+                switch (nl.GetPortDirection(p)) {
+                    case PortDirection::IN: out << "IN "; break;
+                    case PortDirection::INOUT: out << "INOUT "; break;
+                    default: out << "OUT "; break;
+                }
+                if (width == 1) {
+                    out << "STD_LOGIC";
+                } else {
+                    out << "UNSIGNED(" << width - 1 << " DOWNTO 0)";
+                }
+                out << (p + 1 < nl.GetPortCount() ? ";\n" : "\n");
+            }
+            out << "    );\n";
+        }
+        out << "END ENTITY;\n\n";
+
+        // Signals
+        out << "ARCHITECTURE RTL OF " << entity << " IS\n";
+        std::vector<uint8_t> register_net(nl.GetNetCount(), 0);
+        for (RegisterID r = 0; r < nl.GetRegisterCount(); r++) {
+            register_net[nl.GetRegisterQ(r)] = true;
+            if (nl.GetRegisterEdge(r) == ClockEdge::BOTH && nl.GetRegisterClock(r) != INVALID_ID && nl.GetRegisterD(r) != INVALID_ID) {
+                LOG_WARN("{}: register \"{}\" is clocked on both edges - emitted as a rising and a falling edge register pair",
+                         nl.GetName(),
+                         nl.GetRegisterName(r));
+            }
+        }
+        auto vector = [&](NetID n) -> StreamWriter& {
+            return out << " : UNSIGNED(" << nl.GetNetWidth(n) - 1 << " DOWNTO 0)";
+        };
+        for (NetID n = 0; n < nl.GetNetCount(); n++) {
+            out << "    SIGNAL ";
+            w.Net(n);
+            vector(n);
+            auto reg       = register_net[n] ? nl.GetNetDriver(n) : INVALID_ID;
+            bool dual_edge = reg != INVALID_ID && nl.GetRegisterEdge(reg) == ClockEdge::BOTH && nl.GetRegisterClock(reg) != INVALID_ID &&
+                             nl.GetRegisterD(reg) != INVALID_ID;
+            if (reg != INVALID_ID && !dual_edge) {
+                out << " := ";
+                w.Literal(nl.GetRegisterInit(reg), nl.GetNetWidth(n));
+            }
+            out << ';';
+            if (!nl.GetNetName(n).empty())
+                out << " -- " << nl.GetNetName(n);
+            out << '\n';
+
+            if (dual_edge) {
+                out << "    SIGNAL ";
+                w.Net(n) << "_r";
+                vector(n) << " := ";
+                w.Literal(nl.GetRegisterInit(reg), nl.GetNetWidth(n));
+                out << ";\n    SIGNAL ";
+                w.Net(n) << "_f";
+                vector(n) << " := ";
+                w.Literal(0, nl.GetNetWidth(n));
+                out << ";\n";
+            }
+        }
+        out << "BEGIN\n";
+
+        // Port bridges
+        for (PortID p = 0; p < nl.GetPortCount(); p++) {
+            auto net  = nl.GetPortNet(p);
+            bool read = nl.GetPortDirection(p) == PortDirection::IN || nl.GetNetDriverKind(net) == DriverKind::PORT;
+            out << "    ";
+            if (read) {
+                w.PortActual(net);
+                out << " <= " << PortIdentifier(nl.GetPortName(p)) << ";\n";
+            } else {
+                out << PortIdentifier(nl.GetPortName(p)) << " <= ";
+                w.PortActual(net);
+                out << ";\n";
+            }
+        }
+
+        // Combinational logic
+        if (nl.GetCellCount())
+            out << '\n';
+        for (CellID c = 0; c < nl.GetCellCount(); c++)
+            w.Cell(c);
+
+        w.Registers();
+
+        // Instances
+        for (InstanceID i = 0; i < nl.GetInstanceCount(); i++) {
+            auto child_id    = nl.GetInstanceModule(i);
+            auto& child      = m_Design.GetModule(child_id);
+            auto connections = nl.GetInstanceConnections(i);
+
+            out << "\n    " << MakeIdentifier(nl.GetInstanceName(i)) << "_i" << i << " : ENTITY work." << m_EntityNames[child_id];
+            if (connections.empty()) {
+                out << ";\n";
+                continue;
+            }
+            out << " PORT MAP (\n";
+            for (PortID p = 0; p < connections.size(); p++) {
+                out << "        " << PortIdentifier(child.GetPortName(p)) << " => ";
+                w.PortActual(connections[p]);
+                out << (p + 1 < connections.size() ? ",\n" : "\n");
+            }
+            out << "    );\n";
+        }
+
+        out << "END ARCHITECTURE;\n";
+    }
+
+    bool VHDLBackend::Emit(const std::filesystem::path& output_directory, uint32_t thread_count) {
+        XRT_PROFILE_SCOPE("VHDLBackend::Emit");
+
+        std::error_code ec;
+        std::filesystem::create_directories(output_directory, ec);
+        if (ec) {
+            LOG_ERROR("Failed to create output directory \"{}\": {}", output_directory.string(), ec.message());
+            return false;
+        }
+
+        auto module_count = m_Design.GetModuleCount();
+        if (!thread_count)
+            thread_count = std::max(1u, std::thread::hardware_concurrency());
+        thread_count = std::min(thread_count, module_count);
+
+        std::atomic<ModuleID> next{0};
+        std::atomic<bool> ok{true};
+        auto worker = [&]() {
+            StreamWriter out; // buffer reused for all files of this thread
+            for (ModuleID m = next++; m < module_count; m = next++) {
+                auto path = output_directory / (m_EntityNames[m] + ".vhd");
+                if (!out.Open(path)) {
+                    ok = false;
+                    continue;
+                }
+                EmitModule(m, out);
+                if (!out.Close()) {
+                    LOG_ERROR("Failed to write \"{}\"", path.string());
+                    ok = false;
+                }
+            }
+        };
+
+        if (thread_count <= 1) {
+            worker();
+        } else {
+            std::vector<std::thread> threads;
+            threads.reserve(thread_count);
+            for (uint32_t i = 0; i < thread_count; i++)
+                threads.emplace_back(worker);
+            for (auto& t : threads)
+                t.join();
+        }
+
+        LOG_DEBUG("Emitted {} VHDL modules to \"{}\"", module_count, output_directory.string());
+        return ok;
+    }
+
+} // namespace XRT
@@ -0,0 +1,31 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "Netlist/Netlist.hpp"
+#include "StreamWriter.hpp"
+
+namespace XRT {
+
+    /// Emits one VHDL entity/architecture file per elaborated module
+    class VHDLBackend {
+    public:
+        VHDLBackend(const Design& design);
+
+        /// Write <entity>.vhd for every module into output_directory.
+        /// Modules are independent and emitted on up to thread_count threads (0 = hardware concurrency).
+        bool Emit(const std::filesystem::path& output_directory, uint32_t thread_count = 0);
+
+        /// Emit a single module to an open writer
+        void EmitModule(ModuleID module, StreamWriter& out) const;
+
+        const std::string& GetEntityName(ModuleID module) const {
+            return m_EntityNames[module];
+        }
+
+    private:
+        const Design& m_Design;
+        std::vector<std::string> m_EntityNames;
+    };
+
+} // namespace XRT
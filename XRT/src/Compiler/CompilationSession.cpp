@@ -0,0 +1,529 @@
+#include "CompilationSession.hpp"
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <Log/Logger.hpp>
+#include "Netlist/Optimizer/PassManager.hpp"
+#include "Profiler.hpp"
+#include "StringUtils.hpp"
+
+namespace XRT {
+
+    CompilationSession::CompilationSession(uint32_t threads) :
+        m_ThreadCount(threads ? threads : std::max(std::thread::hardware_concurrency(), 1u)), m_Design(CreateScope<Design>()) {
+    }
+
+    CompilationSession::~CompilationSession() {
+    }
+
+    bool CompilationSession::HasErrors() const {
+        return std::any_of(m_Diagnostics.begin(), m_Diagnostics.end(), [](auto& d) {
+            return d.severity == Diagnostic::Severity::ERROR;
+        });
+    }
+
+    void CompilationSession::LogDiagnostics() const {
+        std::deque<std::wstring> texts;
+        DiagnosticRenderer renderer;
+        AddSources(renderer, texts);
+
+        // one message per run of diagnostics of the same file
+        for (size_t first = 0, last; first < m_Diagnostics.size(); first = last) {
+            bool error = false;
+            std::string text;
+            for (last = first; last < m_Diagnostics.size() && m_Diagnostics[last].path == m_Diagnostics[first].path; last++) {
+                error |= m_Diagnostics[last].severity == Diagnostic::Severity::ERROR;
+                renderer.Render(m_Diagnostics[last], text);
+            }
+            text.pop_back();
+            if (error) {
+                LOG_ERROR("{}", text);
+            } else {
+                LOG_WARN("{}", text);
+            }
+        }
+    }
+
+    bool CompilationSession::WriteDiagnostics(const std::filesystem::path& path, DiagnosticRenderer::Format format) const {
+        std::deque<std::wstring> texts;
+        DiagnosticRenderer renderer;
+        AddSources(renderer, texts);
+        auto output = renderer.Render(m_Diagnostics, format);
+
+        std::ofstream file(path, std::ios::binary);
+        if (!file.write(output.data(), static_cast<std::streamsize>(output.size()))) {
+            LOG_ERROR("Failed to write diagnostics to \"{}\"", path.string());
+            return false;
+        }
+        return true;
+    }
+
+    void CompilationSession::AddSources(DiagnosticRenderer& renderer, std::deque<std::wstring>& texts) const {
+        for (auto source : m_RequestSourceFiles) {
+            if (!source->entry)
+                continue;
+            if (source->document) {
+                renderer.AddSource(source->entry->GetPath(), texts.emplace_back(source->document->GetText()));
+            } else {
+                renderer.AddSource(source->entry->GetPath(), source->entry->GetContent());
+            }
+            for (auto& file : source->includes) {
+                if (file->source)
+                    renderer.AddSource(file->path, file->source->GetContent());
+            }
+        }
+    }
+
+    Ref<AST> CompilationSession::GetAST(const std::filesystem::path& path) const {
+        auto it = m_Sources.find(IncludeCache::Resolve(path).generic_string());
+        return it == m_Sources.end() ? nullptr : it->second->GetAST();
+    }
+
+    bool CompilationSession::EditBuffer(const std::filesystem::path& path, size_t offset, size_t length, std::wstring_view text) {
+        XRT_PROFILE_SCOPE("CompilationSession::EditBuffer");
+        auto it = m_Sources.find(IncludeCache::Resolve(path).generic_string());
+        if (it == m_Sources.end() || !it->second->entry) {
+            LOG_ERROR("Edit of unknown source \"{}\"", path.string());
+            return false;
+        }
+
+        auto& source = *it->second;
+        if (!source.document) {
+            source.document = CreateScope<SourceDocument>(source.entry->GetPath(), &m_Includes);
+            source.document->Open(std::wstring{source.entry->GetContent()});
+            source.ast.reset();
+            source.parser.reset();
+            source.lexer.reset();
+        }
+
+        // the elaborator references declarations of the edited AST
+        m_Elaborator.reset();
+        m_DesignValid = false;
+
+        source.document->Edit(offset, length, text);
+        source.diagnostics = source.document->GetDiagnostics();
+        source.includes    = source.document->GetIncludes();
+        source.version     = ++m_LastVersion;
+        return true;
+    }
+
+    void CompilationSession::PruneSources() {
+        std::erase_if(m_Sources, [&](auto& e) {
+            return !m_RequestSourceIndex.contains(e.first);
+        });
+    }
+
+    void CompilationSession::LogStatistics() const {
+        auto kib = [](auto bytes) {
+            return static_cast<double>(bytes) / 1024.0;
+        };
+        LOG_INFO("[Stats] {:<10} {:>10} {:>14} {:>12} {:>13} {:>14} {:>10} {:>12}",
+                 "Phase",
+                 "Time ms",
+                 "Allocated KiB",
+                 "Allocations",
+                 "Retained KiB",
+                 "Peak heap KiB",
+                 "Outputs",
+                 "Bytes/output");
+        for (auto& phase : m_PhaseStatistics) {
+            auto per_output =
+                phase.outputs ? fmt::format("{:.1f}", static_cast<double>(phase.retained_bytes) / static_cast<double>(phase.outputs)) : "-";
+            LOG_INFO("[Stats] {:<10} {:>10.3f} {:>14.1f} {:>12} {:>13.1f} {:>14.1f} {:>10} {:>12}",
+                     phase.name,
+                     phase.seconds * 1000.0,
+                     kib(phase.allocated_bytes),
+                     phase.allocations,
+                     kib(phase.retained_bytes),
+                     kib(phase.peak_live_bytes),
+                     phase.outputs,
+                     per_output);
+        }
+
+        uint64_t tokens = 0;
+        uint64_t nodes  = 0;
+        for (auto source : m_RequestSourceFiles) {
+            if (source->document) {
+                tokens += source->document->GetTokens().size();
+            } else if (source->lexer) {
+                tokens += source->lexer->GetTokens().size();
+            }
+            if (auto ast = source->GetAST())
+                nodes += ast->CountNodes();
+        }
+        auto memory = MemoryStats::GetSnapshot();
+        LOG_INFO("[Stats] {} sources, {} tokens, {} AST nodes - heap {:.1f} KiB in {} blocks, peak RSS {:.1f} MiB",
+                 m_RequestSourceFiles.size(),
+                 tokens,
+                 nodes,
+                 kib(memory.live_bytes),
+                 memory.allocations - memory.frees,
+                 static_cast<double>(MemoryStats::GetPeakRSS()) / (1024.0 * 1024.0));
+    }
+
+    void CompilationSession::BeginPhase(const char* name) {
+        m_PhaseStatistics.push_back({name});
+        MemoryStats::ResetPeak();
+        m_PhaseStartMemory = MemoryStats::GetSnapshot();
+        m_PhaseStartTime   = std::chrono::steady_clock::now();
+    }
+
+    void CompilationSession::EndPhase() {
+        auto time             = std::chrono::steady_clock::now();
+        auto memory           = MemoryStats::GetSnapshot();
+        auto& phase           = m_PhaseStatistics.back();
+        phase.seconds         = std::chrono::duration<double>(time - m_PhaseStartTime).count();
+        phase.allocated_bytes = memory.allocated_bytes - m_PhaseStartMemory.allocated_bytes;
+        phase.allocations     = memory.allocations - m_PhaseStartMemory.allocations;
+        phase.retained_bytes  = memory.live_bytes - m_PhaseStartMemory.live_bytes;
+        phase.peak_live_bytes = memory.peak_live_bytes;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    bool CompilationSession::Compile(const CompileRequest& request) {
+        XRT_PROFILE_SCOPE("CompilationSession::Compile");
+        m_Statistics.requests++;
+        m_Diagnostics.clear();
+        m_PhaseStatistics.clear();
+        BeginPhase("load");
+
+        std::vector<SourceFile*> changed;
+        bool same_sources = request.changed && request.buffers.empty() && m_RequestSources.size() == request.files.size() &&
+                            std::equal(request.files.begin(), request.files.end(), m_RequestFiles.begin(), m_RequestFiles.end(), [](auto& a, auto& b) {
+                                return a.native() == b.native();
+                            });
+        if (same_sources) {
+            // same files as the last request - only the known changed ones and the sources including them are checked
+            std::unordered_set<std::string> known_changed;
+            for (auto& path : *request.changed) {
+                auto key = IncludeCache::Resolve(path).generic_string();
+                auto it  = m_RequestSourceIndex.find(key);
+                if (it != m_RequestSourceIndex.end())
+                    UpdateFile(*m_RequestSourceFiles[it->second], request.files[it->second], changed);
+                known_changed.insert(std::move(key));
+            }
+            for (size_t i = 0; i < m_RequestSourceFiles.size(); i++) {
+                auto& includes = m_RequestSourceFiles[i]->includes;
+                if (std::any_of(includes.begin(), includes.end(), [&](auto& file) {
+                        return known_changed.contains(file->path.generic_string());
+                    })) {
+                    UpdateFile(*m_RequestSourceFiles[i], request.files[i], changed);
+                }
+            }
+        } else {
+            std::unordered_set<std::string> known_changed;
+            if (request.changed) {
+                for (auto& path : *request.changed)
+                    known_changed.insert(IncludeCache::Resolve(path).generic_string());
+            }
+
+            auto previous = std::exchange(m_RequestSources, {});
+            m_RequestSourceFiles.clear();
+            m_RequestSourceIndex.clear();
+            for (auto& path : request.files) {
+                if (auto source = GetSourceFile(path)) {
+                    if (!request.changed || !source->entry || known_changed.contains(m_RequestSources.back()))
+                        UpdateFile(*source, path, changed);
+                }
+            }
+            for (auto& [path, content] : request.buffers) {
+                if (auto source = GetSourceFile(path))
+                    UpdateBuffer(*source, path, content, changed);
+            }
+            m_RequestFiles = request.files;
+            same_sources   = m_RequestSources == previous;
+        }
+
+        auto& sources = m_RequestSourceFiles;
+        if (request.stop_after != CompilePhase::LEX) {
+            // sources of a request that stopped after lexing were not parsed
+            for (auto source : sources) {
+                if (source->lexer && !source->parser && std::find(changed.begin(), changed.end(), source) == changed.end())
+                    changed.push_back(source);
+            }
+        }
+        EndPhase();
+
+        BeginPhase("lex");
+        ForEachSource(changed, [this](SourceFile& source) {
+            LexSource(source);
+        });
+        for (auto source : changed)
+            m_PhaseStatistics.back().outputs += source->lexer ? source->lexer->GetTokens().size() : 0;
+        EndPhase();
+
+        if (request.stop_after != CompilePhase::LEX) {
+            BeginPhase("parse");
+            ForEachSource(changed, [this](SourceFile& source) {
+                ParseSource(source);
+            });
+            EndPhase();
+            for (auto source : changed) {
+                if (source->ast)
+                    m_PhaseStatistics.back().outputs += source->ast->CountNodes();
+            }
+
+            // AST dumps in request order
+            for (auto source : changed) {
+                if (source->parser && source->parser->GetAST())
+                    source->parser->PrintAST();
+            }
+        }
+        m_Statistics.sources_parsed += changed.size();
+        m_Statistics.sources_reused += sources.size() - changed.size();
+
+        bool optimize = request.optimize && request.stop_after == CompilePhase::ALL;
+        DesignKey key{{}, request.top, request.parameters, optimize, request.coverage};
+        for (auto source : sources) {
+            key.sources.push_back(source->version);
+            m_Diagnostics.insert(m_Diagnostics.end(), source->diagnostics.begin(), source->diagnostics.end());
+        }
+
+        if (request.stop_after < CompilePhase::ELABORATE) {
+            LOG_DEBUG("[Session] Request {}: {} sources {}, {} reused",
+                      m_Statistics.requests,
+                      changed.size(),
+                      request.stop_after == CompilePhase::LEX ? "lexed" : "parsed",
+                      sources.size() - changed.size());
+            return !HasErrors();
+        }
+
+        if (m_DesignValid && key == m_DesignKey) {
+            m_Statistics.designs_reused++;
+            LOG_DEBUG("[Session] Request {}: {} sources reused, design reused", m_Statistics.requests, sources.size());
+        } else {
+            auto elaborated = m_Statistics.modules_elaborated;
+            auto reused     = m_Statistics.modules_reused;
+            Elaborate(request, std::move(key), sources, same_sources);
+            LOG_DEBUG("[Session] Request {}: {} sources parsed, {} reused - {} modules elaborated, {} reused",
+                      m_Statistics.requests,
+                      changed.size(),
+                      sources.size() - changed.size(),
+                      m_Statistics.modules_elaborated - elaborated,
+                      m_Statistics.modules_reused - reused);
+        }
+
+        return !HasErrors();
+    }
+
+    CompilationSession::SourceFile* CompilationSession::GetSourceFile(const std::filesystem::path& path) {
+        auto key = IncludeCache::Resolve(path).generic_string();
+        if (!m_RequestSourceIndex.try_emplace(key, m_RequestSources.size()).second)
+            return nullptr; // already part of this request
+
+        auto& source = m_Sources[key];
+        if (!source)
+            source = CreateScope<SourceFile>();
+        m_RequestSources.push_back(std::move(key));
+        m_RequestSourceFiles.push_back(source.get());
+        return source.get();
+    }
+
+    bool CompilationSession::UpdateFile(SourceFile& source, const std::filesystem::path& path, std::vector<SourceFile*>& changed) {
+        std::error_code ec;
+        auto write_time = std::filesystem::last_write_time(path, ec);
+        auto file_size  = ec ? 0 : std::filesystem::file_size(path, ec);
+        if (!ec && source.entry && write_time == source.write_time && file_size == source.file_size && !IncludesChanged(source))
+            return true;
+
+        std::ifstream file(path, std::ios::binary);
+        if (ec || !file.is_open()) {
+            source         = SourceFile{};
+            source.version = ++m_LastVersion;
+            source.diagnostics.push_back({Diagnostic::Severity::ERROR, fmt::format("Failed to open source file \"{}\"", path.string()), {}, path, 0, 0});
+            return false;
+        }
+
+        std::stringstream ss;
+        ss << file.rdbuf();
+        UpdateBuffer(source, path, ss.str(), changed);
+        source.write_time = write_time;
+        source.file_size  = file_size;
+        return true;
+    }
+
+    void CompilationSession::UpdateBuffer(SourceFile& source,
+                                          const std::filesystem::path& path,
+                                          const std::string& content,
+                                          std::vector<SourceFile*>& changed) {
+        auto hash = std::hash<std::string>{}(content);
+        if (source.entry && hash == source.hash && source.entry->GetPath() == path) {
+            if (!IncludesChanged(source))
+                return;
+            if (source.document) {
+                // keep the edited text
+                source.document->Open(source.document->GetText());
+                source.diagnostics = source.document->GetDiagnostics();
+                source.includes    = source.document->GetIncludes();
+                source.version     = ++m_LastVersion;
+                return;
+            }
+        }
+
+        source = SourceFile{};
+        std::wstring text(StringUtils::utf16_length(content), L'\0');
+        auto conversion = StringUtils::utf8_to_utf16(content, text.data());
+        if (!conversion.IsValid()) {
+            // invalid bytes were replaced - report the first one and keep going
+            auto line_start = content.rfind('\n', conversion.error);
+            line_start      = line_start == std::string::npos ? 0 : line_start + 1;
+            auto line       = static_cast<size_t>(std::count(content.begin(), content.begin() + static_cast<std::ptrdiff_t>(line_start), '\n')) + 1;
+            auto column     = StringUtils::utf16_length(std::string_view(content).substr(line_start, conversion.error - line_start)) + 1;
+            source.diagnostics.push_back({Diagnostic::Severity::WARNING,
+                                          fmt::format("Invalid UTF-8 at byte offset {} - replaced with U+FFFD", conversion.error),
+                                          {},
+                                          path,
+                                          line,
+                                          column});
+        }
+        source.entry   = CreateRef<SourceEntry>(std::move(text), path);
+        source.hash    = hash;
+        source.version = ++m_LastVersion;
+        changed.push_back(&source);
+    }
+
+    void CompilationSession::ForEachSource(const std::vector<SourceFile*>& sources, const std::function<void(SourceFile&)>& function) {
+        if (sources.size() > 1 && m_ThreadCount > 1) {
+            if (!m_Pool)
+                m_Pool = CreateScope<WorkerPool>(m_ThreadCount);
+            std::atomic<size_t> next{0};
+            m_Pool->Run([&](uint32_t) {
+                for (size_t i = next++; i < sources.size(); i = next++)
+                    function(*sources[i]);
+            });
+        } else {
+            for (auto source : sources)
+                function(*source);
+        }
+    }
+
+    bool CompilationSession::IncludesChanged(const SourceFile& source) {
+        return std::any_of(source.includes.begin(), source.includes.end(), [](auto& file) {
+            return !IncludeCache::IsCurrent(*file);
+        });
+    }
+
+    void CompilationSession::LexSource(SourceFile& source) {
+        if (source.lexer)
+            return; // lexed by a request that stopped after lexing
+        XRT_PROFILE_SCOPE("Frontend::Lex");
+        auto& path   = source.entry->GetPath();
+        source.lexer = CreateScope<Lexer>(source.entry);
+
+        try {
+            source.lexer->ProcessSource();
+        } catch (const Lexer::UnknownTokenException& e) {
+            auto content    = source.entry->GetContent();
+            auto before     = content.substr(0, content.size() - e.GetRemaining().size());
+            auto line_start = before.rfind(L'\n');
+            auto line       = static_cast<size_t>(std::count(before.begin(), before.end(), L'\n')) + 1;
+            auto column     = before.size() - (line_start == std::wstring_view::npos ? 0 : line_start + 1) + 1;
+            source.diagnostics.push_back({Diagnostic::Severity::ERROR, e.what(), e.GetSource(), path, line, column});
+            source.lexer.reset();
+        } catch (const std::exception& e) {
+            source.diagnostics.push_back({Diagnostic::Severity::ERROR, e.what(), {}, path, 0, 0});
+            source.lexer.reset();
+        }
+    }
+
+    void CompilationSession::ParseSource(SourceFile& source) {
+        if (!source.lexer)
+            return;
+        XRT_PROFILE_SCOPE("Frontend::Parse");
+        auto& path    = source.entry->GetPath();
+        source.parser = CreateScope<Parser>(&m_Includes);
+
+        try {
+            source.parser->Parse(source.lexer);
+            source.ast = source.parser->GetAST();
+        } catch (const Parser::ParseException& e) {
+            source.diagnostics.push_back({Diagnostic::Severity::ERROR, e.what(), {}, path, e.GetLine(), e.GetColumn()});
+        } catch (const std::exception& e) {
+            source.diagnostics.push_back({Diagnostic::Severity::ERROR, e.what(), {}, path, 0, 0});
+        }
+        source.includes = source.parser->GetPreprocessor().GetIncludes();
+    }
+
+    std::filesystem::path CompilationSession::GetTokenPath(const Token* token) const {
+        if (!token || !token->value.data())
+            return {};
+        auto contains = [&](std::wstring_view content) {
+            auto data = token->value.data();
+            return std::less_equal<>{}(content.data(), data) && std::less<>{}(data, content.data() + content.size());
+        };
+        for (auto source : m_RequestSourceFiles) {
+            if (source->entry && !source->document && contains(source->entry->GetContent()))
+                return source->entry->GetPath();
+            for (auto& file : source->includes) {
+                if (file->source && contains(file->source->GetContent()))
+                    return file->path;
+            }
+        }
+        return {};
+    }
+
+    void CompilationSession::Elaborate(const CompileRequest& request, DesignKey&& key, const std::vector<SourceFile*>& sources, bool update) {
+        XRT_PROFILE_SCOPE("CompilationSession::Elaborate");
+        BeginPhase("elaborate");
+
+        // the design is updated in place if it was elaborated from the same sources with the same settings
+        update = update && m_Elaborator && key.top == m_DesignKey.top && key.parameters == m_DesignKey.parameters &&
+                 key.optimize == m_DesignKey.optimize && key.coverage == m_DesignKey.coverage;
+        if (update) {
+            m_Statistics.designs_updated++;
+            for (size_t i = 0; i < sources.size(); i++) {
+                if (key.sources[i] != m_DesignKey.sources[i])
+                    m_Elaborator->ReplaceSource(static_cast<uint32_t>(i), sources[i]->GetAST());
+            }
+        } else {
+            m_Statistics.designs_created++;
+            m_Elaborator.reset();
+            m_Design     = CreateScope<Design>();
+            m_Elaborator = CreateScope<Elaborator>(m_Types, *m_Design);
+            m_Elaborator->SetCoverage(request.coverage);
+            for (auto source : sources)
+                m_Elaborator->AddSource(source->GetAST());
+        }
+        m_DesignKey   = std::move(key);
+        m_DesignValid = false;
+
+        // modules before this index are unchanged and already optimized
+        auto first_new = m_Design->GetModuleCount();
+        try {
+            if (request.top.empty()) {
+                m_Elaborator->ElaborateAll(request.parameters);
+            } else {
+                m_Design->SetTop(m_Elaborator->Elaborate(request.top, request.parameters));
+            }
+        } catch (const Elaborator::ElaborationError& e) {
+            m_Diagnostics.push_back({Diagnostic::Severity::ERROR, e.what(), {}, GetTokenPath(e.GetToken()), e.GetLine(), e.GetColumn()});
+            // components after the failed one were not elaborated - the next request starts over
+            m_Elaborator.reset();
+        }
+
+        m_Statistics.modules_elaborated += m_Design->GetModuleCount() - first_new;
+        m_Statistics.modules_reused += first_new;
+        EndPhase();
+
+        if (m_DesignKey.optimize) {
+            BeginPhase("optimize");
+            PassManager passes;
+            passes.AddDefaultPasses();
+            for (auto m = first_new; m < m_Design->GetModuleCount(); m++) {
+                passes.Run(m_Design->GetModule(m));
+            }
+            EndPhase();
+        }
+
+        // a design with source errors is rebuilt on every request so the errors are reported again
+        m_DesignValid = !HasErrors();
+    }
+
+} // namespace XRT
@@ -0,0 +1,205 @@
+#pragma once
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <Utils.hpp>
+#include "Compiler/DiagnosticRenderer.hpp"
+#include "Diagnostic.hpp"
+#include "Language/AST.hpp"
+#include "Language/Lexer.hpp"
+#include "Language/Parser.hpp"
+#include "Language/Preprocessor.hpp"
+#include "Language/SourceDocument.hpp"
+#include "Language/SourceEntry.hpp"
+#include "Language/TypeContext.hpp"
+#include "MemoryStats.hpp"
+#include "Netlist/Elaborator.hpp"
+#include "Netlist/Netlist.hpp"
+#include "Simulation/WorkerPool.hpp"
+
+namespace XRT {
+
+    /// Last phase run by a compile request
+    enum class CompilePhase : uint8_t {
+        LEX,
+        PARSE,
+        ELABORATE, // without optimization
+        ALL,
+    };
+
+    /// Sources and elaboration settings of one compile
+    struct CompileRequest {
+        std::vector<std::filesystem::path> files;
+        std::vector<std::pair<std::filesystem::path, std::string>> buffers; // in-memory sources - path only names the source
+        std::optional<std::vector<std::filesystem::path>> changed;          // known changed files (watch mode) - other loaded files are not checked on disk
+        std::wstring top;                                                    // empty - elaborate all components
+        ParameterMap parameters;
+        bool optimize = true;
+        bool coverage = false;
+        CompilePhase stop_after = CompilePhase::ALL;
+    };
+
+    /// Long-lived compiler state for repeated compile requests.
+    /// Parsed sources are cached by path and reused while unchanged (size and write time for files, content for buffers,
+    /// and the files they got macros from), types stay interned between requests and a repeated request over unchanged
+    /// sources keeps the previous design.
+    /// If only source contents changed the design is updated in place - components whose declaration or base components
+    /// changed are elaborated and optimized again.
+    class CompilationSession {
+    public:
+        struct Statistics {
+            uint64_t requests           = 0;
+            uint64_t sources_parsed     = 0;
+            uint64_t sources_reused     = 0;
+            uint64_t designs_reused     = 0;
+            uint64_t designs_created    = 0;
+            uint64_t designs_updated    = 0;
+            uint64_t modules_elaborated = 0;
+            uint64_t modules_reused     = 0;
+        };
+
+        /// Wall time and heap use of one phase of the last request - heap values are 0 unless MemoryStats counting is enabled
+        struct PhaseStatistics {
+            const char* name;
+            double seconds           = 0;
+            uint64_t allocated_bytes = 0;
+            uint64_t allocations     = 0;
+            int64_t retained_bytes   = 0; // still allocated at the end of the phase
+            int64_t peak_live_bytes  = 0; // whole heap
+            uint64_t outputs         = 0; // tokens of the lex phase, AST nodes of the parse phase
+        };
+
+    public:
+        /// threads - parser threads for requests with several changed sources (0 - hardware concurrency)
+        CompilationSession(uint32_t threads = 0);
+        ~CompilationSession();
+
+        CompilationSession(const CompilationSession&)            = delete;
+        CompilationSession& operator=(const CompilationSession&) = delete;
+
+        /// Parse changed sources, elaborate and optimize. Sources that fail to parse are left out of elaboration.
+        /// Returns false if the request produced any error diagnostic. The design stays valid until the next Compile.
+        bool Compile(const CompileRequest& request);
+
+        Design& GetDesign() {
+            return *m_Design;
+        }
+        const Design& GetDesign() const {
+            return *m_Design;
+        }
+
+        TypeContext& GetTypes() {
+            return m_Types;
+        }
+
+        /// Diagnostics of the last request - includes cached diagnostics of unchanged sources
+        const std::vector<Diagnostic>& GetDiagnostics() const {
+            return m_Diagnostics;
+        }
+        bool HasErrors() const;
+
+        /// Log diagnostics of the last request with source snippets - one message per file
+        void LogDiagnostics() const;
+        /// Write diagnostics of the last request to a file as JSON or SARIF
+        bool WriteDiagnostics(const std::filesystem::path& path, DiagnosticRenderer::Format format) const;
+
+        /// Replace length UTF-16 code units at offset in a loaded source - only the touched declarations are reparsed.
+        /// The edited text is used by following requests until the file or buffer content of the source changes.
+        bool EditBuffer(const std::filesystem::path& path, size_t offset, size_t length, std::wstring_view text);
+
+        /// Cached AST of a source, nullptr if not loaded or if it failed to parse
+        Ref<AST> GetAST(const std::filesystem::path& path) const;
+
+        /// Drop cached sources that were not part of the last request
+        void PruneSources();
+
+        const Statistics& GetStatistics() const {
+            return m_Statistics;
+        }
+        const std::vector<PhaseStatistics>& GetPhaseStatistics() const {
+            return m_PhaseStatistics;
+        }
+
+        /// Log phases of the last request with token and AST node counts of its sources and the peak RSS of the process
+        void LogStatistics() const;
+
+    private:
+        struct SourceFile {
+            Ref<SourceEntry> entry;
+            Scope<Lexer> lexer;
+            Scope<Parser> parser;
+            Ref<AST> ast;
+            Scope<SourceDocument> document; // incremental state, created by the first EditBuffer
+            std::vector<Ref<const IncludeCache::File>> includes; // files the source got macros from
+            std::vector<Diagnostic> diagnostics;
+            std::filesystem::file_time_type write_time{};
+            uintmax_t file_size = 0;
+            size_t hash         = 0; // content hash
+            uint64_t version    = 0; // unique in the session, changed on every reparse
+
+            Ref<AST> GetAST() const {
+                if (document)
+                    return document->HasErrors() ? nullptr : document->GetAST();
+                return ast;
+            }
+        };
+
+        /// Elaboration inputs of the current design
+        struct DesignKey {
+            std::vector<uint64_t> sources; // versions - unique in the session, so they also identify the path
+            std::wstring top;
+            ParameterMap parameters;
+            bool optimize = true;
+            bool coverage = false;
+
+            bool operator==(const DesignKey& other) const = default;
+        };
+
+        /// nullptr if the path is already part of the current request
+        SourceFile* GetSourceFile(const std::filesystem::path& path);
+        bool UpdateFile(SourceFile& source, const std::filesystem::path& path, std::vector<SourceFile*>& changed);
+        void UpdateBuffer(SourceFile& source, const std::filesystem::path& path, const std::string& content, std::vector<SourceFile*>& changed);
+        /// Run function for every source - in parallel if there are several
+        void ForEachSource(const std::vector<SourceFile*>& sources, const std::function<void(SourceFile&)>& function);
+        void LexSource(SourceFile& source);
+        /// Sources that failed to lex are skipped
+        void ParseSource(SourceFile& source);
+        void BeginPhase(const char* name);
+        void EndPhase();
+        /// Texts of the request sources and their included files for snippets - texts holds copies of edited sources
+        void AddSources(DiagnosticRenderer& renderer, std::deque<std::wstring>& texts) const;
+        /// Source or included file the token was lexed from - empty if not found
+        std::filesystem::path GetTokenPath(const Token* token) const;
+        /// An included file of the source changed on disk
+        static bool IncludesChanged(const SourceFile& source);
+        /// update - same sources as the elaborated design, only their contents may have changed
+        void Elaborate(const CompileRequest& request, DesignKey&& key, const std::vector<SourceFile*>& sources, bool update);
+
+    private:
+        uint32_t m_ThreadCount;
+        Scope<WorkerPool> m_Pool; // created on first parallel parse
+        TypeContext m_Types;
+        IncludeCache m_Includes;
+        std::unordered_map<std::string, Scope<SourceFile>> m_Sources; // [resolved path]
+        std::vector<std::filesystem::path> m_RequestFiles;            // files of the last request as given
+        std::vector<std::string> m_RequestSources;                    // sources of the last request in order
+        std::vector<SourceFile*> m_RequestSourceFiles;                // [request source]
+        std::unordered_map<std::string, size_t> m_RequestSourceIndex; // [normalized path] -> request source
+        uint64_t m_LastVersion = 0;
+        Scope<Design> m_Design;
+        Scope<Elaborator> m_Elaborator;
+        DesignKey m_DesignKey;
+        bool m_DesignValid = false;
+        std::vector<Diagnostic> m_Diagnostics;
+        Statistics m_Statistics;
+        std::vector<PhaseStatistics> m_PhaseStatistics; // of the last request
+        std::chrono::steady_clock::time_point m_PhaseStartTime;
+        MemoryStats::Snapshot m_PhaseStartMemory;
+    };
+
+} // namespace XRT
@@ -0,0 +1,190 @@
+#include "DiagnosticRenderer.hpp"
+#include <algorithm>
+#include <iterator>
+#include <spdlog/fmt/fmt.h>
+#include "Profiler.hpp"
+#include "Server/Json.hpp"
+#include "StringUtils.hpp"
+
+namespace XRT {
+
+    namespace {
+
+        const char* SeverityName(Diagnostic::Severity severity) {
+            return severity == Diagnostic::Severity::ERROR ? "error" : "warning";
+        }
+
+        void AppendUTF8(std::string& out, std::wstring_view text) {
+            auto size = out.size();
+            out.resize(size + StringUtils::utf8_length(text));
+            StringUtils::utf16_to_utf8(text, out.data() + size);
+        }
+
+        bool IsWordCharacter(wchar_t c) {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+        }
+
+    } // namespace
+
+    void DiagnosticRenderer::AddSource(const std::filesystem::path& path, std::wstring_view text) {
+        m_Sources[path.string()] = Source{text, {}};
+        m_LastSource = nullptr;
+        m_LastPath.clear();
+    }
+
+    std::optional<std::wstring_view> DiagnosticRenderer::GetLine(const std::filesystem::path& path, size_t line) {
+        if (!m_LastSource || path.native() != m_LastPath.native()) {
+            auto it = m_Sources.find(path.string());
+            if (it == m_Sources.end())
+                return std::nullopt;
+            m_LastSource = &it->second;
+            m_LastPath   = path;
+        }
+
+        auto& source = *m_LastSource;
+        if (source.line_starts.empty()) {
+            source.line_starts.push_back(0);
+            for (size_t i = source.text.find('\n'); i != std::wstring_view::npos; i = source.text.find('\n', i + 1))
+                source.line_starts.push_back(i + 1);
+        }
+        if (line == 0 || line > source.line_starts.size())
+            return std::nullopt;
+
+        auto begin = source.line_starts[line - 1];
+        auto end   = line < source.line_starts.size() ? source.line_starts[line] - 1 : source.text.size();
+        if (end > begin && source.text[end - 1] == '\r')
+            end--;
+        return source.text.substr(begin, end - begin);
+    }
+
+    size_t DiagnosticRenderer::GetUnderlineLength(std::wstring_view line, size_t column) {
+        size_t end = column;
+        while (end < line.size() && IsWordCharacter(line[end]))
+            end++;
+        return std::max<size_t>(end - column, 1);
+    }
+
+    void DiagnosticRenderer::Render(const Diagnostic& diagnostic, std::string& out) {
+        auto inserter = std::back_inserter(out);
+        if (!diagnostic.path.empty()) {
+            out += diagnostic.path.string();
+            if (diagnostic.line)
+                fmt::format_to(inserter, ":{}:{}", diagnostic.line, diagnostic.column);
+            out += ": ";
+        } else if (diagnostic.line) {
+            fmt::format_to(inserter, "{}:{}: ", diagnostic.line, diagnostic.column);
+        }
+        fmt::format_to(inserter, "{}: {}\n", SeverityName(diagnostic.severity), diagnostic.message);
+
+        auto line = diagnostic.path.empty() ? std::nullopt : GetLine(diagnostic.path, diagnostic.line);
+        if (!line) {
+            if (!diagnostic.detail.empty())
+                fmt::format_to(inserter, "    {}\n", diagnostic.detail);
+            return;
+        }
+
+        // cut long lines so the column stays in view
+        auto column = std::min(diagnostic.column ? diagnostic.column - 1 : 0, line->size());
+        size_t begin = 0;
+        if (line->size() > MAX_SNIPPET_WIDTH && column > MAX_SNIPPET_WIDTH / 2)
+            begin = std::min(column - MAX_SNIPPET_WIDTH / 2, line->size() - MAX_SNIPPET_WIDTH);
+        auto shown = line->substr(begin, MAX_SNIPPET_WIDTH);
+
+        auto gutter = out.size();
+        fmt::format_to(inserter, "{:>5} | ", diagnostic.line);
+        gutter = out.size() - gutter;
+        if (begin)
+            out += "...";
+        AppendUTF8(out, shown);
+        if (begin + shown.size() < line->size())
+            out += "...";
+        out += '\n';
+
+        // tabs are kept so the caret lines up with the source however wide they are shown
+        out.append(gutter - 2, ' ');
+        out += "| ";
+        if (begin)
+            out += "   ";
+        for (auto i = begin; i < column; i++)
+            out += (*line)[i] == '\t' ? '\t' : ' ';
+        out += '^';
+        auto underline = std::min(GetUnderlineLength(*line, column), begin + shown.size() - column);
+        out.append(underline > 1 ? underline - 1 : 0, '~');
+        out += '\n';
+    }
+
+    std::string DiagnosticRenderer::Render(const std::vector<Diagnostic>& diagnostics, Format format) {
+        XRT_PROFILE_SCOPE("DiagnosticRenderer::Render");
+        switch (format) {
+            case Format::JSON: return RenderJson(diagnostics);
+            case Format::SARIF: return RenderSarif(diagnostics);
+            default: break;
+        }
+
+        std::string out;
+        for (auto& diagnostic : diagnostics)
+            Render(diagnostic, out);
+        return out;
+    }
+
+    std::string DiagnosticRenderer::RenderJson(const std::vector<Diagnostic>& diagnostics) {
+        auto results = Json::Array();
+        for (auto& d : diagnostics) {
+            auto result = Json::Object();
+            result.Set("severity", SeverityName(d.severity)).Set("message", d.message);
+            if (!d.detail.empty())
+                result.Set("detail", d.detail);
+            if (!d.path.empty())
+                result.Set("path", d.path.generic_string());
+            if (d.line)
+                result.Set("line", d.line).Set("column", d.column);
+            results.Push(std::move(result));
+        }
+        return results.Dump();
+    }
+
+    std::string DiagnosticRenderer::RenderSarif(const std::vector<Diagnostic>& diagnostics) {
+        auto results = Json::Array();
+        for (auto& d : diagnostics) {
+            auto message = Json::Object();
+            message.Set("text", d.detail.empty() ? d.message : d.message + ": " + d.detail);
+            auto result = Json::Object();
+            result.Set("level", SeverityName(d.severity)).Set("message", std::move(message));
+            if (!d.path.empty()) {
+                auto artifact = Json::Object();
+                artifact.Set("uri", d.path.generic_string());
+                auto location = Json::Object();
+                location.Set("artifactLocation", std::move(artifact));
+                if (d.line) {
+                    auto region = Json::Object();
+                    region.Set("startLine", d.line);
+                    if (d.column) {
+                        region.Set("startColumn", d.column);
+                        if (auto line = GetLine(d.path, d.line); line && d.column <= line->size())
+                            region.Set("endColumn", d.column + GetUnderlineLength(*line, d.column - 1));
+                    }
+                    location.Set("region", std::move(region));
+                }
+                auto physical = Json::Object();
+                physical.Set("physicalLocation", std::move(location));
+                auto locations = Json::Array();
+                locations.Push(std::move(physical));
+                result.Set("locations", std::move(locations));
+            }
+            results.Push(std::move(result));
+        }
+
+        auto driver = Json::Object();
+        driver.Set("name", CFXS_PROGRAM_NAME).Set("version", CFXS_VERSION_STRING);
+        auto tool = Json::Object();
+        tool.Set("driver", std::move(driver));
+        auto run = Json::Object();
+        run.Set("tool", std::move(tool)).Set("results", std::move(results));
+        auto runs = Json::Array();
+        runs.Push(std::move(run));
+        auto log = Json::Object();
+        log.Set("version", "2.1.0").Set("$schema", "https://json.schemastore.org/sarif-2.1.0.json").Set("runs", std::move(runs));
+        return log.Dump();
+    }
+
+} // namespace XRT
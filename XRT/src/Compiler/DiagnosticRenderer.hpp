@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Diagnostic.hpp"
+
+namespace XRT {
+
+    /// Formats diagnostics for people - clang style "path:line:column: error: message" followed by the source line and a
+    /// caret under the column - or as a JSON array or a SARIF 2.1.0 log for tools.
+    /// Line starts of a source are indexed once, by the first diagnostic that needs a snippet from it.
+    class DiagnosticRenderer {
+    public:
+        enum class Format : uint8_t {
+            TEXT,
+            JSON,
+            SARIF,
+        };
+
+        static constexpr size_t MAX_SNIPPET_WIDTH = 160; // longer source lines are cut around the column
+
+    public:
+        /// Source text for snippets of diagnostics with this path - the text must outlive the renderer
+        void AddSource(const std::filesystem::path& path, std::wstring_view text);
+
+        /// Append the text of one diagnostic, ending with a newline
+        void Render(const Diagnostic& diagnostic, std::string& out);
+        /// All diagnostics as one document
+        std::string Render(const std::vector<Diagnostic>& diagnostics, Format format);
+
+    private:
+        struct Source {
+            std::wstring_view text;
+            std::vector<size_t> line_starts; // built on first use
+        };
+
+        /// Line of a known source without its line break - nullopt if the source is unknown or shorter
+        std::optional<std::wstring_view> GetLine(const std::filesystem::path& path, size_t line);
+        /// Characters underlined from column - the rest of a word, 1 otherwise
+        static size_t GetUnderlineLength(std::wstring_view line, size_t column);
+
+        std::string RenderJson(const std::vector<Diagnostic>& diagnostics);
+        std::string RenderSarif(const std::vector<Diagnostic>& diagnostics);
+
+    private:
+        std::unordered_map<std::string, Source> m_Sources; // [path]
+        Source* m_LastSource = nullptr;                     // diagnostics of one file are usually adjacent
+        std::filesystem::path m_LastPath;
+    };
+
+} // namespace XRT
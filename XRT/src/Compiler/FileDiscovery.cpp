@@ -0,0 +1,405 @@
+#include "FileDiscovery.hpp"
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <Log/Logger.hpp>
+#include "Profiler.hpp"
+#include "Simulation/WorkerPool.hpp"
+#if defined(CFXS_PLATFORM_LINUX)
+    #include <dirent.h>
+    #include <sys/stat.h>
+#endif
+
+namespace XRT {
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // GlobPattern
+
+    GlobPattern::GlobPattern(std::string_view pattern) {
+        size_t position = 0;
+        bool star       = false;
+        for (size_t i = 0; i < pattern.size();) {
+            char c = pattern[i];
+            if (c == '*' && star) {
+                i++; // "**" within a segment is the same as "*"
+                continue;
+            }
+            if (position == MAX_POSITIONS)
+                return;
+
+            uint64_t bit = uint64_t{1} << position++;
+            star         = c == '*';
+            if (c == '*' || c == '?') {
+                for (auto& mask : m_Masks)
+                    mask |= bit;
+                if (star)
+                    m_Stars |= bit;
+                i++;
+            } else if (c == '[') {
+                // [abc] [a-z] [!a-z] [^a-z] - ']' first in the set is a member
+                size_t end = i + 1;
+                bool negate = end < pattern.size() && (pattern[end] == '!' || pattern[end] == '^');
+                if (negate)
+                    end++;
+                size_t first = end;
+                while (end < pattern.size() && (pattern[end] != ']' || end == first))
+                    end++;
+                if (end == pattern.size())
+                    return; // unterminated
+
+                std::array<bool, 256> set{};
+                for (size_t j = first; j < end; j++) {
+                    auto from = static_cast<unsigned char>(pattern[j]);
+                    auto to   = from;
+                    if (j + 2 < end && pattern[j + 1] == '-') {
+                        to = static_cast<unsigned char>(pattern[j + 2]);
+                        j += 2;
+                    }
+                    for (unsigned ch = from; ch <= to; ch++)
+                        set[ch] = true;
+                }
+                for (size_t ch = 0; ch < set.size(); ch++) {
+                    if (set[ch] != negate)
+                        m_Masks[ch] |= bit;
+                }
+                i = end + 1;
+            } else {
+                m_Masks[static_cast<unsigned char>(c)] |= bit;
+                i++;
+            }
+        }
+
+        m_Accept = position ? uint64_t{1} << (position - 1) : 0;
+        m_Valid  = true;
+    }
+
+    bool GlobPattern::Match(std::string_view name) const {
+        if (!m_Accept)
+            return name.empty();
+
+        // bit i - pattern matched through position i, "*" positions also match no character
+        uint64_t state = m_Stars & 1;
+        uint64_t start = 1;
+        for (char c : name) {
+            state = (((state << 1) | start) & m_Masks[static_cast<unsigned char>(c)]) | (state & m_Stars);
+            state |= (state << 1) & m_Stars;
+            start = 0;
+            if (!state)
+                return false;
+        }
+        return state & m_Accept;
+    }
+
+    bool GlobPattern::IsWildcard(std::string_view pattern) {
+        return pattern.find_first_of("*?[") != std::string_view::npos;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // PathGlob
+
+    /// Call fn for every non-empty '/' separated segment - stops when fn returns false
+    template<typename Fn>
+    static void ForEachSegment(std::string_view path, Fn&& fn) {
+        while (!path.empty()) {
+            auto end     = path.find('/');
+            auto segment = path.substr(0, end);
+            if (!segment.empty() && !fn(segment))
+                return;
+            path = end == std::string_view::npos ? std::string_view{} : path.substr(end + 1);
+        }
+    }
+
+    PathGlob::PathGlob(std::string_view pattern) {
+        bool valid = true;
+        ForEachSegment(pattern, [&](std::string_view segment) {
+            Segment s;
+            s.recursive = segment == "**";
+            if (s.recursive && !m_Segments.empty() && m_Segments.back().recursive)
+                return true;
+            if (!s.recursive) {
+                s.wildcard = GlobPattern::IsWildcard(segment);
+                if (s.wildcard) {
+                    s.glob = GlobPattern(segment);
+                    valid &= s.glob.IsValid();
+                } else {
+                    s.literal = segment;
+                }
+            }
+            m_Segments.push_back(std::move(s));
+            return true;
+        });
+        m_Valid = valid && !m_Segments.empty() && m_Segments.size() <= MAX_SEGMENTS;
+    }
+
+    PathGlob::State PathGlob::Close(State state) const {
+        for (size_t i = 0; i < m_Segments.size(); i++) {
+            if ((state >> i & 1) && m_Segments[i].recursive)
+                state |= State{1} << (i + 1);
+        }
+        return state;
+    }
+
+    PathGlob::State PathGlob::Step(State state, std::string_view name) const {
+        State next = 0;
+        for (auto active = state & ~Accept(); active; active &= active - 1) {
+            auto i  = static_cast<size_t>(std::countr_zero(active));
+            auto& s = m_Segments[i];
+            if (s.recursive) {
+                next |= State{1} << i;
+            } else if (s.wildcard ? s.glob.Match(name) : s.literal == name) {
+                next |= State{1} << (i + 1);
+            }
+        }
+        return Close(next);
+    }
+
+    bool PathGlob::IsRecursive(State state) const {
+        for (auto active = state & ~Accept(); active; active &= active - 1) {
+            if (m_Segments[static_cast<size_t>(std::countr_zero(active))].recursive)
+                return true;
+        }
+        return false;
+    }
+
+    bool PathGlob::Match(std::string_view path) const {
+        auto state = Start();
+        ForEachSegment(path, [&](std::string_view segment) {
+            state = Step(state, segment);
+            return state != 0;
+        });
+        return IsMatch(state);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // ExcludeList
+
+    bool ExcludeList::AddPattern(std::string_view pattern) {
+        while (!pattern.empty() && std::isspace(static_cast<unsigned char>(pattern.back())))
+            pattern.remove_suffix(1);
+        if (pattern.empty() || pattern.front() == '#')
+            return true;
+
+        Rule rule;
+        if (pattern.front() == '!') {
+            rule.negate = true;
+            pattern.remove_prefix(1);
+        }
+        if (!pattern.empty() && pattern.back() == '/') {
+            rule.directory_only = true;
+            pattern.remove_suffix(1);
+        }
+        rule.anchored = pattern.find('/') != std::string_view::npos;
+        if (!pattern.empty() && pattern.front() == '/')
+            pattern.remove_prefix(1);
+        if (pattern.empty())
+            return true;
+
+        rule.glob = PathGlob(pattern);
+        if (!rule.glob.IsValid())
+            return false;
+        m_Rules.push_back(std::move(rule));
+        return true;
+    }
+
+    bool ExcludeList::LoadFile(const std::filesystem::path& path) {
+        std::ifstream file(path);
+        if (!file.is_open())
+            return false;
+        std::string line;
+        while (std::getline(file, line)) {
+            if (!AddPattern(line))
+                LOG_WARN("Invalid exclude pattern \"{}\" in \"{}\"", line, path.string());
+        }
+        return true;
+    }
+
+    bool ExcludeList::IsExcluded(std::string_view path, std::string_view name, bool directory) const {
+        bool excluded = false;
+        for (auto& rule : m_Rules) {
+            if (excluded != rule.negate || (rule.directory_only && !directory))
+                continue; // can not change the result
+            if (rule.anchored ? rule.glob.Match(path) : rule.glob.Match(name))
+                excluded = !rule.negate;
+        }
+        return excluded;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // FileDiscovery
+
+    /// Directories waiting to be scanned - shared by the walk threads
+    struct FileDiscovery::Walk {
+        const PathGlob& glob;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::vector<std::pair<std::string, PathGlob::State>> pending;
+        uint32_t active = 0; // directories being scanned
+    };
+
+    FileDiscovery::FileDiscovery(uint32_t threads) : m_ThreadCount(threads ? threads : std::max(std::thread::hardware_concurrency(), 1u)) {
+    }
+
+    FileDiscovery::~FileDiscovery() {
+    }
+
+    bool FileDiscovery::Add(std::string_view pattern) {
+        auto normalized = std::filesystem::path{pattern}.lexically_normal().generic_string();
+        if (!GlobPattern::IsWildcard(normalized)) {
+            std::filesystem::path file{normalized};
+            m_Directories.push_back(file.has_parent_path() ? file.parent_path() : std::filesystem::path{"."});
+            m_Files.push_back(std::move(file));
+            return true;
+        }
+
+        XRT_PROFILE_SCOPE("FileDiscovery::Add");
+
+        // literal leading segments are the base directory of the walk
+        auto separator = normalized.rfind('/', normalized.find_first_of("*?["));
+        auto base      = separator == std::string::npos ? std::string{} : normalized.substr(0, separator ? separator : 1);
+        PathGlob glob{separator == std::string::npos ? std::string_view{normalized} : std::string_view{normalized}.substr(separator + 1)};
+        if (!glob.IsValid()) {
+            LOG_ERROR("Invalid pattern \"{}\"", normalized);
+            return false;
+        }
+        std::error_code ec;
+        if (!std::filesystem::is_directory(base.empty() ? "." : base, ec)) {
+            LOG_ERROR("Directory not found: \"{}\"", base);
+            return false;
+        }
+
+        // "**" walks are spread over the pool, others rarely see more than a few directories
+        bool parallel = normalized.find("**") != std::string::npos;
+        if (parallel && m_ThreadCount > 1 && !m_Pool)
+            m_Pool = CreateScope<WorkerPool>(m_ThreadCount);
+        uint32_t workers = parallel && m_Pool ? m_Pool->GetCount() : 1;
+
+        Walk walk{glob, {}, {}, {{base, glob.Start()}}};
+        std::vector<std::vector<Listing>> listings(workers);
+        auto job = [&](uint32_t worker) {
+            std::unique_lock lock(walk.mutex);
+            while (true) {
+                walk.wake.wait(lock, [&] {
+                    return !walk.pending.empty() || walk.active == 0;
+                });
+                if (walk.pending.empty())
+                    return; // nothing pending or being scanned
+
+                auto [directory, state] = std::move(walk.pending.back());
+                walk.pending.pop_back();
+                walk.active++;
+                lock.unlock();
+                Scan(walk, directory, state, listings[worker]);
+                lock.lock();
+                if (--walk.active == 0 && walk.pending.empty())
+                    walk.wake.notify_all();
+            }
+        };
+        if (workers > 1) {
+            m_Pool->Run(job);
+        } else {
+            job(0);
+        }
+
+        // walk order depends on thread timing - sorted by directory, then by name
+        std::vector<Listing> found;
+        for (auto& l : listings)
+            found.insert(found.end(), std::make_move_iterator(l.begin()), std::make_move_iterator(l.end()));
+        std::sort(found.begin(), found.end(), [](const Listing& a, const Listing& b) {
+            return a.directory < b.directory;
+        });
+        for (auto& listing : found) {
+            std::sort(listing.files.begin(), listing.files.end());
+            m_Files.insert(m_Files.end(), std::make_move_iterator(listing.files.begin()), std::make_move_iterator(listing.files.end()));
+            m_Directories.emplace_back(std::move(listing.directory));
+        }
+        return true;
+    }
+
+    void FileDiscovery::Scan(Walk& walk, const std::string& directory, PathGlob::State state, std::vector<Listing>& listings) {
+        std::vector<std::string> files;
+        std::vector<std::pair<std::string, PathGlob::State>> subdirectories;
+        std::string path;
+
+        // directory links are not followed by "**" - links to a parent would never end
+        bool recursive = walk.glob.IsRecursive(state);
+        auto visit     = [&](std::string_view name, bool is_directory, bool is_file, bool is_link) {
+            auto next = walk.glob.Step(state, name);
+            if (!next)
+                return;
+
+            path.assign(directory);
+            if (!path.empty() && path.back() != '/')
+                path += '/';
+            path += name;
+            if (m_Excludes && m_Excludes->IsExcluded(path, name, is_directory))
+                return;
+
+            if (is_file && walk.glob.IsMatch(next))
+                files.push_back(path);
+            if (is_directory && walk.glob.CanContinue(next) && !(is_link && recursive))
+                subdirectories.emplace_back(path, next);
+        };
+
+#if defined(CFXS_PLATFORM_LINUX)
+        auto handle = opendir(directory.empty() ? "." : directory.c_str());
+        if (!handle)
+            return;
+        while (auto entry = readdir(handle)) {
+            std::string_view name = entry->d_name;
+            if (name == "." || name == "..")
+                continue;
+
+            if (entry->d_type == DT_LNK || entry->d_type == DT_UNKNOWN) {
+                // type of the link target - only for names that can still match
+                if (!walk.glob.Step(state, name))
+                    continue;
+                struct stat info;
+                auto target = (directory.empty() ? std::string{} : directory + "/") + entry->d_name;
+                if (stat(target.c_str(), &info))
+                    continue;
+                visit(name, S_ISDIR(info.st_mode), S_ISREG(info.st_mode), entry->d_type == DT_LNK);
+            } else {
+                visit(name, entry->d_type == DT_DIR, entry->d_type == DT_REG, false);
+            }
+        }
+        closedir(handle);
+#else
+        std::error_code ec;
+        for (auto& entry : std::filesystem::directory_iterator(directory.empty() ? "." : directory, ec)) {
+            auto name = entry.path().filename().string();
+            visit(name, entry.is_directory(ec), entry.is_regular_file(ec), entry.is_symlink(ec));
+        }
+#endif
+
+        listings.push_back({directory.empty() ? "." : directory, std::move(files)});
+        if (subdirectories.empty())
+            return;
+        std::lock_guard lock(walk.mutex);
+        walk.pending.insert(walk.pending.end(), std::make_move_iterator(subdirectories.begin()), std::make_move_iterator(subdirectories.end()));
+        walk.wake.notify_all();
+    }
+
+    bool FileDiscovery::ReadResponseFile(const std::filesystem::path& path, std::vector<std::string>& inputs) {
+        std::ifstream file(path);
+        if (!file.is_open())
+            return false;
+
+        std::string line;
+        while (std::getline(file, line)) {
+            auto first = line.find_first_not_of(" \t\r");
+            if (first == std::string::npos || line[first] == '#')
+                continue;
+            auto last = line.find_last_not_of(" \t\r");
+            std::string_view input{line.data() + first, last - first + 1};
+            if (input.size() >= 2 && input.front() == '"' && input.back() == '"')
+                input = input.substr(1, input.size() - 2);
+            inputs.emplace_back(input);
+        }
+        return true;
+    }
+
+} // namespace XRT
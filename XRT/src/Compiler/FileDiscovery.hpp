@@ -0,0 +1,172 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <Utils.hpp>
+
+namespace XRT {
+
+    class WorkerPool;
+
+    /// Wildcard pattern for one path segment - "*" any characters, "?" one character, "[abc]" "[a-z]" "[!a-z]" sets.
+    /// Compiled to a bit-parallel automaton (one bit per pattern position), so matching is linear in the name length.
+    class GlobPattern {
+    public:
+        static constexpr size_t MAX_POSITIONS = 63;
+
+    public:
+        GlobPattern() = default;
+        explicit GlobPattern(std::string_view pattern);
+
+        /// False if the pattern has more than MAX_POSITIONS non-"*" positions or an unterminated set
+        bool IsValid() const {
+            return m_Valid;
+        }
+
+        bool Match(std::string_view name) const;
+
+        /// Pattern contains * ? or [
+        static bool IsWildcard(std::string_view pattern);
+
+    private:
+        std::array<uint64_t, 256> m_Masks{}; // [character] -> positions accepting it
+        uint64_t m_Stars  = 0;               // "*" positions - accept any character repeatedly or nothing
+        uint64_t m_Accept = 0;               // last position
+        bool m_Valid      = false;
+    };
+
+    /// Path pattern of '/' separated segments - literal names, GlobPattern segments and "**" for any number of segments.
+    /// Matched one segment at a time, so a directory walk can carry the match state to its subdirectories.
+    class PathGlob {
+    public:
+        using State = uint64_t; // active segment positions, bit count - whole pattern matched
+
+        static constexpr size_t MAX_SEGMENTS = 63;
+
+    public:
+        PathGlob() = default;
+        explicit PathGlob(std::string_view pattern);
+
+        bool IsValid() const {
+            return m_Valid;
+        }
+
+        State Start() const {
+            return Close(1);
+        }
+        /// State after consuming one path segment - 0 if nothing can match any more
+        State Step(State state, std::string_view name) const;
+        bool IsMatch(State state) const {
+            return state & Accept();
+        }
+        /// More segments can still match
+        bool CanContinue(State state) const {
+            return state & ~Accept();
+        }
+        /// "**" segments are active - any subdirectory can still match
+        bool IsRecursive(State state) const;
+
+        /// Match a whole '/' separated path
+        bool Match(std::string_view path) const;
+
+    private:
+        struct Segment {
+            std::string literal; // empty for wildcard and "**" segments
+            GlobPattern glob;
+            bool wildcard  = false;
+            bool recursive = false; // "**"
+        };
+
+        State Accept() const {
+            return State{1} << m_Segments.size();
+        }
+        /// Add the positions after active "**" segments - "**" also matches no segment
+        State Close(State state) const;
+
+    private:
+        std::vector<Segment> m_Segments;
+        bool m_Valid = false;
+    };
+
+    /// Exclude rules in .gitignore syntax - "#" comments, "!" re-includes, trailing "/" matches directories only.
+    /// Patterns without an inner '/' match a file or directory name at any depth, others match the whole path from its start.
+    /// The last matching rule decides. Files below an excluded directory are not visited, so they can not be re-included.
+    class ExcludeList {
+    public:
+        /// False if the pattern is invalid
+        bool AddPattern(std::string_view pattern);
+        /// Add every line of a .gitignore style file - false if it can not be read
+        bool LoadFile(const std::filesystem::path& path);
+
+        bool IsEmpty() const {
+            return m_Rules.empty();
+        }
+
+        /// path - '/' separated as walked, name - its last segment
+        bool IsExcluded(std::string_view path, std::string_view name, bool directory) const;
+
+    private:
+        struct Rule {
+            PathGlob glob;
+            bool anchored       = false; // match the whole path, otherwise only the name
+            bool negate         = false;
+            bool directory_only = false;
+        };
+
+        std::vector<Rule> m_Rules;
+    };
+
+    /// Expands input path patterns to files with a parallel directory walk.
+    /// Directories are read without a stat per entry where the platform reports entry types.
+    class FileDiscovery {
+    public:
+        /// threads - directory walk threads for "**" patterns (0 - hardware concurrency)
+        FileDiscovery(uint32_t threads = 0);
+        ~FileDiscovery();
+
+        FileDiscovery(const FileDiscovery&)            = delete;
+        FileDiscovery& operator=(const FileDiscovery&) = delete;
+
+        /// Exclude rules for files and directories found by wildcard patterns - must outlive the discovery
+        void SetExcludes(const ExcludeList* excludes) {
+            m_Excludes = excludes;
+        }
+
+        /// Add a file path or a pattern - paths without wildcards are added as they are.
+        /// Matches of a pattern are added in sorted order. False if the pattern is invalid or its base directory does not exist.
+        bool Add(std::string_view pattern);
+
+        /// Files in the order they were added
+        const std::vector<std::filesystem::path>& GetFiles() const {
+            return m_Files;
+        }
+        /// Base directories of all patterns and the directories walked below them
+        const std::vector<std::filesystem::path>& GetDirectories() const {
+            return m_Directories;
+        }
+
+        /// Read a response file - one input per line, blank lines and lines starting with '#' are skipped.
+        /// Surrounding whitespace and quotes are removed. False if the file can not be read.
+        static bool ReadResponseFile(const std::filesystem::path& path, std::vector<std::string>& inputs);
+
+    private:
+        struct Walk;
+        struct Listing {
+            std::string directory;
+            std::vector<std::string> files; // matches directly in directory
+        };
+
+        void Scan(Walk& walk, const std::string& directory, PathGlob::State state, std::vector<Listing>& listings);
+
+    private:
+        uint32_t m_ThreadCount;
+        Scope<WorkerPool> m_Pool; // created by the first "**" pattern
+        const ExcludeList* m_Excludes = nullptr;
+        std::vector<std::filesystem::path> m_Files;
+        std::vector<std::filesystem::path> m_Directories;
+    };
+
+} // namespace XRT
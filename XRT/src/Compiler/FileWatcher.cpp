@@ -0,0 +1,141 @@
+#include "FileWatcher.hpp"
+#include <Log/Logger.hpp>
+#if defined(CFXS_PLATFORM_LINUX)
+    #include <cerrno>
+    #include <cstring>
+    #include <poll.h>
+    #include <signal.h>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+namespace XRT {
+
+#if defined(CFXS_PLATFORM_LINUX)
+    static struct sigaction s_PreviousInterrupt;
+    static struct sigaction s_PreviousTerminate;
+
+    FileWatcher::FileWatcher() {
+        m_Handle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_Handle < 0)
+            LOG_ERROR("[Watch] inotify_init failed: {}", std::strerror(errno));
+
+        // no SA_RESTART - the signal interrupts poll in Wait
+        s_Stop = 0;
+        struct sigaction action {};
+        action.sa_handler = [](int) {
+            s_Stop = 1;
+        };
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGINT, &action, &s_PreviousInterrupt);
+        sigaction(SIGTERM, &action, &s_PreviousTerminate);
+    }
+
+    FileWatcher::~FileWatcher() {
+        sigaction(SIGINT, &s_PreviousInterrupt, nullptr);
+        sigaction(SIGTERM, &s_PreviousTerminate, nullptr);
+        if (m_Handle >= 0)
+            close(m_Handle);
+    }
+
+    bool FileWatcher::Watch(const std::filesystem::path& directory) {
+        if (m_Handle < 0)
+            return false;
+        int wd = inotify_add_watch(m_Handle, directory.c_str(), IN_CLOSE_WRITE | IN_CREATE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_ONLYDIR);
+        if (wd < 0) {
+            LOG_ERROR("[Watch] Failed to watch \"{}\": {}", directory.string(), std::strerror(errno));
+            return false;
+        }
+        m_Directories[wd] = directory;
+        return true;
+    }
+
+    bool FileWatcher::ReadEvents(std::vector<Change>& changes) {
+        alignas(inotify_event) char buffer[16 * 1024];
+        while (true) {
+            auto size = read(m_Handle, buffer, sizeof(buffer));
+            if (size < 0) {
+                if (errno == EAGAIN)
+                    return true;
+                if (errno == EINTR)
+                    continue;
+                LOG_ERROR("[Watch] read failed: {}", std::strerror(errno));
+                return false;
+            }
+
+            for (ssize_t pos = 0; pos < size;) {
+                auto event = reinterpret_cast<const inotify_event*>(buffer + pos);
+                pos += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+                auto dir = m_Directories.find(event->wd);
+                if (dir == m_Directories.end())
+                    continue;
+                if (event->mask & IN_IGNORED) {
+                    m_Directories.erase(dir); // watched directory removed
+                    continue;
+                }
+                bool directory = event->mask & IN_ISDIR;
+                if (!event->len || (!directory && (event->mask & IN_CREATE)))
+                    continue; // new files are reported when written
+                auto path    = dir->second / event->name;
+                bool removed = event->mask & (IN_MOVED_FROM | IN_DELETE);
+
+                // last event of a path wins - editors often delete or rename the old file before writing the new one
+                auto [it, added] = m_ChangeIndex.try_emplace(path.string(), changes.size());
+                if (added) {
+                    changes.push_back({std::move(path), removed, directory});
+                } else {
+                    changes[it->second].removed = removed;
+                }
+            }
+        }
+    }
+
+    bool FileWatcher::Wait(std::vector<Change>& changes, std::chrono::milliseconds debounce) {
+        changes.clear();
+        m_ChangeIndex.clear();
+        if (m_Handle < 0)
+            return false;
+
+        pollfd fd{m_Handle, POLLIN, 0};
+        int timeout = -1; // block until the first change
+        while (true) {
+            if (s_Stop)
+                return false;
+            int ready = poll(&fd, 1, timeout);
+            if (ready < 0) {
+                if (errno == EINTR)
+                    continue; // stop is checked above
+                LOG_ERROR("[Watch] poll failed: {}", std::strerror(errno));
+                return false;
+            }
+            if (ready == 0 && !changes.empty())
+                return true; // quiet for debounce
+            if (ready > 0 && !ReadEvents(changes))
+                return false;
+            if (!changes.empty())
+                timeout = static_cast<int>(debounce.count());
+        }
+    }
+#else
+    FileWatcher::FileWatcher() {
+    }
+
+    FileWatcher::~FileWatcher() {
+    }
+
+    bool FileWatcher::Watch(const std::filesystem::path&) {
+        LOG_ERROR("--watch is only supported on Linux");
+        return false;
+    }
+
+    bool FileWatcher::ReadEvents(std::vector<Change>&) {
+        return false;
+    }
+
+    bool FileWatcher::Wait(std::vector<Change>&, std::chrono::milliseconds) {
+        return false;
+    }
+#endif
+
+} // namespace XRT
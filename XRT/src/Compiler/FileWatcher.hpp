@@ -0,0 +1,52 @@
+#pragma once
+#include <chrono>
+#include <csignal>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace XRT {
+
+    /// Change notifications for files in a set of directories (inotify) for watch mode.
+    /// Directories are watched instead of files so saves that replace a file by renaming over it are seen.
+    /// SIGINT/SIGTERM end a Wait while the watcher exists - IsStopped tells a requested stop from an error.
+    class FileWatcher {
+    public:
+        struct Change {
+            std::filesystem::path path;
+            bool removed   = false; // deleted or renamed away
+            bool directory = false; // subdirectory created, moved or removed - not watched until Watch is called for it
+        };
+
+    public:
+        FileWatcher();
+        ~FileWatcher();
+
+        FileWatcher(const FileWatcher&)            = delete;
+        FileWatcher& operator=(const FileWatcher&) = delete;
+
+        /// Watch files and subdirectories directly in directory - false if it can not be watched
+        bool Watch(const std::filesystem::path& directory);
+
+        /// Block until a file changes, then collect further changes until none arrive for debounce.
+        /// Repeated changes of a path are reported once. Returns false on error or stop.
+        bool Wait(std::vector<Change>& changes, std::chrono::milliseconds debounce);
+
+        bool IsStopped() const {
+            return s_Stop;
+        }
+
+    private:
+        /// Read pending events without blocking
+        bool ReadEvents(std::vector<Change>& changes);
+
+    private:
+        static inline volatile std::sig_atomic_t s_Stop = 0;
+
+        int m_Handle = -1;
+        std::unordered_map<int, std::filesystem::path> m_Directories; // [watch descriptor]
+        std::unordered_map<std::string, size_t> m_ChangeIndex;        // path -> index in the changes of the current Wait
+    };
+
+} // namespace XRT
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace XRT {
+
+    /// Error or warning reported for a source location
+    struct Diagnostic {
+        enum class Severity : uint8_t {
+            WARNING,
+            ERROR,
+        };
+
+        Severity severity = Severity::ERROR;
+        std::string message;
+        std::string detail;         // extra context (lexer source excerpt)
+        std::filesystem::path path; // empty if not tied to a source
+        size_t line   = 0;
+        size_t column = 0;
+    };
+
+} // namespace XRT
@@ -2,7 +2,7 @@
 #include <Utils.hpp>
 #include <string_view>
 #include <vector>
-#include "Language/AST.hpp"
+#include "Language/TypeContext.hpp"
 #include "StringUtils.hpp"
 #include "_ParserTypeBase.hpp"
 
@@ -15,6 +15,7 @@ namespace XRT {
         EXPRESSION,
         SCOPE_START,
         SCOPE_END,
+        COMPONENT,
     };
 
     static inline const char* AST_Type_ToString(AST_Type type) {
@@ -25,6 +26,7 @@ namespace XRT {
             case AST_Type::EXPRESSION: return "EXPRESSION";
             case AST_Type::SCOPE_START: return "SCOPE_START";
             case AST_Type::SCOPE_END: return "SCOPE_END";
+            case AST_Type::COMPONENT: return "COMPONENT";
             default: return "???";
         }
     }
@@ -42,6 +44,86 @@ namespace XRT {
         AST_Type type;
     };
 
+    enum class AST_ExpressionType {
+        LITERAL,    // value
+        IDENTIFIER, // value (A::B::C)
+        UNARY,      // op operands[0]
+        BINARY,     // operands[0] op operands[1]
+        TERNARY,    // operands[0] ? operands[1] : operands[2]
+        CALL,       // operands[0](operands[1..])
+        INDEX,      // operands[0][operands[1]]
+        MEMBER,     // operands[0].value
+        POSTFIX,    // operands[0] op
+        ASSIGN,     // operands[0] op operands[1]
+    };
+
+    struct AST_Expression {
+        AST_Expression(AST_ExpressionType t, const Token* tok) : type(t), token(tok) {
+        }
+
+        AST_ExpressionType type;
+        TokenType op = TokenType::UNKNOWN;
+        std::wstring value;
+        std::vector<Scope<AST_Expression>> operands;
+        const Token* token;
+    };
+
+    enum class AST_StatementType {
+        EXPRESSION, // expression;
+        IF,         // if (expression) body else else_body
+        BLOCK,      // { body }
+    };
+
+    struct AST_Statement {
+        AST_Statement(AST_StatementType t, const Token* tok) : type(t), token(tok) {
+        }
+
+        AST_StatementType type;
+        Scope<AST_Expression> expression;
+        std::vector<Scope<AST_Statement>> body;
+        std::vector<Scope<AST_Statement>> else_body;
+        const Token* token;
+    };
+
+    /// Type as written in source - unsigned<N..>, in<logic>, out logic, CFXS::Component<4>
+    struct AST_TypeRef {
+        std::wstring name;                             // empty for port types
+        PortDirection direction = PortDirection::NONE; // in/out/inout
+        Scope<AST_TypeRef> element;                    // port element type
+        std::vector<Scope<AST_Expression>> arguments;  // template arguments
+        bool range         = false;                    // arguments are a range <a..b> / <a..>
+        const Token* token = nullptr;
+    };
+
+    /// Typed name with optional initializer - template parameters, registers, ports
+    struct AST_Variable {
+        Scope<AST_TypeRef> type; // nullptr for typename parameters
+        std::wstring name;
+        Scope<AST_Expression> initializer;
+        const Token* token = nullptr;
+    };
+
+    struct AST_Alias {
+        std::wstring name;
+        Scope<AST_Expression> value;
+        const Token* token = nullptr;
+    };
+
+    struct AST_Constructor {
+        std::vector<AST_Variable> ports;
+        std::vector<Scope<AST_Statement>> body;
+        bool declaration_only = false;
+        const Token* token    = nullptr;
+    };
+
+    struct AST_EventHandler {
+        std::wstring source;    // Event<source>
+        std::wstring parameter; // EventSource parameter name
+        std::vector<Scope<AST_Statement>> body;
+        const Token* token = nullptr;
+        const Token* edge  = nullptr; // Event<source, edge> - rising, falling, both or a bool constant (true = rising)
+    };
+
     namespace AST_Element {
         struct SourceLink : public AST_Entry {
             SourceLink(const std::wstring_view& path) : AST_Entry(AST_Type::SOURCE_LINK), source_path(path) {
@@ -64,6 +146,20 @@ namespace XRT {
             ScopeEnd() : AST_Entry(AST_Type::SCOPE_END) {
             }
         };
+
+        struct Component : public AST_Entry {
+            Component() : AST_Entry(AST_Type::COMPONENT) {
+            }
+            std::wstring name;
+            bool abstract = false;
+            std::vector<AST_Variable> template_parameters;
+            std::vector<std::wstring> bases;
+            std::vector<AST_Alias> aliases;
+            std::vector<AST_Variable> registers;
+            std::vector<AST_Constructor> constructors;
+            std::vector<AST_EventHandler> events;
+            const Token* token = nullptr;
+        };
     }; // namespace AST_Element
 
     class AST {
@@ -82,7 +178,50 @@ namespace XRT {
             m_Entries.emplace_back(CreateScope<AST_Element::ScopeEnd>());
         }
 
+        const std::vector<Scope<AST_Entry>>& GetEntries() const {
+            return m_Entries;
+        }
+
+        /// Move all entries out - the AST is left empty
+        std::vector<Scope<AST_Entry>> TakeEntries() {
+            return std::move(m_Entries);
+        }
+
+        /// Replace count entries starting at first - used by incremental reparsing
+        void Replace(size_t first, size_t count, std::vector<Scope<AST_Entry>>&& entries) {
+            auto it = m_Entries.erase(m_Entries.begin() + static_cast<ptrdiff_t>(first), m_Entries.begin() + static_cast<ptrdiff_t>(first + count));
+            m_Entries.insert(it, std::make_move_iterator(entries.begin()), std::make_move_iterator(entries.end()));
+        }
+
+        /// Every entry, declaration, statement, expression and type reference
+        size_t CountNodes() const {
+            size_t count = 0;
+            for (auto& e : m_Entries) {
+                count++;
+                if (e->type != AST_Type::COMPONENT)
+                    continue;
+                auto& comp = e->Cast<AST_Element::Component>();
+                for (auto& v : comp.template_parameters)
+                    count += CountNodes(v);
+                for (auto& a : comp.aliases)
+                    count += 1 + CountNodes(a.value.get());
+                for (auto& v : comp.registers)
+                    count += CountNodes(v);
+                for (auto& c : comp.constructors) {
+                    count++;
+                    for (auto& p : c.ports)
+                        count += CountNodes(p);
+                    count += CountNodes(c.body);
+                }
+                for (auto& ev : comp.events)
+                    count += 1 + CountNodes(ev.body);
+            }
+            return count;
+        }
+
         void Print() const {
+            if (!Logger::IsEnabled(spdlog::level::debug))
+                return;
             LOG_DEBUG("AST:");
 
             int scope_depth             = 0;
@@ -115,6 +254,20 @@ namespace XRT {
                                   StringUtils::utf16_to_utf8(e->Cast<AST_Element::Namespace>().name));
                         break;
                     }
+                    case AST_Type::COMPONENT: {
+                        auto& comp = e->Cast<AST_Element::Component>();
+                        LOG_DEBUG("{}name: {}{}",
+                                  str_indent(scope_depth * INDENT),
+                                  comp.abstract ? "abstract " : "",
+                                  StringUtils::utf16_to_utf8(comp.name));
+                        LOG_DEBUG("{}template parameters: {}, registers: {}, constructors: {}, events: {}",
+                                  str_indent(scope_depth * INDENT),
+                                  comp.template_parameters.size(),
+                                  comp.registers.size(),
+                                  comp.constructors.size(),
+                                  comp.events.size());
+                        break;
+                    }
                     default: break;
                 }
 
@@ -124,6 +277,36 @@ namespace XRT {
             }
         }
 
+    private:
+        static size_t CountNodes(const AST_Expression* e) {
+            if (!e)
+                return 0;
+            size_t count = 1;
+            for (auto& op : e->operands)
+                count += CountNodes(op.get());
+            return count;
+        }
+
+        static size_t CountNodes(const AST_TypeRef* t) {
+            if (!t)
+                return 0;
+            size_t count = 1 + CountNodes(t->element.get());
+            for (auto& arg : t->arguments)
+                count += CountNodes(arg.get());
+            return count;
+        }
+
+        static size_t CountNodes(const std::vector<Scope<AST_Statement>>& statements) {
+            size_t count = 0;
+            for (auto& s : statements)
+                count += 1 + CountNodes(s->expression.get()) + CountNodes(s->body) + CountNodes(s->else_body);
+            return count;
+        }
+
+        static size_t CountNodes(const AST_Variable& v) {
+            return 1 + CountNodes(v.type.get()) + CountNodes(v.initializer.get());
+        }
+
     private:
         std::vector<Scope<AST_Entry>> m_Entries;
     };
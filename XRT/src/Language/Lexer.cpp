@@ -1,22 +1,20 @@
 #include "Lexer.hpp"
+#include <algorithm>
 #include <memory>
 #include <string_view>
 #include "Language/Lexer.hpp"
 #include "Language/Token.hpp"
 #include "Language/_LexerTypeBase.hpp"
 #include "Log/Logger.hpp"
-#include "ScopeExecTime.hpp"
+#include "Profiler.hpp"
 #include "StringUtils.hpp"
 #include <Log/ANSI.hpp>
 #include <regex/ctre.hpp>
 
-#define REGEX_WHITESPACE        "[ \t\r\n]+"
-#define REGEX_MULTILINE_COMMENT "\\/\\*[^*]*\\*+(?:[^\\/*][^*]*\\*+)*\\/"
-#define REGEX_COMMENT           "\\/\\/.*[\r\n]?"
-#define REGEX_PUNCTUATOR        "[!%\\^&\\*\\(\\)\\-\\+={}\\|~\\[\\];:<>\?,\\.#\\/\\\\]"
-#define REGEX_IDENTIFIER        "[a-zA-Z_][a-zA-Z_0-9]*"
-#define REGEX_NUMBER_LITERAL    "[0-9][a-fA-FxX_0-9]*"
-#define REGEX_STRING            "\"([^\"\\\\]|\\\\.)*\"" // TODO: Modify regex to not match broken multiline strings
+#define REGEX_WHITESPACE     "[ \t\r\n]+"
+#define REGEX_PUNCTUATOR     "[!%\\^&\\*\\(\\)\\-\\+={}\\|~\\[\\];:<>\?,\\.#\\/\\\\]"
+#define REGEX_IDENTIFIER     "[a-zA-Z_][a-zA-Z_0-9]*"
+#define REGEX_NUMBER_LITERAL "[0-9][a-fA-FxX_0-9]*"
 #define REGEX_KEYWORD \
     "auto|namespace|component|abstract|registers|implementation|extern|static_assert|in|out|inout|if|else|for|template|typename|using|range|length"
 
@@ -32,14 +30,6 @@
         if (match) {                                                                                                         \
             found          = true;                                                                                           \
             auto matchView = match.to_view();                                                                                \
-            if constexpr (type == TokenType::COMMENT) {                                                                      \
-                if ((*matchView.rbegin() == '\n' && *(matchView.rbegin() + 1) == '\r') ||                                    \
-                    (*matchView.rbegin() == '\r' && *(matchView.rbegin() + 1) == '\n')) {                                    \
-                    matchView = std::wstring_view{matchView.data(), matchView.size() - 2};                                   \
-                } else if (*matchView.rbegin() == '\n') {                                                                    \
-                    matchView = std::wstring_view{matchView.data(), matchView.size() - 1};                                   \
-                }                                                                                                            \
-            }                                                                                                                \
             if constexpr (type == TokenType::IDENTIFIER) {                                                                   \
                 if (ctre::match<REGEX_KEYWORD>(matchView)) {                                                                 \
                     CREATE_TOKEN(TokenType::KEYWORD, matchView);                                                             \
@@ -54,19 +44,33 @@
         }                                                                                                                    \
     }
 
+// create token from the first length characters found by a scanner
+#define SCANNED_MATCH(type, length)                                        \
+    {                                                                      \
+        found = true;                                                      \
+        CREATE_TOKEN(type, sourceContent.substr(0, length));               \
+        currentOffset += length;                                           \
+        sourceContent.remove_prefix(length);                               \
+    }
+
 namespace XRT {
 
     Lexer::Lexer(std::shared_ptr<SourceEntry> source) : m_Source(source) {
         m_Tokens.reserve(512);
     }
 
+    Lexer::~Lexer() {
+        for (auto tok : m_Tokens)
+            delete tok;
+    }
+
     void Lexer::ProcessSource() {
         if (m_Tokens.size()) {
             LOG_WARN("Lexer source already processed \"{}\"", m_Source->GetPath());
             return;
         }
 
-        ScopeExecTime xt("Lexer::ProcessSource");
+        XRT_PROFILE_SCOPE("Lexer::ProcessSource");
 
         auto sourceContent   = GetSource()->GetContent();
         size_t currentOffset = 0;
@@ -76,12 +80,19 @@ namespace XRT {
 
             CHECK_MATCH(TokenType::SPACE, REGEX_WHITESPACE)
             CHECK_MATCH(TokenType::IDENTIFIER, REGEX_IDENTIFIER)
-            if (sourceContent.data()[0] == '/') {
-                CHECK_MATCH(TokenType::COMMENT, REGEX_MULTILINE_COMMENT)
-                CHECK_MATCH(TokenType::COMMENT, REGEX_COMMENT)
+            if (sourceContent.starts_with(L"//") || sourceContent.starts_with(L"/*")) {
+                auto length = ScanComment(sourceContent);
+                if (!length)
+                    throw UnknownTokenException(sourceContent, "Unterminated block comment");
+                SCANNED_MATCH(TokenType::COMMENT, length)
             }
             CHECK_MATCH(TokenType::PUNCTUATOR, REGEX_PUNCTUATOR)
-            CHECK_MATCH(TokenType::STRING_LITERAL, REGEX_STRING)
+            if (sourceContent.starts_with(L'"')) {
+                auto length = ScanString(sourceContent);
+                if (!length)
+                    throw UnknownTokenException(sourceContent, "Unterminated string literal");
+                SCANNED_MATCH(TokenType::STRING_LITERAL, length)
+            }
             CHECK_MATCH(TokenType::LITERAL, REGEX_NUMBER_LITERAL)
 
             if (sourceContent.size() == 0) {
@@ -89,7 +100,6 @@ namespace XRT {
             }
 
             if (!found) {
-                LOG_ERROR("Unknown token:\n'{}'", StringUtils::utf16_to_utf8(std::wstring(sourceContent)));
                 throw UnknownTokenException(sourceContent);
                 break;
             }
@@ -129,6 +139,26 @@ namespace XRT {
         }
     }
 
+    size_t Lexer::ScanComment(std::wstring_view text) {
+        if (text[1] == '/')
+            return std::min(text.find_first_of(L"\r\n", 2), text.size());
+        auto end = text.find(L"*/", 2);
+        return end == std::wstring_view::npos ? 0 : end + 2;
+    }
+
+    size_t Lexer::ScanString(std::wstring_view text) {
+        for (size_t i = 1; i < text.size(); i++) {
+            auto c = text[i];
+            if (c == '"')
+                return i + 1;
+            if (c == '\\')
+                c = ++i < text.size() ? text[i] : '\n';
+            if (c == '\r' || c == '\n')
+                return 0;
+        }
+        return 0;
+    }
+
     void Lexer::PrintTokens() {
         if (m_Tokens.empty()) {
             LOG_WARN("No tokens to print :(");
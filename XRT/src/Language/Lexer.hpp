@@ -1,5 +1,6 @@
 #pragma once
 #include <memory>
+#include <string_view>
 #include "_LexerTypeBase.hpp"
 #include "Language/SourceEntry.hpp"
 
@@ -8,7 +9,7 @@ namespace XRT {
     class Lexer : public _LexerTypeBase {
     public:
         Lexer(std::shared_ptr<SourceEntry> source);
-        ~Lexer() = default;
+        ~Lexer();
 
         std::shared_ptr<SourceEntry> GetSource() {
             return m_Source;
@@ -26,9 +27,15 @@ namespace XRT {
 
         void PrintTokens();
 
+    private:
+        /// Length of the comment at the start of text (line comments end before the line break) - 0 if a block comment is not closed
+        static size_t ScanComment(std::wstring_view text);
+        /// Length of the string literal at the start of text - 0 if it is not closed on its line
+        static size_t ScanString(std::wstring_view text);
+
     private:
         std::shared_ptr<SourceEntry> m_Source;
-        TokenStorage m_Tokens;
+        TokenStorage m_Tokens; // owned - deleted with the lexer unless taken out of the storage
     };
 
 } // namespace XRT
\ No newline at end of file
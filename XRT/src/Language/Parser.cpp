@@ -2,7 +2,7 @@
 #include <string_view>
 #include "Language/AST.hpp"
 #include "Language/Token.hpp"
-#include "ScopeExecTime.hpp"
+#include "Profiler.hpp"
 
 #include "ParserTables.hpp"
 #include "StringUtils.hpp"
@@ -16,7 +16,7 @@
 
 namespace XRT {
 
-    Parser::Parser() {
+    Parser::Parser(IncludeCache* includes) : m_Preprocessor(includes) {
     }
 
     Parser::~Parser() {
@@ -74,7 +74,7 @@ namespace XRT {
     new InvalidPunctuatorSequence(tok)
 
     Parser::TokenStorage Parser::PreProcessOperators(LexData lex) {
-        ScopeExecTime xt("Parser::Parse");
+        XRT_PROFILE_SCOPE("Parser::PreProcessOperators");
 
         PARSER_LOG_TRACE("Parse \"{}\"", lex->GetSource()->GetPath());
         if (lex->GetTokens().empty()) {
@@ -131,12 +131,14 @@ namespace XRT {
     }
 
     void Parser::Parse(LexData lex) {
+        XRT_PROFILE_SCOPE("Parser::Parse");
         using TT = TokenType;
 
         const auto source_path = lex->GetSource()->GetPath();
 
         m_AST    = CreateRef<AST>();
-        m_Tokens = PreProcessOperators(lex);
+        m_Tokens = m_Preprocessor.Process(PreProcessOperators(lex), source_path);
+        m_TopLevelItems.clear();
 
         size_t token_index = 0;
         auto current_token = m_Tokens[token_index];
@@ -169,8 +171,6 @@ namespace XRT {
 
                         m_AST->Append(CreateScope<AST_Element::SourceLink>(path->value));
 
-                    } else if (action->value == L"define") {
-                        throw NotImplemented("#define", action);
                     } else {
                         throw InvalidPreprocessorDirective("Unknown preprocessing directive", action);
                     }
@@ -219,6 +219,11 @@ namespace XRT {
                         m_AST->EnterScope();
                         m_AST->Append(CreateScope<AST_Element::Namespace>(ns_name));
 
+                    } else if (current_token->value == L"template" || current_token->value == L"component" ||
+                               current_token->value == L"abstract") {
+                        m_Index = token_index;
+                        m_AST->Append(ParseComponent());
+                        inc_tokens = m_Index - token_index;
                     } else {
                         throw NotImplemented("keyword [" + StringUtils::utf16_to_utf8(current_token->value) + "]", current_token);
                     }
@@ -236,9 +241,495 @@ namespace XRT {
                 }
             }
 
+            if (current_token->type != TT::COMMENT) {
+                auto last = m_Tokens[token_index + inc_tokens - 1];
+                m_TopLevelItems.push_back({last->offset + last->value.size(), m_AST->GetEntries().size()});
+            }
+
             token_index += inc_tokens;
             current_token = m_Tokens[token_index];
         }
+
+        // expanded tokens are located at their macro definitions - declarations can not be told apart by offset
+        if (m_Preprocessor.IsActive())
+            m_TopLevelItems = {{lex->GetTokens().back()->offset, m_AST->GetEntries().size()}};
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////
+    // Token cursor
+
+    const Parser::Token* Parser::Peek(size_t offset) {
+        size_t idx = m_Index;
+        while (true) {
+            if (idx >= m_Tokens.size())
+                throw ParseOverflow("Lookahead overflow", m_Tokens.back());
+            if (m_Tokens[idx]->type != TokenType::COMMENT) {
+                if (offset == 0)
+                    return m_Tokens[idx];
+                offset--;
+            }
+            idx++;
+        }
+    }
+
+    const Parser::Token* Parser::Next() {
+        while (m_Tokens[m_Index]->type == TokenType::COMMENT)
+            m_Index++;
+        auto tok = m_Tokens[m_Index];
+        if (tok->type != TokenType::END_OF_FILE)
+            m_Index++;
+        return tok;
+    }
+
+    bool Parser::Accept(TokenType type) {
+        if (Peek()->type == type) {
+            Next();
+            return true;
+        }
+        return false;
+    }
+
+    bool Parser::AcceptKeyword(std::wstring_view keyword) {
+        auto tok = Peek();
+        if (tok->type == TokenType::KEYWORD && tok->value == keyword) {
+            Next();
+            return true;
+        }
+        return false;
+    }
+
+    const Parser::Token* Parser::Expect(TokenType type) {
+        auto tok = Peek();
+        if (tok->type != type)
+            throw ExpectationError(fmt::format("Expected {} got {}", ToString(type), ToString(tok->type)), tok);
+        return Next();
+    }
+
+    const Parser::Token* Parser::ExpectKeyword(std::wstring_view keyword) {
+        auto tok = Peek();
+        if (tok->type != TokenType::KEYWORD || tok->value != keyword)
+            throw ExpectationError(fmt::format("Expected \"{}\"", StringUtils::utf16_to_utf8(keyword)), tok);
+        return Next();
+    }
+
+    bool Parser::IsCloseAngle() {
+        auto type = Peek()->type;
+        return type == TokenType::CLOSE_ANGLE || (type == TokenType::LSR && m_SplitCloseAngle);
+    }
+
+    void Parser::ExpectCloseAngle() {
+        auto tok = Peek();
+        if (tok->type == TokenType::LSR) {
+            // nested template close "a<b<c>>"
+            if (m_SplitCloseAngle)
+                Next();
+            m_SplitCloseAngle = !m_SplitCloseAngle;
+            return;
+        }
+        Expect(TokenType::CLOSE_ANGLE);
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////
+    // Declarations
+
+    Scope<AST_Element::Component> Parser::ParseComponent() {
+        using TT  = TokenType;
+        auto comp = CreateScope<AST_Element::Component>();
+
+        if (AcceptKeyword(L"template")) {
+            comp->template_parameters = ParseTemplateParameters();
+        }
+        comp->abstract = AcceptKeyword(L"abstract");
+        comp->token    = ExpectKeyword(L"component");
+        comp->name     = Expect(TT::IDENTIFIER)->value;
+
+        // component Name : base, base
+        if (Accept(TT::TERNARY_ELSE)) {
+            do {
+                comp->bases.push_back(ParseQualifiedName());
+            } while (Accept(TT::COMMA));
+        }
+
+        enum class Section { NONE, REGISTERS, IMPLEMENTATION } section = Section::NONE;
+
+        Expect(TT::OPEN_SCOPE);
+        while (!Accept(TT::CLOSE_SCOPE)) {
+            auto tok = Peek();
+
+            if (tok->type == TT::KEYWORD && tok->value == L"registers") {
+                Next();
+                Expect(TT::TERNARY_ELSE);
+                section = Section::REGISTERS;
+            } else if (tok->type == TT::KEYWORD && tok->value == L"implementation") {
+                Next();
+                Expect(TT::TERNARY_ELSE);
+                section = Section::IMPLEMENTATION;
+            } else if (tok->type == TT::KEYWORD && tok->value == L"using") {
+                Next();
+                AST_Alias alias;
+                alias.token = tok;
+                alias.name  = Expect(TT::IDENTIFIER)->value;
+                Expect(TT::ASSIGN);
+                alias.value = ParseExpression();
+                Expect(TT::SEPARATOR);
+                comp->aliases.push_back(std::move(alias));
+            } else if (section == Section::REGISTERS) {
+                comp->registers.push_back(ParseVariable());
+                Expect(TT::SEPARATOR);
+            } else if (section == Section::IMPLEMENTATION && tok->type == TT::IDENTIFIER && tok->value == comp->name) {
+                comp->constructors.push_back(ParseConstructor());
+            } else if (section == Section::IMPLEMENTATION && tok->type == TT::IDENTIFIER && tok->value == L"Event") {
+                comp->events.push_back(ParseEventHandler());
+            } else if (tok->type == TT::END_OF_FILE) {
+                throw ExpectationError("Expected CLOSE_SCOPE got END_OF_FILE", tok);
+            } else {
+                throw NotImplemented("component member [" + StringUtils::utf16_to_utf8(tok->value) + "]", tok);
+            }
+        }
+        Expect(TT::SEPARATOR);
+
+        return comp;
+    }
+
+    std::vector<AST_Variable> Parser::ParseTemplateParameters() {
+        std::vector<AST_Variable> params;
+        Expect(TokenType::OPEN_ANGLE);
+        while (!IsCloseAngle()) {
+            AST_Variable param;
+            if (AcceptKeyword(L"typename")) {
+                param.token = Expect(TokenType::IDENTIFIER);
+                param.name  = param.token->value;
+            } else {
+                param.type  = ParseTypeRef();
+                param.token = Expect(TokenType::IDENTIFIER);
+                param.name  = param.token->value;
+            }
+            if (Accept(TokenType::ASSIGN)) {
+                param.initializer = ParseExpression(false);
+            }
+            params.push_back(std::move(param));
+            if (!Accept(TokenType::COMMA))
+                break;
+        }
+        ExpectCloseAngle();
+        return params;
+    }
+
+    AST_Variable Parser::ParseVariable() {
+        AST_Variable var;
+        var.type  = ParseTypeRef();
+        var.token = Expect(TokenType::IDENTIFIER);
+        var.name  = var.token->value;
+        if (Accept(TokenType::ASSIGN)) {
+            var.initializer = ParseExpression();
+        }
+        return var;
+    }
+
+    Scope<AST_TypeRef> Parser::ParseTypeRef() {
+        using TT   = TokenType;
+        auto type  = CreateScope<AST_TypeRef>();
+        auto tok   = Peek();
+        type->token = tok;
+
+        if (tok->type == TT::KEYWORD && (tok->value == L"in" || tok->value == L"out" || tok->value == L"inout")) {
+            Next();
+            type->direction = tok->value == L"in" ? PortDirection::IN : tok->value == L"out" ? PortDirection::OUT : PortDirection::INOUT;
+            if (Accept(TT::OPEN_ANGLE)) {
+                type->element = ParseTypeRef();
+                ExpectCloseAngle();
+            } else {
+                type->element = ParseTypeRef();
+            }
+            return type;
+        }
+
+        type->name = ParseQualifiedName();
+        if (Accept(TT::OPEN_ANGLE)) {
+            while (!IsCloseAngle()) {
+                type->arguments.push_back(ParseExpression(false));
+                if (Accept(TT::RANGE)) {
+                    // <a..> or <a..b>
+                    type->range = true;
+                    if (!IsCloseAngle())
+                        type->arguments.push_back(ParseExpression(false));
+                    break;
+                }
+                if (!Accept(TT::COMMA))
+                    break;
+            }
+            ExpectCloseAngle();
+        }
+        return type;
+    }
+
+    AST_Constructor Parser::ParseConstructor() {
+        AST_Constructor ctor;
+        ctor.token = Expect(TokenType::IDENTIFIER);
+        Expect(TokenType::OPEN_PAREN);
+        while (!Accept(TokenType::CLOSE_PAREN)) {
+            ctor.ports.push_back(ParseVariable());
+            if (!Accept(TokenType::COMMA)) {
+                Expect(TokenType::CLOSE_PAREN);
+                break;
+            }
+        }
+        if (Accept(TokenType::SEPARATOR)) {
+            ctor.declaration_only = true;
+        } else {
+            ctor.body = ParseBlock();
+        }
+        return ctor;
+    }
+
+    AST_EventHandler Parser::ParseEventHandler() {
+        AST_EventHandler event;
+        event.token = Expect(TokenType::IDENTIFIER);
+        Expect(TokenType::OPEN_ANGLE);
+        auto source = Next();
+        if (source->type != TokenType::IDENTIFIER && !(source->type == TokenType::KEYWORD && source->value == L"auto"))
+            throw ExpectationError("Expected event source", source);
+        event.source = source->value;
+        if (Accept(TokenType::COMMA)) {
+            event.edge   = Next();
+            bool boolean = event.edge->type == TokenType::KEYWORD && (event.edge->value == L"true" || event.edge->value == L"false");
+            if (event.edge->type != TokenType::IDENTIFIER && !boolean)
+                throw ExpectationError("Expected event edge", event.edge);
+        }
+        ExpectCloseAngle();
+
+        Expect(TokenType::OPEN_PAREN);
+        if (!Accept(TokenType::CLOSE_PAREN)) {
+            ParseQualifiedName(); // EventSource
+            event.parameter = Expect(TokenType::IDENTIFIER)->value;
+            Expect(TokenType::CLOSE_PAREN);
+        }
+        event.body = ParseBlock();
+        return event;
+    }
+
+    std::wstring Parser::ParseQualifiedName() {
+        std::wstring name{Expect(TokenType::IDENTIFIER)->value};
+        while (Accept(TokenType::RESOLVE)) {
+            name += L"::";
+            name += Expect(TokenType::IDENTIFIER)->value;
+        }
+        return name;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////
+    // Statements
+
+    std::vector<Scope<AST_Statement>> Parser::ParseBlock() {
+        std::vector<Scope<AST_Statement>> body;
+        Expect(TokenType::OPEN_SCOPE);
+        while (!Accept(TokenType::CLOSE_SCOPE)) {
+            if (Peek()->type == TokenType::END_OF_FILE)
+                throw ExpectationError("Expected CLOSE_SCOPE got END_OF_FILE", Peek());
+            body.push_back(ParseStatement());
+        }
+        return body;
+    }
+
+    Scope<AST_Statement> Parser::ParseStatement() {
+        auto tok = Peek();
+
+        if (tok->type == TokenType::OPEN_SCOPE) {
+            auto stmt  = CreateScope<AST_Statement>(AST_StatementType::BLOCK, tok);
+            stmt->body = ParseBlock();
+            return stmt;
+        }
+
+        if (tok->type == TokenType::KEYWORD && tok->value == L"if") {
+            Next();
+            auto stmt = CreateScope<AST_Statement>(AST_StatementType::IF, tok);
+            Expect(TokenType::OPEN_PAREN);
+            stmt->expression = ParseExpression();
+            Expect(TokenType::CLOSE_PAREN);
+            stmt->body.push_back(ParseStatement());
+            if (AcceptKeyword(L"else")) {
+                stmt->else_body.push_back(ParseStatement());
+            }
+            return stmt;
+        }
+
+        if (tok->type == TokenType::KEYWORD) {
+            throw NotImplemented("statement [" + StringUtils::utf16_to_utf8(tok->value) + "]", tok);
+        }
+
+        auto stmt        = CreateScope<AST_Statement>(AST_StatementType::EXPRESSION, tok);
+        stmt->expression = ParseAssignment();
+        Expect(TokenType::SEPARATOR);
+        return stmt;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////
+    // Expressions
+
+    static bool IsAssignmentOperator(TokenType type) {
+        switch (type) {
+            case TokenType::ASSIGN:
+            case TokenType::ASSIGN_ADD:
+            case TokenType::ASSIGN_SUB:
+            case TokenType::ASSIGN_MUL:
+            case TokenType::ASSIGN_DIV:
+            case TokenType::ASSIGN_AND:
+            case TokenType::ASSIGN_OR:
+            case TokenType::ASSIGN_XOR:
+            case TokenType::ASSIGN_LSL:
+            case TokenType::ASSIGN_LSR:
+            case TokenType::ASSIGN_ROL:
+            case TokenType::ASSIGN_ROR: return true;
+            default: return false;
+        }
+    }
+
+    static int GetBinaryPrecedence(TokenType type, bool allow_gt) {
+        switch (type) {
+            case TokenType::BOOL_OR: return 1;
+            case TokenType::BOOL_AND: return 2;
+            case TokenType::OR: return 3;
+            case TokenType::XOR: return 4;
+            case TokenType::AND: return 5;
+            case TokenType::EQUAL:
+            case TokenType::NOT_EQUAL: return 6;
+            case TokenType::GT:
+            case TokenType::GTEQ: return allow_gt ? 7 : 0;
+            case TokenType::LT:
+            case TokenType::LTEQ: return 7;
+            case TokenType::LSR:
+            case TokenType::ROR: return allow_gt ? 8 : 0;
+            case TokenType::LSL:
+            case TokenType::ROL: return 8;
+            case TokenType::ADD:
+            case TokenType::SUB: return 9;
+            case TokenType::MUL:
+            case TokenType::DIV: return 10;
+            default: return 0;
+        }
+    }
+
+    Scope<AST_Expression> Parser::ParseAssignment() {
+        auto lhs = ParseExpression();
+        auto tok = Peek();
+        if (IsAssignmentOperator(tok->type)) {
+            Next();
+            auto expr = CreateScope<AST_Expression>(AST_ExpressionType::ASSIGN, tok);
+            expr->op  = tok->type;
+            expr->operands.push_back(std::move(lhs));
+            expr->operands.push_back(ParseExpression());
+            return expr;
+        }
+        return lhs;
+    }
+
+    Scope<AST_Expression> Parser::ParseExpression(bool allow_gt) {
+        auto cond = ParseBinary(1, allow_gt);
+        auto tok  = Peek();
+        if (tok->type == TokenType::TERNARY_IF) {
+            Next();
+            auto expr = CreateScope<AST_Expression>(AST_ExpressionType::TERNARY, tok);
+            expr->operands.push_back(std::move(cond));
+            expr->operands.push_back(ParseExpression(allow_gt));
+            Expect(TokenType::TERNARY_ELSE);
+            expr->operands.push_back(ParseExpression(allow_gt));
+            return expr;
+        }
+        return cond;
+    }
+
+    Scope<AST_Expression> Parser::ParseBinary(int min_precedence, bool allow_gt) {
+        auto lhs = ParseUnary(allow_gt);
+        while (true) {
+            auto tok        = Peek();
+            auto precedence = GetBinaryPrecedence(tok->type, allow_gt);
+            if (precedence == 0 || precedence < min_precedence)
+                break;
+            Next();
+            auto expr = CreateScope<AST_Expression>(AST_ExpressionType::BINARY, tok);
+            expr->op  = tok->type;
+            expr->operands.push_back(std::move(lhs));
+            expr->operands.push_back(ParseBinary(precedence + 1, allow_gt));
+            lhs = std::move(expr);
+        }
+        return lhs;
+    }
+
+    Scope<AST_Expression> Parser::ParseUnary(bool allow_gt) {
+        auto tok = Peek();
+        if (tok->type == TokenType::NOT || tok->type == TokenType::SUB || tok->type == TokenType::ADD || tok->type == TokenType::INC ||
+            tok->type == TokenType::DEC) {
+            Next();
+            auto expr = CreateScope<AST_Expression>(AST_ExpressionType::UNARY, tok);
+            expr->op  = tok->type;
+            expr->operands.push_back(ParseUnary(allow_gt));
+            return expr;
+        }
+
+        auto expr = ParsePrimary();
+        while (true) {
+            tok = Peek();
+            if (tok->type == TokenType::OPEN_PAREN) {
+                Next();
+                auto call = CreateScope<AST_Expression>(AST_ExpressionType::CALL, tok);
+                call->operands.push_back(std::move(expr));
+                while (!Accept(TokenType::CLOSE_PAREN)) {
+                    call->operands.push_back(ParseExpression());
+                    if (!Accept(TokenType::COMMA)) {
+                        Expect(TokenType::CLOSE_PAREN);
+                        break;
+                    }
+                }
+                expr = std::move(call);
+            } else if (tok->type == TokenType::OPEN_BRACKET) {
+                Next();
+                auto index = CreateScope<AST_Expression>(AST_ExpressionType::INDEX, tok);
+                index->operands.push_back(std::move(expr));
+                index->operands.push_back(ParseExpression());
+                Expect(TokenType::CLOSE_BRACKET);
+                expr = std::move(index);
+            } else if (tok->type == TokenType::DOT) {
+                Next();
+                auto member   = CreateScope<AST_Expression>(AST_ExpressionType::MEMBER, tok);
+                member->value = Expect(TokenType::IDENTIFIER)->value;
+                member->operands.push_back(std::move(expr));
+                expr = std::move(member);
+            } else if (tok->type == TokenType::INC || tok->type == TokenType::DEC) {
+                Next();
+                auto postfix = CreateScope<AST_Expression>(AST_ExpressionType::POSTFIX, tok);
+                postfix->op  = tok->type;
+                postfix->operands.push_back(std::move(expr));
+                expr = std::move(postfix);
+            } else {
+                break;
+            }
+        }
+        return expr;
+    }
+
+    Scope<AST_Expression> Parser::ParsePrimary() {
+        auto tok = Peek();
+        switch (tok->type) {
+            case TokenType::LITERAL:
+            case TokenType::STRING_LITERAL: {
+                Next();
+                auto expr   = CreateScope<AST_Expression>(AST_ExpressionType::LITERAL, tok);
+                expr->value = tok->value;
+                return expr;
+            }
+            case TokenType::IDENTIFIER: {
+                auto expr   = CreateScope<AST_Expression>(AST_ExpressionType::IDENTIFIER, tok);
+                expr->value = ParseQualifiedName();
+                return expr;
+            }
+            case TokenType::OPEN_PAREN: {
+                Next();
+                auto expr = ParseExpression();
+                Expect(TokenType::CLOSE_PAREN);
+                return expr;
+            }
+            default: throw ExpectationError(fmt::format("Expected expression got {}", ToString(tok->type)), tok);
+        }
     }
 
 } // namespace XRT
\ No newline at end of file
@@ -3,14 +3,17 @@
 #include "Lexer.hpp"
 #include <Utils.hpp>
 #include "AST.hpp"
+#include "Preprocessor.hpp"
 
 namespace XRT {
 
     class Parser : public _ParserTypeBase {
+    public:
         using LexData = const Scope<Lexer>&;
 
     public:
-        Parser();
+        /// includes - cache for files included by the source (nullptr - #include is only a source link)
+        Parser(IncludeCache* includes = nullptr);
         ~Parser();
 
         void Parse(LexData lex);
@@ -23,13 +26,65 @@ namespace XRT {
             m_AST->Print();
         }
 
-    private:
+        const Ref<AST>& GetAST() const {
+            return m_AST;
+        }
+
+        /// Source offset after the last token of each top-level declaration and the AST entry count at that point
+        struct TopLevelItem {
+            size_t end;
+            size_t entries;
+        };
+        /// Tokens of a source that uses macros or conditionals are not in source order - it is a single item then
+        const std::vector<TopLevelItem>& GetTopLevelItems() const {
+            return m_TopLevelItems;
+        }
+
+        const Preprocessor& GetPreprocessor() const {
+            return m_Preprocessor;
+        }
+
         /// Create operator specific tokens from regular base token sequences
-        TokenStorage PreProcessOperators(LexData lex);
+        static TokenStorage PreProcessOperators(LexData lex);
 
     private:
+
+        // Declarations
+        Scope<AST_Element::Component> ParseComponent();
+        std::vector<AST_Variable> ParseTemplateParameters();
+        AST_Variable ParseVariable();
+        Scope<AST_TypeRef> ParseTypeRef();
+        AST_Constructor ParseConstructor();
+        AST_EventHandler ParseEventHandler();
+
+        // Statements and expressions
+        std::vector<Scope<AST_Statement>> ParseBlock();
+        Scope<AST_Statement> ParseStatement();
+        Scope<AST_Expression> ParseAssignment();
+        Scope<AST_Expression> ParseExpression(bool allow_gt = true);
+        Scope<AST_Expression> ParseBinary(int min_precedence, bool allow_gt);
+        Scope<AST_Expression> ParseUnary(bool allow_gt);
+        Scope<AST_Expression> ParsePrimary();
+        std::wstring ParseQualifiedName();
+
+        // Comment skipping token cursor over m_Tokens
+        const Token* Peek(size_t offset = 0);
+        const Token* Next();
+        bool Accept(TokenType type);
+        bool AcceptKeyword(std::wstring_view keyword);
+        const Token* Expect(TokenType type);
+        const Token* ExpectKeyword(std::wstring_view keyword);
+        bool IsCloseAngle();
+        void ExpectCloseAngle();
+
+    private:
+        Preprocessor m_Preprocessor;
         TokenStorage m_Tokens;
         Ref<AST> m_AST;
+        std::vector<TopLevelItem> m_TopLevelItems;
+
+        size_t m_Index         = 0;
+        bool m_SplitCloseAngle = false; // first half of ">>" consumed as template close
     };
 
 } // namespace XRT
\ No newline at end of file
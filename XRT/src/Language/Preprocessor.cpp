@@ -0,0 +1,791 @@
+#include "Preprocessor.hpp"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include "Language/Lexer.hpp"
+#include "Language/Parser.hpp"
+#include "Profiler.hpp"
+#include "StringUtils.hpp"
+
+namespace XRT {
+
+    using TT = TokenType;
+
+    /// Token source of an expansion
+    struct Preprocessor::Context {
+        Context(const TokenStorage* _tokens,
+                size_t _position,
+                Macro* _macro              = nullptr,
+                bool _expanded             = false,
+                Ref<TokenStorage> _storage = {}) :
+            tokens(_tokens), position(_position), macro(_macro), expanded(_expanded), storage(std::move(_storage)) {
+        }
+
+        const TokenStorage* tokens;
+        size_t position;
+        Macro* macro;              // expanding while the context is read
+        bool expanded;             // already expanded - only the last token can start a macro call with following tokens
+        bool source = false;       // rest of the source - bottom of the stack, directives and end of file stop it
+        Ref<TokenStorage> storage; // substituted macro body
+    };
+
+    /// Operands of "#if" replaced for "defined X"
+    static Token s_True{TokenType::LITERAL, L"1", 0, 0, 0};
+    static Token s_False{TokenType::LITERAL, L"0", 0, 0, 0};
+
+    static std::string ToUTF8(std::wstring_view str) {
+        return StringUtils::utf16_to_utf8(str);
+    }
+
+    /// First token after a line break - comments do not count
+    static bool IsLineStart(const _ParserTypeBase::TokenStorage& tokens, size_t index) {
+        auto line = tokens[index]->line;
+        while (index-- > 0) {
+            if (tokens[index]->type != TT::COMMENT)
+                return tokens[index]->line < line;
+        }
+        return true;
+    }
+
+    /// "#ifndef X / #define X" as the first directives and the "#endif" closing the "#ifndef" as the last one
+    static std::wstring_view FindGuard(const _ParserTypeBase::TokenStorage& tokens) {
+        std::vector<const Token*> t;
+        for (auto tok : tokens) {
+            if (tok->type == TT::END_OF_FILE)
+                break;
+            if (tok->type != TT::COMMENT)
+                t.push_back(tok);
+        }
+
+        if (t.size() < 8 || t[0]->type != TT::PREPROCESSOR || t[1]->value != L"ifndef" || t[2]->type != TT::IDENTIFIER)
+            return {};
+        if (t[3]->type != TT::PREPROCESSOR || t[3]->line == t[2]->line || t[4]->value != L"define" || t[5]->value != t[2]->value)
+            return {};
+
+        size_t depth = 0;
+        for (size_t i = 0; i + 1 < t.size(); i++) {
+            if (t[i]->type != TT::PREPROCESSOR || (i && t[i - 1]->line == t[i]->line))
+                continue;
+            auto name = t[i + 1]->value;
+            if (name == L"if" || name == L"ifdef" || name == L"ifndef") {
+                depth++;
+            } else if ((name == L"elif" || name == L"else") && depth == 1) {
+                return {};
+            } else if (name == L"endif" && --depth == 0) {
+                // nothing may follow the guard
+                for (size_t j = i + 2; j < t.size(); j++) {
+                    if (t[j]->line != t[i]->line)
+                        return {};
+                }
+                return t[2]->value;
+            }
+        }
+        return {};
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    // IncludeCache
+
+    bool IncludeCache::IsCurrent(const File& file) {
+        std::error_code ec;
+        auto write_time = std::filesystem::last_write_time(file.path, ec);
+        auto size       = ec ? 0 : std::filesystem::file_size(file.path, ec);
+        return !ec && write_time == file.write_time && size == file.size;
+    }
+
+    std::filesystem::path IncludeCache::Resolve(const std::filesystem::path& path) {
+        std::error_code ec;
+        auto resolved = std::filesystem::weakly_canonical(path, ec);
+        if (ec)
+            resolved = std::filesystem::absolute(path, ec);
+        return (ec ? path : resolved).lexically_normal();
+    }
+
+    Ref<const IncludeCache::File> IncludeCache::Load(const std::filesystem::path& include_path) {
+        // files are shared by compile requests from different working directories
+        auto path = Resolve(include_path);
+        std::error_code ec;
+        if (!std::filesystem::is_regular_file(path, ec))
+            return nullptr;
+        auto write_time = std::filesystem::last_write_time(path, ec);
+        auto size       = ec ? 0 : std::filesystem::file_size(path, ec);
+        if (ec)
+            return nullptr;
+
+        auto key = path.generic_string();
+        {
+            std::lock_guard lock(m_Lock);
+            auto it = m_Files.find(key);
+            if (it != m_Files.end() && it->second->write_time == write_time && it->second->size == size)
+                return it->second;
+        }
+
+        // lexed outside the lock - a file loaded by two threads at once is lexed twice and the last one is kept
+        std::ifstream stream(path, std::ios::binary);
+        if (!stream.is_open())
+            return nullptr;
+        std::stringstream ss;
+        ss << stream.rdbuf();
+
+        auto file        = CreateRef<File>();
+        file->path       = path;
+        file->write_time = write_time;
+        file->size       = size;
+        file->source     = CreateRef<SourceEntry>(StringUtils::utf8_to_utf16(ss.str()), path);
+        file->lexer      = CreateScope<Lexer>(file->source);
+        try {
+            file->lexer->ProcessSource();
+            file->tokens = Parser::PreProcessOperators(file->lexer);
+            file->guard  = FindGuard(file->tokens);
+        } catch (const std::exception& e) {
+            file->tokens.clear();
+            file->error = e.what();
+        }
+
+        std::lock_guard lock(m_Lock);
+        m_Files[key] = file;
+        return file;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    // Preprocessor
+
+    Preprocessor::Preprocessor(IncludeCache* includes) : m_IncludeCache(includes) {
+    }
+
+    Preprocessor::~Preprocessor() {
+    }
+
+    Preprocessor::TokenStorage Preprocessor::Process(TokenStorage tokens, const std::filesystem::path& path) {
+        m_Macros.clear();
+        m_Includes.clear();
+        m_Active = false;
+
+        if (std::none_of(tokens.begin(), tokens.end(), [](Token* tok) {
+                return tok->type == TT::PREPROCESSOR;
+            })) {
+            return tokens;
+        }
+
+        XRT_PROFILE_SCOPE("Preprocessor::Process");
+        TokenStorage out;
+        out.reserve(tokens.size());
+        m_IncludeStack = {IncludeCache::Resolve(path).generic_string()};
+        ProcessFile(tokens, path, &out);
+        m_IncludeStack.clear();
+        return out;
+    }
+
+    void Preprocessor::ProcessFile(const TokenStorage& tokens, const std::filesystem::path& path, TokenStorage* out) {
+        std::vector<Conditional> conditionals;
+        TokenStorage line;
+
+        size_t i = 0;
+        while (i < tokens.size() && tokens[i]->type != TT::END_OF_FILE) {
+            auto tok    = tokens[i];
+            bool active = conditionals.empty() || conditionals.back().active;
+
+            if (tok->type == TT::PREPROCESSOR && IsLineStart(tokens, i)) {
+                i = ReadDirective(tokens, i, line);
+                // includes stay source links for the parser
+                if (out && active && !line.empty() && line[0]->value == L"include") {
+                    out->push_back(tok);
+                    out->insert(out->end(), line.begin(), line.end());
+                }
+                Directive(line, conditionals, path);
+                continue;
+            }
+
+            // included files only contribute macros
+            if (!out || !active) {
+                i++;
+                continue;
+            }
+
+            if (tok->type == TT::IDENTIFIER && !m_Macros.empty()) {
+                auto it = m_Macros.find(tok->value);
+                if (it != m_Macros.end()) {
+                    Stack stack;
+                    stack.emplace_back(&tokens, i + 1).source = true;
+                    Call(it->second, tok, stack, 1, *out);
+                    Expand(stack, 1, *out);
+                    i = stack[0].position;
+                    continue;
+                }
+            }
+
+            out->push_back(tok);
+            i++;
+        }
+
+        if (!conditionals.empty())
+            throw PreprocessorError("Unterminated conditional directive", conditionals.back().token);
+
+        // end of file padding
+        if (out)
+            out->insert(out->end(), tokens.begin() + static_cast<ptrdiff_t>(i), tokens.end());
+    }
+
+    size_t Preprocessor::ReadDirective(const TokenStorage& tokens, size_t index, TokenStorage& line) {
+        line.clear();
+        size_t current = tokens[index]->line;
+        size_t i       = index + 1;
+        for (; i < tokens.size(); i++) {
+            auto tok = tokens[i];
+            if (tok->type == TT::END_OF_FILE || tok->line != current)
+                break;
+            if (tok->type == TT::COMMENT)
+                continue;
+            // "\" at the end of a line continues the directive
+            if (tok->type == TT::UNKNOWN && tok->value == L"\\" && i + 1 < tokens.size() && tokens[i + 1]->line > current) {
+                current = tokens[i + 1]->line;
+                continue;
+            }
+            line.push_back(tok);
+        }
+        return i;
+    }
+
+    void Preprocessor::Directive(const TokenStorage& line, std::vector<Conditional>& conditionals, const std::filesystem::path& path) {
+        if (line.empty())
+            return; // null directive
+
+        auto directive = line[0];
+        auto name      = directive->value;
+        bool active    = conditionals.empty() || conditionals.back().active;
+
+        if (name == L"if" || name == L"ifdef" || name == L"ifndef") {
+            bool value = false;
+            if (active) {
+                m_Active = true;
+                value    = name == L"if" ? Evaluate(line) : IsDefined(line) == (name == L"ifdef");
+            }
+            conditionals.push_back({directive, active && value, !active || value, false});
+            return;
+        }
+
+        if (name == L"elif" || name == L"else") {
+            if (conditionals.empty())
+                throw PreprocessorError("#" + ToUTF8(name) + " without #if", directive);
+            auto& c = conditionals.back();
+            if (c.has_else)
+                throw PreprocessorError("#" + ToUTF8(name) + " after #else", directive);
+            if (name == L"else") {
+                c.active   = !c.taken;
+                c.taken    = true;
+                c.has_else = true;
+            } else {
+                c.active = !c.taken && Evaluate(line);
+                c.taken  = c.taken || c.active;
+            }
+            return;
+        }
+
+        if (name == L"endif") {
+            if (conditionals.empty())
+                throw PreprocessorError("#endif without #if", directive);
+            conditionals.pop_back();
+            return;
+        }
+
+        // other directives in skipped regions are not checked
+        if (!active)
+            return;
+
+        if (name == L"include") {
+            Include(line, path);
+        } else if (name == L"define") {
+            m_Active = true;
+            Define(line);
+        } else if (name == L"undef") {
+            m_Active = true;
+            if (line.size() < 2 || line[1]->type != TT::IDENTIFIER)
+                throw PreprocessorError("Expected macro name", line.back());
+            m_Macros.erase(line[1]->value);
+            m_Generation++;
+        } else if (name == L"error") {
+            std::string message;
+            for (size_t i = 1; i < line.size(); i++)
+                message += (i > 1 ? " " : "") + ToUTF8(line[i]->value);
+            throw PreprocessorError("#error " + message, directive);
+        } else {
+            throw InvalidPreprocessorDirective("Unknown preprocessing directive", directive);
+        }
+    }
+
+    bool Preprocessor::IsDefined(const TokenStorage& line) const {
+        if (line.size() < 2 || line[1]->type != TT::IDENTIFIER)
+            throw PreprocessorError("Expected macro name", line.back());
+        return m_Macros.contains(line[1]->value);
+    }
+
+    void Preprocessor::Define(const TokenStorage& line) {
+        if (line.size() < 2 || line[1]->type != TT::IDENTIFIER)
+            throw PreprocessorError("Expected macro name", line.back());
+
+        auto name = line[1];
+        Macro macro;
+        size_t i = 2;
+
+        // "NAME(" without space is a function-like macro
+        if (i < line.size() && line[i]->type == TT::OPEN_PAREN && line[i]->value.data() == name->value.data() + name->value.size()) {
+            macro.function_like = true;
+            i++;
+            bool expect_name = true;
+            while (true) {
+                if (i >= line.size())
+                    throw PreprocessorError("Unterminated macro parameter list", name);
+                auto tok = line[i++];
+                if (tok->type == TT::CLOSE_PAREN && (expect_name ? macro.parameters.empty() : true))
+                    break;
+                if (expect_name && tok->type == TT::IDENTIFIER) {
+                    if (std::find(macro.parameters.begin(), macro.parameters.end(), tok->value) != macro.parameters.end())
+                        throw PreprocessorError("Duplicate macro parameter", tok);
+                    macro.parameters.push_back(tok->value);
+                } else if (expect_name || tok->type != TT::COMMA) {
+                    throw PreprocessorError("Invalid macro parameter list", tok);
+                }
+                expect_name = !expect_name;
+            }
+        }
+
+        macro.body.assign(line.begin() + static_cast<ptrdiff_t>(i), line.end());
+        for (auto tok : macro.body) {
+            if (tok->type == TT::PREPROCESSOR)
+                throw NotImplemented("# and ## in macro bodies", tok);
+            if (macro.function_like) {
+                auto it = std::find(macro.parameters.begin(), macro.parameters.end(), tok->value);
+                macro.body_parameters.push_back(tok->type == TT::IDENTIFIER && it != macro.parameters.end()
+                                                    ? static_cast<uint32_t>(it - macro.parameters.begin())
+                                                    : NO_PARAMETER);
+            }
+        }
+
+        m_Macros[name->value] = std::move(macro);
+        m_Generation++;
+    }
+
+    void Preprocessor::Include(const TokenStorage& line, const std::filesystem::path& path) {
+        // the parser reports malformed includes
+        if (!m_IncludeCache || line.size() < 2 || line[1]->type != TT::STRING_LITERAL)
+            return;
+
+        auto name = line[1]->value.substr(1, line[1]->value.size() - 2);
+        if (name.find_first_of(L"*?") != std::wstring_view::npos)
+            return; // wildcard link
+
+        std::filesystem::path target = ToUTF8(name);
+        if (target.is_relative())
+            target = path.parent_path() / target;
+        auto file = m_IncludeCache->Load(target);
+        if (!file)
+            return; // link to a source that is not a file here
+
+        auto key = file->path.generic_string();
+        if ((!file->guard.empty() && m_Macros.contains(file->guard)) ||
+            std::find(m_IncludeStack.begin(), m_IncludeStack.end(), key) != m_IncludeStack.end()) {
+            m_Statistics.includes_skipped++;
+            return;
+        }
+        if (!file->error.empty())
+            throw PreprocessorError("Failed to lex included file: " + file->error, line[1]);
+
+        m_Statistics.includes_loaded++;
+        if (std::find(m_Includes.begin(), m_Includes.end(), file) == m_Includes.end())
+            m_Includes.push_back(file);
+
+        m_IncludeStack.push_back(std::move(key));
+        ProcessFile(file->tokens, file->path, nullptr);
+        m_IncludeStack.pop_back();
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    // Expansion
+
+    void Preprocessor::Pop(Stack& stack) {
+        if (stack.back().macro)
+            stack.back().macro->expanding = false;
+        stack.pop_back();
+    }
+
+    Preprocessor::Token* Preprocessor::Read(Stack& stack, size_t floor) {
+        while (stack.size() > floor) {
+            auto& context = stack.back();
+            if (context.position < context.tokens->size())
+                return (*context.tokens)[context.position++];
+            Pop(stack);
+        }
+
+        if (floor == 0)
+            return nullptr;
+
+        auto& source = stack[floor - 1];
+        while (source.position < source.tokens->size()) {
+            auto tok = (*source.tokens)[source.position];
+            if (tok->type == TT::COMMENT) {
+                source.position++;
+                continue;
+            }
+            if (tok->type == TT::END_OF_FILE || (tok->type == TT::PREPROCESSOR && IsLineStart(*source.tokens, source.position)))
+                return nullptr;
+            source.position++;
+            return tok;
+        }
+        return nullptr;
+    }
+
+    Preprocessor::Lookahead Preprocessor::Peek(const Stack& stack, size_t floor) const {
+        for (size_t i = stack.size(); i-- > floor;) {
+            auto& context = stack[i];
+            if (context.position < context.tokens->size())
+                return (*context.tokens)[context.position]->type == TT::OPEN_PAREN ? Lookahead::PAREN : Lookahead::OTHER;
+        }
+
+        if (floor == 0)
+            return Lookahead::END;
+
+        auto& source = stack[floor - 1];
+        for (auto i = source.position; i < source.tokens->size(); i++) {
+            auto tok = (*source.tokens)[i];
+            if (tok->type != TT::COMMENT)
+                return tok->type == TT::OPEN_PAREN ? Lookahead::PAREN : Lookahead::OTHER;
+        }
+        return Lookahead::OTHER;
+    }
+
+    bool Preprocessor::Expand(Stack& stack, size_t floor, TokenStorage& out) {
+        while (stack.size() > floor) {
+            auto& context = stack.back();
+            if (context.position == context.tokens->size()) {
+                Pop(stack);
+                continue;
+            }
+
+            auto tok      = (*context.tokens)[context.position++];
+            bool expanded = context.expanded;
+            if (tok->type != TT::IDENTIFIER || (expanded && context.position != context.tokens->size())) {
+                out.push_back(tok);
+                continue;
+            }
+
+            auto it = m_Macros.find(tok->value);
+            if (it == m_Macros.end() || (expanded && !it->second.function_like)) {
+                out.push_back(tok);
+                continue;
+            }
+
+            if (!Call(it->second, tok, stack, floor, out)) {
+                while (stack.size() > floor)
+                    Pop(stack);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool Preprocessor::Call(Macro& macro, Token* name, Stack& stack, size_t floor, TokenStorage& out) {
+        if (macro.expanding) {
+            m_Suppressed++;
+            out.push_back(name);
+            return true;
+        }
+        if (m_Depth >= MAX_EXPANSION_DEPTH)
+            throw PreprocessorError("Macro expansion too deep", name);
+
+        if (!macro.function_like) {
+            if (macro.generation == m_Generation) {
+                m_Statistics.memo_hits++;
+                macro.expanding = true;
+                stack.emplace_back(&macro.expansion, 0, &macro, true);
+                return true;
+            }
+
+            // expand the body on its own - without names of expanding macros the result holds in any context
+            m_Statistics.expansions++;
+            TokenStorage expansion;
+            Stack body;
+            body.emplace_back(&macro.body, 0);
+            auto suppressed = m_Suppressed;
+            macro.expanding = true;
+            m_Depth++;
+            bool complete = Expand(body, 0, expansion);
+            m_Depth--;
+
+            if (!complete) {
+                // a macro call in the body takes arguments from the following tokens
+                stack.emplace_back(&macro.body, 0, &macro);
+            } else if (m_Suppressed == suppressed) {
+                macro.expansion  = std::move(expansion);
+                macro.generation = m_Generation;
+                stack.emplace_back(&macro.expansion, 0, &macro, true);
+            } else {
+                auto storage = CreateRef<TokenStorage>(std::move(expansion));
+                stack.emplace_back(storage.get(), 0, &macro, true, storage);
+            }
+            return true;
+        }
+
+        switch (Peek(stack, floor)) {
+            case Lookahead::END: return false;
+            case Lookahead::OTHER: out.push_back(name); return true;
+            case Lookahead::PAREN: Read(stack, floor); break;
+        }
+
+        m_Statistics.expansions++;
+        std::vector<TokenStorage> arguments(1);
+        size_t depth = 0;
+        while (true) {
+            auto tok = Read(stack, floor);
+            if (!tok) {
+                if (floor == 0)
+                    return false;
+                throw PreprocessorError("Unterminated macro call", name);
+            }
+            if (tok->type == TT::OPEN_PAREN) {
+                depth++;
+            } else if (tok->type == TT::CLOSE_PAREN && depth-- == 0) {
+                break;
+            } else if (tok->type == TT::COMMA && depth == 0) {
+                arguments.emplace_back();
+                continue;
+            }
+            arguments.back().push_back(tok);
+        }
+
+        if (macro.parameters.empty() && arguments.size() == 1 && arguments[0].empty())
+            arguments.clear();
+        if (arguments.size() != macro.parameters.size()) {
+            throw PreprocessorError(fmt::format("Macro expects {} arguments, got {}", macro.parameters.size(), arguments.size()), name);
+        }
+
+        // arguments are expanded before substitution
+        std::vector<TokenStorage> expanded(arguments.size());
+        m_Depth++;
+        for (size_t a = 0; a < arguments.size(); a++) {
+            Stack argument;
+            argument.emplace_back(&arguments[a], 0);
+            if (!Expand(argument, 0, expanded[a]))
+                throw PreprocessorError("Unterminated macro call in argument", name);
+        }
+        m_Depth--;
+
+        auto storage = CreateRef<TokenStorage>();
+        for (size_t t = 0; t < macro.body.size(); t++) {
+            auto parameter = macro.body_parameters[t];
+            if (parameter == NO_PARAMETER) {
+                storage->push_back(macro.body[t]);
+            } else {
+                storage->insert(storage->end(), expanded[parameter].begin(), expanded[parameter].end());
+            }
+        }
+
+        macro.expanding = true;
+        stack.emplace_back(storage.get(), 0, &macro, false, storage);
+        return true;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    // #if expressions
+
+    /// Integer constant expression with C precedence - identifiers left after expansion are 0
+    class ConditionEvaluator {
+    public:
+        ConditionEvaluator(const _ParserTypeBase::TokenStorage& tokens, const Token* directive) : m_Tokens(tokens), m_Directive(directive) {
+        }
+
+        int64_t Evaluate() {
+            if (m_Tokens.empty())
+                throw _ParserTypeBase::PreprocessorError("Expected expression", m_Directive);
+            auto value = Conditional(true);
+            if (m_Position != m_Tokens.size())
+                throw _ParserTypeBase::PreprocessorError("Unexpected token in expression", m_Tokens[m_Position]);
+            return value;
+        }
+
+    private:
+        const Token* Current() const {
+            return m_Position < m_Tokens.size() ? m_Tokens[m_Position] : nullptr;
+        }
+
+        const Token* Expect() {
+            auto tok = Current();
+            if (!tok)
+                throw _ParserTypeBase::PreprocessorError("Unexpected end of expression", m_Tokens.empty() ? m_Directive : m_Tokens.back());
+            m_Position++;
+            return tok;
+        }
+
+        static int Precedence(const Token* tok) {
+            switch (tok->type) {
+                case TT::BOOL_OR: return 1;
+                case TT::BOOL_AND: return 2;
+                case TT::OR: return 3;
+                case TT::XOR: return 4;
+                case TT::AND: return 5;
+                case TT::EQUAL:
+                case TT::NOT_EQUAL: return 6;
+                case TT::LT:
+                case TT::GT:
+                case TT::LTEQ:
+                case TT::GTEQ: return 7;
+                case TT::LSL:
+                case TT::LSR: return 8;
+                case TT::ADD:
+                case TT::SUB: return 9;
+                case TT::MUL:
+                case TT::DIV: return 10;
+                case TT::UNKNOWN: return tok->value == L"%" ? 10 : 0;
+                default: return 0;
+            }
+        }
+
+        // live - result is used, division by zero is only an error there
+        int64_t Conditional(bool live) {
+            auto condition = Binary(1, live);
+            auto tok       = Current();
+            if (!tok || tok->type != TT::TERNARY_IF)
+                return condition;
+            m_Position++;
+            auto a = Conditional(live && condition);
+            if (Expect()->type != TT::TERNARY_ELSE)
+                throw _ParserTypeBase::PreprocessorError("Expected ':' in expression", m_Tokens[m_Position - 1]);
+            auto b = Conditional(live && !condition);
+            return condition ? a : b;
+        }
+
+        int64_t Binary(int min_precedence, bool live) {
+            auto lhs = Unary(live);
+            while (auto tok = Current()) {
+                auto precedence = Precedence(tok);
+                if (precedence < min_precedence || precedence == 0)
+                    break;
+                m_Position++;
+                bool rhs_live = live && !(tok->type == TT::BOOL_OR && lhs) && !(tok->type == TT::BOOL_AND && !lhs);
+                auto rhs      = Binary(precedence + 1, rhs_live);
+                lhs           = Apply(tok, lhs, rhs, rhs_live);
+            }
+            return lhs;
+        }
+
+        static int64_t Apply(const Token* op, int64_t a, int64_t b, bool live) {
+            auto ua = static_cast<uint64_t>(a);
+            auto ub = static_cast<uint64_t>(b);
+            switch (op->type) {
+                case TT::BOOL_OR: return a || b;
+                case TT::BOOL_AND: return a && b;
+                case TT::OR: return static_cast<int64_t>(ua | ub);
+                case TT::XOR: return static_cast<int64_t>(ua ^ ub);
+                case TT::AND: return static_cast<int64_t>(ua & ub);
+                case TT::EQUAL: return a == b;
+                case TT::NOT_EQUAL: return a != b;
+                case TT::LT: return a < b;
+                case TT::GT: return a > b;
+                case TT::LTEQ: return a <= b;
+                case TT::GTEQ: return a >= b;
+                case TT::LSL: return static_cast<int64_t>(ua << (ub & 63));
+                case TT::LSR: return a >> (ub & 63);
+                case TT::ADD: return static_cast<int64_t>(ua + ub);
+                case TT::SUB: return static_cast<int64_t>(ua - ub);
+                case TT::MUL: return static_cast<int64_t>(ua * ub);
+                default: break;
+            }
+            // "/" and "%"
+            if (b == 0) {
+                if (live)
+                    throw _ParserTypeBase::PreprocessorError("Division by zero in expression", op);
+                return 0;
+            }
+            if (a == INT64_MIN && b == -1)
+                return op->type == TT::DIV ? a : 0;
+            return op->type == TT::DIV ? a / b : a % b;
+        }
+
+        int64_t Unary(bool live) {
+            auto tok = Expect();
+            switch (tok->type) {
+                case TT::NOT: return !Unary(live);
+                case TT::SUB: return static_cast<int64_t>(0 - static_cast<uint64_t>(Unary(live)));
+                case TT::ADD: return Unary(live);
+                case TT::UNKNOWN:
+                    if (tok->value == L"~")
+                        return static_cast<int64_t>(~static_cast<uint64_t>(Unary(live)));
+                    break;
+                case TT::OPEN_PAREN: {
+                    auto value = Conditional(live);
+                    if (Expect()->type != TT::CLOSE_PAREN)
+                        throw _ParserTypeBase::PreprocessorError("Expected ')' in expression", m_Tokens[m_Position - 1]);
+                    return value;
+                }
+                case TT::LITERAL: return Literal(tok);
+                case TT::IDENTIFIER: return tok->value == L"true";
+                default: break;
+            }
+            throw _ParserTypeBase::PreprocessorError("Unexpected token in expression", tok);
+        }
+
+        /// 1234, 0x12AB, 0b1010, 1_000
+        static int64_t Literal(const Token* tok) {
+            std::wstring_view text = tok->value;
+            uint64_t base          = 10;
+            if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+                base = 16;
+                text.remove_prefix(2);
+            } else if (text.size() > 2 && text[0] == '0' && (text[1] == 'b' || text[1] == 'B')) {
+                base = 2;
+                text.remove_prefix(2);
+            }
+
+            uint64_t value = 0;
+            for (auto c : text) {
+                uint64_t digit;
+                if (c == '_') {
+                    continue;
+                } else if (c >= '0' && c <= '9') {
+                    digit = static_cast<uint64_t>(c - '0');
+                } else if (c >= 'a' && c <= 'f') {
+                    digit = static_cast<uint64_t>(c - 'a' + 10);
+                } else if (c >= 'A' && c <= 'F') {
+                    digit = static_cast<uint64_t>(c - 'A' + 10);
+                } else {
+                    digit = base;
+                }
+                if (digit >= base)
+                    throw _ParserTypeBase::PreprocessorError("Invalid number literal", tok);
+                value = value * base + digit;
+            }
+            return static_cast<int64_t>(value);
+        }
+
+    private:
+        const _ParserTypeBase::TokenStorage& m_Tokens;
+        const Token* m_Directive;
+        size_t m_Position = 0;
+    };
+
+    bool Preprocessor::Evaluate(const TokenStorage& line) {
+        // "defined X" and "defined(X)" before expansion
+        TokenStorage tokens;
+        for (size_t i = 1; i < line.size(); i++) {
+            if (line[i]->type != TT::IDENTIFIER || line[i]->value != L"defined") {
+                tokens.push_back(line[i]);
+                continue;
+            }
+            bool paren = i + 1 < line.size() && line[i + 1]->type == TT::OPEN_PAREN;
+            auto name  = i + 1 + paren;
+            if (name >= line.size() || line[name]->type != TT::IDENTIFIER ||
+                (paren && (name + 1 >= line.size() || line[name + 1]->type != TT::CLOSE_PAREN))) {
+                throw PreprocessorError("Expected macro name after defined", line[i]);
+            }
+            tokens.push_back(m_Macros.contains(line[name]->value) ? &s_True : &s_False);
+            i = name + paren;
+        }
+
+        TokenStorage expanded;
+        Stack stack;
+        stack.emplace_back(&tokens, 0);
+        if (!Expand(stack, 0, expanded))
+            throw PreprocessorError("Unterminated macro call in expression", line[0]);
+        return ConditionEvaluator(expanded, line[0]).Evaluate() != 0;
+    }
+
+} // namespace XRT
@@ -0,0 +1,142 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <Utils.hpp>
+#include "_ParserTypeBase.hpp"
+#include "Language/SourceEntry.hpp"
+
+namespace XRT {
+
+    class Lexer;
+
+    /// Included files lexed once and shared by all preprocessors that use the cache - thread safe.
+    /// A file is lexed again when its size or write time changes.
+    class IncludeCache {
+    public:
+        struct File {
+            std::filesystem::path path;
+            Ref<SourceEntry> source;
+            Scope<Lexer> lexer;
+            std::vector<Token*> tokens; // operators merged, owned by the lexer
+            std::wstring_view guard;    // "#ifndef X / #define X ... #endif" around the whole file - empty if not guarded
+            std::string error;          // lexer error - no tokens
+            std::filesystem::file_time_type write_time{};
+            uintmax_t size = 0;
+        };
+
+    public:
+        /// Cached or freshly lexed file - nullptr if path is not a readable regular file
+        Ref<const File> Load(const std::filesystem::path& path);
+
+        /// File on disk still has the cached size and write time
+        static bool IsCurrent(const File& file);
+
+        /// Absolute normalized path - cache key of a file, relative paths resolve against the current directory
+        static std::filesystem::path Resolve(const std::filesystem::path& path);
+
+    private:
+        std::mutex m_Lock;
+        std::unordered_map<std::string, Ref<const File>> m_Files; // [resolved path]
+    };
+
+    /// Token stream stage between the lexer and the parser.
+    /// Handles #define (object and function-like), #undef, #if/#ifdef/#ifndef/#elif/#else/#endif and #error.
+    /// Expansion works on token handles - expanded tokens are the tokens of the macro definition, nothing is relexed.
+    /// The expansion of a macro without arguments is memoised until the next #define/#undef, so nested macro tables
+    /// are expanded once per macro and output stays linear in its size.
+    /// #include directives are passed on to the parser as source links. With an include cache, macros and conditionals of an
+    /// included file that exists are processed as well - files already on the include stack and files whose include guard
+    /// is defined are skipped without scanning them again.
+    class Preprocessor : public _ParserTypeBase {
+    public:
+        static constexpr size_t MAX_EXPANSION_DEPTH = 256;
+        static constexpr uint32_t NO_PARAMETER      = UINT32_MAX;
+
+        struct Statistics {
+            uint64_t expansions       = 0;
+            uint64_t memo_hits        = 0;
+            uint64_t includes_loaded  = 0;
+            uint64_t includes_skipped = 0; // include guard defined or file on the include stack
+        };
+
+    public:
+        /// includes - cache for #include files (nullptr - includes are only passed on)
+        Preprocessor(IncludeCache* includes = nullptr);
+        ~Preprocessor();
+
+        Preprocessor(const Preprocessor&)            = delete;
+        Preprocessor& operator=(const Preprocessor&) = delete;
+
+        /// Process the operator merged tokens of a source - tokens without directives are returned as they are
+        TokenStorage Process(TokenStorage tokens, const std::filesystem::path& path);
+
+        /// The source used a directive other than #include or got macros from an included file -
+        /// output tokens may come from other lines or files than their neighbours
+        bool IsActive() const {
+            return m_Active;
+        }
+
+        /// Included files that were processed - output tokens reference them, so they are kept alive here
+        const std::vector<Ref<const IncludeCache::File>>& GetIncludes() const {
+            return m_Includes;
+        }
+
+        const Statistics& GetStatistics() const {
+            return m_Statistics;
+        }
+
+    private:
+        struct Macro {
+            std::vector<std::wstring_view> parameters;
+            std::vector<Token*> body;
+            std::vector<uint32_t> body_parameters; // [body token] parameter index, NO_PARAMETER for other tokens
+            bool function_like = false;
+            bool expanding     = false; // active while its expansion is read - not expanded again
+            std::vector<Token*> expansion; // memoised expansion of a macro without parameters
+            uint64_t generation = 0;       // m_Generation of expansion, 0 - none
+        };
+
+        struct Conditional {
+            const Token* token;
+            bool active;     // tokens of the current branch are used
+            bool taken;      // a branch was taken or the enclosing region is inactive
+            bool has_else;
+        };
+
+        struct Context;
+        using Stack = std::vector<Context>;
+        enum class Lookahead { PAREN, OTHER, END };
+
+        void ProcessFile(const TokenStorage& tokens, const std::filesystem::path& path, TokenStorage* out);
+        /// Collect the tokens of the directive starting at index - returns the index after it
+        static size_t ReadDirective(const TokenStorage& tokens, size_t index, TokenStorage& line);
+        void Directive(const TokenStorage& line, std::vector<Conditional>& conditionals, const std::filesystem::path& path);
+        void Define(const TokenStorage& line);
+        void Include(const TokenStorage& line, const std::filesystem::path& path);
+        bool Evaluate(const TokenStorage& line);
+        bool IsDefined(const TokenStorage& line) const;
+
+        bool Expand(Stack& stack, size_t floor, TokenStorage& out);
+        bool Call(Macro& macro, Token* name, Stack& stack, size_t floor, TokenStorage& out);
+        Token* Read(Stack& stack, size_t floor);
+        Lookahead Peek(const Stack& stack, size_t floor) const;
+        void Pop(Stack& stack);
+
+    private:
+        IncludeCache* m_IncludeCache;
+        std::unordered_map<std::wstring_view, Macro> m_Macros;
+        uint64_t m_Generation = 1; // incremented by #define and #undef
+        uint64_t m_Suppressed = 0; // names of expanding macros seen - expansions that saw one depend on their context
+        size_t m_Depth        = 0;
+        std::vector<std::string> m_IncludeStack; // [normalized path]
+        std::vector<Ref<const IncludeCache::File>> m_Includes;
+        bool m_Active = false;
+        Statistics m_Statistics;
+    };
+
+} // namespace XRT
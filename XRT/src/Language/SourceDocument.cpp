@@ -0,0 +1,429 @@
+#include "SourceDocument.hpp"
+#include <algorithm>
+#include "Language/Lexer.hpp"
+#include "Language/Parser.hpp"
+#include "Profiler.hpp"
+
+namespace XRT {
+
+    /// Text being relexed/reparsed - replaces segments [first, last)
+    struct SourceDocument::Window {
+        ~Window() {
+            Reset();
+        }
+
+        void Reset() {
+            parser.reset();
+            lexer.reset();
+            diagnostics.clear();
+            error = false;
+        }
+
+        Location base;
+        std::wstring text;
+        size_t first = 0;
+        size_t last  = 0;
+        Ref<SourceEntry> source;
+        Scope<Lexer> lexer;
+        Scope<Parser> parser;
+        std::vector<Diagnostic> diagnostics;
+        bool error = false; // lexer error - no usable tokens
+    };
+
+    static bool IsSpace(wchar_t c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    static bool IsPunctuator(wchar_t c) {
+        return c < 128 && std::wstring_view{L"!%^&*()-+={}|~[];:<>?,.#/\\"}.find(c) != std::wstring_view::npos;
+    }
+
+    /// Could lexing a and b separately give different tokens than lexing them together.
+    /// The lexer continues a run of punctuators ("};//" is four punctuators), anything else after a punctuator starts a new token.
+    static bool Joinable(wchar_t a, wchar_t b) {
+        return !IsSpace(a) && !IsSpace(b) && (!IsPunctuator(a) || IsPunctuator(b));
+    }
+
+    static void Advance(size_t& line, size_t& column, std::wstring_view text) {
+        for (auto c : text) {
+            if (c == '\n') {
+                line++;
+                column = 1;
+            } else {
+                column++;
+            }
+        }
+    }
+
+    SourceDocument::Segment::~Segment() {
+        for (auto tok : tokens)
+            delete tok;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    SourceDocument::SourceDocument(const std::filesystem::path& path, IncludeCache* includes) :
+        m_Path(path), m_IncludeCache(includes), m_AST(CreateRef<AST>()) {
+    }
+
+    SourceDocument::~SourceDocument() {
+        // entries reference segment tokens
+        m_AST->TakeEntries();
+    }
+
+    void SourceDocument::Open(std::wstring text) {
+        XRT_PROFILE_SCOPE("SourceDocument::Open");
+        m_LastRelexLength = 0;
+        m_Length          = text.size();
+        m_Version++;
+
+        Window window;
+        window.text  = std::move(text);
+        window.first = 0;
+        window.last  = m_Segments.size();
+        ParseWindow(window, false);
+
+        std::vector<Scope<Segment>> segments;
+        SplitWindow(window, segments);
+        auto entries = window.parser && window.parser->GetAST() ? window.parser->GetAST()->TakeEntries() : std::vector<Scope<AST_Entry>>{};
+        m_AST->Replace(0, m_AST->GetEntries().size(), std::move(entries));
+        m_Segments     = std::move(segments);
+        m_Preprocessed = window.parser && window.parser->GetPreprocessor().IsActive();
+        m_Includes     = window.parser ? window.parser->GetPreprocessor().GetIncludes() : std::vector<Ref<const IncludeCache::File>>{};
+    }
+
+    void SourceDocument::Edit(size_t offset, size_t length, std::wstring_view text) {
+        XRT_PROFILE_SCOPE("SourceDocument::Edit");
+        offset = std::min(offset, m_Length);
+        length = std::min(length, m_Length - offset);
+        if (m_Segments.empty()) {
+            Open(std::wstring{text});
+            return;
+        }
+        if (m_Preprocessed) {
+            Open(GetText().replace(offset, length, text));
+            return;
+        }
+
+        // segments touched by the edit - an edit on a boundary belongs to the later segment
+        auto find = [&](size_t position) -> size_t {
+            auto it = std::upper_bound(m_Segments.begin(), m_Segments.end(), position, [](size_t pos, const Scope<Segment>& seg) {
+                return pos < seg->base.offset;
+            });
+            return static_cast<size_t>(it - m_Segments.begin()) - 1;
+        };
+        size_t first = find(offset);
+        size_t last  = find(offset + length) + 1;
+
+        std::wstring window_text;
+        for (size_t i = first; i < last; i++)
+            window_text += m_Segments[i]->GetText();
+        window_text.replace(offset - m_Segments[first]->base.offset, length, text);
+        m_Length = m_Length - length + text.size();
+
+        // removed text makes the neighbours adjacent
+        while (window_text.empty() && last < m_Segments.size())
+            window_text += m_Segments[last++]->GetText();
+        // the previous segment ends on a token that could continue into the window
+        while (first > 0 && !window_text.empty() && Joinable(m_Segments[first - 1]->GetText().back(), window_text.front()))
+            window_text.insert(0, m_Segments[--first]->GetText());
+
+        Reparse(first, last, std::move(window_text));
+        m_Version++;
+    }
+
+    void SourceDocument::Reparse(size_t first, size_t last, std::wstring&& text) {
+        m_LastRelexLength = 0;
+
+        Window window;
+        window.base  = m_Segments[first]->base;
+        window.text  = std::move(text);
+        window.first = first;
+        window.last  = last;
+
+        // grow over following segments until the window ends on a stable boundary
+        size_t grow = 1;
+        while (!ParseWindow(window, window.last < m_Segments.size())) {
+            window.Reset();
+            for (size_t i = 0; i < grow && window.last < m_Segments.size(); i++)
+                window.text += m_Segments[window.last++]->GetText();
+            grow *= 2;
+        }
+
+        // macros defined in the window can change any following declaration
+        if (window.parser && window.parser->GetPreprocessor().IsActive()) {
+            std::wstring whole;
+            for (size_t i = 0; i < window.first; i++)
+                whole += m_Segments[i]->GetText();
+            whole += window.text;
+            for (size_t i = window.last; i < m_Segments.size(); i++)
+                whole += m_Segments[i]->GetText();
+            window.Reset();
+            Open(std::move(whole));
+            return;
+        }
+
+        std::vector<Scope<Segment>> segments;
+        SplitWindow(window, segments);
+
+        size_t entry_first = 0;
+        size_t entry_count = 0;
+        for (size_t i = 0; i < window.last; i++)
+            (i < window.first ? entry_first : entry_count) += m_Segments[i]->entries;
+        auto entries = window.parser && window.parser->GetAST() ? window.parser->GetAST()->TakeEntries() : std::vector<Scope<AST_Entry>>{};
+        m_AST->Replace(entry_first, entry_count, std::move(entries));
+
+        auto it = m_Segments.erase(m_Segments.begin() + static_cast<ptrdiff_t>(window.first), m_Segments.begin() + static_cast<ptrdiff_t>(window.last));
+        m_Segments.insert(it, std::make_move_iterator(segments.begin()), std::make_move_iterator(segments.end()));
+
+        // segments after the window only move - their tokens are relocated when the AST is requested
+        UpdateBases();
+    }
+
+    bool SourceDocument::ParseWindow(Window& window, bool has_more) {
+        m_LastRelexLength += window.text.size();
+        window.source = CreateRef<SourceEntry>(window.text, m_Path);
+        window.lexer  = CreateScope<Lexer>(window.source);
+
+        auto content = window.source->GetContent();
+        auto& tokens = window.lexer->GetTokens();
+        auto& base   = window.base;
+
+        try {
+            window.lexer->ProcessSource();
+        } catch (const Lexer::UnknownTokenException& e) {
+            auto remaining = e.GetRemaining();
+            // unterminated block comment or string - may be closed by following text
+            if (has_more && (remaining.starts_with(L"/*") || remaining.starts_with(L'"')))
+                return false;
+
+            auto position = content.size() - remaining.size();
+            size_t line   = base.line;
+            size_t column = base.column;
+            Advance(line, column, content.substr(0, position));
+            auto detail = remaining.substr(0, std::min(remaining.find_first_of(L"\r\n"), remaining.size()));
+            window.diagnostics.push_back({Diagnostic::Severity::ERROR, e.what(), StringUtils::utf16_to_utf8(detail), m_Path, line, column});
+            window.error = true;
+            return true;
+        }
+
+        if (tokens.empty())
+            return true;
+
+        if (has_more) {
+            auto last = std::find_if(tokens.rbegin(), tokens.rend(), [](Token* tok) {
+                return tok->type != TokenType::END_OF_FILE;
+            });
+            // line comment or token cut by the window end
+            if (last != tokens.rend() && (*last)->offset + (*last)->value.size() == content.size() &&
+                ((*last)->type == TokenType::COMMENT || Joinable(content.back(), m_Segments[window.last]->GetText().front()))) {
+                return false;
+            }
+            // unterminated block comment lexes as punctuators - may be closed by following text
+            for (size_t i = 0; i + 1 < tokens.size(); i++) {
+                if (tokens[i]->type == TokenType::PUNCTUATOR && tokens[i]->value == L"/" && tokens[i + 1]->type == TokenType::PUNCTUATOR &&
+                    tokens[i + 1]->value == L"*" && tokens[i + 1]->offset == tokens[i]->offset + 1) {
+                    return false;
+                }
+            }
+        }
+
+        // window relative to document locations
+        for (auto tok : tokens) {
+            tok->column = tok->line == 1 ? base.column + tok->column - 1 : tok->column;
+            tok->line   = base.line + tok->line - 1;
+            tok->offset += base.offset;
+        }
+
+        window.parser = CreateScope<Parser>(m_IncludeCache);
+        try {
+            window.parser->Parse(window.lexer);
+        } catch (const Parser::PreprocessorError& e) {
+            // conditionals and macro calls can be closed by following text
+            if (has_more)
+                return false;
+            window.diagnostics.push_back({Diagnostic::Severity::ERROR, e.what(), {}, m_Path, e.GetLine(), e.GetColumn()});
+        } catch (const Parser::ParseException& e) {
+            // the parser decides on one token of lookahead - only an error at the end depends on following text
+            auto eof = tokens.back();
+            if (has_more && e.GetLine() == eof->line && e.GetColumn() == eof->column)
+                return false;
+            window.diagnostics.push_back({Diagnostic::Severity::ERROR, e.what(), {}, m_Path, e.GetLine(), e.GetColumn()});
+        } catch (const std::exception& e) {
+            window.diagnostics.push_back({Diagnostic::Severity::ERROR, e.what(), {}, m_Path, base.line, base.column});
+        }
+        return true;
+    }
+
+    void SourceDocument::SplitWindow(Window& window, std::vector<Scope<Segment>>& segments) {
+        auto content = window.source->GetContent();
+        auto& tokens = window.lexer->GetTokens();
+
+        auto add_segment = [&](size_t begin, size_t end, size_t entries) {
+            auto seg     = CreateScope<Segment>();
+            seg->source  = window.source;
+            seg->begin   = begin;
+            seg->end     = end;
+            seg->entries = entries;
+            for (size_t i = begin; i < end; i++) {
+                if (content[i] == '\n') {
+                    seg->lines++;
+                    seg->last_line_size = 0;
+                } else {
+                    seg->last_line_size++;
+                }
+            }
+            segments.push_back(std::move(seg));
+        };
+
+        size_t begin = 0;
+        if (!window.error && window.parser) {
+            size_t entries = 0;
+            for (auto& item : window.parser->GetTopLevelItems()) {
+                add_segment(begin, item.end - window.base.offset, item.entries - entries);
+                begin   = item.end - window.base.offset;
+                entries = item.entries;
+            }
+        }
+        // trivia after the last declaration or the text of the failed declaration
+        if (begin < content.size())
+            add_segment(begin, content.size(), 0);
+        if (!window.diagnostics.empty())
+            segments.back()->diagnostics = std::move(window.diagnostics);
+
+        if (window.error) {
+            window.Reset(); // tokens of a failed lex are not usable
+        } else {
+            // token ownership - padding tokens go to the last segment
+            size_t t = 0;
+            for (size_t i = 0; i < segments.size(); i++) {
+                auto end = window.base.offset + segments[i]->end;
+                while (t < tokens.size() && (tokens[t]->offset < end || i + 1 == segments.size()))
+                    segments[i]->tokens.push_back(tokens[t++]);
+            }
+            tokens.clear();
+        }
+
+        // locations are current for fresh segments
+        auto location = window.base;
+        for (auto& seg : segments) {
+            seg->base       = location;
+            seg->token_base = location;
+            location.offset += seg->end - seg->begin;
+            location.line += seg->lines;
+            location.column = seg->lines ? seg->last_line_size + 1 : location.column + seg->end - seg->begin;
+        }
+    }
+
+    void SourceDocument::UpdateBases() {
+        Location location;
+        for (auto& seg : m_Segments) {
+            seg->base = location;
+            location.offset += seg->end - seg->begin;
+            location.line += seg->lines;
+            location.column = seg->lines ? seg->last_line_size + 1 : location.column + seg->end - seg->begin;
+        }
+    }
+
+    void SourceDocument::Relocate(Segment& segment) {
+        auto& from = segment.token_base;
+        auto& to   = segment.base;
+        for (auto tok : segment.tokens) {
+            if (tok->line == from.line)
+                tok->column = tok->column + to.column - from.column;
+            tok->line   = tok->line + to.line - from.line;
+            tok->offset = tok->offset + to.offset - from.offset;
+        }
+        for (auto& d : segment.diagnostics) {
+            if (d.line == from.line)
+                d.column = d.column + to.column - from.column;
+            d.line = d.line + to.line - from.line;
+        }
+        from = to;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    const Ref<AST>& SourceDocument::GetAST() {
+        XRT_PROFILE_SCOPE("SourceDocument::GetAST");
+        for (auto& seg : m_Segments) {
+            if (!(seg->base == seg->token_base))
+                Relocate(*seg);
+        }
+        return m_AST;
+    }
+
+    std::vector<const Token*> SourceDocument::GetTokens() {
+        GetAST();
+        std::vector<const Token*> tokens;
+        size_t end = 0;
+        for (auto& seg : m_Segments) {
+            for (auto tok : seg->tokens) {
+                // punctuators merged into the operator before them ("::") stay in the lexer output
+                if (tok->type == TokenType::END_OF_FILE || (tok->offset < end && !tokens.empty()))
+                    continue;
+                tokens.push_back(tok);
+                end = tok->offset + tok->value.size();
+            }
+        }
+        return tokens;
+    }
+
+    size_t SourceDocument::GetOffset(size_t line, size_t column) const {
+        if (m_Segments.empty())
+            return 0;
+
+        // last segment starting at or before the location
+        auto it = std::upper_bound(m_Segments.begin(), m_Segments.end(), std::make_pair(line, column), [](auto& location, const Scope<Segment>& seg) {
+            return location < std::make_pair(seg->base.line, seg->base.column);
+        });
+        if (it != m_Segments.begin())
+            it--;
+
+        size_t current = (*it)->base.line;
+        size_t col     = (*it)->base.column;
+        size_t offset  = (*it)->base.offset;
+        for (; it != m_Segments.end(); it++) {
+            for (auto c : (*it)->GetText()) {
+                if (current == line && (col == column || c == '\n'))
+                    return offset;
+                if (c == '\n') {
+                    current++;
+                    col = 1;
+                } else {
+                    col++;
+                }
+                offset++;
+            }
+        }
+        return offset;
+    }
+
+    std::vector<Diagnostic> SourceDocument::GetDiagnostics() const {
+        std::vector<Diagnostic> diagnostics;
+        for (auto& seg : m_Segments) {
+            for (auto d : seg->diagnostics) {
+                if (d.line == seg->token_base.line)
+                    d.column = d.column + seg->base.column - seg->token_base.column;
+                d.line = d.line + seg->base.line - seg->token_base.line;
+                diagnostics.push_back(std::move(d));
+            }
+        }
+        return diagnostics;
+    }
+
+    bool SourceDocument::HasErrors() const {
+        return std::any_of(m_Segments.begin(), m_Segments.end(), [](auto& seg) {
+            return !seg->diagnostics.empty();
+        });
+    }
+
+    std::wstring SourceDocument::GetText() const {
+        std::wstring text;
+        text.reserve(m_Length);
+        for (auto& seg : m_Segments)
+            text += seg->GetText();
+        return text;
+    }
+
+} // namespace XRT
@@ -0,0 +1,131 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <Utils.hpp>
+#include "Diagnostic.hpp"
+#include "Language/AST.hpp"
+#include "Language/Preprocessor.hpp"
+#include "Language/SourceEntry.hpp"
+#include "Language/Token.hpp"
+
+namespace XRT {
+
+    /// Editable source with incremental lexing and parsing.
+    /// The text is split into segments at top-level declaration boundaries (include, namespace open/close, component).
+    /// Each segment owns its tokens and a run of AST entries. An edit relexes and reparses only the segments it touches,
+    /// growing the window over following segments until the lexer and parser both end on a segment boundary,
+    /// and splices the new entries into the AST - entries of all other segments are kept as they are.
+    /// Text that uses macros or conditionals is a single segment - every edit reparses all of it.
+    class SourceDocument {
+    public:
+        /// includes - cache for files included by the text (nullptr - #include is only a source link)
+        SourceDocument(const std::filesystem::path& path, IncludeCache* includes = nullptr);
+        ~SourceDocument();
+
+        SourceDocument(const SourceDocument&)            = delete;
+        SourceDocument& operator=(const SourceDocument&) = delete;
+
+        /// Replace the whole text - full lex and parse
+        void Open(std::wstring text);
+
+        /// Replace length UTF-16 code units at offset with text
+        void Edit(size_t offset, size_t length, std::wstring_view text);
+
+        /// Entries of all declarations that parsed. Token locations of segments moved by earlier edits are updated here.
+        /// While the text has errors the result depends on how it was reached: Open keeps only the declarations before
+        /// the first error (none after a lex error), an Edit keeps the declarations of all segments outside the edited window.
+        /// Once the errors are fixed both give the same entries.
+        const Ref<AST>& GetAST();
+
+        /// Tokens of the current text in source order, without end of file padding and punctuators merged into operators.
+        /// Locations are updated like GetAST. After a lex error Open keeps no tokens, an Edit keeps the tokens of the
+        /// segments outside the edited window.
+        std::vector<const Token*> GetTokens();
+
+        /// Offset of a 1-based line and column - clamped to the end of the line and the end of the text
+        size_t GetOffset(size_t line, size_t column) const;
+
+        /// Lex/parse errors of the current text
+        std::vector<Diagnostic> GetDiagnostics() const;
+        bool HasErrors() const;
+
+        std::wstring GetText() const;
+        size_t GetLength() const {
+            return m_Length;
+        }
+
+        const std::filesystem::path& GetPath() const {
+            return m_Path;
+        }
+
+        /// Incremented by every Open/Edit
+        uint64_t GetVersion() const {
+            return m_Version;
+        }
+
+        size_t GetSegmentCount() const {
+            return m_Segments.size();
+        }
+
+        /// Characters relexed by the last Open/Edit
+        size_t GetLastRelexLength() const {
+            return m_LastRelexLength;
+        }
+
+        /// Included files the current text got macros from
+        const std::vector<Ref<const IncludeCache::File>>& GetIncludes() const {
+            return m_Includes;
+        }
+
+    private:
+        struct Location {
+            size_t offset = 0;
+            size_t line   = 1;
+            size_t column = 1;
+
+            bool operator==(const Location& other) const = default;
+        };
+
+        struct Segment {
+            ~Segment();
+
+            Ref<SourceEntry> source;   // shared by all segments parsed in one window
+            size_t begin = 0;          // range in source content
+            size_t end   = 0;          //
+            size_t lines = 0;          // newlines in range
+            size_t last_line_size = 0; // characters after the last newline
+            std::vector<Token*> tokens;
+            size_t entries = 0;        // AST entries produced by this segment
+            std::vector<Diagnostic> diagnostics;
+            Location base;             // current start of the segment
+            Location token_base;       // start when token/diagnostic locations were written
+
+            std::wstring_view GetText() const {
+                return source->GetContent().substr(begin, end - begin);
+            }
+        };
+
+        /// Lex and parse text starting at base - false if more text is needed to reach a stable end
+        struct Window;
+        bool ParseWindow(Window& window, bool has_more);
+        void SplitWindow(Window& window, std::vector<Scope<Segment>>& segments);
+        void Reparse(size_t first, size_t last, std::wstring&& text);
+        void UpdateBases();
+
+        static void Relocate(Segment& segment);
+
+    private:
+        std::filesystem::path m_Path;
+        IncludeCache* m_IncludeCache;
+        std::vector<Scope<Segment>> m_Segments;
+        std::vector<Ref<const IncludeCache::File>> m_Includes; // AST entries can reference their tokens
+        Ref<AST> m_AST;
+        size_t m_Length          = 0;
+        uint64_t m_Version       = 0;
+        size_t m_LastRelexLength = 0;
+        bool m_Preprocessed      = false; // the text uses macros or conditionals
+    };
+
+} // namespace XRT
@@ -1,11 +1,13 @@
 #pragma once
 #include <filesystem>
+#include <string>
+#include <utility>
 
 namespace XRT {
 
     class SourceEntry {
     public:
-        SourceEntry(const std::wstring& content, const std::filesystem::path& path) : m_Content(content), m_Path(path) {
+        SourceEntry(std::wstring content, const std::filesystem::path& path) : m_Content(std::move(content)), m_Path(path) {
         }
 
         const std::wstring_view GetContent() const {
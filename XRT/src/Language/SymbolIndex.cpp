@@ -0,0 +1,489 @@
+#include "SymbolIndex.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <unordered_set>
+#include "Log/Logger.hpp"
+#include "Profiler.hpp"
+#include "StringUtils.hpp"
+#include "Waveform/BlockCodec.hpp"
+
+namespace XRT {
+
+    namespace {
+
+        SymbolIndex::Location GetLocation(const Token* tok) {
+            return {static_cast<uint32_t>(tok->line), static_cast<uint32_t>(tok->column)};
+        }
+
+        std::wstring Qualify(const std::wstring& container, std::wstring_view name) {
+            return container.empty() ? std::wstring{name} : container + L"::" + std::wstring{name};
+        }
+
+        template<typename T>
+        void EraseFrom(std::unordered_map<std::wstring, std::vector<T*>>& map, const std::wstring& key, T* value) {
+            auto it = map.find(key);
+            if (it == map.end())
+                return;
+            std::erase(it->second, value);
+            if (it->second.empty())
+                map.erase(it);
+        }
+
+    } // namespace
+
+    void SymbolIndex::Update(const std::filesystem::path& path, const std::vector<const Token*>& tokens, const AST& ast, int64_t write_time, uint64_t size) {
+        XRT_PROFILE_SCOPE("SymbolIndex::Update");
+        auto& file = m_Files[GetKey(path)];
+        if (file) {
+            Unlink(file.get());
+        } else {
+            file       = CreateScope<FileIndex>();
+            file->path = path;
+        }
+        file->write_time = write_time;
+        file->size       = size;
+        auto previous    = std::move(file->symbols);
+        file->symbols.clear();
+        file->references.clear();
+
+        // structure from tokens - declarations of a file that failed to parse are still found
+        struct Open {
+            std::wstring name;            // qualified
+            size_t component = SIZE_MAX; // symbol index if a component body
+        };
+        std::vector<Open> open;
+        std::unordered_map<size_t, size_t> component_keywords; // token offset -> symbol index
+        std::unordered_map<std::wstring, std::vector<Location>> references;
+        Open pending;
+        bool has_pending = false;
+        Location template_begin;
+        size_t component_depth = 0; // open component bodies
+
+        auto current_namespace = [&]() -> std::wstring {
+            return open.empty() ? std::wstring{} : open.back().name;
+        };
+        auto next = [&](size_t i) -> const Token* {
+            return i + 1 < tokens.size() ? tokens[i + 1] : nullptr;
+        };
+
+        for (size_t i = 0; i < tokens.size(); i++) {
+            auto tok = tokens[i];
+            switch (tok->type) {
+                case TokenType::IDENTIFIER: references[std::wstring{tok->value}].push_back(GetLocation(tok)); break;
+                case TokenType::KEYWORD: {
+                    if (component_depth) {
+                        // using NAME = value;
+                        auto name = next(i);
+                        if (tok->value == L"using" && name && name->type == TokenType::IDENTIFIER && open.back().component != SIZE_MAX) {
+                            auto& comp = file->symbols[open.back().component];
+                            file->symbols.push_back({std::wstring{name->value}, comp.GetQualifiedName(), SymbolKind::ALIAS, GetLocation(name), {}, {}});
+                        }
+                    } else if (tok->value == L"namespace") {
+                        // namespace A::B { - every part is declared in the one before it
+                        auto container = current_namespace();
+                        for (size_t j = i + 1; j < tokens.size() && tokens[j]->type == TokenType::IDENTIFIER; j += 2) {
+                            file->symbols.push_back({std::wstring{tokens[j]->value}, container, SymbolKind::NAMESPACE, GetLocation(tokens[j]), {}, {}});
+                            container = Qualify(container, tokens[j]->value);
+                            if (j + 1 >= tokens.size() || tokens[j + 1]->type != TokenType::RESOLVE)
+                                break;
+                        }
+                        pending     = {container, SIZE_MAX};
+                        has_pending = true;
+                    } else if (tok->value == L"template") {
+                        template_begin = GetLocation(tok);
+                    } else if (tok->value == L"component") {
+                        auto name  = next(i);
+                        auto begin = template_begin.line ? template_begin : GetLocation(tok);
+                        template_begin = {};
+                        if (!name || name->type != TokenType::IDENTIFIER)
+                            break;
+                        component_keywords[tok->offset] = file->symbols.size();
+                        pending = {Qualify(current_namespace(), name->value), file->symbols.size()};
+                        has_pending = true;
+                        file->symbols.push_back({std::wstring{name->value}, current_namespace(), SymbolKind::COMPONENT, GetLocation(name), begin, {}});
+                    }
+                    break;
+                }
+                case TokenType::OPEN_SCOPE: {
+                    if (has_pending) {
+                        component_depth += pending.component != SIZE_MAX;
+                        open.push_back(std::move(pending));
+                        has_pending = false;
+                    } else {
+                        open.push_back({current_namespace(), open.empty() ? SIZE_MAX : open.back().component});
+                    }
+                    break;
+                }
+                case TokenType::CLOSE_SCOPE: {
+                    if (open.empty())
+                        break;
+                    auto component = open.back().component;
+                    open.pop_back();
+                    if (component != SIZE_MAX && (open.empty() || open.back().component != component)) {
+                        file->symbols[component].end = GetLocation(tok);
+                        component_depth--;
+                    }
+                    break;
+                }
+                default: break;
+            }
+        }
+
+        // components left open by a parse error extend to the end of the file
+        for (auto& sym : file->symbols) {
+            if (sym.kind == SymbolKind::COMPONENT && !sym.end.line)
+                sym.end = {UINT32_MAX, UINT32_MAX};
+        }
+
+        // members from the declarations that parsed
+        std::unordered_set<std::wstring> parsed;
+        for (auto& entry : ast.GetEntries()) {
+            if (entry->type != AST_Type::COMPONENT)
+                continue;
+            auto& comp = entry->Cast<AST_Element::Component>();
+            auto it    = comp.token ? component_keywords.find(comp.token->offset) : component_keywords.end();
+            if (it == component_keywords.end())
+                continue;
+            auto container = file->symbols[it->second].GetQualifiedName();
+            parsed.insert(container);
+            auto add       = [&](const AST_Variable& var, SymbolKind kind) {
+                if (var.token)
+                    file->symbols.push_back({var.name, container, kind, GetLocation(var.token), {}, {}});
+            };
+            for (auto& param : comp.template_parameters)
+                add(param, SymbolKind::PARAMETER);
+            for (auto& reg : comp.registers)
+                add(reg, SymbolKind::REGISTER);
+            for (auto& ctor : comp.constructors) {
+                for (auto& port : ctor.ports)
+                    add(port, SymbolKind::PORT);
+            }
+        }
+
+        // a component being edited keeps its last parsed members until it parses again
+        for (auto& sym : previous) {
+            if (sym.IsGlobal() || parsed.contains(sym.container))
+                continue;
+            auto declared = std::any_of(file->symbols.begin(), file->symbols.end(), [&](const Symbol& s) {
+                return s.kind == SymbolKind::COMPONENT && s.GetQualifiedName() == sym.container;
+            });
+            if (declared)
+                file->symbols.push_back(std::move(sym));
+        }
+
+        file->references.reserve(references.size());
+        for (auto& [name, locations] : references)
+            file->references.push_back({name, std::move(locations)});
+        std::sort(file->references.begin(), file->references.end(), [](auto& a, auto& b) {
+            return a.name < b.name;
+        });
+
+        Link(file.get());
+    }
+
+    void SymbolIndex::Remove(const std::filesystem::path& path) {
+        auto it = m_Files.find(GetKey(path));
+        if (it == m_Files.end())
+            return;
+        Unlink(it->second.get());
+        m_Files.erase(it);
+    }
+
+    void SymbolIndex::Link(FileIndex* file) {
+        for (auto& sym : file->symbols) {
+            if (!sym.IsGlobal())
+                continue;
+            auto& files = m_Globals[sym.name];
+            if (std::find(files.begin(), files.end(), file) == files.end()) {
+                files.push_back(file);
+                m_GlobalNames[sym.name]++;
+            }
+            auto& in_container = m_Containers[sym.container];
+            if (std::find(in_container.begin(), in_container.end(), file) == in_container.end())
+                in_container.push_back(file);
+        }
+    }
+
+    void SymbolIndex::Unlink(FileIndex* file) {
+        for (auto& sym : file->symbols) {
+            if (!sym.IsGlobal())
+                continue;
+            auto it = m_Globals.find(sym.name);
+            if (it != m_Globals.end() && std::find(it->second.begin(), it->second.end(), file) != it->second.end()) {
+                auto name = m_GlobalNames.find(sym.name);
+                if (--name->second == 0)
+                    m_GlobalNames.erase(name);
+            }
+            EraseFrom(m_Globals, sym.name, file);
+            EraseFrom(m_Containers, sym.container, file);
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    const SymbolIndex::FileIndex* SymbolIndex::GetFile(const std::filesystem::path& path) const {
+        auto it = m_Files.find(GetKey(path));
+        return it == m_Files.end() ? nullptr : it->second.get();
+    }
+
+    std::vector<const SymbolIndex::FileIndex*> SymbolIndex::GetFiles() const {
+        std::vector<const FileIndex*> files;
+        files.reserve(m_Files.size());
+        for (auto& [key, file] : m_Files)
+            files.push_back(file.get());
+        return files;
+    }
+
+    const SymbolIndex::Symbol* SymbolIndex::FindComponent(const FileIndex& file, Location location) const {
+        for (auto& sym : file.symbols) {
+            if (sym.kind == SymbolKind::COMPONENT && sym.begin <= location && location <= sym.end)
+                return &sym;
+        }
+        return nullptr;
+    }
+
+    std::vector<const SymbolIndex::Symbol*> SymbolIndex::FindMembers(const FileIndex& file, const Symbol& component) const {
+        std::vector<const Symbol*> members;
+        auto container = component.GetQualifiedName();
+        for (auto& sym : file.symbols) {
+            if (!sym.IsGlobal() && sym.container == container)
+                members.push_back(&sym);
+        }
+        return members;
+    }
+
+    std::vector<SymbolIndex::Match> SymbolIndex::FindGlobal(std::wstring_view name) const {
+        std::vector<Match> matches;
+        auto it = m_Globals.find(std::wstring{name});
+        if (it == m_Globals.end())
+            return matches;
+        for (auto file : it->second) {
+            for (auto& sym : file->symbols) {
+                if (sym.IsGlobal() && sym.name == name)
+                    matches.push_back({file, &sym});
+            }
+        }
+        return matches;
+    }
+
+    std::vector<SymbolIndex::Match> SymbolIndex::FindInContainer(std::wstring_view container) const {
+        std::vector<Match> matches;
+        auto it = m_Containers.find(std::wstring{container});
+        if (it == m_Containers.end())
+            return matches;
+        for (auto file : it->second) {
+            for (auto& sym : file->symbols) {
+                if (sym.IsGlobal() && sym.container == container)
+                    matches.push_back({file, &sym});
+            }
+        }
+        return matches;
+    }
+
+    void SymbolIndex::FindReferences(std::wstring_view name,
+                                     const FileIndex* file,
+                                     const std::function<void(const FileIndex&, Location)>& callback) const {
+        auto search = [&](const FileIndex& f) {
+            auto it = std::lower_bound(f.references.begin(), f.references.end(), name, [](const Reference& ref, std::wstring_view n) {
+                return ref.name < n;
+            });
+            if (it == f.references.end() || it->name != name)
+                return;
+            for (auto& location : it->locations)
+                callback(f, location);
+        };
+
+        if (file) {
+            search(*file);
+        } else {
+            for (auto& [key, f] : m_Files)
+                search(*f);
+        }
+    }
+
+    void SymbolIndex::CompleteGlobal(std::wstring_view prefix, const std::function<bool(const std::wstring&)>& callback) const {
+        for (auto it = m_GlobalNames.lower_bound(prefix); it != m_GlobalNames.end() && it->first.starts_with(prefix); it++) {
+            if (!callback(it->first))
+                return;
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    bool SymbolIndex::Write(const std::filesystem::path& path) const {
+        XRT_PROFILE_SCOPE("SymbolIndex::Write");
+        using BlockCodec::WriteVarint;
+        std::vector<uint8_t> data(MAGIC, MAGIC + sizeof(MAGIC));
+        auto write_string = [&](const std::string& str) {
+            WriteVarint(data, str.size());
+            data.insert(data.end(), str.begin(), str.end());
+        };
+        auto write_location = [&](Location location) {
+            WriteVarint(data, location.line);
+            WriteVarint(data, location.column);
+        };
+
+        // names repeat across files - one table of distinct names, referenced by index
+        std::unordered_map<std::wstring_view, uint64_t> names;
+        std::vector<std::wstring_view> table;
+        auto intern = [&](std::wstring_view name) {
+            auto [it, added] = names.try_emplace(name, table.size());
+            if (added)
+                table.push_back(name);
+            return it->second;
+        };
+        for (auto& [key, file] : m_Files) {
+            for (auto& sym : file->symbols) {
+                intern(sym.name);
+                intern(sym.container);
+            }
+            for (auto& ref : file->references)
+                intern(ref.name);
+        }
+        WriteVarint(data, table.size());
+        for (auto name : table)
+            write_string(StringUtils::utf16_to_utf8(name));
+
+        WriteVarint(data, m_Files.size());
+        for (auto& [key, file] : m_Files) {
+            write_string(file->path.generic_string());
+            WriteVarint(data, static_cast<uint64_t>(file->write_time));
+            WriteVarint(data, file->size);
+            WriteVarint(data, file->symbols.size());
+            for (auto& sym : file->symbols) {
+                WriteVarint(data, names[sym.name]);
+                WriteVarint(data, names[sym.container]);
+                WriteVarint(data, static_cast<uint64_t>(sym.kind));
+                write_location(sym.location);
+                write_location(sym.begin);
+                write_location(sym.end);
+            }
+            WriteVarint(data, file->references.size());
+            for (auto& ref : file->references) {
+                WriteVarint(data, names[ref.name]);
+                WriteVarint(data, ref.locations.size());
+                for (auto location : ref.locations)
+                    write_location(location);
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::create_directories(path.parent_path(), ec);
+        auto file = std::fopen(path.string().c_str(), "wb");
+        if (!file) {
+            LOG_ERROR("Failed to open \"{}\" for writing", path.string());
+            return false;
+        }
+        bool ok = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+        ok &= std::fclose(file) == 0;
+        if (!ok)
+            LOG_ERROR("Failed to write \"{}\"", path.string());
+        return ok;
+    }
+
+    bool SymbolIndex::Read(const std::filesystem::path& path) {
+        XRT_PROFILE_SCOPE("SymbolIndex::Read");
+        auto file = std::fopen(path.string().c_str(), "rb");
+        if (!file)
+            return false;
+        std::vector<uint8_t> data;
+        uint8_t chunk[64 * 1024];
+        for (size_t n; (n = std::fread(chunk, 1, sizeof(chunk), file)) > 0;)
+            data.insert(data.end(), chunk, chunk + n);
+        std::fclose(file);
+
+        size_t pos = sizeof(MAGIC);
+        std::string str;
+        std::vector<std::wstring> table;
+        auto read = [&](uint64_t& value) {
+            return BlockCodec::ReadVarint(data, pos, value);
+        };
+        auto read_string = [&]() {
+            uint64_t size;
+            if (!read(size) || size > data.size() - pos)
+                return false;
+            str.assign(reinterpret_cast<const char*>(data.data() + pos), size);
+            pos += size;
+            return true;
+        };
+        auto read_name = [&](std::wstring& name) {
+            uint64_t index;
+            if (!read(index) || index >= table.size())
+                return false;
+            name = table[index];
+            return true;
+        };
+        auto read_location = [&](Location& location) {
+            uint64_t line, column;
+            if (!read(line) || !read(column) || line > UINT32_MAX || column > UINT32_MAX)
+                return false;
+            location = {static_cast<uint32_t>(line), static_cast<uint32_t>(column)};
+            return true;
+        };
+        auto fail = [&](const char* reason) {
+            LOG_WARN("Invalid symbol index \"{}\": {}", path.string(), reason);
+            return false;
+        };
+
+        if (data.size() < sizeof(MAGIC) || std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0)
+            return fail("bad header");
+
+        uint64_t count, value;
+        if (!read(count) || count > data.size() - pos)
+            return fail("truncated name table");
+        table.resize(count);
+        for (auto& name : table) {
+            if (!read_string())
+                return fail("truncated name table");
+            name = StringUtils::utf8_to_utf16(str);
+        }
+
+        // parse into separate files so a corrupt index leaves this one untouched
+        std::vector<Scope<FileIndex>> files;
+        uint64_t file_count;
+        if (!read(file_count))
+            return fail("truncated file table");
+        for (uint64_t f = 0; f < file_count; f++) {
+            auto fi = CreateScope<FileIndex>();
+            uint64_t write_time;
+            if (!read_string() || !read(write_time) || !read(fi->size) || !read(count) || count > data.size() - pos)
+                return fail("truncated file entry");
+            fi->path       = str;
+            fi->write_time = static_cast<int64_t>(write_time);
+            fi->symbols.resize(count);
+            for (auto& sym : fi->symbols) {
+                if (!read_name(sym.name) || !read_name(sym.container) || !read(value) || value > static_cast<uint64_t>(SymbolKind::ALIAS))
+                    return fail("truncated symbol");
+                sym.kind = static_cast<SymbolKind>(value);
+                if (!read_location(sym.location) || !read_location(sym.begin) || !read_location(sym.end))
+                    return fail("truncated symbol");
+            }
+            if (!read(count) || count > data.size() - pos)
+                return fail("truncated reference table");
+            fi->references.resize(count);
+            for (auto& ref : fi->references) {
+                if (!read_name(ref.name) || !read(count) || count > data.size() - pos)
+                    return fail("truncated reference");
+                ref.locations.resize(count);
+                for (auto& location : ref.locations) {
+                    if (!read_location(location))
+                        return fail("truncated reference");
+                }
+            }
+            files.push_back(std::move(fi));
+        }
+
+        m_Files.clear();
+        m_Globals.clear();
+        m_Containers.clear();
+        m_GlobalNames.clear();
+        for (auto& fi : files) {
+            auto ptr = fi.get();
+            m_Files[GetKey(fi->path)] = std::move(fi);
+            Link(ptr);
+        }
+        return true;
+    }
+
+} // namespace XRT
@@ -0,0 +1,120 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <Utils.hpp>
+#include "Language/AST.hpp"
+#include "Language/Token.hpp"
+
+namespace XRT {
+
+    /// Cross-file index of declared names for editor queries.
+    /// A file is indexed from its tokens and (partial) AST - updating a file replaces only its own entries.
+    /// Namespaces and components are global, template parameters, registers, ports and aliases are members of their component.
+    class SymbolIndex {
+    public:
+        static constexpr char MAGIC[4] = {'X', 'S', 'I', '1'};
+
+        enum class SymbolKind : uint8_t {
+            NAMESPACE,
+            COMPONENT,
+            PARAMETER,
+            REGISTER,
+            PORT,
+            ALIAS,
+        };
+
+        /// 1-based line and column like token locations
+        struct Location {
+            uint32_t line   = 0;
+            uint32_t column = 0;
+
+            auto operator<=>(const Location&) const = default;
+        };
+
+        struct Symbol {
+            std::wstring name;
+            std::wstring container; // qualified namespace of globals, qualified component of members
+            SymbolKind kind = SymbolKind::NAMESPACE;
+            Location location;      // name
+            Location begin;         // component - template/component keyword to closing brace
+            Location end;           //
+
+            std::wstring GetQualifiedName() const {
+                return container.empty() ? name : container + L"::" + name;
+            }
+            bool IsGlobal() const {
+                return kind == SymbolKind::NAMESPACE || kind == SymbolKind::COMPONENT;
+            }
+        };
+
+        /// All identifier occurrences of a name in a file, declarations included
+        struct Reference {
+            std::wstring name;
+            std::vector<Location> locations;
+        };
+
+        struct FileIndex {
+            std::filesystem::path path;
+            int64_t write_time = 0; // source file state when indexed from disk - 0 for editor buffers
+            uint64_t size      = 0; //
+            std::vector<Symbol> symbols;
+            std::vector<Reference> references; // sorted by name
+        };
+
+        struct Match {
+            const FileIndex* file;
+            const Symbol* symbol;
+        };
+
+    public:
+        /// Replace the entries of a file
+        void Update(const std::filesystem::path& path, const std::vector<const Token*>& tokens, const AST& ast, int64_t write_time = 0, uint64_t size = 0);
+        void Remove(const std::filesystem::path& path);
+
+        /// nullptr if not indexed
+        const FileIndex* GetFile(const std::filesystem::path& path) const;
+        std::vector<const FileIndex*> GetFiles() const;
+        size_t GetFileCount() const {
+            return m_Files.size();
+        }
+
+        /// Component of a file containing a location
+        const Symbol* FindComponent(const FileIndex& file, Location location) const;
+        /// Members of a component declared in file
+        std::vector<const Symbol*> FindMembers(const FileIndex& file, const Symbol& component) const;
+        /// Namespaces and components with a name in all files
+        std::vector<Match> FindGlobal(std::wstring_view name) const;
+        /// Namespaces and components declared directly in a qualified namespace
+        std::vector<Match> FindInContainer(std::wstring_view container) const;
+        /// Occurrences of an identifier - in all files or only in file
+        void FindReferences(std::wstring_view name, const FileIndex* file, const std::function<void(const FileIndex&, Location)>& callback) const;
+        /// Distinct global names starting with prefix in sorted order - stops when callback returns false
+        void CompleteGlobal(std::wstring_view prefix, const std::function<bool(const std::wstring&)>& callback) const;
+
+        /// Compact varint encoded file
+        bool Write(const std::filesystem::path& path) const;
+        /// Replace the index with a file written by Write - false if missing or invalid
+        bool Read(const std::filesystem::path& path);
+
+    private:
+        static std::string GetKey(const std::filesystem::path& path) {
+            return path.lexically_normal().generic_string();
+        }
+
+        void Link(FileIndex* file);
+        void Unlink(FileIndex* file);
+
+    private:
+        std::unordered_map<std::string, Scope<FileIndex>> m_Files;
+        std::unordered_map<std::wstring, std::vector<FileIndex*>> m_Globals;    // name -> files declaring it
+        std::unordered_map<std::wstring, std::vector<FileIndex*>> m_Containers; // qualified namespace -> files declaring in it
+        std::map<std::wstring, uint32_t, std::less<>> m_GlobalNames;            // name -> declaring file count
+    };
+
+} // namespace XRT
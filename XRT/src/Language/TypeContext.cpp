@@ -0,0 +1,156 @@
+#include "TypeContext.hpp"
+#include <bit>
+#include <functional>
+#include "StringUtils.hpp"
+
+namespace XRT {
+
+    static inline size_t HashCombine(size_t seed, size_t value) {
+        return seed ^ (value + 0x9E3779B97F4A7C15ull + (seed << 6) + (seed >> 2));
+    }
+
+    static size_t HashType(const Type& t) {
+        size_t h = HashCombine(static_cast<size_t>(t.kind), static_cast<size_t>(t.direction));
+        h        = HashCombine(h, std::hash<const void*>{}(t.element));
+        h        = HashCombine(h, static_cast<size_t>(t.range_min));
+        h        = HashCombine(h, static_cast<size_t>(t.range_max));
+        if (t.kind == TypeKind::COMPONENT) {
+            h = HashCombine(h, std::hash<std::wstring_view>{}(t.name));
+            for (auto& arg : t.arguments) {
+                h = HashCombine(h, std::hash<const void*>{}(arg.type));
+                h = HashCombine(h, static_cast<size_t>(arg.value));
+            }
+        }
+        return h;
+    }
+
+    static bool StructuralEqual(const Type& a, const Type& b) {
+        return a.kind == b.kind && a.direction == b.direction && a.element == b.element && a.range_min == b.range_min &&
+               a.range_max == b.range_max && a.name == b.name && a.arguments == b.arguments;
+    }
+
+    static uint32_t BitsForUnsigned(uint64_t value) {
+        return value ? static_cast<uint32_t>(std::bit_width(value)) : 1;
+    }
+
+    static uint32_t BitsForSigned(int64_t range_min, int64_t range_max) {
+        auto bits_for = [](int64_t v) -> uint32_t {
+            // magnitude bits + sign bit
+            auto mag = v < 0 ? static_cast<uint64_t>(-(v + 1)) : static_cast<uint64_t>(v);
+            return static_cast<uint32_t>(std::bit_width(mag)) + 1;
+        };
+        return std::max(bits_for(range_min), bits_for(range_max));
+    }
+
+    static Type MakeKey(TypeKind kind) {
+        return Type{kind, PortDirection::NONE, 0, nullptr, 0, 0, {}, {}, 0};
+    }
+
+    std::string Type::ToString() const {
+        switch (kind) {
+            case TypeKind::VOID: return "void";
+            case TypeKind::BOOL: return "bool";
+            case TypeKind::LOGIC: return "logic";
+            case TypeKind::UNSIGNED: return "unsigned<" + std::to_string(range_min) + ".." + std::to_string(range_max) + ">";
+            case TypeKind::SIGNED: return "signed<" + std::to_string(range_min) + ".." + std::to_string(range_max) + ">";
+            case TypeKind::PORT: return std::string(PortDirection_ToString(direction)) + "<" + element->ToString() + ">";
+            case TypeKind::COMPONENT: {
+                std::string str = StringUtils::utf16_to_utf8(name);
+                if (!arguments.empty()) {
+                    str += "<";
+                    for (size_t i = 0; i < arguments.size(); i++) {
+                        if (i)
+                            str += ", ";
+                        str += arguments[i].type ? arguments[i].type->ToString() : std::to_string(arguments[i].value);
+                    }
+                    str += ">";
+                }
+                return str;
+            }
+            default: return "???";
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    TypeContext::TypeContext() {
+        m_Void  = Intern(MakeKey(TypeKind::VOID));
+        m_Bool  = Intern(MakeKey(TypeKind::BOOL));
+        m_Logic = Intern(MakeKey(TypeKind::LOGIC));
+    }
+
+    const Type* TypeContext::GetUnsigned(int64_t range_min, int64_t range_max) {
+        auto key      = MakeKey(TypeKind::UNSIGNED);
+        key.range_min = range_min;
+        key.range_max = range_max;
+        return Intern(std::move(key));
+    }
+
+    const Type* TypeContext::GetSigned(int64_t range_min, int64_t range_max) {
+        auto key      = MakeKey(TypeKind::SIGNED);
+        key.range_min = range_min;
+        key.range_max = range_max;
+        return Intern(std::move(key));
+    }
+
+    const Type* TypeContext::GetPort(PortDirection direction, const Type* element) {
+        auto key      = MakeKey(TypeKind::PORT);
+        key.direction = direction;
+        key.element   = element->GetValueType();
+        return Intern(std::move(key));
+    }
+
+    const Type* TypeContext::GetComponent(std::wstring_view name, const std::vector<TemplateArgument>& arguments) {
+        auto key      = MakeKey(TypeKind::COMPONENT);
+        key.name      = name;
+        key.arguments = arguments;
+        return Intern(std::move(key));
+    }
+
+    size_t TypeContext::GetTypeCount() const {
+        size_t count = 0;
+        for (auto& shard : m_Shards) {
+            std::shared_lock lock(shard.mutex);
+            count += shard.storage.size();
+        }
+        return count;
+    }
+
+    const Type* TypeContext::Intern(Type&& key) {
+        key.hash    = HashType(key);
+        auto& shard = m_Shards[key.hash % SHARD_COUNT];
+
+        auto find = [&]() -> const Type* {
+            auto [first, last] = shard.index.equal_range(key.hash);
+            for (auto it = first; it != last; ++it) {
+                if (StructuralEqual(*it->second, key))
+                    return it->second;
+            }
+            return nullptr;
+        };
+
+        {
+            std::shared_lock lock(shard.mutex);
+            if (auto existing = find())
+                return existing;
+        }
+
+        std::unique_lock lock(shard.mutex);
+        if (auto existing = find()) // inserted by another thread between locks
+            return existing;
+
+        switch (key.kind) {
+            case TypeKind::BOOL:
+            case TypeKind::LOGIC: key.width = 1; break;
+            case TypeKind::UNSIGNED: key.width = BitsForUnsigned(static_cast<uint64_t>(std::max<int64_t>(key.range_max, 0))); break;
+            case TypeKind::SIGNED: key.width = BitsForSigned(key.range_min, key.range_max); break;
+            case TypeKind::PORT: key.width = key.element->width; break;
+            default: key.width = 0; break;
+        }
+
+        auto& node = shard.storage.emplace_back(std::move(key));
+        shard.index.emplace(node.hash, &node);
+        return &node;
+    }
+
+} // namespace XRT
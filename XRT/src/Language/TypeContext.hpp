@@ -0,0 +1,133 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace XRT {
+
+    enum class TypeKind : uint8_t {
+        VOID,
+        BOOL,
+        LOGIC,
+        UNSIGNED,
+        SIGNED,
+        PORT,
+        COMPONENT,
+    };
+
+    enum class PortDirection : uint8_t {
+        NONE,
+        IN,
+        OUT,
+        INOUT,
+    };
+
+    struct Type;
+
+    /// Template argument of a component type - either a type or a constant value
+    struct TemplateArgument {
+        const Type* type = nullptr; // nullptr if value argument
+        uint64_t value   = 0;
+
+        bool operator==(const TemplateArgument& other) const {
+            return type == other.type && value == other.value;
+        }
+    };
+
+    /// Interned type node - owned by a TypeContext, compare by pointer
+    struct Type {
+        TypeKind kind;
+        PortDirection direction; // PORT
+        uint32_t width;          // cached bit width (0 for VOID/COMPONENT)
+        const Type* element;     // PORT
+        int64_t range_min;       // UNSIGNED/SIGNED
+        int64_t range_max;       // UNSIGNED/SIGNED
+        std::wstring name;       // COMPONENT
+        std::vector<TemplateArgument> arguments; // COMPONENT
+        size_t hash;
+
+        bool IsIntegral() const {
+            return kind == TypeKind::BOOL || kind == TypeKind::LOGIC || kind == TypeKind::UNSIGNED || kind == TypeKind::SIGNED;
+        }
+
+        bool IsPort() const {
+            return kind == TypeKind::PORT;
+        }
+
+        /// Strip port direction
+        const Type* GetValueType() const {
+            return kind == TypeKind::PORT ? element : this;
+        }
+
+        std::string ToString() const;
+    };
+
+    /// Structural type interner - every distinct type exists exactly once per context,
+    /// so type equality is pointer equality. Safe to share between compilation threads.
+    class TypeContext {
+    public:
+        TypeContext();
+        ~TypeContext() = default;
+
+        TypeContext(const TypeContext&)            = delete;
+        TypeContext& operator=(const TypeContext&) = delete;
+
+        const Type* GetVoid() const {
+            return m_Void;
+        }
+        const Type* GetBool() const {
+            return m_Bool;
+        }
+        const Type* GetLogic() const {
+            return m_Logic;
+        }
+
+        /// unsigned<min..max>
+        const Type* GetUnsigned(int64_t range_min, int64_t range_max);
+        /// unsigned<N..> - unsigned able to hold values 0..N
+        const Type* GetUnsignedOfRange(uint64_t max_value) {
+            return GetUnsigned(0, static_cast<int64_t>(max_value));
+        }
+        /// signed<min..max>
+        const Type* GetSigned(int64_t range_min, int64_t range_max);
+        /// in<T>, out<T>, inout<T>
+        const Type* GetPort(PortDirection direction, const Type* element);
+        /// Component specialization
+        const Type* GetComponent(std::wstring_view name, const std::vector<TemplateArgument>& arguments = {});
+
+        /// Number of unique types interned
+        size_t GetTypeCount() const;
+
+    private:
+        const Type* Intern(Type&& key);
+
+    private:
+        static constexpr size_t SHARD_COUNT = 16;
+        struct Shard {
+            mutable std::shared_mutex mutex;
+            std::unordered_multimap<size_t, const Type*> index;
+            std::deque<Type> storage; // stable addresses
+        };
+        std::array<Shard, SHARD_COUNT> m_Shards;
+
+        const Type* m_Void;
+        const Type* m_Bool;
+        const Type* m_Logic;
+    };
+
+    static inline const char* PortDirection_ToString(PortDirection dir) {
+        switch (dir) {
+            case PortDirection::IN: return "in";
+            case PortDirection::OUT: return "out";
+            case PortDirection::INOUT: return "inout";
+            default: return "";
+        }
+    }
+
+} // namespace XRT
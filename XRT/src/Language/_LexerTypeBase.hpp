@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <exception>
 #include <string_view>
 #include <StringUtils.hpp>
@@ -13,19 +14,27 @@ namespace XRT {
 
         class UnknownTokenException : public std::exception {
         public:
-            UnknownTokenException(std::wstring_view source) : m_Source(source) {
+            UnknownTokenException(std::wstring_view source, const char* reason = "Lexer::UnknownTokenException") :
+                m_Source(source), m_Reason(reason) {
             }
 
             const char* what() const noexcept override {
-                return "Lexer::UnknownTokenException";
+                return m_Reason;
             }
 
+            /// Rest of the line starting at the unknown token
             std::string GetSource() const {
-                return StringUtils::utf16_to_utf8(m_Source);
+                return StringUtils::utf16_to_utf8(m_Source.substr(0, std::min(m_Source.find_first_of(L"\r\n"), m_Source.size())));
+            }
+
+            /// Unlexed rest of the source content, starting at the unknown token
+            std::wstring_view GetRemaining() const {
+                return m_Source;
             }
 
         private:
             std::wstring_view m_Source;
+            const char* m_Reason;
         };
     };
 
@@ -95,6 +95,28 @@ namespace XRT {
             std::string m_Reason;
         };
 
+        class PreprocessorError : public ParseException {
+        public:
+            PreprocessorError(const std::string& reason, const Token* token) :
+                m_Token(token), m_Reason(reason + " (" + StringUtils::utf16_to_utf8(token->value) + ")") {
+            }
+
+            const char* what() const noexcept override {
+                return m_Reason.c_str();
+            }
+
+            size_t GetLine() const override {
+                return m_Token->line;
+            }
+            size_t GetColumn() const override {
+                return m_Token->column;
+            }
+
+        private:
+            const Token* m_Token;
+            std::string m_Reason;
+        };
+
         class ExpectationError : public ParseException {
         public:
             ExpectationError(const std::string& reason, const Token* token) :
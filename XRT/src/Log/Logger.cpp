@@ -18,22 +18,55 @@
 // [CFXS] //
 #include "Logger.hpp"
 
+#include <cstdlib>
+#include <mutex>
+#include <spdlog/async.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/sinks/basic_file_sink.h>
 #include "spdlog/sinks/ansicolor_sink.h"
 
 std::shared_ptr<spdlog::logger> Logger::s_CoreLogger;
 
-void Logger::Initialize() {
+void Logger::Initialize(const Options& options) {
     std::vector<spdlog::sink_ptr> logSinks;
-    logSinks.emplace_back(std::make_shared<spdlog::sinks::ansicolor_stdout_sink_mt>());
-    logSinks.emplace_back(std::make_shared<spdlog::sinks::basic_file_sink_mt>("XRT.log", true));
+    if (options.console_stderr)
+        logSinks.emplace_back(std::make_shared<spdlog::sinks::ansicolor_stderr_sink_mt>());
+    else
+        logSinks.emplace_back(std::make_shared<spdlog::sinks::ansicolor_stdout_sink_mt>());
+    if (!options.file.empty())
+        logSinks.emplace_back(std::make_shared<spdlog::sinks::basic_file_sink_mt>(options.file, true));
+    for (auto& sink : logSinks)
+        sink->set_pattern("%^[%T.%e]%n%v%$");
 
-    logSinks[0]->set_pattern("%^[%T.%e]%n%v%$");
-    logSinks[1]->set_pattern("%^[%T.%e]%n%v%$");
+    if (s_CoreLogger) {
+        s_CoreLogger->flush();
+        spdlog::drop(s_CoreLogger->name());
+    }
 
-    s_CoreLogger = std::make_shared<spdlog::logger>(" ", begin(logSinks), end(logSinks));
+    if (options.async) {
+        static std::once_flag s_ThreadPoolInit;
+        std::call_once(s_ThreadPoolInit, [] {
+            spdlog::init_thread_pool(ASYNC_QUEUE_SIZE, 1);
+            std::atexit(Shutdown);
+        });
+        s_CoreLogger = std::make_shared<spdlog::async_logger>(
+            " ", begin(logSinks), end(logSinks), spdlog::thread_pool(), spdlog::async_overflow_policy::block);
+        s_CoreLogger->flush_on(spdlog::level::err);
+        spdlog::flush_every(FLUSH_INTERVAL);
+    } else {
+        s_CoreLogger = std::make_shared<spdlog::logger>(" ", begin(logSinks), end(logSinks));
+        s_CoreLogger->flush_on(spdlog::level::trace);
+    }
     spdlog::register_logger(s_CoreLogger);
-    s_CoreLogger->set_level(spdlog::level::trace);
-    s_CoreLogger->flush_on(spdlog::level::trace);
+    s_CoreLogger->set_level(options.level);
+}
+
+void Logger::Initialize() {
+    Initialize(Options{});
+}
+
+void Logger::Shutdown() {
+    if (s_CoreLogger)
+        s_CoreLogger->flush();
+    spdlog::shutdown();
 }
@@ -24,23 +24,62 @@
 #include <spdlog/fmt/ostr.h>
 // #pragma warning(pop)
 #include "LoggerOverloads.hpp"
+#include <chrono>
+#include <string>
 
 class Logger {
 public:
+    struct Options {
+        spdlog::level::level_enum level = spdlog::level::trace;
+        std::string file                = "XRT.log"; // empty - console only
+        bool async                      = true;      // format and write on a background thread
+        bool console_stderr             = false;     // console output on stderr - stdout carries a protocol (--lsp)
+    };
+
+    /// Bounded async queue - producers block when full so no message is lost
+    static constexpr size_t ASYNC_QUEUE_SIZE = 8192;
+    /// Async file/console flush period - errors are flushed immediately
+    static constexpr auto FLUSH_INTERVAL = std::chrono::seconds(1);
+
+public:
+    /// Can be called again to reconfigure
+    static void Initialize(const Options& options);
     static void Initialize();
 
+    /// Drain the async queue and stop the logging thread - registered with atexit
+    static void Shutdown();
+
     static inline std::shared_ptr<spdlog::logger>& GetCoreLogger() {
         return s_CoreLogger;
     }
 
+    static inline bool IsEnabled(spdlog::level::level_enum level) {
+        return s_CoreLogger->should_log(level);
+    }
+
 private:
     static std::shared_ptr<spdlog::logger> s_CoreLogger;
 };
 
-// Core log macros
-#define LOG_DEBUG(...)    ::Logger::GetCoreLogger()->debug(__VA_ARGS__)
-#define LOG_TRACE(...)    ::Logger::GetCoreLogger()->trace(__VA_ARGS__)
-#define LOG_INFO(...)     ::Logger::GetCoreLogger()->info(__VA_ARGS__)
-#define LOG_WARN(...)     ::Logger::GetCoreLogger()->warn(__VA_ARGS__)
-#define LOG_ERROR(...)    ::Logger::GetCoreLogger()->error(__VA_ARGS__)
-#define LOG_CRITICAL(...) ::Logger::GetCoreLogger()->critical(__VA_ARGS__)
\ No newline at end of file
+// Core log macros - arguments are only evaluated when the level is enabled
+#define LOG_AT_LEVEL_(lvl, method, ...)                      \
+    do {                                                    \
+        if (::Logger::IsEnabled(spdlog::level::lvl))        \
+            ::Logger::GetCoreLogger()->method(__VA_ARGS__); \
+    } while (0)
+
+#if defined(NDEBUG) && !defined(XRT_KEEP_TRACE_LOG)
+    // stripped from release builds - arguments stay type checked but are never evaluated
+    #define LOG_TRACE(...)                                     \
+        do {                                                   \
+            if (false)                                         \
+                ::Logger::GetCoreLogger()->trace(__VA_ARGS__); \
+        } while (0)
+#else
+    #define LOG_TRACE(...) LOG_AT_LEVEL_(trace, trace, __VA_ARGS__)
+#endif
+#define LOG_DEBUG(...)    LOG_AT_LEVEL_(debug, debug, __VA_ARGS__)
+#define LOG_INFO(...)     LOG_AT_LEVEL_(info, info, __VA_ARGS__)
+#define LOG_WARN(...)     LOG_AT_LEVEL_(warn, warn, __VA_ARGS__)
+#define LOG_ERROR(...)    LOG_AT_LEVEL_(err, error, __VA_ARGS__)
+#define LOG_CRITICAL(...) LOG_AT_LEVEL_(critical, critical, __VA_ARGS__)
@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <filesystem>
 #include <string_view>
 // #pragma warning(push, 0)
@@ -53,26 +54,23 @@ struct fmt::formatter<std::filesystem::path> {
     }
 };
 
-template<>
-struct fmt::formatter<std::wstring> {
-    constexpr auto parse(format_parse_context& ctx) -> decltype(ctx.begin()) {
-        return ctx.end();
-    }
-
-    template<typename FormatContext>
-    auto format(const std::wstring& input, FormatContext& ctx) -> decltype(ctx.out()) {
-        return format_to(ctx.out(), "{}", StringUtils::utf16_to_utf8(input));
-    }
-};
-
 template<>
 struct fmt::formatter<std::wstring_view> {
     constexpr auto parse(format_parse_context& ctx) -> decltype(ctx.begin()) {
         return ctx.end();
     }
 
+    /// Short strings are converted on the stack - names and messages are logged without an allocation
     template<typename FormatContext>
     auto format(std::wstring_view input, FormatContext& ctx) -> decltype(ctx.out()) {
+        char buffer[512];
+        if (input.size() <= sizeof(buffer) / 4) { // 4 bytes is the most a unit converts to
+            auto result = StringUtils::utf16_to_utf8(input, buffer);
+            return std::copy_n(buffer, result.written, ctx.out());
+        }
         return format_to(ctx.out(), "{}", StringUtils::utf16_to_utf8(input));
     }
 };
+
+template<>
+struct fmt::formatter<std::wstring> : fmt::formatter<std::wstring_view> {};
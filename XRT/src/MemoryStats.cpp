@@ -0,0 +1,116 @@
+#include "MemoryStats.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#if defined(CFXS_PLATFORM_WINDOWS)
+    #include <malloc.h>
+    #include <Windows.h>
+    #include <psapi.h>
+#else
+    #include <malloc.h>
+    #include <sys/resource.h>
+#endif
+
+namespace XRT {
+
+    namespace {
+
+        std::atomic<bool> s_Enabled{false};
+        std::atomic<uint64_t> s_AllocatedBytes{0};
+        std::atomic<uint64_t> s_Allocations{0};
+        std::atomic<uint64_t> s_Frees{0};
+        std::atomic<int64_t> s_LiveBytes{0};
+        std::atomic<int64_t> s_PeakLiveBytes{0};
+
+        size_t GetBlockSize(void* ptr) {
+#if defined(CFXS_PLATFORM_WINDOWS)
+            return _msize(ptr);
+#else
+            return malloc_usable_size(ptr);
+#endif
+        }
+
+        void CountAllocation(void* ptr) {
+            auto size = GetBlockSize(ptr);
+            s_AllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+            s_Allocations.fetch_add(1, std::memory_order_relaxed);
+            auto live = s_LiveBytes.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed) + static_cast<int64_t>(size);
+            auto peak = s_PeakLiveBytes.load(std::memory_order_relaxed);
+            while (live > peak && !s_PeakLiveBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+            }
+        }
+
+        void CountFree(void* ptr) {
+            s_Frees.fetch_add(1, std::memory_order_relaxed);
+            s_LiveBytes.fetch_sub(static_cast<int64_t>(GetBlockSize(ptr)), std::memory_order_relaxed);
+        }
+
+    } // namespace
+
+    void MemoryStats::SetEnabled(bool enabled) {
+        s_Enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool MemoryStats::IsEnabled() {
+        return s_Enabled.load(std::memory_order_relaxed);
+    }
+
+    MemoryStats::Snapshot MemoryStats::GetSnapshot() {
+        Snapshot snapshot;
+        snapshot.allocated_bytes = s_AllocatedBytes.load(std::memory_order_relaxed);
+        snapshot.allocations     = s_Allocations.load(std::memory_order_relaxed);
+        snapshot.frees           = s_Frees.load(std::memory_order_relaxed);
+        snapshot.live_bytes      = s_LiveBytes.load(std::memory_order_relaxed);
+        snapshot.peak_live_bytes = s_PeakLiveBytes.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+    void MemoryStats::ResetPeak() {
+        s_PeakLiveBytes.store(s_LiveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    size_t MemoryStats::GetPeakRSS() {
+#if defined(CFXS_PLATFORM_WINDOWS)
+        PROCESS_MEMORY_COUNTERS counters;
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return 0;
+        return counters.PeakWorkingSetSize;
+#else
+        rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage))
+            return 0;
+        return static_cast<size_t>(usage.ru_maxrss) * 1024; // KB
+#endif
+    }
+
+} // namespace XRT
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Global allocation functions - the array and nothrow forms call these by default
+
+void* operator new(size_t size) {
+    if (!size)
+        size = 1;
+    void* ptr;
+    while (!(ptr = std::malloc(size))) {
+        auto handler = std::get_new_handler();
+        if (!handler)
+            throw std::bad_alloc();
+        handler();
+    }
+    if (XRT::s_Enabled.load(std::memory_order_relaxed))
+        XRT::CountAllocation(ptr);
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    if (!ptr)
+        return;
+    if (XRT::s_Enabled.load(std::memory_order_relaxed))
+        XRT::CountFree(ptr);
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace XRT {
+
+    /// Heap counters of the whole process - the global operator new/delete count every allocation while counting is enabled.
+    /// Sizes are the usable block sizes reported by the allocator, so they include its rounding.
+    /// Disabled counting costs one relaxed load per allocation.
+    class MemoryStats {
+    public:
+        struct Snapshot {
+            uint64_t allocated_bytes = 0; // since counting was enabled
+            uint64_t allocations     = 0;
+            uint64_t frees           = 0;
+            int64_t live_bytes       = 0; // allocated minus freed since counting was enabled
+            int64_t peak_live_bytes  = 0; // since the last ResetPeak
+        };
+
+    public:
+        static void SetEnabled(bool enabled);
+        static bool IsEnabled();
+
+        static Snapshot GetSnapshot();
+        /// Restart peak tracking from the current live bytes
+        static void ResetPeak();
+
+        /// Peak resident set size of the process in bytes - 0 if not available
+        static size_t GetPeakRSS();
+    };
+
+} // namespace XRT
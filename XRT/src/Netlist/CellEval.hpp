@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include "Netlist.hpp"
+
+namespace XRT {
+
+    static inline uint64_t NetMask(uint32_t width) {
+        return width >= 64 ? ~0ull : ((1ull << width) - 1);
+    }
+
+    /// Evaluate a single cell on scalar values - inputs must already be masked to their net widths
+    static inline uint64_t EvaluateCell(CellType type, uint64_t param, uint32_t out_width, uint64_t a, uint64_t b = 0, uint64_t c = 0) {
+        uint64_t r;
+        switch (type) {
+            case CellType::CONST: r = param; break;
+            case CellType::BUF: r = a; break;
+            case CellType::NOT: r = ~a; break;
+            case CellType::AND: r = a & b; break;
+            case CellType::OR: r = a | b; break;
+            case CellType::XOR: r = a ^ b; break;
+            case CellType::ADD: r = a + b; break;
+            case CellType::SUB: r = a - b; break;
+            case CellType::MUL: r = a * b; break;
+            case CellType::EQ: r = a == b; break;
+            case CellType::NE: r = a != b; break;
+            case CellType::LT: r = a < b; break;
+            case CellType::LE: r = a <= b; break;
+            case CellType::GT: r = a > b; break;
+            case CellType::GE: r = a >= b; break;
+            case CellType::LSL: r = b >= 64 ? 0 : a << b; break;
+            case CellType::LSR: r = b >= 64 ? 0 : a >> b; break;
+            case CellType::MUX: r = a ? b : c; break; // a = select
+            case CellType::SLICE: r = param >= 64 ? 0 : a >> param; break;
+            case CellType::REDUCE_OR: r = a != 0; break;
+            default: r = 0; break;
+        }
+        return r & NetMask(out_width);
+    }
+
+} // namespace XRT
@@ -0,0 +1,931 @@
+#include "Elaborator.hpp"
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <Log/Logger.hpp>
+#include "Profiler.hpp"
+#include "StringUtils.hpp"
+
+namespace XRT {
+
+    using ElaborationError = Elaborator::ElaborationError;
+
+    static uint32_t BitsFor(uint64_t value) {
+        return value ? static_cast<uint32_t>(std::bit_width(value)) : 1;
+    }
+
+    static uint64_t WidthMask(uint32_t width) {
+        return width >= 64 ? ~0ull : ((1ull << width) - 1);
+    }
+
+    static std::string ToUTF8(std::wstring_view str) {
+        return StringUtils::utf16_to_utf8(str);
+    }
+
+    /// 1234, 0x12AB, 0b1010, 1_000
+    static uint64_t ParseLiteral(const AST_Expression& expr) {
+        std::wstring_view text = expr.value;
+        uint64_t base          = 10;
+        if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+            base = 16;
+            text.remove_prefix(2);
+        } else if (text.size() > 2 && text[0] == '0' && (text[1] == 'b' || text[1] == 'B')) {
+            base = 2;
+            text.remove_prefix(2);
+        }
+
+        uint64_t value = 0;
+        for (auto c : text) {
+            uint64_t digit;
+            if (c == '_') {
+                continue;
+            } else if (c >= '0' && c <= '9') {
+                digit = static_cast<uint64_t>(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                digit = static_cast<uint64_t>(c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F') {
+                digit = static_cast<uint64_t>(c - 'A' + 10);
+            } else {
+                digit = base;
+            }
+            if (digit >= base)
+                throw ElaborationError("Invalid number literal \"" + ToUTF8(expr.value) + "\"", expr.token);
+            value = value * base + digit;
+        }
+        return value;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    struct Symbol {
+        enum class Kind { CONSTANT, PORT, REGISTER };
+
+        Kind kind;
+        uint64_t value          = 0; // CONSTANT
+        uint32_t width          = 0;
+        NetID net               = INVALID_ID;
+        uint32_t index          = INVALID_ID; // PortID / RegisterID
+        PortDirection direction = PortDirection::NONE;
+    };
+
+    /// Elaboration of a single component specialization into a netlist
+    class ComponentElaborator {
+        using FindComponent = std::function<const AST_Element::Component*(std::wstring_view)>;
+
+        enum class Context { CONSTRUCTOR, EVENT };
+
+        /// Pending assignment values per assignable target (out ports or registers)
+        using AssignState = std::vector<NetID>;
+
+    public:
+        ComponentElaborator(TypeContext& types, const AST_Element::Component& decl, FindComponent find_component, Netlist& netlist, bool coverage) :
+            m_Types(types), m_Declaration(decl), m_FindComponent(std::move(find_component)), m_Netlist(netlist), m_Coverage(coverage) {
+        }
+
+        /// Bind template parameter values - the specialization key is known after this step
+        void Bind(const ParameterMap& parameters) {
+            ResolveParameters(parameters);
+        }
+
+        void Run() {
+            for (auto& alias : m_Declaration.aliases) {
+                auto value = ConstEval(*alias.value);
+                AddSymbol(alias.name, Symbol{Symbol::Kind::CONSTANT, value, BitsFor(value)}, alias.token);
+            }
+
+            DeclarePorts(m_Declaration);
+            DeclareRegisters();
+
+            ElaborateConstructors();
+            ElaborateEvents();
+
+            m_Netlist.Finalize();
+        }
+
+    private:
+        void AddSymbol(const std::wstring& name, const Symbol& symbol, const Token* token) {
+            if (!m_Symbols.emplace(name, symbol).second)
+                throw ElaborationError("Redefinition of \"" + ToUTF8(name) + "\"", token);
+        }
+
+        const Symbol* FindSymbol(std::wstring_view name) const {
+            auto it = m_Symbols.find(std::wstring{name});
+            return it == m_Symbols.end() ? nullptr : &it->second;
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Declarations
+
+        void ResolveParameters(const ParameterMap& parameters) {
+            for (auto& param : m_Declaration.template_parameters) {
+                if (!param.type)
+                    throw ElaborationError("typename template parameters are not supported", param.token);
+
+                uint64_t value;
+                auto it = parameters.find(param.name);
+                if (it != parameters.end()) {
+                    value = it->second;
+                } else if (param.initializer) {
+                    value = ConstEval(*param.initializer);
+                } else {
+                    throw ElaborationError("No value for template parameter \"" + ToUTF8(param.name) + "\"", param.token);
+                }
+
+                // unbounded "unsigned" parameters take the width of their value
+                auto type  = ResolveType(*param.type);
+                auto width = type->kind == TypeKind::UNSIGNED && type->range_max == INT64_MAX ? BitsFor(value) : type->width;
+                value &= WidthMask(width);
+                AddSymbol(param.name, Symbol{Symbol::Kind::CONSTANT, value, width}, param.token);
+                m_Netlist.AddParameter(ToUTF8(param.name), value);
+            }
+        }
+
+        void DeclarePorts(const AST_Element::Component& decl) {
+            for (auto& base : decl.bases) {
+                if (auto base_decl = m_FindComponent(base)) {
+                    DeclarePorts(*base_decl);
+                } else if (base == L"std::clockable") {
+                    // built-in until std library sources are resolved by #include
+                    DeclarePort(L"clock", PortDirection::IN, m_Types.GetLogic(), decl.token);
+                } else {
+                    throw ElaborationError("Unknown base component \"" + ToUTF8(base) + "\"", decl.token);
+                }
+            }
+
+            for (auto& ctor : decl.constructors) {
+                for (auto& port : ctor.ports) {
+                    auto type = ResolveType(*port.type);
+                    if (!type->IsPort())
+                        throw ElaborationError("Constructor parameter \"" + ToUTF8(port.name) + "\" is not a port", port.token);
+                    DeclarePort(port.name, type->direction, type->element, port.token);
+                }
+            }
+        }
+
+        void DeclarePort(const std::wstring& name, PortDirection direction, const Type* type, const Token* token) {
+            auto utf8_name = ToUTF8(name);
+            auto net       = m_Netlist.AddNet(type->width, utf8_name);
+            auto port      = m_Netlist.AddPort(utf8_name, direction, net);
+            AddSymbol(name, Symbol{Symbol::Kind::PORT, 0, type->width, net, port, direction}, token);
+        }
+
+        void DeclareRegisters() {
+            for (auto& reg : m_Declaration.registers) {
+                auto type = ResolveType(*reg.type);
+                if (!type->IsIntegral())
+                    throw ElaborationError("Register \"" + ToUTF8(reg.name) + "\" must be of integral type", reg.token);
+
+                uint64_t init = reg.initializer ? ConstEval(*reg.initializer) & WidthMask(type->width) : 0;
+                auto name     = ToUTF8(reg.name);
+                auto q        = m_Netlist.AddNet(type->width, name);
+                auto id       = m_Netlist.AddRegister(name, q, INVALID_ID, INVALID_ID, ClockEdge::RISING, init);
+                AddSymbol(reg.name, Symbol{Symbol::Kind::REGISTER, 0, type->width, q, id}, reg.token);
+            }
+        }
+
+        const Type* ResolveType(const AST_TypeRef& ref) {
+            const Type* type = nullptr;
+            if (ref.direction != PortDirection::NONE) {
+                type = m_Types.GetPort(ref.direction, ResolveType(*ref.element));
+            } else if (ref.name == L"logic") {
+                type = m_Types.GetLogic();
+            } else if (ref.name == L"bool") {
+                type = m_Types.GetBool();
+            } else if (ref.name == L"unsigned" || ref.name == L"signed") {
+                int64_t range_min = 0;
+                int64_t range_max = INT64_MAX;
+                if (ref.range) {
+                    // <max..> / <min..max>
+                    if (ref.arguments.size() == 1) {
+                        range_max = static_cast<int64_t>(ConstEval(*ref.arguments[0]));
+                    } else {
+                        range_min = static_cast<int64_t>(ConstEval(*ref.arguments[0]));
+                        range_max = static_cast<int64_t>(ConstEval(*ref.arguments[1]));
+                    }
+                } else if (ref.arguments.size() == 1) {
+                    // <bits>
+                    auto bits = ConstEval(*ref.arguments[0]);
+                    if (bits == 0 || bits > MAX_NET_WIDTH)
+                        throw ElaborationError("Invalid bit width " + std::to_string(bits), ref.token);
+                    range_max = bits == 64 ? INT64_MAX : static_cast<int64_t>(WidthMask(static_cast<uint32_t>(bits)));
+                }
+                type = ref.name == L"unsigned" ? m_Types.GetUnsigned(range_min, range_max) : m_Types.GetSigned(range_min, range_max);
+            } else {
+                throw ElaborationError("Unsupported type \"" + ToUTF8(ref.name) + "\"", ref.token);
+            }
+
+            if (type->width > MAX_NET_WIDTH)
+                throw ElaborationError("Type " + type->ToString() + " exceeds max net width", ref.token);
+            return type;
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Constant evaluation
+
+        uint64_t ConstEval(const AST_Expression& expr) {
+            switch (expr.type) {
+                case AST_ExpressionType::LITERAL: return ParseLiteral(expr);
+                case AST_ExpressionType::IDENTIFIER: {
+                    if (expr.value == L"true")
+                        return 1;
+                    if (expr.value == L"false")
+                        return 0;
+                    auto sym = FindSymbol(expr.value);
+                    if (sym && sym->kind == Symbol::Kind::CONSTANT)
+                        return sym->value;
+                    break;
+                }
+                case AST_ExpressionType::UNARY: {
+                    auto v = ConstEval(*expr.operands[0]);
+                    switch (expr.op) {
+                        case TokenType::NOT: return !v;
+                        case TokenType::SUB: return ~v + 1;
+                        case TokenType::ADD: return v;
+                        default: break;
+                    }
+                    break;
+                }
+                case AST_ExpressionType::BINARY: {
+                    auto a = ConstEval(*expr.operands[0]);
+                    auto b = ConstEval(*expr.operands[1]);
+                    switch (expr.op) {
+                        case TokenType::ADD: return a + b;
+                        case TokenType::SUB: return a - b;
+                        case TokenType::MUL: return a * b;
+                        case TokenType::DIV:
+                            if (b == 0)
+                                throw ElaborationError("Division by zero", expr.token);
+                            return a / b;
+                        case TokenType::AND: return a & b;
+                        case TokenType::OR: return a | b;
+                        case TokenType::XOR: return a ^ b;
+                        case TokenType::LSL: return b >= 64 ? 0 : a << b;
+                        case TokenType::LSR: return b >= 64 ? 0 : a >> b;
+                        case TokenType::EQUAL: return a == b;
+                        case TokenType::NOT_EQUAL: return a != b;
+                        case TokenType::LT: return a < b;
+                        case TokenType::LTEQ: return a <= b;
+                        case TokenType::GT: return a > b;
+                        case TokenType::GTEQ: return a >= b;
+                        case TokenType::BOOL_AND: return a && b;
+                        case TokenType::BOOL_OR: return a || b;
+                        default: break;
+                    }
+                    break;
+                }
+                case AST_ExpressionType::TERNARY: {
+                    return ConstEval(*expr.operands[0]) ? ConstEval(*expr.operands[1]) : ConstEval(*expr.operands[2]);
+                }
+                case AST_ExpressionType::CALL: {
+                    auto& callee = *expr.operands[0];
+                    if (callee.type == AST_ExpressionType::IDENTIFIER && (callee.value == L"std::pow" || callee.value == L"pow") &&
+                        expr.operands.size() == 3) {
+                        auto base  = ConstEval(*expr.operands[1]);
+                        auto power = ConstEval(*expr.operands[2]);
+                        // exponentiation by squaring - constants are 64 bit
+                        auto overflows = [](uint64_t a, uint64_t b) {
+                            return a && b > std::numeric_limits<uint64_t>::max() / a;
+                        };
+                        uint64_t v = 1;
+                        while (power) {
+                            if (power & 1) {
+                                if (overflows(v, base))
+                                    throw ElaborationError("std::pow result does not fit in 64 bits", expr.token);
+                                v *= base;
+                            }
+                            power >>= 1;
+                            if (power) {
+                                if (overflows(base, base))
+                                    throw ElaborationError("std::pow result does not fit in 64 bits", expr.token);
+                                base *= base;
+                            }
+                        }
+                        return v;
+                    }
+                    break;
+                }
+                default: break;
+            }
+            throw ElaborationError("Expression is not constant", expr.token);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Netlist construction helpers
+
+        NetID MakeCell(CellType type, uint32_t width, std::initializer_list<NetID> inputs, uint64_t param = 0) {
+            auto net = m_Netlist.AddNet(width);
+            m_Netlist.AddCell(type, net, inputs, param);
+            return net;
+        }
+
+        NetID MakeConst(uint64_t value, uint32_t width) {
+            return MakeCell(CellType::CONST, width, {}, value & WidthMask(width));
+        }
+
+        NetID ToBool(NetID net) {
+            return m_Netlist.GetNetWidth(net) == 1 ? net : MakeCell(CellType::REDUCE_OR, 1, {net});
+        }
+
+        NetID Resize(NetID net, uint32_t width) {
+            return m_Netlist.GetNetWidth(net) == width ? net : MakeCell(CellType::BUF, width, {net});
+        }
+
+        uint32_t Width(NetID net) const {
+            return m_Netlist.GetNetWidth(net);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Expressions
+
+        NetID Expression(const AST_Expression& expr, AssignState& state) {
+            switch (expr.type) {
+                case AST_ExpressionType::LITERAL: {
+                    auto v = ParseLiteral(expr);
+                    return MakeConst(v, BitsFor(v));
+                }
+
+                case AST_ExpressionType::IDENTIFIER: {
+                    if (expr.value == L"true" || expr.value == L"false")
+                        return MakeConst(expr.value == L"true", 1);
+                    auto sym = FindSymbol(expr.value);
+                    if (!sym)
+                        throw ElaborationError("Unknown identifier \"" + ToUTF8(expr.value) + "\"", expr.token);
+                    switch (sym->kind) {
+                        case Symbol::Kind::CONSTANT: return MakeConst(sym->value, sym->width);
+                        case Symbol::Kind::REGISTER: return sym->net; // registers read their current state
+                        case Symbol::Kind::PORT: {
+                            if (sym->direction == PortDirection::OUT && m_Context == Context::CONSTRUCTOR &&
+                                state[sym->index] != INVALID_ID)
+                                return state[sym->index];
+                            if (m_Context == Context::EVENT && sym->net == m_EventClock) {
+                                // the clock level is known inside a single edge handler
+                                if (m_EventEdge && *m_EventEdge != ClockEdge::BOTH)
+                                    return MakeConst(*m_EventEdge == ClockEdge::RISING, 1);
+                                m_EventReadsClock = true;
+                            }
+                            return sym->net;
+                        }
+                        default: throw ElaborationError("Invalid use of \"" + ToUTF8(expr.value) + "\"", expr.token);
+                    }
+                }
+
+                case AST_ExpressionType::UNARY: {
+                    auto a = Expression(*expr.operands[0], state);
+                    switch (expr.op) {
+                        case TokenType::NOT:
+                            return Width(a) == 1 ? MakeCell(CellType::NOT, 1, {a}) : MakeCell(CellType::EQ, 1, {a, MakeConst(0, 1)});
+                        case TokenType::SUB: return MakeCell(CellType::SUB, Width(a), {MakeConst(0, 1), a});
+                        case TokenType::ADD: return a;
+                        default: throw ElaborationError(ToString(expr.op) + " can only be used as a statement", expr.token);
+                    }
+                }
+
+                case AST_ExpressionType::BINARY: {
+                    auto a = Expression(*expr.operands[0], state);
+                    auto b = Expression(*expr.operands[1], state);
+                    if (expr.op == TokenType::BOOL_AND || expr.op == TokenType::BOOL_OR) {
+                        return MakeCell(expr.op == TokenType::BOOL_AND ? CellType::AND : CellType::OR, 1, {ToBool(a), ToBool(b)});
+                    }
+                    auto type  = GetBinaryCellType(expr);
+                    auto width = std::max(Width(a), Width(b));
+                    switch (type) {
+                        case CellType::EQ:
+                        case CellType::NE:
+                        case CellType::LT:
+                        case CellType::LE:
+                        case CellType::GT:
+                        case CellType::GE: width = 1; break;
+                        case CellType::MUL: width = std::min(Width(a) + Width(b), MAX_NET_WIDTH); break;
+                        case CellType::LSL:
+                        case CellType::LSR: width = Width(a); break;
+                        default: break;
+                    }
+                    return MakeCell(type, width, {a, b});
+                }
+
+                case AST_ExpressionType::TERNARY: {
+                    auto s = ToBool(Expression(*expr.operands[0], state));
+                    auto a = Expression(*expr.operands[1], state);
+                    auto b = Expression(*expr.operands[2], state);
+                    return MakeCell(CellType::MUX, std::max(Width(a), Width(b)), {s, a, b});
+                }
+
+                case AST_ExpressionType::CALL:
+                case AST_ExpressionType::INDEX: {
+                    // net(bit) / net(high, low) / net[bit]
+                    auto& callee = *expr.operands[0];
+                    auto sym     = callee.type == AST_ExpressionType::IDENTIFIER ? FindSymbol(callee.value) : nullptr;
+                    if (sym && (sym->kind == Symbol::Kind::PORT || sym->kind == Symbol::Kind::REGISTER)) {
+                        auto net = Expression(callee, state);
+                        if (expr.operands.size() == 2) {
+                            auto bit = ConstEval(*expr.operands[1]);
+                            if (bit >= Width(net))
+                                throw ElaborationError("Bit index " + std::to_string(bit) + " out of range", expr.token);
+                            return MakeCell(CellType::SLICE, 1, {net}, bit);
+                        } else if (expr.operands.size() == 3) {
+                            auto high = ConstEval(*expr.operands[1]);
+                            auto low  = ConstEval(*expr.operands[2]);
+                            if (high < low || high >= Width(net))
+                                throw ElaborationError("Invalid bit range", expr.token);
+                            return MakeCell(CellType::SLICE, static_cast<uint32_t>(high - low + 1), {net}, low);
+                        }
+                        throw ElaborationError("Invalid bit selection", expr.token);
+                    }
+                    auto v = ConstEval(expr);
+                    return MakeConst(v, BitsFor(v));
+                }
+
+                case AST_ExpressionType::MEMBER: {
+                    auto& object = *expr.operands[0];
+                    if (object.type == AST_ExpressionType::IDENTIFIER && object.value == m_EventParameter) {
+                        // clockable components only have the clock event source
+                        if (expr.value == L"clock")
+                            return MakeConst(1, 1);
+                        return MakeConst(0, 1);
+                    }
+                    throw ElaborationError("Unsupported member access \"" + ToUTF8(expr.value) + "\"", expr.token);
+                }
+
+                default: throw ElaborationError("Invalid expression", expr.token);
+            }
+        }
+
+        CellType GetBinaryCellType(const AST_Expression& expr) {
+            switch (expr.op) {
+                case TokenType::ADD: return CellType::ADD;
+                case TokenType::SUB: return CellType::SUB;
+                case TokenType::MUL: return CellType::MUL;
+                case TokenType::AND: return CellType::AND;
+                case TokenType::OR: return CellType::OR;
+                case TokenType::XOR: return CellType::XOR;
+                case TokenType::LSL: return CellType::LSL;
+                case TokenType::LSR: return CellType::LSR;
+                case TokenType::EQUAL: return CellType::EQ;
+                case TokenType::NOT_EQUAL: return CellType::NE;
+                case TokenType::LT: return CellType::LT;
+                case TokenType::LTEQ: return CellType::LE;
+                case TokenType::GT: return CellType::GT;
+                case TokenType::GTEQ: return CellType::GE;
+                default: throw ElaborationError("Unsupported operator " + ToString(expr.op), expr.token);
+            }
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Statements
+
+        /// Resolve assignment target to state slot
+        const Symbol& GetTarget(const AST_Expression& expr) {
+            if (expr.type != AST_ExpressionType::IDENTIFIER)
+                throw ElaborationError("Invalid assignment target", expr.token);
+            auto sym = FindSymbol(expr.value);
+            if (m_Context == Context::EVENT && sym && sym->kind == Symbol::Kind::REGISTER)
+                return *sym;
+            if (m_Context == Context::CONSTRUCTOR && sym && sym->kind == Symbol::Kind::PORT && sym->direction == PortDirection::OUT)
+                return *sym;
+            throw ElaborationError(m_Context == Context::EVENT ? "Only registers can be assigned in events"
+                                                                : "Only output ports can be assigned in constructors",
+                                   expr.token);
+        }
+
+        NetID ReadTarget(const Symbol& target, AssignState& state) {
+            if (m_Context == Context::CONSTRUCTOR && state[target.index] != INVALID_ID)
+                return state[target.index];
+            return target.net;
+        }
+
+        void Statements(const std::vector<Scope<AST_Statement>>& body, AssignState& state) {
+            for (auto& stmt : body) {
+                Statement(*stmt, state);
+            }
+        }
+
+        void Statement(const AST_Statement& stmt, AssignState& state) {
+            switch (stmt.type) {
+                case AST_StatementType::BLOCK: Statements(stmt.body, state); break;
+
+                case AST_StatementType::IF: {
+                    auto cond       = ToBool(Expression(*stmt.expression, state));
+                    auto then_state = state;
+                    auto else_state = state;
+                    if (m_Coverage && m_Context == Context::EVENT) {
+                        // branches are hit when this condition matches and the enclosing branch is hit
+                        auto parent   = m_CoverParent;
+                        auto location = std::to_string(stmt.token->line) + ":" + std::to_string(stmt.token->column);
+                        auto then_id  = m_Netlist.AddCoverPoint(location + ":then", cond, true, m_EventClock, ClockEdge::RISING, parent);
+                        auto else_id  = m_Netlist.AddCoverPoint(location + ":else", cond, false, m_EventClock, ClockEdge::RISING, parent);
+
+                        m_CoverParent = then_id;
+                        Statements(stmt.body, then_state);
+                        m_CoverParent = else_id;
+                        Statements(stmt.else_body, else_state);
+                        m_CoverParent = parent;
+                    } else {
+                        Statements(stmt.body, then_state);
+                        Statements(stmt.else_body, else_state);
+                    }
+                    for (size_t i = 0; i < state.size(); i++) {
+                        if (then_state[i] == else_state[i])
+                            continue;
+                        auto width = m_TargetWidths[i];
+                        auto a     = then_state[i] == INVALID_ID ? MakeConst(0, width) : then_state[i];
+                        auto b     = else_state[i] == INVALID_ID ? MakeConst(0, width) : else_state[i];
+                        state[i]   = MakeCell(CellType::MUX, width, {cond, a, b});
+                    }
+                    break;
+                }
+
+                case AST_StatementType::EXPRESSION: {
+                    auto& expr = *stmt.expression;
+                    if (expr.type == AST_ExpressionType::ASSIGN) {
+                        auto& target = GetTarget(*expr.operands[0]);
+                        auto value   = Expression(*expr.operands[1], state);
+                        if (expr.op != TokenType::ASSIGN) {
+                            auto type = CellType::ADD;
+                            switch (expr.op) {
+                                case TokenType::ASSIGN_ADD: type = CellType::ADD; break;
+                                case TokenType::ASSIGN_SUB: type = CellType::SUB; break;
+                                case TokenType::ASSIGN_MUL: type = CellType::MUL; break;
+                                case TokenType::ASSIGN_AND: type = CellType::AND; break;
+                                case TokenType::ASSIGN_OR: type = CellType::OR; break;
+                                case TokenType::ASSIGN_XOR: type = CellType::XOR; break;
+                                case TokenType::ASSIGN_LSL: type = CellType::LSL; break;
+                                case TokenType::ASSIGN_LSR: type = CellType::LSR; break;
+                                default: throw ElaborationError("Unsupported assignment " + ToString(expr.op), expr.token);
+                            }
+                            value = MakeCell(type, target.width, {ReadTarget(target, state), value});
+                        }
+                        state[target.index] = Resize(value, target.width);
+                    } else if ((expr.type == AST_ExpressionType::POSTFIX || expr.type == AST_ExpressionType::UNARY) &&
+                               (expr.op == TokenType::INC || expr.op == TokenType::DEC)) {
+                        auto& target        = GetTarget(*expr.operands[0]);
+                        auto type           = expr.op == TokenType::INC ? CellType::ADD : CellType::SUB;
+                        state[target.index] = MakeCell(type, target.width, {ReadTarget(target, state), MakeConst(1, 1)});
+                    } else {
+                        throw ElaborationError("Expression statement has no effect", expr.token);
+                    }
+                    break;
+                }
+            }
+        }
+
+        ////////////////////////////////////////////////////////////
+
+        void ElaborateConstructors() {
+            m_Context = Context::CONSTRUCTOR;
+            m_TargetWidths.clear();
+            for (PortID p = 0; p < m_Netlist.GetPortCount(); p++)
+                m_TargetWidths.push_back(m_Netlist.GetNetWidth(m_Netlist.GetPortNet(p)));
+
+            AssignState state(m_Netlist.GetPortCount(), INVALID_ID);
+            for (auto& ctor : m_Declaration.constructors) {
+                Statements(ctor.body, state);
+            }
+
+            for (PortID p = 0; p < m_Netlist.GetPortCount(); p++) {
+                if (m_Netlist.GetPortDirection(p) != PortDirection::OUT)
+                    continue;
+                auto value = state[p];
+                if (value == INVALID_ID) {
+                    LOG_WARN("{}: output \"{}\" is not driven", m_Netlist.GetName(), m_Netlist.GetPortName(p));
+                    value = MakeConst(0, m_TargetWidths[p]);
+                }
+                m_Netlist.AddCell(CellType::BUF, m_Netlist.GetPortNet(p), {value});
+            }
+        }
+
+        /// Edge of an Event<source, edge> handler
+        ClockEdge EventEdge(const Token& token) {
+            if (token.value == L"rising" || token.value == L"true")
+                return ClockEdge::RISING;
+            if (token.value == L"falling" || token.value == L"false")
+                return ClockEdge::FALLING;
+            if (token.value == L"both")
+                return ClockEdge::BOTH;
+            auto sym = FindSymbol(token.value);
+            if (!sym || sym->kind != Symbol::Kind::CONSTANT)
+                throw ElaborationError("Event edge \"" + ToUTF8(token.value) + "\" is not rising, falling, both or a constant", &token);
+            return sym->value ? ClockEdge::RISING : ClockEdge::FALLING;
+        }
+
+        void ElaborateEvents() {
+            m_Context = Context::EVENT;
+            m_TargetWidths.clear();
+            AssignState state;
+            for (RegisterID r = 0; r < m_Netlist.GetRegisterCount(); r++) {
+                m_TargetWidths.push_back(m_Netlist.GetNetWidth(m_Netlist.GetRegisterQ(r)));
+                state.push_back(m_Netlist.GetRegisterQ(r));
+            }
+
+            // registers are clocked by the component clock port on the Event<source, edge> edge (rising by default) -
+            // handlers without an edge that test the clock level select their own edges and run on both
+            auto clock_symbol = FindSymbol(L"clock");
+            NetID clock       = clock_symbol && clock_symbol->kind == Symbol::Kind::PORT ? clock_symbol->net : INVALID_ID;
+            m_EventEdge.reset();
+            m_EventReadsClock = false;
+            for (auto& event : m_Declaration.events) {
+                if (!event.edge)
+                    continue;
+                auto edge = EventEdge(*event.edge);
+                if (m_EventEdge && *m_EventEdge != edge)
+                    throw ElaborationError("Event handlers with different clock edges are not supported", event.edge);
+                m_EventEdge = edge;
+            }
+
+            for (auto& event : m_Declaration.events) {
+                if (event.source != L"auto") {
+                    auto source = FindSymbol(event.source);
+                    if (!source || source->kind != Symbol::Kind::PORT || source->direction != PortDirection::IN)
+                        throw ElaborationError("Unknown event source \"" + ToUTF8(event.source) + "\"", event.token);
+                    if (clock != INVALID_ID && clock != source->net)
+                        throw ElaborationError("Multiple event sources per component are not supported", event.token);
+                    clock = source->net;
+                }
+                if (clock == INVALID_ID)
+                    throw ElaborationError("Event handler in component without clock", event.token);
+
+                m_EventParameter = event.parameter;
+                m_EventClock     = clock;
+                Statements(event.body, state);
+                m_EventParameter.clear();
+            }
+
+            if (m_Netlist.GetRegisterCount() && clock == INVALID_ID)
+                throw ElaborationError("Registers in component without clock", m_Declaration.token);
+
+            auto edge = m_EventEdge.value_or(m_EventReadsClock ? ClockEdge::BOTH : ClockEdge::RISING);
+            for (RegisterID r = 0; r < m_Netlist.GetRegisterCount(); r++) {
+                m_Netlist.SetRegisterInput(r, state[r]);
+                m_Netlist.SetRegisterClock(r, clock, edge);
+            }
+            // branches are sampled on the events the handlers run on - only known once all handlers are elaborated
+            for (CoverID c = 0; c < m_Netlist.GetCoverPointCount(); c++)
+                m_Netlist.SetCoverPointEdge(c, edge);
+        }
+
+    private:
+        TypeContext& m_Types;
+        const AST_Element::Component& m_Declaration;
+        FindComponent m_FindComponent;
+        Netlist& m_Netlist;
+
+        std::unordered_map<std::wstring, Symbol> m_Symbols;
+        Context m_Context = Context::CONSTRUCTOR;
+        std::vector<uint32_t> m_TargetWidths;
+        std::wstring m_EventParameter;
+        std::optional<ClockEdge> m_EventEdge; // Event<source, edge> of the handlers
+        bool m_EventReadsClock = false;       // clock level tested by a handler without an edge
+
+        // Branch coverage
+        bool m_Coverage;
+        NetID m_EventClock    = INVALID_ID;
+        CoverID m_CoverParent = INVALID_ID; // coverage point of the enclosing if branch
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    static std::wstring_view UnqualifiedName(std::wstring_view name) {
+        auto separator = name.rfind(L"::");
+        return separator == std::wstring_view::npos ? name : name.substr(separator + 2);
+    }
+
+    /// Component name lookup - exact or unqualified match of a Namespace::Name
+    static bool MatchesName(std::wstring_view full_name, std::wstring_view name) {
+        return full_name == name || (full_name.size() > name.size() && full_name.ends_with(name) &&
+                                     full_name.compare(full_name.size() - name.size() - 2, 2, L"::") == 0);
+    }
+
+    Elaborator::Elaborator(TypeContext& types, Design& design) : m_Types(types), m_Design(design) {
+    }
+
+    uint32_t Elaborator::AddSource(const Ref<AST>& ast) {
+        auto source = static_cast<uint32_t>(m_Sources.size());
+        m_Sources.push_back(ast);
+        m_SourceComponents.emplace_back();
+        RegisterComponents(source);
+        return source;
+    }
+
+    void Elaborator::RegisterComponents(uint32_t source) {
+        auto& ast = m_Sources[source];
+        if (!ast)
+            return;
+
+        // namespace name per scope level
+        std::vector<std::wstring> scopes;
+        for (auto& e : ast->GetEntries()) {
+            switch (e->type) {
+                case AST_Type::SCOPE_START: scopes.emplace_back(); break;
+                case AST_Type::SCOPE_END:
+                    if (!scopes.empty())
+                        scopes.pop_back();
+                    break;
+                case AST_Type::NAMESPACE:
+                    if (!scopes.empty())
+                        scopes.back() = e->Cast<AST_Element::Namespace>().name;
+                    break;
+                case AST_Type::COMPONENT: {
+                    auto& comp = e->Cast<AST_Element::Component>();
+                    std::wstring full_name;
+                    for (auto& ns : scopes) {
+                        if (ns.empty())
+                            continue;
+                        full_name += ns + L"::";
+                    }
+                    full_name += comp.name;
+
+                    auto index = m_Components.size();
+                    m_ComponentsByFullName.emplace(full_name, index);
+                    m_ComponentsByName[comp.name].push_back(index);
+                    m_Components.push_back({std::move(full_name), &comp, source});
+                    m_SourceComponents[source].push_back(index);
+                    m_Pending.push_back(index);
+                    break;
+                }
+                default: break;
+            }
+        }
+    }
+
+    void Elaborator::UnregisterComponent(size_t component) {
+        // the declaration may already be gone - only the name is used
+        auto& c    = m_Components[component];
+        auto name  = std::wstring{UnqualifiedName(c.full_name)};
+        auto named = m_ComponentsByName.find(name);
+        std::erase(named->second, component);
+
+        auto it = m_ComponentsByFullName.find(c.full_name);
+        if (it != m_ComponentsByFullName.end() && it->second == component) {
+            // next declaration of the same name takes over
+            auto next = std::find_if(named->second.begin(), named->second.end(), [&](size_t index) {
+                return m_Components[index].full_name == c.full_name;
+            });
+            if (next != named->second.end()) {
+                it->second = *next;
+            } else {
+                m_ComponentsByFullName.erase(it);
+            }
+        }
+
+        if (named->second.empty())
+            m_ComponentsByName.erase(named);
+        c.declaration = nullptr;
+    }
+
+    void Elaborator::ReplaceSource(uint32_t source, const Ref<AST>& ast) {
+        XRT_PROFILE_SCOPE("Elaborator::ReplaceSource");
+
+        // names declared before and after the change
+        std::vector<std::wstring> names;
+        auto old_components = std::exchange(m_SourceComponents[source], {});
+        for (auto index : old_components) {
+            names.push_back(m_Components[index].full_name);
+            UnregisterComponent(index);
+        }
+        m_Sources[source] = ast;
+        RegisterComponents(source);
+        for (auto index : m_SourceComponents[source])
+            names.push_back(m_Components[index].full_name);
+
+        // specializations of declarations with the same name may have been shared,
+        // base lookups matching a changed name may resolve to another declaration now
+        std::vector<bool> stale(m_Components.size());
+        for (auto index : old_components)
+            stale[index] = true;
+        for (auto& name : names) {
+            auto unqualified = std::wstring{UnqualifiedName(name)};
+            if (auto it = m_ComponentsByName.find(unqualified); it != m_ComponentsByName.end()) {
+                for (auto index : it->second)
+                    stale[index] = stale[index] || m_Components[index].full_name == name;
+            }
+            if (auto it = m_Dependents.find(unqualified); it != m_Dependents.end()) {
+                for (auto& [index, lookup] : it->second)
+                    stale[index] = stale[index] || MatchesName(name, lookup);
+            }
+        }
+
+        for (auto id = m_ModuleComponents.size(); id-- > 0;) {
+            if (stale[m_ModuleComponents[id]])
+                RemoveModule(static_cast<ModuleID>(id));
+        }
+        for (size_t index = 0; index < stale.size(); index++) {
+            if (stale[index] && m_Components[index].declaration)
+                m_Pending.push_back(index);
+        }
+    }
+
+    void Elaborator::RemoveModule(ModuleID id) {
+        m_Specializations.erase(m_ModuleKeys[id]);
+        auto moved = m_Design.RemoveModule(id);
+        if (moved != INVALID_ID) {
+            m_ModuleKeys[id]                    = std::move(m_ModuleKeys[moved]);
+            m_ModuleComponents[id]              = m_ModuleComponents[moved];
+            m_Specializations[m_ModuleKeys[id]] = id;
+        }
+        m_ModuleKeys.pop_back();
+        m_ModuleComponents.pop_back();
+    }
+
+    const Elaborator::ComponentInfo* Elaborator::FindComponent(std::wstring_view name) const {
+        auto exact = m_ComponentsByFullName.find(std::wstring{name});
+        if (exact != m_ComponentsByFullName.end())
+            return &m_Components[exact->second];
+
+        // unqualified match - last declaration with a qualified name ending in ::name
+        auto it = m_ComponentsByName.find(std::wstring{UnqualifiedName(name)});
+        if (it == m_ComponentsByName.end())
+            return nullptr;
+        const ComponentInfo* found = nullptr;
+        for (auto index : it->second) {
+            if (MatchesName(m_Components[index].full_name, name))
+                found = &m_Components[index];
+        }
+        return found;
+    }
+
+    ModuleID Elaborator::Elaborate(std::wstring_view component, const ParameterMap& parameters) {
+        auto info = FindComponent(component);
+        if (!info)
+            throw ElaborationError("Unknown component \"" + ToUTF8(component) + "\"", nullptr);
+        if (info->declaration->abstract)
+            throw ElaborationError("Cannot elaborate abstract component \"" + ToUTF8(info->full_name) + "\"", info->declaration->token);
+        return ElaborateComponent(static_cast<size_t>(info - m_Components.data()), parameters);
+    }
+
+    ModuleID Elaborator::ElaborateComponent(size_t component, const ParameterMap& parameters) {
+        XRT_PROFILE_SCOPE("Elaborator::Elaborate");
+
+        auto& info   = m_Components[component];
+        auto netlist = CreateScope<Netlist>(ToUTF8(info.full_name));
+        ComponentElaborator elab(
+            m_Types,
+            *info.declaration,
+            [this, component](std::wstring_view name) -> const AST_Element::Component* {
+                // a change of any component matching the name invalidates the module
+                auto& dependents = m_Dependents[std::wstring{UnqualifiedName(name)}];
+                if (dependents.empty() || dependents.back().first != component || dependents.back().second != name)
+                    dependents.emplace_back(component, name);
+
+                auto base = FindComponent(name);
+                return base ? base->declaration : nullptr;
+            },
+            *netlist,
+            m_Coverage);
+        elab.Bind(parameters);
+
+        // reuse identical specializations
+        std::string key{netlist->GetName()};
+        for (auto& [name, value] : netlist->GetParameters()) {
+            key += ',';
+            key += std::to_string(value);
+        }
+        auto it = m_Specializations.find(key);
+        if (it != m_Specializations.end())
+            return it->second;
+
+        elab.Run();
+
+        LOG_TRACE("Elaborated {} - {} nets, {} cells, {} registers, {} ports",
+                  netlist->GetName(),
+                  netlist->GetNetCount(),
+                  netlist->GetCellCount(),
+                  netlist->GetRegisterCount(),
+                  netlist->GetPortCount());
+
+        auto id = m_Design.AddModule(std::move(netlist));
+        m_Specializations.emplace(key, id);
+        m_ModuleKeys.push_back(std::move(key));
+        m_ModuleComponents.push_back(component);
+        if (m_Design.GetTop() == INVALID_ID)
+            m_Design.SetTop(id);
+        return id;
+    }
+
+    void Elaborator::ElaborateAll(const ParameterMap& parameters) {
+        // in declaration order, each component once
+        auto pending = std::exchange(m_Pending, {});
+        std::sort(pending.begin(), pending.end());
+        pending.erase(std::unique(pending.begin(), pending.end()), pending.end());
+
+        for (auto index : pending) {
+            auto& c = m_Components[index];
+            if (!c.declaration || c.declaration->abstract)
+                continue;
+
+            bool complete = true;
+            for (auto& param : c.declaration->template_parameters) {
+                if (!param.initializer && !parameters.contains(param.name)) {
+                    LOG_WARN("Skipping {} - no value for template parameter {}", ToUTF8(c.full_name), ToUTF8(param.name));
+                    complete = false;
+                    break;
+                }
+            }
+
+            if (complete)
+                ElaborateComponent(index, parameters);
+        }
+    }
+
+} // namespace XRT
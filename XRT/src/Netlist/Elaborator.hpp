@@ -0,0 +1,108 @@
+#pragma once
+#include <exception>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <Utils.hpp>
+#include "Language/AST.hpp"
+#include "Language/TypeContext.hpp"
+#include "Netlist.hpp"
+
+namespace XRT {
+
+    /// Template parameter overrides by name
+    using ParameterMap = std::unordered_map<std::wstring, uint64_t>;
+
+    /// Turns parsed component declarations into netlist modules.
+    /// Sources can be replaced after elaboration - modules of the replaced declarations and of components whose base
+    /// names resolve to changed declarations are removed from the design, other modules stay.
+    class Elaborator {
+    public:
+        class ElaborationError : public std::exception {
+        public:
+            ElaborationError(const std::string& reason, const Token* token) : m_Token(token), m_Reason(reason) {
+            }
+
+            const char* what() const noexcept override {
+                return m_Reason.c_str();
+            }
+
+            size_t GetLine() const {
+                return m_Token ? m_Token->line : 0;
+            }
+            size_t GetColumn() const {
+                return m_Token ? m_Token->column : 0;
+            }
+            const Token* GetToken() const {
+                return m_Token;
+            }
+
+        private:
+            const Token* m_Token;
+            std::string m_Reason;
+        };
+
+        struct ComponentInfo {
+            std::wstring full_name; // Namespace::Name
+            const AST_Element::Component* declaration; // nullptr after the source was replaced
+            uint32_t source;                           // AddSource index
+        };
+
+    public:
+        Elaborator(TypeContext& types, Design& design);
+        ~Elaborator() = default;
+
+        /// Register component declarations of a parsed source (nullptr - source without declarations).
+        /// Returns the source index for ReplaceSource.
+        uint32_t AddSource(const Ref<AST>& ast);
+
+        /// Replace the declarations of a source. Modules that depend on the old or new declarations are removed,
+        /// the next ElaborateAll elaborates their components again.
+        void ReplaceSource(uint32_t source, const Ref<AST>& ast);
+
+        /// Elaborate a component specialization - existing specializations are reused.
+        /// Component name can be fully qualified or unqualified if unique.
+        ModuleID Elaborate(std::wstring_view component, const ParameterMap& parameters = {});
+
+        /// Add branch coverage points for if statements in event handlers to elaborated modules
+        void SetCoverage(bool enable) {
+            m_Coverage = enable;
+        }
+
+        /// Elaborate every non-abstract component that has values for all template parameters.
+        /// Later calls only elaborate components added or invalidated since - parameters must stay the same.
+        void ElaborateAll(const ParameterMap& parameters = {});
+
+        const std::vector<ComponentInfo>& GetComponents() const {
+            return m_Components;
+        }
+
+        TypeContext& GetTypes() {
+            return m_Types;
+        }
+
+    private:
+        const ComponentInfo* FindComponent(std::wstring_view name) const;
+        ModuleID ElaborateComponent(size_t component, const ParameterMap& parameters);
+        void RegisterComponents(uint32_t source);
+        void UnregisterComponent(size_t component);
+        void RemoveModule(ModuleID id);
+
+    private:
+        TypeContext& m_Types;
+        Design& m_Design;
+        std::vector<Ref<AST>> m_Sources;
+        std::vector<std::vector<size_t>> m_SourceComponents; // [source]
+        std::vector<ComponentInfo> m_Components;
+        std::unordered_map<std::wstring, size_t> m_ComponentsByFullName;         // first declaration
+        std::unordered_map<std::wstring, std::vector<size_t>> m_ComponentsByName; // unqualified name -> declarations
+        // unqualified base name -> component and the name it looked up
+        std::unordered_map<std::wstring, std::vector<std::pair<size_t, std::wstring>>> m_Dependents;
+        std::vector<size_t> m_Pending; // components for the next ElaborateAll
+        std::unordered_map<std::string, ModuleID> m_Specializations;
+        std::vector<std::string> m_ModuleKeys;  // [module] specialization
+        std::vector<size_t> m_ModuleComponents; // [module]
+        bool m_Coverage = false;
+    };
+
+} // namespace XRT
@@ -0,0 +1,464 @@
+#include "Netlist.hpp"
+#include <functional>
+#include <Assert.hpp>
+#include <Log/Logger.hpp>
+#include "Profiler.hpp"
+
+namespace XRT {
+
+    const char* CellType_ToString(CellType type) {
+        switch (type) {
+            case CellType::CONST: return "CONST";
+            case CellType::BUF: return "BUF";
+            case CellType::NOT: return "NOT";
+            case CellType::AND: return "AND";
+            case CellType::OR: return "OR";
+            case CellType::XOR: return "XOR";
+            case CellType::ADD: return "ADD";
+            case CellType::SUB: return "SUB";
+            case CellType::MUL: return "MUL";
+            case CellType::EQ: return "EQ";
+            case CellType::NE: return "NE";
+            case CellType::LT: return "LT";
+            case CellType::LE: return "LE";
+            case CellType::GT: return "GT";
+            case CellType::GE: return "GE";
+            case CellType::LSL: return "LSL";
+            case CellType::LSR: return "LSR";
+            case CellType::MUX: return "MUX";
+            case CellType::SLICE: return "SLICE";
+            case CellType::REDUCE_OR: return "REDUCE_OR";
+            default: return "???";
+        }
+    }
+
+    const char* ClockEdge_ToString(ClockEdge edge) {
+        switch (edge) {
+            case ClockEdge::RISING: return "RISING";
+            case ClockEdge::FALLING: return "FALLING";
+            case ClockEdge::BOTH: return "BOTH";
+            default: return "???";
+        }
+    }
+
+    template<typename T>
+    static size_t VectorBytes(const std::vector<T>& v) {
+        return v.capacity() * sizeof(T);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // NameTable
+
+    NameID NameTable::Intern(std::string_view name) {
+        auto hash          = std::hash<std::string_view>{}(name);
+        auto [first, last] = m_Lookup.equal_range(hash);
+        for (auto it = first; it != last; ++it) {
+            if (Get(it->second) == name)
+                return it->second;
+        }
+
+        auto id = static_cast<NameID>(m_Offsets.size() - 1);
+        m_Buffer.append(name);
+        m_Offsets.push_back(static_cast<uint32_t>(m_Buffer.size()));
+        m_Lookup.emplace(hash, id);
+        return id;
+    }
+
+    size_t NameTable::GetMemoryUsage() const {
+        return m_Buffer.capacity() + VectorBytes(m_Offsets) + m_Lookup.size() * (sizeof(size_t) + sizeof(NameID) + 2 * sizeof(void*));
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Netlist
+
+    Netlist::Netlist(std::string_view name) {
+        m_Name = m_Names.Intern(name);
+    }
+
+    NetID Netlist::AddNet(uint32_t width, std::string_view name) {
+        auto id = static_cast<NetID>(m_NetWidth.size());
+        m_NetWidth.push_back(width);
+        m_NetName.push_back(name.empty() ? INVALID_ID : m_Names.Intern(name));
+        m_NetDriver.push_back(INVALID_ID);
+        m_NetDriverKind.push_back(DriverKind::NONE);
+        return id;
+    }
+
+    CoverID Netlist::AddCoverPoint(std::string_view name, NetID condition, bool polarity, NetID clock, ClockEdge edge, CoverID parent) {
+        auto id = static_cast<CoverID>(m_CoverNet.size());
+        m_CoverName.push_back(m_Names.Intern(name));
+        m_CoverNet.push_back(condition);
+        m_CoverPolarity.push_back(polarity);
+        m_CoverClock.push_back(clock);
+        m_CoverEdge.push_back(edge);
+        m_CoverParent.push_back(parent);
+        return id;
+    }
+
+    PortID Netlist::AddPort(std::string_view name, PortDirection direction, NetID net) {
+        auto id = static_cast<PortID>(m_PortNet.size());
+        m_PortName.push_back(m_Names.Intern(name));
+        m_PortDirection.push_back(direction);
+        m_PortNet.push_back(net);
+        if (direction != PortDirection::OUT) {
+            m_NetDriver[net]     = id;
+            m_NetDriverKind[net] = DriverKind::PORT;
+        }
+        return id;
+    }
+
+    CellID Netlist::AddCell(CellType type, NetID output, std::span<const NetID> inputs, uint64_t param) {
+        CFXS_ASSERT(inputs.size() == CellType_GetInputCount(type), "Invalid cell input count");
+        auto id = static_cast<CellID>(m_CellType.size());
+        m_CellType.push_back(type);
+        m_CellOutput.push_back(output);
+        m_CellParam.push_back(param);
+        m_CellInputOffset.push_back(static_cast<uint32_t>(m_CellInputs.size()));
+        m_CellInputs.insert(m_CellInputs.end(), inputs.begin(), inputs.end());
+        m_NetDriver[output]     = id;
+        m_NetDriverKind[output] = DriverKind::CELL;
+        return id;
+    }
+
+    RegisterID Netlist::AddRegister(std::string_view name, NetID q, NetID d, NetID clock, ClockEdge edge, uint64_t init) {
+        auto id = static_cast<RegisterID>(m_RegisterQ.size());
+        m_RegisterName.push_back(m_Names.Intern(name));
+        m_RegisterQ.push_back(q);
+        m_RegisterD.push_back(d);
+        m_RegisterClock.push_back(clock);
+        m_RegisterEdge.push_back(edge);
+        m_RegisterInit.push_back(init);
+        m_NetDriver[q]     = id;
+        m_NetDriverKind[q] = DriverKind::REGISTER;
+        return id;
+    }
+
+    InstanceID Netlist::AddInstance(std::string_view name, ModuleID module, const Netlist& child, std::span<const NetID> connections) {
+        CFXS_ASSERT(connections.size() == child.GetPortCount(), "Invalid instance connection count");
+        auto id = static_cast<InstanceID>(m_InstanceModule.size());
+        m_InstanceName.push_back(m_Names.Intern(name));
+        m_InstanceModule.push_back(module);
+        m_InstanceConnections.insert(m_InstanceConnections.end(), connections.begin(), connections.end());
+        m_InstanceOffset.push_back(static_cast<uint32_t>(m_InstanceConnections.size()));
+        for (PortID p = 0; p < child.GetPortCount(); p++) {
+            if (child.GetPortDirection(p) == PortDirection::OUT) {
+                m_NetDriver[connections[p]]     = id;
+                m_NetDriverKind[connections[p]] = DriverKind::INSTANCE;
+            }
+        }
+        return id;
+    }
+
+    void Netlist::SetCell(CellID cell, CellType type, std::span<const NetID> inputs, uint64_t param) {
+        CFXS_ASSERT(inputs.size() == CellType_GetInputCount(type), "Invalid cell input count");
+        if (inputs.size() > CellType_GetInputCount(m_CellType[cell])) {
+            m_CellInputOffset[cell] = static_cast<uint32_t>(m_CellInputs.size());
+            m_CellInputs.insert(m_CellInputs.end(), inputs.begin(), inputs.end());
+        } else {
+            std::copy(inputs.begin(), inputs.end(), m_CellInputs.begin() + m_CellInputOffset[cell]);
+        }
+        m_CellType[cell]  = type;
+        m_CellParam[cell] = param;
+    }
+
+    void Netlist::Compact(const std::vector<uint8_t>& keep_cells, const std::vector<uint8_t>& keep_registers) {
+        // referenced nets
+        std::vector<NetID> net_map(GetNetCount(), INVALID_ID);
+        auto mark = [&](NetID net) {
+            if (net != INVALID_ID)
+                net_map[net] = 0;
+        };
+        for (auto net : m_PortNet)
+            mark(net);
+        for (auto net : m_InstanceConnections)
+            mark(net);
+        for (CoverID i = 0; i < GetCoverPointCount(); i++) {
+            mark(m_CoverNet[i]);
+            mark(m_CoverClock[i]);
+        }
+        for (CellID c = 0; c < GetCellCount(); c++) {
+            if (!keep_cells[c])
+                continue;
+            mark(m_CellOutput[c]);
+            for (auto net : GetCellInputs(c))
+                mark(net);
+        }
+        for (RegisterID r = 0; r < GetRegisterCount(); r++) {
+            if (!keep_registers[r])
+                continue;
+            mark(m_RegisterQ[r]);
+            mark(m_RegisterD[r]);
+            mark(m_RegisterClock[r]);
+        }
+
+        // renumber nets
+        NetID next_net = 0;
+        for (NetID n = 0; n < GetNetCount(); n++) {
+            if (net_map[n] == INVALID_ID)
+                continue;
+            // instance drivers keep their IDs, everything else is re-registered below
+            bool instance_driver      = m_NetDriverKind[n] == DriverKind::INSTANCE;
+            net_map[n]                = next_net;
+            m_NetWidth[next_net]      = m_NetWidth[n];
+            m_NetName[next_net]       = m_NetName[n];
+            m_NetDriver[next_net]     = instance_driver ? m_NetDriver[n] : INVALID_ID;
+            m_NetDriverKind[next_net] = instance_driver ? DriverKind::INSTANCE : DriverKind::NONE;
+            next_net++;
+        }
+        m_NetWidth.resize(next_net);
+        m_NetName.resize(next_net);
+        m_NetDriver.resize(next_net);
+        m_NetDriverKind.resize(next_net);
+        auto remap = [&](NetID net) {
+            return net == INVALID_ID ? INVALID_ID : net_map[net];
+        };
+
+        // cells - inputs are repacked into a fresh CSR row array
+        std::vector<NetID> inputs;
+        inputs.reserve(m_CellInputs.size());
+        CellID next_cell = 0;
+        for (CellID c = 0; c < GetCellCount(); c++) {
+            if (!keep_cells[c])
+                continue;
+            auto offset = static_cast<uint32_t>(inputs.size());
+            for (auto net : GetCellInputs(c))
+                inputs.push_back(remap(net));
+            auto output                  = remap(m_CellOutput[c]);
+            m_CellType[next_cell]        = m_CellType[c];
+            m_CellOutput[next_cell]      = output;
+            m_CellParam[next_cell]       = m_CellParam[c];
+            m_CellInputOffset[next_cell] = offset;
+            m_NetDriver[output]          = next_cell;
+            m_NetDriverKind[output]      = DriverKind::CELL;
+            next_cell++;
+        }
+        m_CellType.resize(next_cell);
+        m_CellOutput.resize(next_cell);
+        m_CellParam.resize(next_cell);
+        m_CellInputOffset.resize(next_cell);
+        m_CellInputs = std::move(inputs);
+
+        // registers
+        RegisterID next_reg = 0;
+        for (RegisterID r = 0; r < GetRegisterCount(); r++) {
+            if (!keep_registers[r])
+                continue;
+            auto q                    = remap(m_RegisterQ[r]);
+            m_RegisterName[next_reg]  = m_RegisterName[r];
+            m_RegisterQ[next_reg]     = q;
+            m_RegisterD[next_reg]     = remap(m_RegisterD[r]);
+            m_RegisterClock[next_reg] = remap(m_RegisterClock[r]);
+            m_RegisterEdge[next_reg]  = m_RegisterEdge[r];
+            m_RegisterInit[next_reg]  = m_RegisterInit[r];
+            m_NetDriver[q]            = next_reg;
+            m_NetDriverKind[q]        = DriverKind::REGISTER;
+            next_reg++;
+        }
+        m_RegisterName.resize(next_reg);
+        m_RegisterQ.resize(next_reg);
+        m_RegisterD.resize(next_reg);
+        m_RegisterClock.resize(next_reg);
+        m_RegisterEdge.resize(next_reg);
+        m_RegisterInit.resize(next_reg);
+
+        // ports and instances
+        for (PortID p = 0; p < GetPortCount(); p++) {
+            m_PortNet[p] = remap(m_PortNet[p]);
+            if (m_PortDirection[p] != PortDirection::OUT) {
+                m_NetDriver[m_PortNet[p]]     = p;
+                m_NetDriverKind[m_PortNet[p]] = DriverKind::PORT;
+            }
+        }
+        for (InstanceID i = 0; i < GetInstanceCount(); i++) {
+            for (uint32_t k = m_InstanceOffset[i]; k < m_InstanceOffset[i + 1]; k++) {
+                m_InstanceConnections[k] = remap(m_InstanceConnections[k]);
+            }
+        }
+        for (CoverID i = 0; i < GetCoverPointCount(); i++) {
+            m_CoverNet[i]   = remap(m_CoverNet[i]);
+            m_CoverClock[i] = remap(m_CoverClock[i]);
+        }
+
+        Finalize();
+    }
+
+    void Netlist::Finalize() {
+        // counting sort of cell inputs by net
+        m_FanoutOffset.assign(m_NetWidth.size() + 1, 0);
+        for (CellID c = 0; c < GetCellCount(); c++) {
+            for (auto net : GetCellInputs(c)) {
+                m_FanoutOffset[net + 1]++;
+            }
+        }
+        for (size_t i = 1; i < m_FanoutOffset.size(); i++) {
+            m_FanoutOffset[i] += m_FanoutOffset[i - 1];
+        }
+
+        m_Fanout.resize(m_FanoutOffset.back());
+        std::vector<uint32_t> fill(m_FanoutOffset.begin(), m_FanoutOffset.end() - 1);
+        for (CellID c = 0; c < GetCellCount(); c++) {
+            for (auto net : GetCellInputs(c)) {
+                m_Fanout[fill[net]++] = c;
+            }
+        }
+    }
+
+    PortID Netlist::FindPort(std::string_view name) const {
+        for (PortID p = 0; p < GetPortCount(); p++) {
+            if (GetPortName(p) == name)
+                return p;
+        }
+        return INVALID_ID;
+    }
+
+    size_t Netlist::GetMemoryUsage() const {
+        return m_Names.GetMemoryUsage() + VectorBytes(m_Parameters) + VectorBytes(m_NetWidth) + VectorBytes(m_NetName) +
+               VectorBytes(m_NetDriver) + VectorBytes(m_NetDriverKind) + VectorBytes(m_FanoutOffset) + VectorBytes(m_Fanout) +
+               VectorBytes(m_CellType) + VectorBytes(m_CellOutput) + VectorBytes(m_CellParam) + VectorBytes(m_CellInputOffset) +
+               VectorBytes(m_CellInputs) + VectorBytes(m_RegisterName) + VectorBytes(m_RegisterQ) + VectorBytes(m_RegisterD) +
+               VectorBytes(m_RegisterClock) + VectorBytes(m_RegisterEdge) + VectorBytes(m_RegisterInit) + VectorBytes(m_PortName) +
+               VectorBytes(m_PortDirection) + VectorBytes(m_PortNet) + VectorBytes(m_CoverName) + VectorBytes(m_CoverNet) + VectorBytes(m_CoverPolarity) +
+               VectorBytes(m_CoverClock) + VectorBytes(m_CoverEdge) + VectorBytes(m_CoverParent) + VectorBytes(m_InstanceName) + VectorBytes(m_InstanceModule) +
+               VectorBytes(m_InstanceOffset) + VectorBytes(m_InstanceConnections);
+    }
+
+    void Netlist::Print() const {
+        LOG_DEBUG("Netlist {}:", GetName());
+        if (!Logger::IsEnabled(spdlog::level::trace))
+            return;
+        for (auto& [name, value] : m_Parameters) {
+            LOG_TRACE("    param {} = {}", m_Names.Get(name), value);
+        }
+        for (PortID p = 0; p < GetPortCount(); p++) {
+            LOG_TRACE("    port {} {} n{}", PortDirection_ToString(GetPortDirection(p)), GetPortName(p), GetPortNet(p));
+        }
+        for (RegisterID r = 0; r < GetRegisterCount(); r++) {
+            LOG_TRACE("    reg {} q=n{} d=n{} clock=n{} {} init={}",
+                      GetRegisterName(r),
+                      GetRegisterQ(r),
+                      GetRegisterD(r),
+                      GetRegisterClock(r),
+                      ClockEdge_ToString(GetRegisterEdge(r)),
+                      GetRegisterInit(r));
+        }
+        for (CellID c = 0; c < GetCellCount(); c++) {
+            std::string inputs;
+            for (auto net : GetCellInputs(c)) {
+                inputs += " n" + std::to_string(net);
+            }
+            LOG_TRACE("    n{}[{}] = {}{} #{}", GetCellOutput(c), GetNetWidth(GetCellOutput(c)), CellType_ToString(GetCellType(c)), inputs, GetCellParam(c));
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Design
+
+    ModuleID Design::AddModule(Scope<Netlist>&& module) {
+        m_Modules.push_back(std::move(module));
+        return static_cast<ModuleID>(m_Modules.size() - 1);
+    }
+
+    ModuleID Design::RemoveModule(ModuleID id) {
+        auto last = static_cast<ModuleID>(m_Modules.size() - 1);
+        if (m_Top == id) {
+            m_Top = INVALID_ID;
+        } else if (m_Top == last) {
+            m_Top = id;
+        }
+
+        m_Modules[id] = std::move(m_Modules.back());
+        m_Modules.pop_back();
+        return id == last ? INVALID_ID : last;
+    }
+
+    ModuleID Design::FindModule(std::string_view name) const {
+        for (ModuleID m = 0; m < GetModuleCount(); m++) {
+            if (m_Modules[m]->GetName() == name)
+                return m;
+        }
+        return INVALID_ID;
+    }
+
+    /// Copy module contents into flat netlist - child ports are bound to parent nets with buffers
+    static void InlineModule(const Design& design,
+                             const Netlist& module,
+                             Netlist& flat,
+                             const std::string& prefix,
+                             std::span<const NetID> bindings) {
+        std::vector<NetID> net_map(module.GetNetCount());
+        std::string name;
+        for (NetID n = 0; n < module.GetNetCount(); n++) {
+            auto net_name = module.GetNetName(n);
+            name.assign(prefix).append(net_name);
+            net_map[n] = flat.AddNet(module.GetNetWidth(n), net_name.empty() ? std::string_view{} : std::string_view{name});
+        }
+
+        for (PortID p = 0; p < module.GetPortCount(); p++) {
+            auto net = net_map[module.GetPortNet(p)];
+            if (bindings.empty()) {
+                flat.AddPort(module.GetPortName(p), module.GetPortDirection(p), net);
+            } else if (module.GetPortDirection(p) == PortDirection::OUT) {
+                flat.AddCell(CellType::BUF, bindings[p], {net});
+            } else {
+                flat.AddCell(CellType::BUF, net, {bindings[p]});
+            }
+        }
+
+        NetID inputs[3];
+        for (CellID c = 0; c < module.GetCellCount(); c++) {
+            auto in = module.GetCellInputs(c);
+            for (size_t i = 0; i < in.size(); i++)
+                inputs[i] = net_map[in[i]];
+            flat.AddCell(module.GetCellType(c), net_map[module.GetCellOutput(c)], {inputs, in.size()}, module.GetCellParam(c));
+        }
+
+        for (RegisterID r = 0; r < module.GetRegisterCount(); r++) {
+            auto map = [&](NetID n) {
+                return n == INVALID_ID ? INVALID_ID : net_map[n];
+            };
+            name.assign(prefix).append(module.GetRegisterName(r));
+            flat.AddRegister(name,
+                             map(module.GetRegisterQ(r)),
+                             map(module.GetRegisterD(r)),
+                             map(module.GetRegisterClock(r)),
+                             module.GetRegisterEdge(r),
+                             module.GetRegisterInit(r));
+        }
+
+        auto cover_base = flat.GetCoverPointCount();
+        for (CoverID i = 0; i < module.GetCoverPointCount(); i++) {
+            auto parent = module.GetCoverPointParent(i);
+            name.assign(prefix).append(module.GetCoverPointName(i));
+            flat.AddCoverPoint(name,
+                               net_map[module.GetCoverPointNet(i)],
+                               module.GetCoverPointPolarity(i),
+                               net_map[module.GetCoverPointClock(i)],
+                               module.GetCoverPointEdge(i),
+                               parent == INVALID_ID ? INVALID_ID : cover_base + parent);
+        }
+
+        std::vector<NetID> child_bindings;
+        for (InstanceID i = 0; i < module.GetInstanceCount(); i++) {
+            child_bindings.clear();
+            for (auto n : module.GetInstanceConnections(i))
+                child_bindings.push_back(net_map[n]);
+            InlineModule(design,
+                         design.GetModule(module.GetInstanceModule(i)),
+                         flat,
+                         prefix + std::string(module.GetInstanceName(i)) + ".",
+                         child_bindings);
+        }
+    }
+
+    Scope<Netlist> Design::Flatten(ModuleID top) const {
+        XRT_PROFILE_SCOPE("Design::Flatten");
+        auto& module = GetModule(top);
+        auto flat    = CreateScope<Netlist>(module.GetName());
+        for (auto& [name, value] : module.GetParameters())
+            flat->AddParameter(module.GetNames().Get(name), value);
+        InlineModule(*this, module, *flat, "", {});
+        flat->Finalize();
+        return flat;
+    }
+
+} // namespace XRT
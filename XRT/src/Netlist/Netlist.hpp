@@ -0,0 +1,388 @@
+#pragma once
+#include <cstdint>
+#include <initializer_list>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <Utils.hpp>
+#include "Language/TypeContext.hpp"
+
+namespace XRT {
+
+    using NetID      = uint32_t;
+    using CellID     = uint32_t;
+    using RegisterID = uint32_t;
+    using PortID     = uint32_t;
+    using InstanceID = uint32_t;
+    using ModuleID   = uint32_t;
+    using NameID     = uint32_t;
+    using CoverID    = uint32_t;
+
+    static constexpr uint32_t INVALID_ID = 0xFFFFFFFF;
+
+    /// Max supported net width - net values are stored in a single 64bit word
+    static constexpr uint32_t MAX_NET_WIDTH = 64;
+
+    /// Cell operations - inputs are zero extended/truncated to the operand width,
+    /// result is truncated to the output net width
+    enum class CellType : uint8_t {
+        CONST,     // param
+        BUF,       // a
+        NOT,       // ~a
+        AND,       // a & b
+        OR,        // a | b
+        XOR,       // a ^ b
+        ADD,       // a + b
+        SUB,       // a - b
+        MUL,       // a * b
+        EQ,        // a == b
+        NE,        // a != b
+        LT,        // a < b
+        LE,        // a <= b
+        GT,        // a > b
+        GE,        // a >= b
+        LSL,       // a << b
+        LSR,       // a >> b
+        MUX,       // s ? a : b
+        SLICE,     // a >> param (truncated to output width)
+        REDUCE_OR, // a != 0
+        __COUNT__,
+    };
+
+    enum class ClockEdge : uint8_t {
+        RISING,
+        FALLING,
+        BOTH,
+    };
+
+    enum class DriverKind : uint8_t {
+        NONE,
+        CELL,
+        REGISTER,
+        PORT,
+        INSTANCE,
+    };
+
+    const char* CellType_ToString(CellType type);
+    const char* ClockEdge_ToString(ClockEdge edge);
+
+    /// Number of cell inputs per cell type
+    inline uint32_t CellType_GetInputCount(CellType type) {
+        switch (type) {
+            case CellType::CONST: return 0;
+            case CellType::BUF:
+            case CellType::NOT:
+            case CellType::SLICE:
+            case CellType::REDUCE_OR: return 1;
+            case CellType::MUX: return 3;
+            default: return 2;
+        }
+    }
+
+    /// Interned name storage - all names in one contiguous buffer
+    class NameTable {
+    public:
+        NameID Intern(std::string_view name);
+
+        std::string_view Get(NameID id) const {
+            if (id == INVALID_ID)
+                return {};
+            return std::string_view{m_Buffer.data() + m_Offsets[id], m_Offsets[id + 1] - m_Offsets[id]};
+        }
+
+        size_t GetCount() const {
+            return m_Offsets.size() - 1;
+        }
+
+        size_t GetMemoryUsage() const;
+
+    private:
+        std::string m_Buffer;
+        std::vector<uint32_t> m_Offsets{0};
+        std::unordered_multimap<size_t, NameID> m_Lookup; // name hash -> id
+    };
+
+    /// Flat struct-of-arrays netlist of a single component specialization.
+    /// All objects are addressed by dense 32bit IDs; cell inputs (fan-in) and net fanout use CSR adjacency.
+    class Netlist {
+    public:
+        Netlist(std::string_view name);
+        ~Netlist() = default;
+
+        Netlist(const Netlist&)            = delete;
+        Netlist& operator=(const Netlist&) = delete;
+
+        ////////////////////////////////////////////////////////////
+        // Construction
+
+        NetID AddNet(uint32_t width, std::string_view name = {});
+        PortID AddPort(std::string_view name, PortDirection direction, NetID net);
+        CellID AddCell(CellType type, NetID output, std::span<const NetID> inputs, uint64_t param = 0);
+        CellID AddCell(CellType type, NetID output, std::initializer_list<NetID> inputs, uint64_t param = 0) {
+            return AddCell(type, output, std::span<const NetID>{inputs.begin(), inputs.size()}, param);
+        }
+        RegisterID AddRegister(std::string_view name, NetID q, NetID d, NetID clock, ClockEdge edge, uint64_t init);
+        /// connections are parent nets bound to the child ports (indexed by child PortID)
+        InstanceID AddInstance(std::string_view name, ModuleID module, const Netlist& child, std::span<const NetID> connections);
+
+        /// Coverage point - counts "edge" events of "clock" where bit 0 of "condition" equals "polarity"
+        /// and the parent point (INVALID_ID for none) is hit as well. Parents must be added before their children.
+        /// Condition nets are kept alive by optimization like port nets.
+        CoverID AddCoverPoint(std::string_view name, NetID condition, bool polarity, NetID clock, ClockEdge edge, CoverID parent = INVALID_ID);
+
+        /// Set a register next state input
+        void SetRegisterInput(RegisterID reg, NetID d) {
+            m_RegisterD[reg] = d;
+        }
+
+        /// Set a register clock input and sensitivity
+        void SetRegisterClock(RegisterID reg, NetID clock, ClockEdge edge) {
+            m_RegisterClock[reg] = clock;
+            m_RegisterEdge[reg]  = edge;
+        }
+
+        /// Set the clock events a coverage point is sampled on
+        void SetCoverPointEdge(CoverID cover, ClockEdge edge) {
+            m_CoverEdge[cover] = edge;
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Modification
+
+        /// Replace cell function - inputs are rewritten in place when the row fits, otherwise appended
+        void SetCell(CellID cell, CellType type, std::span<const NetID> inputs, uint64_t param);
+        void SetCellInput(CellID cell, uint32_t index, NetID net) {
+            m_CellInputs[m_CellInputOffset[cell] + index] = net;
+        }
+
+        /// Remove cells/registers not marked in keep masks and all nets no longer referenced - IDs are renumbered
+        void Compact(const std::vector<uint8_t>& keep_cells, const std::vector<uint8_t>& keep_registers);
+
+        /// Specialization parameter (for reference in generated output)
+        void AddParameter(std::string_view name, uint64_t value) {
+            m_Parameters.emplace_back(m_Names.Intern(name), value);
+        }
+
+        /// Build fanout adjacency - must be called after construction/modification before fanout queries
+        void Finalize();
+
+        ////////////////////////////////////////////////////////////
+        // Queries
+
+        std::string_view GetName() const {
+            return m_Names.Get(m_Name);
+        }
+
+        const NameTable& GetNames() const {
+            return m_Names;
+        }
+
+        const std::vector<std::pair<NameID, uint64_t>>& GetParameters() const {
+            return m_Parameters;
+        }
+
+        // Nets
+        uint32_t GetNetCount() const {
+            return static_cast<uint32_t>(m_NetWidth.size());
+        }
+        uint32_t GetNetWidth(NetID net) const {
+            return m_NetWidth[net];
+        }
+        std::string_view GetNetName(NetID net) const {
+            return m_Names.Get(m_NetName[net]);
+        }
+        DriverKind GetNetDriverKind(NetID net) const {
+            return m_NetDriverKind[net];
+        }
+        uint32_t GetNetDriver(NetID net) const {
+            return m_NetDriver[net];
+        }
+        std::span<const CellID> GetNetFanout(NetID net) const {
+            return {m_Fanout.data() + m_FanoutOffset[net], m_FanoutOffset[net + 1] - m_FanoutOffset[net]};
+        }
+
+        // Cells
+        uint32_t GetCellCount() const {
+            return static_cast<uint32_t>(m_CellType.size());
+        }
+        CellType GetCellType(CellID cell) const {
+            return m_CellType[cell];
+        }
+        NetID GetCellOutput(CellID cell) const {
+            return m_CellOutput[cell];
+        }
+        uint64_t GetCellParam(CellID cell) const {
+            return m_CellParam[cell];
+        }
+        std::span<const NetID> GetCellInputs(CellID cell) const {
+            return {m_CellInputs.data() + m_CellInputOffset[cell], CellType_GetInputCount(m_CellType[cell])};
+        }
+
+        // Registers
+        uint32_t GetRegisterCount() const {
+            return static_cast<uint32_t>(m_RegisterQ.size());
+        }
+        std::string_view GetRegisterName(RegisterID reg) const {
+            return m_Names.Get(m_RegisterName[reg]);
+        }
+        NetID GetRegisterQ(RegisterID reg) const {
+            return m_RegisterQ[reg];
+        }
+        NetID GetRegisterD(RegisterID reg) const {
+            return m_RegisterD[reg];
+        }
+        NetID GetRegisterClock(RegisterID reg) const {
+            return m_RegisterClock[reg];
+        }
+        ClockEdge GetRegisterEdge(RegisterID reg) const {
+            return m_RegisterEdge[reg];
+        }
+        uint64_t GetRegisterInit(RegisterID reg) const {
+            return m_RegisterInit[reg];
+        }
+
+        // Ports
+        uint32_t GetPortCount() const {
+            return static_cast<uint32_t>(m_PortNet.size());
+        }
+        std::string_view GetPortName(PortID port) const {
+            return m_Names.Get(m_PortName[port]);
+        }
+        PortDirection GetPortDirection(PortID port) const {
+            return m_PortDirection[port];
+        }
+        NetID GetPortNet(PortID port) const {
+            return m_PortNet[port];
+        }
+        PortID FindPort(std::string_view name) const;
+
+        // Coverage points
+        uint32_t GetCoverPointCount() const {
+            return static_cast<uint32_t>(m_CoverNet.size());
+        }
+        std::string_view GetCoverPointName(CoverID cover) const {
+            return m_Names.Get(m_CoverName[cover]);
+        }
+        NetID GetCoverPointNet(CoverID cover) const {
+            return m_CoverNet[cover];
+        }
+        bool GetCoverPointPolarity(CoverID cover) const {
+            return m_CoverPolarity[cover];
+        }
+        NetID GetCoverPointClock(CoverID cover) const {
+            return m_CoverClock[cover];
+        }
+        ClockEdge GetCoverPointEdge(CoverID cover) const {
+            return m_CoverEdge[cover];
+        }
+        CoverID GetCoverPointParent(CoverID cover) const {
+            return m_CoverParent[cover];
+        }
+
+        // Instances
+        uint32_t GetInstanceCount() const {
+            return static_cast<uint32_t>(m_InstanceModule.size());
+        }
+        std::string_view GetInstanceName(InstanceID inst) const {
+            return m_Names.Get(m_InstanceName[inst]);
+        }
+        ModuleID GetInstanceModule(InstanceID inst) const {
+            return m_InstanceModule[inst];
+        }
+        /// Parent nets connected to the instance ports (indexed by child PortID)
+        std::span<const NetID> GetInstanceConnections(InstanceID inst) const {
+            return {m_InstanceConnections.data() + m_InstanceOffset[inst], m_InstanceOffset[inst + 1] - m_InstanceOffset[inst]};
+        }
+
+        /// Approximate heap usage in bytes
+        size_t GetMemoryUsage() const;
+
+        void Print() const;
+
+    private:
+        NameID m_Name;
+        NameTable m_Names;
+        std::vector<std::pair<NameID, uint64_t>> m_Parameters;
+
+        // Nets
+        std::vector<uint32_t> m_NetWidth;
+        std::vector<NameID> m_NetName;
+        std::vector<uint32_t> m_NetDriver;
+        std::vector<DriverKind> m_NetDriverKind;
+        std::vector<uint32_t> m_FanoutOffset; // CSR [net] -> m_Fanout
+        std::vector<CellID> m_Fanout;
+
+        // Cells
+        std::vector<CellType> m_CellType;
+        std::vector<NetID> m_CellOutput;
+        std::vector<uint64_t> m_CellParam;
+        std::vector<uint32_t> m_CellInputOffset; // [cell] -> m_CellInputs, row length given by the cell type
+        std::vector<NetID> m_CellInputs;
+
+        // Registers
+        std::vector<NameID> m_RegisterName;
+        std::vector<NetID> m_RegisterQ;
+        std::vector<NetID> m_RegisterD;
+        std::vector<NetID> m_RegisterClock;
+        std::vector<ClockEdge> m_RegisterEdge;
+        std::vector<uint64_t> m_RegisterInit;
+
+        // Ports
+        std::vector<NameID> m_PortName;
+        std::vector<PortDirection> m_PortDirection;
+        std::vector<NetID> m_PortNet;
+
+        // Coverage points
+        std::vector<NameID> m_CoverName;
+        std::vector<NetID> m_CoverNet;
+        std::vector<uint8_t> m_CoverPolarity;
+        std::vector<NetID> m_CoverClock;
+        std::vector<ClockEdge> m_CoverEdge;
+        std::vector<CoverID> m_CoverParent;
+
+        // Instances
+        std::vector<NameID> m_InstanceName;
+        std::vector<ModuleID> m_InstanceModule;
+        std::vector<uint32_t> m_InstanceOffset{0}; // CSR [instance] -> m_InstanceConnections
+        std::vector<NetID> m_InstanceConnections;
+    };
+
+    /// Collection of elaborated component specializations
+    class Design {
+    public:
+        Design() = default;
+
+        ModuleID AddModule(Scope<Netlist>&& module);
+        /// Remove a module - the last module takes its id. Returns the previous id of the moved module, INVALID_ID if none moved.
+        /// Instances of the moved module are not updated.
+        ModuleID RemoveModule(ModuleID id);
+
+        Netlist& GetModule(ModuleID id) {
+            return *m_Modules[id];
+        }
+        const Netlist& GetModule(ModuleID id) const {
+            return *m_Modules[id];
+        }
+        uint32_t GetModuleCount() const {
+            return static_cast<uint32_t>(m_Modules.size());
+        }
+        ModuleID FindModule(std::string_view name) const;
+
+        ModuleID GetTop() const {
+            return m_Top;
+        }
+        void SetTop(ModuleID top) {
+            m_Top = top;
+        }
+
+        /// Inline all instances of a module hierarchy into a single netlist
+        Scope<Netlist> Flatten(ModuleID top) const;
+
+    private:
+        std::vector<Scope<Netlist>> m_Modules;
+        ModuleID m_Top = INVALID_ID;
+    };
+
+} // namespace XRT
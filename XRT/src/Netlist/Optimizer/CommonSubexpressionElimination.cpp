@@ -0,0 +1,67 @@
+#include "CommonSubexpressionElimination.hpp"
+#include <algorithm>
+
+namespace XRT {
+
+    size_t CommonSubexpressionElimination::CellKeyHash::operator()(const CellKey& key) const {
+        uint64_t h = static_cast<uint64_t>(key.type) | (static_cast<uint64_t>(key.width) << 8);
+        h ^= key.param + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+        for (auto net : key.inputs)
+            h ^= net + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+        return h;
+    }
+
+    CommonSubexpressionElimination::CellKey CommonSubexpressionElimination::MakeKey(const Netlist& netlist, CellID cell) {
+        CellKey key{netlist.GetCellType(cell), netlist.GetNetWidth(netlist.GetCellOutput(cell)), netlist.GetCellParam(cell), {0, 0, 0}};
+        auto inputs = netlist.GetCellInputs(cell);
+        std::copy(inputs.begin(), inputs.end(), key.inputs);
+
+        switch (key.type) {
+            case CellType::AND:
+            case CellType::OR:
+            case CellType::XOR:
+            case CellType::ADD:
+            case CellType::MUL:
+            case CellType::EQ:
+            case CellType::NE:
+                if (key.inputs[0] > key.inputs[1])
+                    std::swap(key.inputs[0], key.inputs[1]);
+                break;
+            default: break;
+        }
+        return key;
+    }
+
+    void CommonSubexpressionElimination::Process(OptimizationContext& ctx, NodeID node) {
+        if (node & REGISTER_NODE)
+            return;
+
+        auto& nl = ctx.GetNetlist();
+        auto key = MakeKey(nl, node);
+
+        auto [it, inserted] = m_Table.try_emplace(key, node);
+        if (inserted || it->second == node)
+            return;
+
+        auto other = it->second;
+        if (!ctx.IsCellAlive(other) || !(MakeKey(nl, other) == key)) {
+            it->second = node;
+            return;
+        }
+
+        // keep the cell with a pinned output
+        auto out       = nl.GetCellOutput(node);
+        auto other_out = nl.GetCellOutput(other);
+        if (ctx.IsPinned(out)) {
+            if (ctx.IsPinned(other_out))
+                return;
+            it->second = node;
+            std::swap(node, other);
+            std::swap(out, other_out);
+        }
+
+        ctx.ReplaceNet(out, other_out);
+        ctx.RemoveCell(node);
+    }
+
+} // namespace XRT
@@ -0,0 +1,37 @@
+#pragma once
+#include <unordered_map>
+#include "PassManager.hpp"
+
+namespace XRT {
+
+    /// Merge cells computing the same function of the same nets
+    class CommonSubexpressionElimination : public NetlistPass {
+    public:
+        const char* GetName() const override {
+            return "CommonSubexpressionElimination";
+        }
+
+        void Process(OptimizationContext& ctx, NodeID node) override;
+
+    private:
+        struct CellKey {
+            CellType type;
+            uint32_t width;
+            uint64_t param;
+            NetID inputs[3];
+
+            bool operator==(const CellKey& other) const = default;
+        };
+
+        struct CellKeyHash {
+            size_t operator()(const CellKey& key) const;
+        };
+
+        static CellKey MakeKey(const Netlist& netlist, CellID cell);
+
+    private:
+        // entries may go stale after rewrites - validated on lookup
+        std::unordered_map<CellKey, CellID, CellKeyHash> m_Table;
+    };
+
+} // namespace XRT
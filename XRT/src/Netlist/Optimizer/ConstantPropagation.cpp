@@ -0,0 +1,202 @@
+#include "ConstantPropagation.hpp"
+#include "Netlist/CellEval.hpp"
+
+namespace XRT {
+
+    void ConstantPropagation::Process(OptimizationContext& ctx, NodeID node) {
+        if (node & REGISTER_NODE) {
+            ProcessRegister(ctx, node & NODE_INDEX_MASK);
+        } else {
+            ProcessCell(ctx, node);
+        }
+    }
+
+    void ConstantPropagation::ProcessRegister(OptimizationContext& ctx, RegisterID reg) {
+        auto& nl  = ctx.GetNetlist();
+        auto q    = nl.GetRegisterQ(reg);
+        auto d    = nl.GetRegisterD(reg);
+        auto init = nl.GetRegisterInit(reg) & NetMask(nl.GetNetWidth(q));
+
+        if (ctx.IsPinned(q))
+            return;
+
+        // never loaded or always loads its own/init value
+        auto d_value = d == INVALID_ID ? std::optional<uint64_t>{} : ctx.GetConstValue(d);
+        if (d == INVALID_ID || d == q || (d_value && (*d_value & NetMask(nl.GetNetWidth(q))) == init)) {
+            ctx.ReplaceNet(q, ctx.AddConst(init, nl.GetNetWidth(q)));
+            ctx.RemoveRegister(reg);
+            return;
+        }
+
+        // BOTH edge register with D = clock ? a : Q only changes on the rising edge (and vice versa)
+        auto clock = nl.GetRegisterClock(reg);
+        if (nl.GetRegisterEdge(reg) != ClockEdge::BOTH || clock == INVALID_ID || nl.GetNetDriverKind(d) != DriverKind::CELL)
+            return;
+        auto mux = nl.GetNetDriver(d);
+        if (nl.GetCellType(mux) != CellType::MUX || nl.GetNetWidth(d) != nl.GetNetWidth(q))
+            return;
+        auto in = nl.GetCellInputs(mux);
+        if (in[0] != clock)
+            return;
+        if (in[2] == q && nl.GetNetWidth(in[1]) == nl.GetNetWidth(q)) {
+            ctx.RewriteRegister(reg, in[1], ClockEdge::RISING);
+        } else if (in[1] == q && nl.GetNetWidth(in[2]) == nl.GetNetWidth(q)) {
+            ctx.RewriteRegister(reg, in[2], ClockEdge::FALLING);
+        }
+    }
+
+    void ConstantPropagation::ProcessCell(OptimizationContext& ctx, CellID cell) {
+        auto& nl   = ctx.GetNetlist();
+        auto type  = nl.GetCellType(cell);
+        auto out   = nl.GetCellOutput(cell);
+        auto width = nl.GetNetWidth(out);
+        auto mask  = NetMask(width);
+
+        if (type == CellType::CONST)
+            return;
+
+        NetID in[3];
+        std::optional<uint64_t> value[3];
+        bool all_const = true;
+        auto inputs    = nl.GetCellInputs(cell);
+        for (size_t i = 0; i < inputs.size(); i++) {
+            in[i]    = inputs[i];
+            value[i] = ctx.GetConstValue(in[i]);
+            if (!value[i])
+                all_const = false;
+        }
+
+        auto to_const = [&](uint64_t v) {
+            ctx.RewriteCell(cell, CellType::CONST, {}, v & mask);
+        };
+        auto to_buf = [&](NetID net) {
+            ctx.RewriteCell(cell, CellType::BUF, {net});
+        };
+        auto same_width = [&](NetID net) {
+            return nl.GetNetWidth(net) == width;
+        };
+
+        if (all_const) {
+            to_const(EvaluateCell(type, nl.GetCellParam(cell), width, value[0].value_or(0), value[1].value_or(0), value[2].value_or(0)));
+            return;
+        }
+
+        switch (type) {
+            case CellType::BUF: {
+                if (same_width(in[0]) && !ctx.IsPinned(out)) {
+                    ctx.ReplaceNet(out, in[0]);
+                    ctx.RemoveCell(cell);
+                }
+                return;
+            }
+            case CellType::NOT: {
+                if (nl.GetNetDriverKind(in[0]) != DriverKind::CELL || !same_width(in[0]))
+                    return;
+                auto inner = nl.GetNetDriver(in[0]);
+                if (nl.GetCellType(inner) == CellType::NOT && same_width(nl.GetCellInputs(inner)[0]))
+                    to_buf(nl.GetCellInputs(inner)[0]);
+                return;
+            }
+            case CellType::MUX: {
+                if (value[0]) {
+                    to_buf(*value[0] ? in[1] : in[2]);
+                } else if (in[1] == in[2]) {
+                    to_buf(in[1]);
+                } else if (width == 1 && nl.GetNetWidth(in[0]) == 1 && value[1] && value[2] && (*value[1] & 1) != (*value[2] & 1)) {
+                    // s ? 1 : 0 / s ? 0 : 1
+                    if (*value[1] & 1) {
+                        to_buf(in[0]);
+                    } else {
+                        ctx.RewriteCell(cell, CellType::NOT, {in[0]});
+                    }
+                }
+                return;
+            }
+            case CellType::SLICE: {
+                if (nl.GetCellParam(cell) == 0)
+                    to_buf(in[0]);
+                return;
+            }
+            case CellType::REDUCE_OR: {
+                if (nl.GetNetWidth(in[0]) == 1)
+                    to_buf(in[0]);
+                return;
+            }
+            default: break;
+        }
+
+        // binary operations
+        if (in[0] == in[1]) {
+            switch (type) {
+                case CellType::AND:
+                case CellType::OR: to_buf(in[0]); return;
+                case CellType::XOR:
+                case CellType::SUB:
+                case CellType::NE:
+                case CellType::LT:
+                case CellType::GT: to_const(0); return;
+                case CellType::EQ:
+                case CellType::LE:
+                case CellType::GE: to_const(1); return;
+                default: break;
+            }
+        }
+
+        // x op c with the constant on either side for commutative operations
+        bool commutative = type == CellType::AND || type == CellType::OR || type == CellType::XOR || type == CellType::ADD ||
+                           type == CellType::EQ || type == CellType::NE;
+        int const_idx = value[1] ? 1 : (commutative && value[0] ? 0 : -1);
+        if (const_idx < 0)
+            return;
+        auto c       = *value[const_idx];
+        auto x       = in[1 - const_idx];
+        auto x_mask  = NetMask(nl.GetNetWidth(x));
+        bool x_fits  = nl.GetNetWidth(x) <= width;
+        bool is_bool = nl.GetNetWidth(x) == 1 && width == 1;
+
+        switch (type) {
+            case CellType::AND: {
+                if ((c & x_mask & mask) == 0) {
+                    to_const(0);
+                } else if (x_fits && (c & x_mask) == x_mask) {
+                    to_buf(x);
+                }
+                return;
+            }
+            case CellType::OR: {
+                if (x_fits && c == 0) {
+                    to_buf(x);
+                } else if ((c & mask) == mask) {
+                    to_const(mask);
+                }
+                return;
+            }
+            case CellType::XOR:
+            case CellType::ADD:
+            case CellType::SUB:
+            case CellType::LSL:
+            case CellType::LSR: {
+                if (x_fits && c == 0)
+                    to_buf(x);
+                return;
+            }
+            case CellType::EQ:
+            case CellType::NE: {
+                bool eq = type == CellType::EQ;
+                if (c & ~x_mask) {
+                    // x can never hold a value with bits above its width
+                    to_const(eq ? 0 : 1);
+                } else if (is_bool) {
+                    if (eq == (c == 1)) {
+                        to_buf(x);
+                    } else {
+                        ctx.RewriteCell(cell, CellType::NOT, {x});
+                    }
+                }
+                return;
+            }
+            default: return;
+        }
+    }
+
+} // namespace XRT
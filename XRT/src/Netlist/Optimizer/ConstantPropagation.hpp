@@ -0,0 +1,22 @@
+#pragma once
+#include "PassManager.hpp"
+
+namespace XRT {
+
+    /// Constant folding and algebraic simplification.
+    /// Registers that can never change are replaced by their init value and
+    /// dual edge registers that only load on one clock level are specialized to that edge.
+    class ConstantPropagation : public NetlistPass {
+    public:
+        const char* GetName() const override {
+            return "ConstantPropagation";
+        }
+
+        void Process(OptimizationContext& ctx, NodeID node) override;
+
+    private:
+        void ProcessCell(OptimizationContext& ctx, CellID cell);
+        void ProcessRegister(OptimizationContext& ctx, RegisterID reg);
+    };
+
+} // namespace XRT
@@ -0,0 +1,20 @@
+#include "DeadLogicElimination.hpp"
+
+namespace XRT {
+
+    void DeadLogicElimination::Process(OptimizationContext& ctx, NodeID node) {
+        auto& nl = ctx.GetNetlist();
+        auto idx = node & NODE_INDEX_MASK;
+
+        auto out = (node & REGISTER_NODE) ? nl.GetRegisterQ(idx) : nl.GetCellOutput(idx);
+        if (ctx.IsPinned(out) || !ctx.GetUsers(out).empty())
+            return;
+
+        if (node & REGISTER_NODE) {
+            ctx.RemoveRegister(idx);
+        } else {
+            ctx.RemoveCell(idx);
+        }
+    }
+
+} // namespace XRT
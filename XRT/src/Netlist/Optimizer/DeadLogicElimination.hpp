@@ -0,0 +1,17 @@
+#pragma once
+#include "PassManager.hpp"
+
+namespace XRT {
+
+    /// Remove cells and registers whose output is never read.
+    /// Dead cycles through registers are left to the reachability sweep in OptimizationContext::Commit.
+    class DeadLogicElimination : public NetlistPass {
+    public:
+        const char* GetName() const override {
+            return "DeadLogicElimination";
+        }
+
+        void Process(OptimizationContext& ctx, NodeID node) override;
+    };
+
+} // namespace XRT
@@ -0,0 +1,301 @@
+#include "PassManager.hpp"
+#include <algorithm>
+#include <Assert.hpp>
+#include <Log/Logger.hpp>
+#include "Profiler.hpp"
+#include "ConstantPropagation.hpp"
+#include "CommonSubexpressionElimination.hpp"
+#include "DeadLogicElimination.hpp"
+
+namespace XRT {
+
+    void Worklist::Push(NodeID node) {
+        auto& queued = Queued(node);
+        if (!queued) {
+            queued = true;
+            m_Stack.push_back(node);
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // OptimizationContext
+
+    OptimizationContext::OptimizationContext(Netlist& netlist) : m_Netlist(netlist) {
+        m_Users.resize(netlist.GetNetCount());
+        m_Pinned.resize(netlist.GetNetCount(), 0);
+        m_CellAlive.resize(netlist.GetCellCount(), 1);
+        m_RegisterAlive.resize(netlist.GetRegisterCount(), 1);
+
+        for (CellID c = 0; c < netlist.GetCellCount(); c++) {
+            for (auto net : netlist.GetCellInputs(c))
+                m_Users[net].push_back(c);
+        }
+        for (RegisterID r = 0; r < netlist.GetRegisterCount(); r++) {
+            if (netlist.GetRegisterD(r) != INVALID_ID)
+                m_Users[netlist.GetRegisterD(r)].push_back(r | REGISTER_NODE);
+            if (netlist.GetRegisterClock(r) != INVALID_ID)
+                m_Users[netlist.GetRegisterClock(r)].push_back(r | REGISTER_NODE);
+        }
+        for (PortID p = 0; p < netlist.GetPortCount(); p++)
+            m_Pinned[netlist.GetPortNet(p)] = true;
+        for (InstanceID i = 0; i < netlist.GetInstanceCount(); i++) {
+            for (auto net : netlist.GetInstanceConnections(i))
+                m_Pinned[net] = true;
+        }
+        for (CoverID i = 0; i < netlist.GetCoverPointCount(); i++) {
+            m_Pinned[netlist.GetCoverPointNet(i)]   = true;
+            m_Pinned[netlist.GetCoverPointClock(i)] = true;
+        }
+    }
+
+    std::optional<uint64_t> OptimizationContext::GetConstValue(NetID net) const {
+        if (m_Netlist.GetNetDriverKind(net) != DriverKind::CELL)
+            return {};
+        auto cell = m_Netlist.GetNetDriver(net);
+        if (!m_CellAlive[cell] || m_Netlist.GetCellType(cell) != CellType::CONST)
+            return {};
+        return m_Netlist.GetCellParam(cell);
+    }
+
+    void OptimizationContext::AddUser(NetID net, NodeID node) {
+        m_Users[net].push_back(node);
+    }
+
+    void OptimizationContext::RemoveUser(NetID net, NodeID node) {
+        auto& users = m_Users[net];
+        auto it     = std::find(users.begin(), users.end(), node);
+        if (it != users.end()) {
+            *it = users.back();
+            users.pop_back();
+        }
+    }
+
+    void OptimizationContext::TouchDriver(NetID net) {
+        switch (m_Netlist.GetNetDriverKind(net)) {
+            case DriverKind::CELL: Touch(m_Netlist.GetNetDriver(net)); break;
+            case DriverKind::REGISTER: Touch(m_Netlist.GetNetDriver(net) | REGISTER_NODE); break;
+            default: break;
+        }
+    }
+
+    void OptimizationContext::TouchUsers(NetID net) {
+        for (auto user : m_Users[net])
+            Touch(user);
+    }
+
+    void OptimizationContext::ReplaceNet(NetID from, NetID to) {
+        if (from == to)
+            return;
+        CFXS_ASSERT(!m_Pinned[from], "Replacing pinned net");
+        auto users = std::move(m_Users[from]);
+        m_Users[from].clear();
+
+        for (auto user : users) {
+            if (user & REGISTER_NODE) {
+                auto reg = user & NODE_INDEX_MASK;
+                if (m_Netlist.GetRegisterD(reg) == from)
+                    m_Netlist.SetRegisterInput(reg, to);
+                if (m_Netlist.GetRegisterClock(reg) == from)
+                    m_Netlist.SetRegisterClock(reg, to, m_Netlist.GetRegisterEdge(reg));
+            } else {
+                auto inputs = m_Netlist.GetCellInputs(user);
+                for (uint32_t i = 0; i < inputs.size(); i++) {
+                    if (inputs[i] == from)
+                        m_Netlist.SetCellInput(user, i, to);
+                }
+            }
+            AddUser(to, user);
+            Touch(user);
+        }
+
+        TouchDriver(from);
+        m_Changes++;
+    }
+
+    void OptimizationContext::RewriteCell(CellID cell, CellType type, std::span<const NetID> inputs, uint64_t param) {
+        NetID old_inputs[3];
+        auto old = m_Netlist.GetCellInputs(cell);
+        std::copy(old.begin(), old.end(), old_inputs);
+        auto old_count = old.size();
+
+        for (size_t i = 0; i < old_count; i++)
+            RemoveUser(old_inputs[i], cell);
+        m_Netlist.SetCell(cell, type, inputs, param);
+        for (auto net : inputs)
+            AddUser(net, cell);
+
+        // inputs that lost a user might be dead now, readers of the output might simplify
+        for (size_t i = 0; i < old_count; i++)
+            TouchDriver(old_inputs[i]);
+        Touch(cell);
+        TouchUsers(m_Netlist.GetCellOutput(cell));
+        m_Changes++;
+    }
+
+    void OptimizationContext::RewriteRegister(RegisterID reg, NetID d, ClockEdge edge) {
+        auto old_d = m_Netlist.GetRegisterD(reg);
+        if (old_d != INVALID_ID)
+            RemoveUser(old_d, reg | REGISTER_NODE);
+        m_Netlist.SetRegisterInput(reg, d);
+        m_Netlist.SetRegisterClock(reg, m_Netlist.GetRegisterClock(reg), edge);
+        AddUser(d, reg | REGISTER_NODE);
+
+        if (old_d != INVALID_ID)
+            TouchDriver(old_d);
+        Touch(reg | REGISTER_NODE);
+        m_Changes++;
+    }
+
+    void OptimizationContext::RemoveCell(CellID cell) {
+        m_CellAlive[cell] = false;
+        for (auto net : m_Netlist.GetCellInputs(cell)) {
+            RemoveUser(net, cell);
+            TouchDriver(net);
+        }
+        m_Changes++;
+    }
+
+    void OptimizationContext::RemoveRegister(RegisterID reg) {
+        m_RegisterAlive[reg] = false;
+        for (auto net : {m_Netlist.GetRegisterD(reg), m_Netlist.GetRegisterClock(reg)}) {
+            if (net == INVALID_ID)
+                continue;
+            RemoveUser(net, reg | REGISTER_NODE);
+            TouchDriver(net);
+        }
+        m_Changes++;
+    }
+
+    NetID OptimizationContext::AddConst(uint64_t value, uint32_t width) {
+        auto net  = m_Netlist.AddNet(width);
+        auto cell = m_Netlist.AddCell(CellType::CONST, net, {}, value);
+        m_Users.emplace_back();
+        m_Pinned.push_back(false);
+        m_CellAlive.push_back(true);
+        Touch(cell);
+        return net;
+    }
+
+    void OptimizationContext::Commit() {
+        // mark everything that can reach an output port, instance or coverage point
+        std::vector<uint8_t> keep_cells(m_Netlist.GetCellCount(), 0);
+        std::vector<uint8_t> keep_registers(m_Netlist.GetRegisterCount(), 0);
+        std::vector<NetID> stack;
+
+        for (PortID p = 0; p < m_Netlist.GetPortCount(); p++) {
+            if (m_Netlist.GetPortDirection(p) != PortDirection::IN)
+                stack.push_back(m_Netlist.GetPortNet(p));
+        }
+        for (InstanceID i = 0; i < m_Netlist.GetInstanceCount(); i++) {
+            for (auto net : m_Netlist.GetInstanceConnections(i))
+                stack.push_back(net);
+        }
+        for (CoverID i = 0; i < m_Netlist.GetCoverPointCount(); i++) {
+            stack.push_back(m_Netlist.GetCoverPointNet(i));
+            stack.push_back(m_Netlist.GetCoverPointClock(i));
+        }
+
+        while (!stack.empty()) {
+            auto net = stack.back();
+            stack.pop_back();
+            auto driver = m_Netlist.GetNetDriver(net);
+            switch (m_Netlist.GetNetDriverKind(net)) {
+                case DriverKind::CELL: {
+                    if (keep_cells[driver] || !m_CellAlive[driver])
+                        break;
+                    keep_cells[driver] = true;
+                    for (auto in : m_Netlist.GetCellInputs(driver))
+                        stack.push_back(in);
+                    break;
+                }
+                case DriverKind::REGISTER: {
+                    if (keep_registers[driver] || !m_RegisterAlive[driver])
+                        break;
+                    keep_registers[driver] = true;
+                    stack.push_back(m_Netlist.GetRegisterD(driver));
+                    stack.push_back(m_Netlist.GetRegisterClock(driver));
+                    break;
+                }
+                default: break;
+            }
+        }
+
+        m_Netlist.Compact(keep_cells, keep_registers);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // PassManager
+
+    void PassManager::AddDefaultPasses() {
+        AddPass(CreateScope<ConstantPropagation>());
+        AddPass(CreateScope<CommonSubexpressionElimination>());
+        AddPass(CreateScope<DeadLogicElimination>());
+    }
+
+    void PassManager::Run(Netlist& netlist) {
+        XRT_PROFILE_SCOPE("PassManager::Run");
+
+        OptimizationContext ctx(netlist);
+        std::vector<Worklist> worklists(m_Passes.size());
+        m_Statistics.clear();
+        for (size_t i = 0; i < m_Passes.size(); i++) {
+            ctx.AddWorklist(&worklists[i]);
+            m_Statistics.push_back({m_Passes[i]->GetName()});
+        }
+
+        // seed with everything - later iterations only see nodes touched by changes
+        for (CellID c = netlist.GetCellCount(); c-- > 0;)
+            ctx.Touch(c);
+        for (RegisterID r = netlist.GetRegisterCount(); r-- > 0;)
+            ctx.Touch(r | REGISTER_NODE);
+
+        auto cells_before     = netlist.GetCellCount();
+        auto registers_before = netlist.GetRegisterCount();
+
+        bool pending = true;
+        while (pending) {
+            pending = false;
+            for (size_t i = 0; i < m_Passes.size(); i++) {
+                auto& wl    = worklists[i];
+                auto& stats = m_Statistics[i];
+                if (wl.IsEmpty())
+                    continue;
+
+                auto changes = ctx.GetChangeCount();
+                auto start   = std::chrono::steady_clock::now();
+                while (!wl.IsEmpty()) {
+                    auto node = wl.Pop();
+                    bool alive =
+                        (node & REGISTER_NODE) ? ctx.IsRegisterAlive(node & NODE_INDEX_MASK) : ctx.IsCellAlive(node & NODE_INDEX_MASK);
+                    if (!alive)
+                        continue;
+                    m_Passes[i]->Process(ctx, node);
+                    stats.visited++;
+                }
+                stats.time += std::chrono::steady_clock::now() - start;
+                stats.changes += ctx.GetChangeCount() - changes;
+            }
+            for (auto& wl : worklists) {
+                if (!wl.IsEmpty())
+                    pending = true;
+            }
+        }
+
+        ctx.Commit();
+
+        for (auto& stats : m_Statistics) {
+            LOG_DEBUG("[Pass] \"{}\" {:.3f}ms - {} visited, {} changes",
+                      stats.name,
+                      static_cast<float>(stats.time.count()) / 1000000.0f,
+                      stats.visited,
+                      stats.changes);
+        }
+        LOG_DEBUG("[Pass] {}: cells {} -> {}, registers {} -> {}",
+                  netlist.GetName(),
+                  cells_before,
+                  netlist.GetCellCount(),
+                  registers_before,
+                  netlist.GetRegisterCount());
+    }
+
+} // namespace XRT
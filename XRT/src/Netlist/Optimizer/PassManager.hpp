@@ -0,0 +1,160 @@
+#pragma once
+#include <chrono>
+#include <optional>
+#include <span>
+#include <vector>
+#include <Utils.hpp>
+#include "Netlist/Netlist.hpp"
+
+namespace XRT {
+
+    /// Worklist node - cell ID, or register ID with REGISTER_NODE flag
+    using NodeID                            = uint32_t;
+    static constexpr NodeID REGISTER_NODE   = 0x80000000;
+    static constexpr NodeID NODE_INDEX_MASK = 0x7FFFFFFF;
+
+    /// Deduplicating LIFO worklist
+    class Worklist {
+    public:
+        void Push(NodeID node);
+        NodeID Pop() {
+            auto node = m_Stack.back();
+            m_Stack.pop_back();
+            Queued(node) = false;
+            return node;
+        }
+        bool IsEmpty() const {
+            return m_Stack.empty();
+        }
+
+    private:
+        uint8_t& Queued(NodeID node) {
+            auto& v  = (node & REGISTER_NODE) ? m_QueuedRegisters : m_QueuedCells;
+            auto idx = node & NODE_INDEX_MASK;
+            if (idx >= v.size())
+                v.resize(idx + 1, 0);
+            return v[idx];
+        }
+
+    private:
+        std::vector<NodeID> m_Stack;
+        std::vector<uint8_t> m_QueuedCells;
+        std::vector<uint8_t> m_QueuedRegisters;
+    };
+
+    /// Mutable view of a netlist during optimization - tracks exact net users and
+    /// notifies all pass worklists about nodes affected by every change
+    class OptimizationContext {
+    public:
+        OptimizationContext(Netlist& netlist);
+
+        Netlist& GetNetlist() {
+            return m_Netlist;
+        }
+
+        bool IsCellAlive(CellID cell) const {
+            return m_CellAlive[cell];
+        }
+        bool IsRegisterAlive(RegisterID reg) const {
+            return m_RegisterAlive[reg];
+        }
+
+        /// Cells and registers (REGISTER_NODE) reading a net
+        std::span<const NodeID> GetUsers(NetID net) const {
+            return m_Users[net];
+        }
+
+        /// Net is bound to a port, instance or coverage point and can not be replaced/removed
+        bool IsPinned(NetID net) const {
+            return m_Pinned[net];
+        }
+
+        /// Value of a net driven by a CONST cell
+        std::optional<uint64_t> GetConstValue(NetID net) const;
+
+        /// Redirect all readers of "from" to "to"
+        void ReplaceNet(NetID from, NetID to);
+        void RewriteCell(CellID cell, CellType type, std::span<const NetID> inputs, uint64_t param = 0);
+        void RewriteCell(CellID cell, CellType type, std::initializer_list<NetID> inputs, uint64_t param = 0) {
+            RewriteCell(cell, type, std::span<const NetID>{inputs.begin(), inputs.size()}, param);
+        }
+        void RewriteRegister(RegisterID reg, NetID d, ClockEdge edge);
+        void RemoveCell(CellID cell);
+        void RemoveRegister(RegisterID reg);
+        NetID AddConst(uint64_t value, uint32_t width);
+
+        /// Drop everything not reachable from outputs and compact the netlist
+        void Commit();
+
+        // Worklist registration
+        void AddWorklist(Worklist* worklist) {
+            m_Worklists.push_back(worklist);
+        }
+        void Touch(NodeID node) {
+            for (auto wl : m_Worklists)
+                wl->Push(node);
+        }
+        void TouchDriver(NetID net);
+        void TouchUsers(NetID net);
+
+        size_t GetChangeCount() const {
+            return m_Changes;
+        }
+
+    private:
+        void AddUser(NetID net, NodeID node);
+        void RemoveUser(NetID net, NodeID node);
+
+    private:
+        Netlist& m_Netlist;
+        std::vector<std::vector<NodeID>> m_Users;
+        std::vector<uint8_t> m_Pinned;
+        std::vector<uint8_t> m_CellAlive;
+        std::vector<uint8_t> m_RegisterAlive;
+        std::vector<Worklist*> m_Worklists;
+        size_t m_Changes = 0;
+    };
+
+    /// Worklist driven netlist transformation
+    class NetlistPass {
+    public:
+        virtual ~NetlistPass() = default;
+
+        virtual const char* GetName() const = 0;
+
+        /// Process a cell or register (REGISTER_NODE) taken from the pass worklist
+        virtual void Process(OptimizationContext& ctx, NodeID node) = 0;
+    };
+
+    class PassManager {
+    public:
+        struct PassStatistics {
+            const char* name;
+            std::chrono::nanoseconds time{0};
+            size_t visited = 0;
+            size_t changes = 0;
+        };
+
+    public:
+        PassManager() = default;
+
+        void AddPass(Scope<NetlistPass>&& pass) {
+            m_Passes.push_back(std::move(pass));
+        }
+
+        /// Default pipeline - constant propagation, CSE, dead logic elimination
+        void AddDefaultPasses();
+
+        /// Run all passes until no worklist has pending nodes, then compact the netlist
+        void Run(Netlist& netlist);
+
+        const std::vector<PassStatistics>& GetStatistics() const {
+            return m_Statistics;
+        }
+
+    private:
+        std::vector<Scope<NetlistPass>> m_Passes;
+        std::vector<PassStatistics> m_Statistics;
+    };
+
+} // namespace XRT
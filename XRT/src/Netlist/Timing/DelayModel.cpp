@@ -0,0 +1,86 @@
+#include "DelayModel.hpp"
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <Log/Logger.hpp>
+#include "Simulation/SimTime.hpp"
+
+namespace XRT {
+
+    DelayModel::DelayModel() {
+        m_CellDelay.fill({0, 0});
+        SetCellDelay(CellType::NOT, 50);
+        SetCellDelay(CellType::AND, 50);
+        SetCellDelay(CellType::OR, 50);
+        SetCellDelay(CellType::XOR, 60);
+        SetCellDelay(CellType::ADD, 100, 20);
+        SetCellDelay(CellType::SUB, 100, 20);
+        SetCellDelay(CellType::MUL, 300, 50);
+        SetCellDelay(CellType::EQ, 80, 5);
+        SetCellDelay(CellType::NE, 80, 5);
+        SetCellDelay(CellType::LT, 100, 20);
+        SetCellDelay(CellType::LE, 100, 20);
+        SetCellDelay(CellType::GT, 100, 20);
+        SetCellDelay(CellType::GE, 100, 20);
+        SetCellDelay(CellType::LSL, 150, 10);
+        SetCellDelay(CellType::LSR, 150, 10);
+        SetCellDelay(CellType::MUX, 70);
+        SetCellDelay(CellType::REDUCE_OR, 50, 5);
+        // CONST, BUF and SLICE are wiring
+    }
+
+    bool DelayModel::Load(const std::filesystem::path& path) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            LOG_ERROR("Failed to open delay model \"{}\"", path.string());
+            return false;
+        }
+
+        std::string line;
+        uint32_t line_number = 0;
+        while (std::getline(file, line)) {
+            line_number++;
+            auto comment = line.find('#');
+            if (comment != std::string::npos)
+                line.resize(comment);
+
+            std::istringstream ss(line);
+            std::string name, base_str, per_bit_str;
+            if (!(ss >> name))
+                continue;
+            ss >> base_str >> per_bit_str;
+
+            auto base    = ParseTimeLiteral(base_str);
+            auto per_bit = per_bit_str.empty() ? std::optional<SimTime>{0} : ParseTimeLiteral(per_bit_str);
+            if (!base || !per_bit) {
+                LOG_ERROR("{}:{}: expected \"<NAME> <base> [per_bit]\"", path.string(), line_number);
+                return false;
+            }
+
+            if (name == "CLOCK_TO_Q") {
+                m_ClockToQ = static_cast<Delay>(*base);
+            } else if (name == "SETUP") {
+                m_Setup = static_cast<Delay>(*base);
+            } else if (name == "INPUT") {
+                m_InputDelay = static_cast<Delay>(*base);
+            } else if (name == "OUTPUT") {
+                m_OutputDelay = static_cast<Delay>(*base);
+            } else {
+                bool found = false;
+                for (size_t t = 0; t < static_cast<size_t>(CellType::__COUNT__); t++) {
+                    if (name == CellType_ToString(static_cast<CellType>(t))) {
+                        SetCellDelay(static_cast<CellType>(t), static_cast<Delay>(*base), static_cast<Delay>(*per_bit));
+                        found = true;
+                        break;
+                    }
+                }
+                if (!found) {
+                    LOG_ERROR("{}:{}: unknown cell type \"{}\"", path.string(), line_number, name);
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+} // namespace XRT
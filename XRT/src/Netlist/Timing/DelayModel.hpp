@@ -0,0 +1,80 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include "Netlist/Netlist.hpp"
+
+namespace XRT {
+
+    /// Path delay in picoseconds
+    using Delay = int64_t;
+
+    /// Per cell type delay estimate - base + per_bit * operand width.
+    /// Defaults are a rough generic FPGA fabric, intended for relative comparison of paths, not signoff.
+    class DelayModel {
+    public:
+        struct CellDelay {
+            Delay base;
+            Delay per_bit;
+        };
+
+    public:
+        DelayModel();
+
+        /// Load overrides from a text file - one "<NAME> <base> [per_bit]" entry per line, '#' starts a comment.
+        /// NAME is a cell type (ADD, MUX, ...) or CLOCK_TO_Q, SETUP, INPUT, OUTPUT. Values are time literals ("120", "0.2ns").
+        bool Load(const std::filesystem::path& path);
+
+        void SetCellDelay(CellType type, Delay base, Delay per_bit = 0) {
+            m_CellDelay[static_cast<size_t>(type)] = {base, per_bit};
+        }
+        const CellDelay& GetCellDelay(CellType type) const {
+            return m_CellDelay[static_cast<size_t>(type)];
+        }
+        /// width is the widest of the cell output and operands
+        Delay GetCellDelay(CellType type, uint32_t width) const {
+            auto& d = GetCellDelay(type);
+            return d.base + d.per_bit * width;
+        }
+
+        /// Register clock to output delay - arrival time of register outputs
+        Delay GetClockToQ() const {
+            return m_ClockToQ;
+        }
+        void SetClockToQ(Delay delay) {
+            m_ClockToQ = delay;
+        }
+
+        /// Register setup time - subtracted from the capture edge
+        Delay GetSetup() const {
+            return m_Setup;
+        }
+        void SetSetup(Delay delay) {
+            m_Setup = delay;
+        }
+
+        /// External delay before input ports change
+        Delay GetInputDelay() const {
+            return m_InputDelay;
+        }
+        void SetInputDelay(Delay delay) {
+            m_InputDelay = delay;
+        }
+
+        /// External delay after output ports before the capture edge
+        Delay GetOutputDelay() const {
+            return m_OutputDelay;
+        }
+        void SetOutputDelay(Delay delay) {
+            m_OutputDelay = delay;
+        }
+
+    private:
+        std::array<CellDelay, static_cast<size_t>(CellType::__COUNT__)> m_CellDelay;
+        Delay m_ClockToQ    = 150;
+        Delay m_Setup       = 100;
+        Delay m_InputDelay  = 0;
+        Delay m_OutputDelay = 0;
+    };
+
+} // namespace XRT
@@ -0,0 +1,367 @@
+#include "TimingAnalysis.hpp"
+#include <queue>
+#include <thread>
+#include <Log/Logger.hpp>
+#include "Profiler.hpp"
+
+namespace XRT {
+
+    using TimingError = TimingAnalysis::TimingError;
+
+    TimingAnalysis::TimingAnalysis(const Netlist& netlist, const DelayModel& model) : m_Netlist(netlist), m_Model(model) {
+        if (netlist.GetInstanceCount())
+            throw TimingError("Netlist \"" + std::string{netlist.GetName()} + "\" has instances - timing analysis requires a flat netlist");
+    }
+
+    Delay TimingAnalysis::ComputeCellDelay(CellID cell) const {
+        auto& nl       = m_Netlist;
+        uint32_t width = nl.GetNetWidth(nl.GetCellOutput(cell));
+        for (auto net : nl.GetCellInputs(cell))
+            width = std::max(width, nl.GetNetWidth(net));
+        return m_Model.GetCellDelay(nl.GetCellType(cell), width);
+    }
+
+    Delay TimingAnalysis::ComputeRequired(NetID net) const {
+        auto required = m_EndpointRequired[net];
+        ForEachReader(net, [&](CellID c) {
+            auto r = m_Required[m_Netlist.GetCellOutput(c)];
+            if (r != UNCONSTRAINED)
+                required = std::min(required, r - m_CellDelay[c]);
+        });
+        return required;
+    }
+
+    void TimingAnalysis::ParallelFor(uint32_t begin, uint32_t end, const std::function<void(uint32_t, uint32_t)>& job) {
+        if (!m_Workers || end - begin < MIN_PARALLEL_CELLS) {
+            job(begin, end);
+            return;
+        }
+        auto count = m_Workers->GetCount();
+        auto chunk = (end - begin + count - 1) / count;
+        m_Workers->Run([&](uint32_t worker) {
+            auto from = begin + worker * chunk;
+            if (from < end)
+                job(from, std::min(end, from + chunk));
+        });
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Full analysis
+
+    void TimingAnalysis::Levelize() {
+        XRT_PROFILE_SCOPE("TimingAnalysis::Levelize");
+        auto& nl = m_Netlist;
+
+        // Kahn's algorithm - cells without cell driven inputs are level 0
+        std::vector<uint32_t> pending(nl.GetCellCount(), 0);
+        m_LevelCells.clear();
+        m_LevelCells.reserve(nl.GetCellCount());
+        for (CellID c = 0; c < nl.GetCellCount(); c++) {
+            for (uint32_t i = 0; i < m_InputCount[c]; i++) {
+                if (nl.GetNetDriverKind(m_Inputs[c][i]) == DriverKind::CELL)
+                    pending[c]++;
+            }
+            if (!pending[c])
+                m_LevelCells.push_back(c);
+        }
+
+        m_Level.assign(nl.GetCellCount(), 0);
+        m_LevelOffset.assign(1, 0);
+        size_t begin = 0;
+        while (begin < m_LevelCells.size()) {
+            auto end   = m_LevelCells.size();
+            auto level = static_cast<uint32_t>(m_LevelOffset.size() - 1);
+            m_LevelOffset.push_back(static_cast<uint32_t>(end));
+            for (auto i = begin; i < end; i++) {
+                auto c     = m_LevelCells[i];
+                m_Level[c] = level;
+                for (auto user : nl.GetNetFanout(nl.GetCellOutput(c))) {
+                    if (--pending[user] == 0)
+                        m_LevelCells.push_back(user);
+                }
+            }
+            begin = end;
+        }
+
+        if (m_LevelCells.size() != nl.GetCellCount()) {
+            for (CellID c = 0; c < nl.GetCellCount(); c++) {
+                if (pending[c])
+                    throw TimingError("Combinational loop through net " + GetNetLabel(nl.GetCellOutput(c)));
+            }
+        }
+    }
+
+    void TimingAnalysis::Run(uint32_t threads) {
+        XRT_PROFILE_SCOPE("TimingAnalysis::Run");
+        auto& nl = m_Netlist;
+
+        if (!threads)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        if (threads > 1 && (!m_Workers || m_Workers->GetCount() != threads)) {
+            m_Workers = CreateScope<WorkerPool>(threads);
+        } else if (threads <= 1) {
+            m_Workers.reset();
+        }
+
+        // cell snapshot
+        m_AddedFanout.clear();
+        m_Inputs.resize(nl.GetCellCount());
+        m_InputCount.resize(nl.GetCellCount());
+        m_CellDelay.resize(nl.GetCellCount());
+        m_Queued.assign(nl.GetCellCount(), 0);
+        ParallelFor(0, nl.GetCellCount(), [&](uint32_t begin, uint32_t end) {
+            for (auto c = begin; c < end; c++) {
+                auto inputs     = nl.GetCellInputs(c);
+                m_InputCount[c] = static_cast<uint8_t>(inputs.size());
+                std::copy(inputs.begin(), inputs.end(), m_Inputs[c].begin());
+                m_CellDelay[c] = ComputeCellDelay(c);
+            }
+        });
+
+        Levelize();
+
+        // startpoints
+        m_Arrival.assign(nl.GetNetCount(), 0);
+        for (RegisterID r = 0; r < nl.GetRegisterCount(); r++)
+            m_Arrival[nl.GetRegisterQ(r)] = m_Model.GetClockToQ();
+        for (PortID p = 0; p < nl.GetPortCount(); p++) {
+            if (nl.GetPortDirection(p) == PortDirection::IN && nl.GetNetDriverKind(nl.GetPortNet(p)) == DriverKind::PORT)
+                m_Arrival[nl.GetPortNet(p)] = m_Model.GetInputDelay();
+        }
+
+        // endpoints - registers sensitive to both edges capture every half period
+        m_Endpoints.clear();
+        m_EndpointRequired.assign(nl.GetNetCount(), UNCONSTRAINED);
+        auto add_endpoint = [&](NetID net, Delay required, RegisterID reg, PortID port) {
+            m_Endpoints.push_back({net, required, reg, port});
+            m_EndpointRequired[net] = std::min(m_EndpointRequired[net], required);
+        };
+        for (RegisterID r = 0; r < nl.GetRegisterCount(); r++) {
+            if (nl.GetRegisterD(r) == INVALID_ID || nl.GetRegisterClock(r) == INVALID_ID)
+                continue;
+            auto window = nl.GetRegisterEdge(r) == ClockEdge::BOTH ? m_ClockPeriod / 2 : m_ClockPeriod;
+            add_endpoint(nl.GetRegisterD(r), window - m_Model.GetSetup(), r, INVALID_ID);
+        }
+        for (PortID p = 0; p < nl.GetPortCount(); p++) {
+            if (nl.GetPortDirection(p) == PortDirection::OUT)
+                add_endpoint(nl.GetPortNet(p), m_ClockPeriod - m_Model.GetOutputDelay(), INVALID_ID, p);
+        }
+
+        // arrival - forward by level
+        for (uint32_t l = 0; l < GetLevelCount(); l++) {
+            ParallelFor(m_LevelOffset[l], m_LevelOffset[l + 1], [&](uint32_t begin, uint32_t end) {
+                for (auto i = begin; i < end; i++) {
+                    auto c                         = m_LevelCells[i];
+                    m_Arrival[nl.GetCellOutput(c)] = ComputeArrival(c);
+                }
+            });
+        }
+
+        // required - backward by level, then the startpoint nets
+        m_Required.assign(nl.GetNetCount(), UNCONSTRAINED);
+        for (auto l = GetLevelCount(); l-- > 0;) {
+            ParallelFor(m_LevelOffset[l], m_LevelOffset[l + 1], [&](uint32_t begin, uint32_t end) {
+                for (auto i = begin; i < end; i++) {
+                    auto out        = nl.GetCellOutput(m_LevelCells[i]);
+                    m_Required[out] = ComputeRequired(out);
+                }
+            });
+        }
+        ParallelFor(0, nl.GetNetCount(), [&](uint32_t begin, uint32_t end) {
+            for (auto n = begin; n < end; n++) {
+                if (nl.GetNetDriverKind(n) != DriverKind::CELL)
+                    m_Required[n] = ComputeRequired(n);
+            }
+        });
+
+        LOG_DEBUG("[Timing] {}: {} cells in {} levels, {} endpoints", nl.GetName(), nl.GetCellCount(), GetLevelCount(), m_Endpoints.size());
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Incremental update
+
+    void TimingAnalysis::UpdateCell(CellID cell) {
+        auto& nl = m_Netlist;
+
+        // new connections are not in the netlist fanout until the next Finalize
+        auto old_inputs    = m_Inputs[cell];
+        auto old_count     = m_InputCount[cell];
+        auto inputs        = nl.GetCellInputs(cell);
+        m_InputCount[cell] = static_cast<uint8_t>(inputs.size());
+        std::copy(inputs.begin(), inputs.end(), m_Inputs[cell].begin());
+        for (auto net : inputs) {
+            bool known = false;
+            for (auto c : nl.GetNetFanout(net))
+                known |= c == cell;
+            auto [begin, end] = m_AddedFanout.equal_range(net);
+            for (auto it = begin; it != end; ++it)
+                known |= it->second == cell;
+            if (!known)
+                m_AddedFanout.emplace(net, cell);
+        }
+        m_CellDelay[cell] = ComputeCellDelay(cell);
+
+        // keep levels topological - a deeper driver pushes this cell and its fanout down
+        uint32_t level = 0;
+        for (auto net : inputs) {
+            if (nl.GetNetDriverKind(net) == DriverKind::CELL)
+                level = std::max(level, m_Level[nl.GetNetDriver(net)] + 1);
+        }
+        if (level > m_Level[cell]) {
+            m_Level[cell] = level;
+            std::vector<CellID> stack{cell};
+            while (!stack.empty()) {
+                auto c = stack.back();
+                stack.pop_back();
+                ForEachReader(nl.GetCellOutput(c), [&](CellID user) {
+                    if (m_Level[user] > m_Level[c])
+                        return;
+                    m_Level[user] = m_Level[c] + 1;
+                    if (m_Level[user] > nl.GetCellCount())
+                        throw TimingError("Combinational loop through net " + GetNetLabel(nl.GetCellOutput(user)));
+                    stack.push_back(user);
+                });
+            }
+        }
+
+        m_LastUpdateCount = 0;
+        using Entry       = std::pair<uint32_t, CellID>; // level, cell
+
+        // arrival - forward through the fanout cone in level order, stops where arrival is unchanged
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> forward;
+        auto push_forward = [&](CellID c) {
+            if (!m_Queued[c]) {
+                m_Queued[c] = 1;
+                forward.emplace(m_Level[c], c);
+            }
+        };
+        push_forward(cell);
+        while (!forward.empty()) {
+            auto c = forward.top().second;
+            forward.pop();
+            m_Queued[c] = 0;
+            m_LastUpdateCount++;
+
+            auto out     = nl.GetCellOutput(c);
+            auto arrival = ComputeArrival(c);
+            if (arrival != m_Arrival[out]) {
+                m_Arrival[out] = arrival;
+                ForEachReader(out, push_forward);
+            }
+        }
+
+        // required - backward through the fanin cones of old and new inputs, deepest first
+        std::priority_queue<Entry> backward;
+        auto touch = [&](NetID net) {
+            if (nl.GetNetDriverKind(net) == DriverKind::CELL) {
+                auto driver = nl.GetNetDriver(net);
+                if (!m_Queued[driver]) {
+                    m_Queued[driver] = 1;
+                    backward.emplace(m_Level[driver], driver);
+                }
+            } else {
+                m_Required[net] = ComputeRequired(net);
+            }
+        };
+        for (uint32_t i = 0; i < old_count; i++)
+            touch(old_inputs[i]);
+        for (auto net : inputs)
+            touch(net);
+        while (!backward.empty()) {
+            auto c = backward.top().second;
+            backward.pop();
+            m_Queued[c] = 0;
+            m_LastUpdateCount++;
+
+            auto out      = nl.GetCellOutput(c);
+            auto required = ComputeRequired(out);
+            if (required != m_Required[out]) {
+                m_Required[out] = required;
+                for (uint32_t i = 0; i < m_InputCount[c]; i++)
+                    touch(m_Inputs[c][i]);
+            }
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Reporting
+
+    Delay TimingAnalysis::GetWorstSlack() const {
+        auto worst = UNCONSTRAINED;
+        for (auto& e : m_Endpoints)
+            worst = std::min(worst, e.required - m_Arrival[e.net]);
+        return worst;
+    }
+
+    std::string TimingAnalysis::GetNetLabel(NetID net) const {
+        auto name = m_Netlist.GetNetName(net);
+        return name.empty() ? "n" + std::to_string(net) : std::string{name};
+    }
+
+    std::vector<TimingAnalysis::TimingPath> TimingAnalysis::GetCriticalPaths(uint32_t count) const {
+        auto& nl = m_Netlist;
+
+        std::vector<std::pair<Delay, uint32_t>> order; // slack, endpoint
+        order.reserve(m_Endpoints.size());
+        for (uint32_t i = 0; i < m_Endpoints.size(); i++)
+            order.emplace_back(m_Endpoints[i].required - m_Arrival[m_Endpoints[i].net], i);
+        count = std::min(count, static_cast<uint32_t>(order.size()));
+        std::partial_sort(order.begin(), order.begin() + count, order.end());
+
+        std::vector<TimingPath> paths;
+        for (uint32_t i = 0; i < count; i++) {
+            auto& e = m_Endpoints[order[i].second];
+
+            TimingPath path;
+            path.endpoint = e.reg != INVALID_ID ? "reg " + std::string{nl.GetRegisterName(e.reg)} : "port " + std::string{nl.GetPortName(e.port)};
+            path.arrival  = m_Arrival[e.net];
+            path.required = e.required;
+            path.slack    = order[i].first;
+
+            // follow the latest arriving input back to the startpoint
+            auto net = e.net;
+            while (nl.GetNetDriverKind(net) == DriverKind::CELL) {
+                auto c = nl.GetNetDriver(net);
+                path.points.push_back({net, c, m_Arrival[net]});
+                if (!m_InputCount[c])
+                    break;
+                net = m_Inputs[c][0];
+                for (uint32_t k = 1; k < m_InputCount[c]; k++) {
+                    if (m_Arrival[m_Inputs[c][k]] > m_Arrival[net])
+                        net = m_Inputs[c][k];
+                }
+            }
+            if (nl.GetNetDriverKind(net) != DriverKind::CELL)
+                path.points.push_back({net, INVALID_ID, m_Arrival[net]});
+            std::reverse(path.points.begin(), path.points.end());
+            paths.push_back(std::move(path));
+        }
+        return paths;
+    }
+
+    void TimingAnalysis::Report(uint32_t path_count) const {
+        auto& nl = m_Netlist;
+        if (m_Endpoints.empty()) {
+            LOG_INFO("[Timing] {}: no constrained paths", nl.GetName());
+            return;
+        }
+
+        auto worst = GetWorstSlack();
+        if (worst < 0) {
+            LOG_WARN("[Timing] {}: clock period {}ps violated - worst slack {}ps", nl.GetName(), m_ClockPeriod, worst);
+        } else {
+            LOG_INFO("[Timing] {}: clock period {}ps met - worst slack {}ps", nl.GetName(), m_ClockPeriod, worst);
+        }
+
+        auto paths = GetCriticalPaths(path_count);
+        for (size_t i = 0; i < paths.size(); i++) {
+            auto& path = paths[i];
+            LOG_INFO("[Timing] #{} {} - slack {}ps (arrival {}ps, required {}ps)", i + 1, path.endpoint, path.slack, path.arrival, path.required);
+            for (auto& p : path.points) {
+                auto via = p.cell == INVALID_ID ? "start" : CellType_ToString(nl.GetCellType(p.cell));
+                LOG_INFO("    {:>8}ps  {:<10} {}", p.arrival, via, GetNetLabel(p.net));
+            }
+        }
+    }
+
+} // namespace XRT
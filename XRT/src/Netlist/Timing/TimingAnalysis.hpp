@@ -0,0 +1,168 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <Utils.hpp>
+#include "Netlist/Netlist.hpp"
+#include "Simulation/WorkerPool.hpp"
+#include "DelayModel.hpp"
+
+namespace XRT {
+
+    /// Static timing estimate of a flat netlist.
+    /// Paths start at register outputs and input ports and end at register inputs and output ports.
+    /// Arrival times propagate forward and required times backward over the levelized cells; all cells of a level
+    /// are independent so large levels are split across worker threads.
+    /// After a full Run, single cell changes are applied with UpdateCell which only revisits the affected cones.
+    class TimingAnalysis {
+    public:
+        class TimingError : public std::exception {
+        public:
+            TimingError(const std::string& reason) : m_Reason(reason) {
+            }
+
+            const char* what() const noexcept override {
+                return m_Reason.c_str();
+            }
+
+        private:
+            std::string m_Reason;
+        };
+
+        /// Required time of nets that do not reach an endpoint
+        static constexpr Delay UNCONSTRAINED = std::numeric_limits<Delay>::max();
+
+        /// Smallest level worth splitting across threads
+        static constexpr uint32_t MIN_PARALLEL_CELLS = 4096;
+
+        struct PathPoint {
+            NetID net;
+            CellID cell; // driver cell, INVALID_ID for the startpoint
+            Delay arrival;
+        };
+
+        struct TimingPath {
+            std::string endpoint;
+            Delay arrival;
+            Delay required;
+            Delay slack;
+            std::vector<PathPoint> points; // startpoint -> endpoint
+        };
+
+    public:
+        /// Netlist must be flat and finalized
+        TimingAnalysis(const Netlist& netlist, const DelayModel& model);
+
+        void SetClockPeriod(Delay period) {
+            m_ClockPeriod = period;
+        }
+        Delay GetClockPeriod() const {
+            return m_ClockPeriod;
+        }
+
+        /// Full analysis - threads = 0 uses all hardware threads
+        void Run(uint32_t threads = 0);
+
+        /// Re-time after SetCell/SetCellInput changed a single cell (function or inputs).
+        /// The change must not create a combinational loop.
+        void UpdateCell(CellID cell);
+
+        Delay GetArrival(NetID net) const {
+            return m_Arrival[net];
+        }
+        Delay GetRequired(NetID net) const {
+            return m_Required[net];
+        }
+        Delay GetSlack(NetID net) const {
+            return m_Required[net] == UNCONSTRAINED ? UNCONSTRAINED : m_Required[net] - m_Arrival[net];
+        }
+        Delay GetWorstSlack() const;
+
+        uint32_t GetLevelCount() const {
+            return static_cast<uint32_t>(m_LevelOffset.size() - 1);
+        }
+        /// Cells re-evaluated by the last UpdateCell
+        uint32_t GetLastUpdateCount() const {
+            return m_LastUpdateCount;
+        }
+
+        /// Worst endpoints sorted by slack, one path each
+        std::vector<TimingPath> GetCriticalPaths(uint32_t count) const;
+
+        void Report(uint32_t path_count) const;
+
+    private:
+        struct Endpoint {
+            NetID net;
+            Delay required;
+            RegisterID reg; // INVALID_ID for output ports
+            PortID port;    // INVALID_ID for registers
+        };
+
+        void Levelize();
+        void ParallelFor(uint32_t begin, uint32_t end, const std::function<void(uint32_t, uint32_t)>& job);
+
+        Delay ComputeCellDelay(CellID cell) const;
+        Delay ComputeArrival(CellID cell) const {
+            Delay arrival = 0;
+            for (uint32_t i = 0; i < m_InputCount[cell]; i++)
+                arrival = std::max(arrival, m_Arrival[m_Inputs[cell][i]]);
+            return arrival + m_CellDelay[cell];
+        }
+        Delay ComputeRequired(NetID net) const;
+
+        bool Reads(CellID cell, NetID net) const {
+            for (uint32_t i = 0; i < m_InputCount[cell]; i++) {
+                if (m_Inputs[cell][i] == net)
+                    return true;
+            }
+            return false;
+        }
+
+        /// Iterate cells currently reading net - netlist fanout plus edges added by UpdateCell, stale edges skipped
+        template<typename Fn>
+        void ForEachReader(NetID net, Fn&& fn) const {
+            for (auto c : m_Netlist.GetNetFanout(net)) {
+                if (Reads(c, net))
+                    fn(c);
+            }
+            auto [begin, end] = m_AddedFanout.equal_range(net);
+            for (auto it = begin; it != end; ++it) {
+                if (Reads(it->second, net))
+                    fn(it->second);
+            }
+        }
+
+        std::string GetNetLabel(NetID net) const;
+
+    private:
+        const Netlist& m_Netlist;
+        const DelayModel& m_Model;
+        Delay m_ClockPeriod = 10000;
+
+        // per cell - snapshot of the inputs timed, to detect connection changes
+        std::vector<std::array<NetID, 3>> m_Inputs;
+        std::vector<uint8_t> m_InputCount;
+        std::vector<Delay> m_CellDelay;
+        std::vector<uint32_t> m_Level;
+        std::vector<uint32_t> m_LevelOffset{0}; // CSR [level] -> m_LevelCells
+        std::vector<CellID> m_LevelCells;
+        std::unordered_multimap<NetID, CellID> m_AddedFanout;
+
+        // per net
+        std::vector<Delay> m_Arrival;
+        std::vector<Delay> m_Required;
+        std::vector<Delay> m_EndpointRequired; // UNCONSTRAINED for non-endpoints
+
+        std::vector<Endpoint> m_Endpoints;
+        std::vector<uint8_t> m_Queued; // [cell] incremental worklist membership
+        Scope<WorkerPool> m_Workers;
+        uint32_t m_LastUpdateCount = 0;
+    };
+
+} // namespace XRT
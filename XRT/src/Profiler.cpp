@@ -0,0 +1,206 @@
+#include "Profiler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <Log/Logger.hpp>
+#include <Utils.hpp>
+#include "Server/Json.hpp"
+
+namespace XRT {
+
+    namespace {
+
+        struct ZoneStats {
+            uint64_t count = 0;
+            int64_t total  = 0; // ns
+            int64_t self   = 0; // ns, total minus nested zones
+            int64_t min    = std::numeric_limits<int64_t>::max();
+            int64_t max    = 0;
+        };
+
+        struct Frame {
+            uint32_t zone;
+            Profiler::Clock::time_point start;
+            int64_t children; // ns spent in nested zones
+        };
+
+        struct TraceEvent {
+            uint32_t zone;
+            int64_t start;    // ns since profiler epoch
+            int64_t duration; // ns
+        };
+
+        struct ThreadData {
+            uint32_t index;
+            std::vector<Frame> stack;
+            std::vector<ZoneStats> stats; // [zone]
+            std::vector<TraceEvent> events;
+            uint64_t dropped = 0;
+        };
+
+        std::mutex s_Lock;
+        std::vector<const char*> s_ZoneNames;
+        std::vector<Scope<ThreadData>> s_Threads; // owned here so data outlives worker threads
+        std::atomic<bool> s_TraceEnabled{false};
+        const Profiler::Clock::time_point s_Epoch = Profiler::Clock::now();
+
+        thread_local ThreadData* t_Data = nullptr;
+
+        ThreadData& GetThreadData() {
+            if (!t_Data) {
+                std::lock_guard lock(s_Lock);
+                s_Threads.push_back(CreateScope<ThreadData>());
+                t_Data        = s_Threads.back().get();
+                t_Data->index = static_cast<uint32_t>(s_Threads.size() - 1);
+            }
+            return *t_Data;
+        }
+
+        int64_t ToNanoseconds(Profiler::Clock::duration duration) {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        }
+
+    } // namespace
+
+    uint32_t Profiler::RegisterZone(const char* name) {
+        std::lock_guard lock(s_Lock);
+        s_ZoneNames.push_back(name);
+        return static_cast<uint32_t>(s_ZoneNames.size() - 1);
+    }
+
+    void Profiler::SetTraceEnabled(bool enabled) {
+        s_TraceEnabled = enabled;
+    }
+
+    void Profiler::BeginZone(uint32_t zone) {
+        auto& data = GetThreadData();
+        data.stack.push_back({zone, Clock::now(), 0});
+    }
+
+    void Profiler::EndZone() {
+        auto end   = Clock::now();
+        auto& data = GetThreadData();
+        auto frame = data.stack.back();
+        data.stack.pop_back();
+
+        auto duration = ToNanoseconds(end - frame.start);
+        if (!data.stack.empty())
+            data.stack.back().children += duration;
+
+        if (frame.zone >= data.stats.size())
+            data.stats.resize(frame.zone + 1);
+        auto& stats = data.stats[frame.zone];
+        stats.count++;
+        stats.total += duration;
+        stats.self += duration - frame.children;
+        stats.min = std::min(stats.min, duration);
+        stats.max = std::max(stats.max, duration);
+
+        if (s_TraceEnabled.load(std::memory_order_relaxed)) {
+            if (data.events.size() < MAX_TRACE_EVENTS_PER_THREAD) {
+                data.events.push_back({frame.zone, ToNanoseconds(frame.start - s_Epoch), duration});
+            } else {
+                data.dropped++;
+            }
+        }
+    }
+
+    bool Profiler::WriteTrace(const std::filesystem::path& path) {
+        std::lock_guard lock(s_Lock);
+        std::ofstream out(path, std::ios::binary);
+        if (!out.is_open()) {
+            LOG_ERROR("Failed to open trace output \"{}\"", path.string());
+            return false;
+        }
+
+        // complete ("X") events - nesting is reconstructed from timestamps, microsecond units
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        bool first   = true;
+        size_t count = 0;
+        for (auto& thread : s_Threads) {
+            out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread->index
+                << ",\"args\":{\"name\":\"Thread " << thread->index << "\"}}";
+            first = false;
+            for (auto& e : thread->events) {
+                out << fmt::format(",\n{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                                   Json::Escape(s_ZoneNames[e.zone]),
+                                   thread->index,
+                                   static_cast<double>(e.start) / 1000.0,
+                                   static_cast<double>(e.duration) / 1000.0);
+            }
+            count += thread->events.size();
+            if (thread->dropped)
+                LOG_WARN("[Profiler] Thread {} dropped {} trace events", thread->index, thread->dropped);
+        }
+        out << "\n]}\n";
+
+        if (!out.good()) {
+            LOG_ERROR("Failed to write trace output \"{}\"", path.string());
+            return false;
+        }
+        LOG_INFO("[Profiler] {} trace events written to \"{}\"", count, path.string());
+        return true;
+    }
+
+    void Profiler::LogSummary() {
+        std::lock_guard lock(s_Lock);
+
+        std::vector<ZoneStats> totals(s_ZoneNames.size());
+        for (auto& thread : s_Threads) {
+            for (size_t z = 0; z < thread->stats.size(); z++) {
+                auto& s = thread->stats[z];
+                auto& t = totals[z];
+                t.count += s.count;
+                t.total += s.total;
+                t.self += s.self;
+                t.min = std::min(t.min, s.min);
+                t.max = std::max(t.max, s.max);
+            }
+        }
+
+        // the same label can be registered from several call sites
+        std::vector<std::pair<std::string_view, ZoneStats>> zones;
+        for (size_t z = 0; z < totals.size(); z++) {
+            if (!totals[z].count)
+                continue;
+            auto it = std::find_if(zones.begin(), zones.end(), [&](auto& e) {
+                return e.first == s_ZoneNames[z];
+            });
+            if (it == zones.end()) {
+                zones.emplace_back(s_ZoneNames[z], totals[z]);
+                continue;
+            }
+            auto& t = it->second;
+            t.count += totals[z].count;
+            t.total += totals[z].total;
+            t.self += totals[z].self;
+            t.min = std::min(t.min, totals[z].min);
+            t.max = std::max(t.max, totals[z].max);
+        }
+        if (zones.empty())
+            return;
+        std::sort(zones.begin(), zones.end(), [](auto& a, auto& b) {
+            return a.second.total > b.second.total;
+        });
+
+        auto ms = [](int64_t ns) {
+            return static_cast<double>(ns) / 1000000.0;
+        };
+        LOG_INFO("[Profiler] {:<36} {:>8} {:>11} {:>11} {:>10} {:>10} {:>10}", "Zone", "Count", "Total ms", "Self ms", "Min ms", "Mean ms", "Max ms");
+        for (auto& [name, s] : zones) {
+            LOG_INFO("[Profiler] {:<36} {:>8} {:>11.3f} {:>11.3f} {:>10.3f} {:>10.3f} {:>10.3f}",
+                     name,
+                     s.count,
+                     ms(s.total),
+                     ms(s.self),
+                     ms(s.min),
+                     ms(s.total) / static_cast<double>(s.count),
+                     ms(s.max));
+        }
+    }
+
+} // namespace XRT
@@ -0,0 +1,59 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+
+namespace XRT {
+
+    /// Zone profiler - every thread keeps its own stack of open zones and per zone statistics,
+    /// so recording never takes a lock. Zones are registered once per call site by the XRT_PROFILE_SCOPE macro.
+    /// Results are read after all worker threads have finished.
+    class Profiler {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        /// Trace events kept per thread - zones past this only count towards statistics
+        static constexpr size_t MAX_TRACE_EVENTS_PER_THREAD = 1 << 22;
+
+    public:
+        /// Returns the zone ID for a static label
+        static uint32_t RegisterZone(const char* name);
+
+        static void BeginZone(uint32_t zone);
+        static void EndZone();
+
+        /// Keep individual zone events for WriteTrace (statistics are always collected)
+        static void SetTraceEnabled(bool enabled);
+
+        /// Write all recorded events in Chrome trace event format (chrome://tracing, ui.perfetto.dev)
+        static bool WriteTrace(const std::filesystem::path& path);
+
+        /// Log aggregated count/total/self/min/mean/max per zone
+        static void LogSummary();
+    };
+
+    /// Scoped zone
+    class ProfileZone {
+    public:
+        ProfileZone(uint32_t zone) {
+            Profiler::BeginZone(zone);
+        }
+        ~ProfileZone() {
+            Profiler::EndZone();
+        }
+
+        ProfileZone(const ProfileZone&)            = delete;
+        ProfileZone& operator=(const ProfileZone&) = delete;
+    };
+
+} // namespace XRT
+
+#ifdef XRT_PROFILER
+    #define XRT_PROFILE_CONCAT_(a, b) a##b
+    #define XRT_PROFILE_CONCAT(a, b)  XRT_PROFILE_CONCAT_(a, b)
+    #define XRT_PROFILE_SCOPE(name)                                                                                 \
+        static const uint32_t XRT_PROFILE_CONCAT(s_ProfileZone, __LINE__) = ::XRT::Profiler::RegisterZone(name); \
+        ::XRT::ProfileZone XRT_PROFILE_CONCAT(profile_zone_, __LINE__)(XRT_PROFILE_CONCAT(s_ProfileZone, __LINE__))
+#else
+    #define XRT_PROFILE_SCOPE(name)
+#endif
@@ -0,0 +1,257 @@
+#include "CompileServer.hpp"
+#include <chrono>
+#include <mutex>
+#include <spdlog/sinks/base_sink.h>
+#if defined(CFXS_PLATFORM_LINUX)
+    #include <cerrno>
+    #include <cstring>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+#endif
+
+namespace XRT {
+
+    namespace {
+
+        /// Forwards log messages of the current request to the client
+        class ClientSink : public spdlog::sinks::base_sink<std::mutex> {
+        public:
+            ClientSink(int connection) : m_Connection(connection) {
+            }
+
+        protected:
+            void sink_it_(const spdlog::details::log_msg& msg) override {
+                if (m_Disconnected)
+                    return;
+                m_Buffer.clear();
+                m_Buffer += static_cast<char>(msg.level);
+                m_Buffer.append(msg.payload.data(), msg.payload.size());
+                m_Disconnected = !Protocol::WriteFrame(m_Connection, Protocol::FrameType::LOG, m_Buffer);
+            }
+
+            void flush_() override {
+            }
+
+        private:
+            int m_Connection;
+            bool m_Disconnected = false;
+            std::string m_Buffer;
+        };
+
+#if defined(CFXS_PLATFORM_LINUX)
+        bool MakeAddress(const std::filesystem::path& path, sockaddr_un& address) {
+            auto str = path.string();
+            if (str.size() >= sizeof(address.sun_path)) {
+                LOG_ERROR("Socket path too long \"{}\"", str);
+                return false;
+            }
+            std::memset(&address, 0, sizeof(address));
+            address.sun_family = AF_UNIX;
+            std::memcpy(address.sun_path, str.c_str(), str.size() + 1);
+            return true;
+        }
+
+        int Connect(const std::filesystem::path& path) {
+            sockaddr_un address;
+            if (!MakeAddress(path, address))
+                return -1;
+            int s = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (s < 0)
+                return -1;
+            if (connect(s, reinterpret_cast<sockaddr*>(&address), sizeof(address))) {
+                close(s);
+                return -1;
+            }
+            return s;
+        }
+#endif
+
+    } // namespace
+
+    CompileServer::CompileServer(Handler handler) : m_Handler(std::move(handler)) {
+    }
+
+    CompileServer::~CompileServer() {
+#if defined(CFXS_PLATFORM_LINUX)
+        if (m_Socket >= 0) {
+            close(m_Socket);
+            std::error_code ec;
+            std::filesystem::remove(m_Path, ec);
+        }
+#endif
+    }
+
+#if defined(CFXS_PLATFORM_LINUX)
+    bool CompileServer::Listen(const std::filesystem::path& socket_path) {
+        sockaddr_un address;
+        if (!MakeAddress(socket_path, address))
+            return false;
+
+        // a socket file left by a server that did not exit cleanly refuses connections
+        if (std::filesystem::exists(socket_path)) {
+            int existing = Connect(socket_path);
+            if (existing >= 0) {
+                close(existing);
+                LOG_ERROR("[Server] Already running on \"{}\"", socket_path.string());
+                return false;
+            }
+            std::error_code ec;
+            std::filesystem::remove(socket_path, ec);
+        }
+
+        m_Socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (m_Socket < 0 || bind(m_Socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) || listen(m_Socket, 16)) {
+            LOG_ERROR("[Server] Failed to listen on \"{}\": {}", socket_path.string(), std::strerror(errno));
+            if (m_Socket >= 0)
+                close(m_Socket);
+            m_Socket = -1;
+            return false;
+        }
+        m_Path = socket_path;
+        return true;
+    }
+
+    bool CompileServer::Run(const std::filesystem::path& socket_path) {
+        if (!Listen(socket_path))
+            return false;
+
+        // client sinks filter by the requested level, server output keeps the server level
+        auto& logger = Logger::GetCoreLogger();
+        for (auto& sink : logger->sinks())
+            sink->set_level(logger->level());
+        logger->set_level(spdlog::level::trace);
+
+        LOG_INFO("[Server] Listening on \"{}\"", socket_path.string());
+        while (!m_Stop) {
+            int connection = accept4(m_Socket, nullptr, nullptr, SOCK_CLOEXEC);
+            if (connection < 0) {
+                if (errno == EINTR)
+                    continue;
+                LOG_ERROR("[Server] accept failed: {}", std::strerror(errno));
+                return false;
+            }
+            Serve(connection);
+            close(connection);
+        }
+        LOG_INFO("[Server] Shutdown");
+        return true;
+    }
+
+    void CompileServer::Serve(int connection) {
+        Protocol::FrameType type;
+        std::string payload;
+        if (!Protocol::ReadFrame(connection, type, payload))
+            return;
+
+        if (type == Protocol::FrameType::SHUTDOWN) {
+            m_Stop = true;
+            int32_t code = 0;
+            Protocol::WriteFrame(connection, Protocol::FrameType::EXIT, {reinterpret_cast<const char*>(&code), sizeof(code)});
+            return;
+        }
+
+        Protocol::Request request;
+        if (type != Protocol::FrameType::REQUEST || !Protocol::DecodeRequest(payload, request)) {
+            LOG_WARN("[Server] Invalid request");
+            return;
+        }
+
+        auto start   = std::chrono::steady_clock::now();
+        auto& logger = Logger::GetCoreLogger();
+        auto sink    = std::make_shared<ClientSink>(connection);
+        sink->set_level(request.log_level);
+        logger->sinks().push_back(sink);
+
+        std::error_code ec;
+        auto server_directory = std::filesystem::current_path();
+        std::filesystem::current_path(request.working_directory, ec);
+
+        int32_t code = -1;
+        if (ec) {
+            LOG_ERROR("Invalid working directory \"{}\"", request.working_directory);
+        } else {
+            try {
+                code = m_Handler(request.arguments);
+            } catch (const std::exception& e) {
+                LOG_CRITICAL("{}", e.what());
+            }
+        }
+
+        logger->flush();
+        logger->sinks().pop_back();
+        std::filesystem::current_path(server_directory, ec);
+
+        Protocol::WriteFrame(connection, Protocol::FrameType::EXIT, {reinterpret_cast<const char*>(&code), sizeof(code)});
+        LOG_DEBUG("[Server] Request in \"{}\" - exit code {}, {:.3f}ms",
+                  request.working_directory,
+                  code,
+                  std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    int CompileClient::Run(const std::filesystem::path& socket_path, const std::vector<std::string>& arguments, spdlog::level::level_enum log_level) {
+        int connection = Connect(socket_path);
+        if (connection < 0) {
+            LOG_ERROR("Failed to connect to server \"{}\"", socket_path.string());
+            return -1;
+        }
+
+        Protocol::Request request{log_level, std::filesystem::current_path().string(), arguments};
+        if (!Protocol::WriteFrame(connection, Protocol::FrameType::REQUEST, Protocol::EncodeRequest(request))) {
+            LOG_ERROR("Failed to send request to server");
+            close(connection);
+            return -1;
+        }
+
+        Protocol::FrameType type;
+        std::string payload;
+        while (Protocol::ReadFrame(connection, type, payload)) {
+            if (type == Protocol::FrameType::LOG && !payload.empty()) {
+                auto level = static_cast<spdlog::level::level_enum>(payload[0]);
+                Logger::GetCoreLogger()->log(level, "{}", std::string_view{payload}.substr(1));
+            } else if (type == Protocol::FrameType::EXIT && payload.size() == sizeof(int32_t)) {
+                int32_t code;
+                std::memcpy(&code, payload.data(), sizeof(code));
+                close(connection);
+                return code;
+            }
+        }
+
+        LOG_ERROR("Server closed the connection");
+        close(connection);
+        return -1;
+    }
+
+    bool CompileClient::Shutdown(const std::filesystem::path& socket_path) {
+        int connection = Connect(socket_path);
+        if (connection < 0) {
+            LOG_ERROR("Failed to connect to server \"{}\"", socket_path.string());
+            return false;
+        }
+
+        Protocol::FrameType type;
+        std::string payload;
+        bool ok = Protocol::WriteFrame(connection, Protocol::FrameType::SHUTDOWN, {}) && Protocol::ReadFrame(connection, type, payload);
+        close(connection);
+        return ok;
+    }
+#else
+    bool CompileServer::Run(const std::filesystem::path&) {
+        LOG_ERROR("--server is only supported on Linux");
+        return false;
+    }
+
+    int CompileClient::Run(const std::filesystem::path&, const std::vector<std::string>&, spdlog::level::level_enum) {
+        LOG_ERROR("--connect is only supported on Linux");
+        return -1;
+    }
+
+    bool CompileClient::Shutdown(const std::filesystem::path&) {
+        LOG_ERROR("--connect is only supported on Linux");
+        return false;
+    }
+#endif
+
+} // namespace XRT
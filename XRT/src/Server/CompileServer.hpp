@@ -0,0 +1,49 @@
+#pragma once
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+#include "Protocol.hpp"
+
+namespace XRT {
+
+    /// Resident compiler process - serves compile requests from CompileClient over a Unix domain socket one at a time.
+    /// Log output of a request is forwarded to the requesting client. State that should stay warm between requests
+    /// (CompilationSession) is owned by the handler.
+    class CompileServer {
+    public:
+        /// Runs one request with the working directory of the client - returns the exit code
+        using Handler = std::function<int(const std::vector<std::string>& arguments)>;
+
+    public:
+        CompileServer(Handler handler);
+        ~CompileServer();
+
+        CompileServer(const CompileServer&)            = delete;
+        CompileServer& operator=(const CompileServer&) = delete;
+
+        /// Serve until a SHUTDOWN request - false if the socket could not be opened
+        bool Run(const std::filesystem::path& socket_path);
+
+    private:
+        bool Listen(const std::filesystem::path& socket_path);
+        void Serve(int connection);
+
+    private:
+        Handler m_Handler;
+        std::filesystem::path m_Path;
+        int m_Socket = -1;
+        bool m_Stop  = false;
+    };
+
+    /// Thin client for a CompileServer
+    class CompileClient {
+    public:
+        /// Send arguments to the server and replay its log output through the local logger - returns the remote exit code
+        static int Run(const std::filesystem::path& socket_path, const std::vector<std::string>& arguments, spdlog::level::level_enum log_level);
+
+        /// Ask the server to exit
+        static bool Shutdown(const std::filesystem::path& socket_path);
+    };
+
+} // namespace XRT
@@ -0,0 +1,302 @@
+#include "Json.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <spdlog/fmt/fmt.h>
+
+namespace XRT {
+
+    namespace {
+
+        class JsonReader {
+        public:
+            JsonReader(std::string_view text) : m_Text(text) {
+            }
+
+            bool ReadDocument(Json& out) {
+                if (!ReadValue(out, 0))
+                    return false;
+                SkipSpace();
+                return m_Pos == m_Text.size();
+            }
+
+        private:
+            static constexpr uint32_t MAX_DEPTH = 256;
+
+            void SkipSpace() {
+                while (m_Pos < m_Text.size() && (m_Text[m_Pos] == ' ' || m_Text[m_Pos] == '\t' || m_Text[m_Pos] == '\r' || m_Text[m_Pos] == '\n'))
+                    m_Pos++;
+            }
+
+            bool Consume(std::string_view word) {
+                if (m_Text.substr(m_Pos, word.size()) != word)
+                    return false;
+                m_Pos += word.size();
+                return true;
+            }
+
+            bool ReadValue(Json& out, uint32_t depth) {
+                SkipSpace();
+                if (m_Pos >= m_Text.size() || depth > MAX_DEPTH)
+                    return false;
+
+                switch (m_Text[m_Pos]) {
+                    case '{': {
+                        m_Pos++;
+                        out = Json::Object();
+                        SkipSpace();
+                        if (m_Pos < m_Text.size() && m_Text[m_Pos] == '}') {
+                            m_Pos++;
+                            return true;
+                        }
+                        while (true) {
+                            std::string key;
+                            Json value;
+                            SkipSpace();
+                            if (!ReadString(key))
+                                return false;
+                            SkipSpace();
+                            if (!Consume(":") || !ReadValue(value, depth + 1))
+                                return false;
+                            out.Set(key, std::move(value));
+                            SkipSpace();
+                            if (Consume("}"))
+                                return true;
+                            if (!Consume(","))
+                                return false;
+                        }
+                    }
+                    case '[': {
+                        m_Pos++;
+                        out = Json::Array();
+                        SkipSpace();
+                        if (Consume("]"))
+                            return true;
+                        while (true) {
+                            Json value;
+                            if (!ReadValue(value, depth + 1))
+                                return false;
+                            out.Push(std::move(value));
+                            SkipSpace();
+                            if (Consume("]"))
+                                return true;
+                            if (!Consume(","))
+                                return false;
+                        }
+                    }
+                    case '"': {
+                        std::string str;
+                        if (!ReadString(str))
+                            return false;
+                        out = Json{std::move(str)};
+                        return true;
+                    }
+                    case 't': out = Json{true}; return Consume("true");
+                    case 'f': out = Json{false}; return Consume("false");
+                    case 'n': out = Json{}; return Consume("null");
+                    default: {
+                        std::string number{m_Text.substr(m_Pos, std::min<size_t>(m_Text.size() - m_Pos, 64))};
+                        char* end;
+                        auto value = std::strtod(number.c_str(), &end);
+                        if (end == number.c_str())
+                            return false;
+                        m_Pos += static_cast<size_t>(end - number.c_str());
+                        out = Json{value};
+                        return true;
+                    }
+                }
+            }
+
+            bool ReadHex(uint32_t& value) {
+                if (m_Pos + 4 > m_Text.size())
+                    return false;
+                value = 0;
+                for (int i = 0; i < 4; i++) {
+                    auto c = m_Text[m_Pos++];
+                    value <<= 4;
+                    if (c >= '0' && c <= '9')
+                        value |= static_cast<uint32_t>(c - '0');
+                    else if (c >= 'a' && c <= 'f')
+                        value |= static_cast<uint32_t>(c - 'a' + 10);
+                    else if (c >= 'A' && c <= 'F')
+                        value |= static_cast<uint32_t>(c - 'A' + 10);
+                    else
+                        return false;
+                }
+                return true;
+            }
+
+            static void AppendUTF8(std::string& out, uint32_t cp) {
+                if (cp < 0x80) {
+                    out += static_cast<char>(cp);
+                } else if (cp < 0x800) {
+                    out += static_cast<char>(0xC0 | (cp >> 6));
+                    out += static_cast<char>(0x80 | (cp & 0x3F));
+                } else if (cp < 0x10000) {
+                    out += static_cast<char>(0xE0 | (cp >> 12));
+                    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (cp & 0x3F));
+                } else {
+                    out += static_cast<char>(0xF0 | (cp >> 18));
+                    out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+                    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (cp & 0x3F));
+                }
+            }
+
+            bool ReadString(std::string& out) {
+                if (!Consume("\""))
+                    return false;
+                while (m_Pos < m_Text.size()) {
+                    auto c = m_Text[m_Pos++];
+                    if (c == '"')
+                        return true;
+                    if (c != '\\') {
+                        out += c;
+                        continue;
+                    }
+                    if (m_Pos >= m_Text.size())
+                        return false;
+                    switch (m_Text[m_Pos++]) {
+                        case '"': out += '"'; break;
+                        case '\\': out += '\\'; break;
+                        case '/': out += '/'; break;
+                        case 'b': out += '\b'; break;
+                        case 'f': out += '\f'; break;
+                        case 'n': out += '\n'; break;
+                        case 'r': out += '\r'; break;
+                        case 't': out += '\t'; break;
+                        case 'u': {
+                            uint32_t cp;
+                            if (!ReadHex(cp))
+                                return false;
+                            // surrogate pair
+                            if (cp >= 0xD800 && cp < 0xDC00 && Consume("\\u")) {
+                                uint32_t low;
+                                if (!ReadHex(low) || low < 0xDC00 || low >= 0xE000)
+                                    return false;
+                                cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                            }
+                            AppendUTF8(out, cp);
+                            break;
+                        }
+                        default: return false;
+                    }
+                }
+                return false;
+            }
+
+        private:
+            std::string_view m_Text;
+            size_t m_Pos = 0;
+        };
+
+        void EscapeString(std::string& out, std::string_view str) {
+            for (auto c : str) {
+                switch (c) {
+                    case '"': out += "\\\""; break;
+                    case '\\': out += "\\\\"; break;
+                    case '\n': out += "\\n"; break;
+                    case '\r': out += "\\r"; break;
+                    case '\t': out += "\\t"; break;
+                    default:
+                        if (static_cast<unsigned char>(c) < 0x20)
+                            out += fmt::format("\\u{:04x}", static_cast<unsigned>(c));
+                        else
+                            out += c;
+                }
+            }
+        }
+
+        void DumpString(std::string& out, const std::string& str) {
+            out += '"';
+            EscapeString(out, str);
+            out += '"';
+        }
+
+    } // namespace
+
+    std::string Json::Escape(std::string_view str) {
+        std::string out;
+        out.reserve(str.size());
+        EscapeString(out, str);
+        return out;
+    }
+
+    std::optional<Json> Json::Parse(std::string_view text) {
+        Json json;
+        JsonReader reader(text);
+        if (!reader.ReadDocument(json))
+            return std::nullopt;
+        return json;
+    }
+
+    const Json& Json::operator[](std::string_view key) const {
+        static const Json s_Null;
+        for (auto& [k, v] : m_Object) {
+            if (k == key)
+                return v;
+        }
+        return s_Null;
+    }
+
+    Json& Json::Set(std::string_view key, Json value) {
+        m_Type = Type::OBJECT;
+        for (auto& [k, v] : m_Object) {
+            if (k == key) {
+                v = std::move(value);
+                return *this;
+            }
+        }
+        m_Object.emplace_back(key, std::move(value));
+        return *this;
+    }
+
+    Json& Json::Push(Json value) {
+        m_Type = Type::ARRAY;
+        m_Array.push_back(std::move(value));
+        return *this;
+    }
+
+    std::string Json::Dump() const {
+        std::string out;
+        Dump(out);
+        return out;
+    }
+
+    void Json::Dump(std::string& out) const {
+        switch (m_Type) {
+            case Type::NUL: out += "null"; break;
+            case Type::BOOL: out += m_Bool ? "true" : "false"; break;
+            case Type::NUMBER:
+                if (std::isfinite(m_Number) && m_Number == std::floor(m_Number) && std::fabs(m_Number) < 1e15)
+                    out += fmt::format("{}", static_cast<int64_t>(m_Number));
+                else
+                    out += fmt::format("{}", std::isfinite(m_Number) ? m_Number : 0.0);
+                break;
+            case Type::STRING: DumpString(out, m_String); break;
+            case Type::ARRAY: {
+                out += '[';
+                for (size_t i = 0; i < m_Array.size(); i++) {
+                    if (i)
+                        out += ',';
+                    m_Array[i].Dump(out);
+                }
+                out += ']';
+                break;
+            }
+            case Type::OBJECT: {
+                out += '{';
+                for (size_t i = 0; i < m_Object.size(); i++) {
+                    if (i)
+                        out += ',';
+                    DumpString(out, m_Object[i].first);
+                    out += ':';
+                    m_Object[i].second.Dump(out);
+                }
+                out += '}';
+                break;
+            }
+        }
+    }
+
+} // namespace XRT
@@ -0,0 +1,109 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace XRT {
+
+    /// Minimal JSON value for protocol messages - objects keep insertion order and are searched linearly
+    class Json {
+    public:
+        enum class Type : uint8_t {
+            NUL,
+            BOOL,
+            NUMBER,
+            STRING,
+            ARRAY,
+            OBJECT,
+        };
+
+    public:
+        Json() = default;
+        Json(std::nullptr_t) {
+        }
+        Json(bool value) : m_Type(Type::BOOL), m_Bool(value) {
+        }
+        template<typename T, typename = std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>>>
+        Json(T value) : m_Type(Type::NUMBER), m_Number(static_cast<double>(value)) {
+        }
+        Json(const char* value) : m_Type(Type::STRING), m_String(value) {
+        }
+        Json(std::string value) : m_Type(Type::STRING), m_String(std::move(value)) {
+        }
+        Json(std::string_view value) : m_Type(Type::STRING), m_String(value) {
+        }
+
+        static Json Array() {
+            Json json;
+            json.m_Type = Type::ARRAY;
+            return json;
+        }
+        static Json Object() {
+            Json json;
+            json.m_Type = Type::OBJECT;
+            return json;
+        }
+
+        /// nullopt on syntax error
+        static std::optional<Json> Parse(std::string_view text);
+        std::string Dump() const;
+
+        /// String contents with JSON escapes, without quotes - for writers that format JSON text directly
+        static std::string Escape(std::string_view str);
+
+        Type GetType() const {
+            return m_Type;
+        }
+        bool IsNull() const {
+            return m_Type == Type::NUL;
+        }
+        bool IsString() const {
+            return m_Type == Type::STRING;
+        }
+        bool IsNumber() const {
+            return m_Type == Type::NUMBER;
+        }
+
+        bool GetBool(bool fallback = false) const {
+            return m_Type == Type::BOOL ? m_Bool : fallback;
+        }
+        double GetNumber(double fallback = 0) const {
+            return m_Type == Type::NUMBER ? m_Number : fallback;
+        }
+        size_t GetSize(size_t fallback = 0) const {
+            return m_Type == Type::NUMBER && m_Number >= 0 ? static_cast<size_t>(m_Number) : fallback;
+        }
+        const std::string& GetString() const {
+            return m_String; // empty if not a string
+        }
+
+        /// Array elements, empty if not an array
+        const std::vector<Json>& GetArray() const {
+            return m_Array;
+        }
+
+        /// Object member - null value if missing or not an object
+        const Json& operator[](std::string_view key) const;
+
+        /// Add or replace an object member
+        Json& Set(std::string_view key, Json value);
+        /// Append an array element
+        Json& Push(Json value);
+
+    private:
+        void Dump(std::string& out) const;
+
+    private:
+        Type m_Type     = Type::NUL;
+        bool m_Bool     = false;
+        double m_Number = 0;
+        std::string m_String;
+        std::vector<Json> m_Array;
+        std::vector<std::pair<std::string, Json>> m_Object;
+    };
+
+} // namespace XRT
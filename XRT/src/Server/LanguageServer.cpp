@@ -0,0 +1,730 @@
+#include "LanguageServer.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include "Log/Logger.hpp"
+#include "Profiler.hpp"
+#include "StringUtils.hpp"
+#if defined(CFXS_PLATFORM_WINDOWS)
+    #include <fcntl.h>
+    #include <io.h>
+#endif
+
+namespace XRT {
+
+    namespace {
+
+        enum CompletionItemKind : int {
+            FIELD          = 5,
+            VARIABLE       = 6,
+            CLASS          = 7,
+            MODULE         = 9,
+            CONSTANT       = 21,
+            TYPE_PARAMETER = 25,
+        };
+
+        int GetCompletionKind(SymbolIndex::SymbolKind kind) {
+            switch (kind) {
+                case SymbolIndex::SymbolKind::NAMESPACE: return MODULE;
+                case SymbolIndex::SymbolKind::COMPONENT: return CLASS;
+                case SymbolIndex::SymbolKind::PARAMETER: return TYPE_PARAMETER;
+                case SymbolIndex::SymbolKind::REGISTER: return FIELD;
+                case SymbolIndex::SymbolKind::PORT: return VARIABLE;
+                case SymbolIndex::SymbolKind::ALIAS: return CONSTANT;
+                default: return VARIABLE;
+            }
+        }
+
+        std::filesystem::path UriToPath(std::string_view uri) {
+            if (uri.starts_with("file://"))
+                uri.remove_prefix(7);
+            std::string path;
+            for (size_t i = 0; i < uri.size(); i++) {
+                if (uri[i] == '%' && i + 2 < uri.size()) {
+                    path += static_cast<char>(std::strtol(std::string{uri.substr(i + 1, 2)}.c_str(), nullptr, 16));
+                    i += 2;
+                } else {
+                    path += uri[i];
+                }
+            }
+#if defined(CFXS_PLATFORM_WINDOWS)
+            if (path.size() > 2 && path[0] == '/' && path[2] == ':')
+                path.erase(0, 1); // /C:/dir
+#endif
+            return std::filesystem::path{path}.lexically_normal();
+        }
+
+        std::string PathToUri(const std::filesystem::path& path) {
+            static constexpr char HEX[] = "0123456789ABCDEF";
+            auto str = path.generic_string();
+            std::string uri{str.starts_with('/') ? "file://" : "file:///"};
+            for (auto c : str) {
+                auto u = static_cast<unsigned char>(c);
+                if (std::isalnum(u) || c == '/' || c == '-' || c == '_' || c == '.' || c == '~' || c == ':') {
+                    uri += c;
+                } else {
+                    uri += '%';
+                    uri += HEX[u >> 4];
+                    uri += HEX[u & 15];
+                }
+            }
+            return uri;
+        }
+
+        SymbolIndex::Location GetLocation(const Token* tok) {
+            return {static_cast<uint32_t>(tok->line), static_cast<uint32_t>(tok->column)};
+        }
+
+        int64_t GetWriteTime(const std::filesystem::path& path, uint64_t& size) {
+            std::error_code ec;
+            auto write_time = std::filesystem::last_write_time(path, ec);
+            size            = ec ? 0 : std::filesystem::file_size(path, ec);
+            return ec ? 0 : int64_t{write_time.time_since_epoch().count()};
+        }
+
+        /// container is qualifier or ends with ::qualifier
+        bool MatchesQualifier(const std::wstring& container, const std::wstring& qualifier) {
+            if (container == qualifier)
+                return true;
+            return container.size() > qualifier.size() + 2 && container.ends_with(qualifier) &&
+                   container.compare(container.size() - qualifier.size() - 2, 2, L"::") == 0;
+        }
+
+    } // namespace
+
+    LanguageServer::LanguageServer(std::filesystem::path index_path) : m_IndexPath(std::move(index_path)) {
+    }
+
+    LanguageServer::~LanguageServer() {
+        if (m_Reader.joinable())
+            m_Reader.join();
+    }
+
+    int LanguageServer::Run() {
+#if defined(CFXS_PLATFORM_WINDOWS)
+        _setmode(_fileno(stdin), _O_BINARY);
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        LOG_INFO("[LSP] Serving on stdio");
+        m_Reader = std::thread(&LanguageServer::ReaderMain, this);
+
+        while (!m_Exit) {
+            std::deque<Json> batch;
+            {
+                std::unique_lock lock(m_QueueLock);
+                bool idle = m_IndexQueue.empty() && std::none_of(m_Documents.begin(), m_Documents.end(), [](auto& e) {
+                                return e.second->diagnostics_pending || e.second->index_pending;
+                            });
+                if (idle) {
+                    m_QueueSignal.wait(lock, [this] {
+                        return !m_Queue.empty() || m_InputClosed;
+                    });
+                }
+                if (m_Queue.empty() && m_InputClosed)
+                    break;
+                batch.swap(m_Queue);
+            }
+
+            while (!batch.empty() && !m_Exit) {
+                auto message = std::move(batch.front());
+                batch.pop_front();
+                Handle(message, batch);
+            }
+
+            // background work yields to every new message
+            if (m_Exit || HasQueued())
+                continue;
+            PublishDiagnostics();
+            if (!HasQueued())
+                IndexNext();
+        }
+
+        if (m_IndexChanged)
+            m_Index.Write(m_IndexPath);
+        LOG_INFO("[LSP] Exit");
+        return m_Shutdown ? 0 : 1;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    // Transport
+
+    void LanguageServer::ReaderMain() {
+        std::string header;
+        std::string body;
+        while (true) {
+            // Content-Length: N\r\n ... \r\n\r\n
+            size_t length = SIZE_MAX;
+            bool closed   = false;
+            while (true) {
+                header.clear();
+                int c;
+                while ((c = std::getchar()) != EOF && c != '\n')
+                    header += static_cast<char>(c);
+                if (c == EOF) {
+                    closed = true;
+                    break;
+                }
+                if (!header.empty() && header.back() == '\r')
+                    header.pop_back();
+                if (header.empty())
+                    break;
+                if (header.starts_with("Content-Length:"))
+                    length = std::strtoull(header.c_str() + 15, nullptr, 10);
+            }
+            if (closed)
+                break;
+            if (length == SIZE_MAX) {
+                LOG_ERROR("[LSP] Message without Content-Length");
+                continue;
+            }
+
+            body.resize(length);
+            if (std::fread(body.data(), 1, length, stdin) != length)
+                break;
+            auto message = Json::Parse(body);
+            if (!message) {
+                LOG_ERROR("[LSP] Invalid message: {}", body);
+                continue;
+            }
+
+            auto& method = (*message)["method"].GetString();
+            std::lock_guard lock(m_QueueLock);
+            if (method == "$/cancelRequest") {
+                // cheaper to note here than to queue - the request may already be waiting
+                if (m_Cancelled.size() > 1024)
+                    m_Cancelled.clear();
+                m_Cancelled.insert((*message)["params"]["id"].Dump());
+                continue;
+            }
+            bool exit = method == "exit";
+            m_Queue.push_back(std::move(*message));
+            m_QueueSignal.notify_one();
+            if (exit)
+                return;
+        }
+
+        std::lock_guard lock(m_QueueLock);
+        m_InputClosed = true;
+        m_QueueSignal.notify_one();
+    }
+
+    bool LanguageServer::HasQueued() {
+        std::lock_guard lock(m_QueueLock);
+        return !m_Queue.empty();
+    }
+
+    void LanguageServer::Send(const Json& message) {
+        auto body = message.Dump();
+        std::fprintf(stdout, "Content-Length: %zu\r\n\r\n", body.size());
+        std::fwrite(body.data(), 1, body.size(), stdout);
+        std::fflush(stdout);
+    }
+
+    void LanguageServer::Respond(const Json& id, Json result) {
+        auto message = Json::Object();
+        message.Set("jsonrpc", "2.0").Set("id", id).Set("result", std::move(result));
+        Send(message);
+    }
+
+    void LanguageServer::RespondError(const Json& id, int code, const std::string& text) {
+        auto error = Json::Object();
+        error.Set("code", code).Set("message", text);
+        auto message = Json::Object();
+        message.Set("jsonrpc", "2.0").Set("id", id).Set("error", std::move(error));
+        Send(message);
+    }
+
+    void LanguageServer::Handle(const Json& message, const std::deque<Json>& later) {
+        auto& method = message["method"].GetString();
+        auto& id     = message["id"];
+        auto& params = message["params"];
+        if (id.IsNull()) {
+            HandleNotification(method, params);
+            return;
+        }
+        if (method.empty())
+            return; // response - the server sends no requests
+
+        // a newer request of the same kind for the same document replaces this one
+        auto& uri       = params["textDocument"]["uri"].GetString();
+        auto supersedes = [&](const Json& m) {
+            return !m["id"].IsNull() && m["method"].GetString() == method && m["params"]["textDocument"]["uri"].GetString() == uri;
+        };
+        bool cancelled;
+        bool superseded = !uri.empty() && std::any_of(later.begin(), later.end(), supersedes);
+        {
+            std::lock_guard lock(m_QueueLock);
+            cancelled = m_Cancelled.erase(id.Dump()) > 0;
+            superseded |= !uri.empty() && std::any_of(m_Queue.begin(), m_Queue.end(), supersedes);
+        }
+        if (cancelled || superseded) {
+            LOG_TRACE("[LSP] {} {} {}", method, id.Dump(), cancelled ? "cancelled" : "superseded");
+            RespondError(id, REQUEST_CANCELLED, cancelled ? "Request cancelled" : "Request superseded");
+            return;
+        }
+        if (!m_Initialized && method != "initialize") {
+            RespondError(id, INVALID_REQUEST, "Server not initialized");
+            return;
+        }
+
+        auto start  = std::chrono::steady_clock::now();
+        auto result = HandleRequest(method, params);
+        auto time   = std::chrono::steady_clock::now() - start;
+        if (!result) {
+            RespondError(id, METHOD_NOT_FOUND, "Unknown method " + method);
+            return;
+        }
+        Respond(id, std::move(*result));
+
+        auto ms = std::chrono::duration<double, std::milli>(time).count();
+        if (time > REQUEST_BUDGET)
+            LOG_WARN("[LSP] {} took {:.1f}ms", method, ms);
+        else
+            LOG_TRACE("[LSP] {} {:.3f}ms", method, ms);
+    }
+
+    std::optional<Json> LanguageServer::HandleRequest(const std::string& method, const Json& params) {
+        XRT_PROFILE_SCOPE("LanguageServer::HandleRequest");
+        if (method == "initialize")
+            return Initialize(params);
+        if (method == "shutdown") {
+            m_Shutdown = true;
+            return Json{};
+        }
+        if (method == "textDocument/definition")
+            return Definition(params);
+        if (method == "textDocument/references")
+            return References(params);
+        if (method == "textDocument/completion")
+            return Completion(params);
+        return std::nullopt;
+    }
+
+    void LanguageServer::HandleNotification(const std::string& method, const Json& params) {
+        XRT_PROFILE_SCOPE("LanguageServer::HandleNotification");
+        if (method == "initialized")
+            LoadWorkspace();
+        else if (method == "exit")
+            m_Exit = true;
+        else if (method == "textDocument/didOpen")
+            OpenDocument(params);
+        else if (method == "textDocument/didChange")
+            ChangeDocument(params);
+        else if (method == "textDocument/didClose")
+            CloseDocument(params);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    // Lifecycle
+
+    Json LanguageServer::Initialize(const Json& params) {
+        if (!params["rootUri"].GetString().empty())
+            m_Root = UriToPath(params["rootUri"].GetString());
+        else if (!params["rootPath"].GetString().empty())
+            m_Root = params["rootPath"].GetString();
+        else if (!params["workspaceFolders"].GetArray().empty())
+            m_Root = UriToPath(params["workspaceFolders"].GetArray().front()["uri"].GetString());
+        else
+            m_Root = std::filesystem::current_path();
+        m_Root = std::filesystem::absolute(m_Root).lexically_normal();
+        if (m_IndexPath.empty())
+            m_IndexPath = m_Root / ".xrt" / "symbols.xsi";
+
+        m_Initialized = true;
+
+        auto sync = Json::Object();
+        sync.Set("openClose", true).Set("change", 2); // incremental
+        auto completion = Json::Object();
+        completion.Set("triggerCharacters", Json::Array().Push(":"));
+        auto capabilities = Json::Object();
+        // sources are stored as utf-16 (astral characters as surrogate pairs) - columns are utf-16 code units
+        capabilities.Set("positionEncoding", "utf-16")
+            .Set("textDocumentSync", std::move(sync))
+            .Set("definitionProvider", true)
+            .Set("referencesProvider", true)
+            .Set("completionProvider", std::move(completion));
+        auto info = Json::Object();
+        info.Set("name", CFXS_PROGRAM_NAME).Set("version", CFXS_VERSION_STRING);
+
+        auto result = Json::Object();
+        result.Set("capabilities", std::move(capabilities)).Set("serverInfo", std::move(info));
+        return result;
+    }
+
+    void LanguageServer::LoadWorkspace() {
+        XRT_PROFILE_SCOPE("LanguageServer::LoadWorkspace");
+        auto start  = std::chrono::steady_clock::now();
+        bool cached = m_Index.Read(m_IndexPath);
+
+        std::unordered_set<std::string> found;
+        std::error_code ec;
+        auto it = std::filesystem::recursive_directory_iterator(m_Root, std::filesystem::directory_options::skip_permission_denied, ec);
+        for (; !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+            auto& path = it->path();
+            if (it->is_directory(ec)) {
+                if (path.filename().string().starts_with('.'))
+                    it.disable_recursion_pending(); // .git, .xrt
+                continue;
+            }
+            auto ext = path.extension().string();
+            std::transform(ext.begin(), ext.end(), ext.begin(), [](char c) {
+                return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            });
+            if (ext != ".xdl")
+                continue;
+
+            auto normal = path.lexically_normal();
+            found.insert(normal.generic_string());
+            uint64_t size;
+            auto write_time = GetWriteTime(normal, size);
+            auto file       = m_Index.GetFile(normal);
+            if (!file || file->write_time != write_time || file->size != size)
+                m_IndexQueue.push_back(normal);
+        }
+
+        for (auto file : m_Index.GetFiles()) {
+            if (!found.contains(file->path.lexically_normal().generic_string()) && file->write_time) {
+                m_Index.Remove(file->path);
+                m_IndexChanged = true;
+            }
+        }
+
+        auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        LOG_INFO("[LSP] Workspace \"{}\": {} sources, {} from {}, {} to index ({:.1f}ms)",
+                 m_Root.string(),
+                 found.size(),
+                 found.size() - m_IndexQueue.size(),
+                 cached ? m_IndexPath.string() : "no index",
+                 m_IndexQueue.size(),
+                 ms);
+    }
+
+    void LanguageServer::IndexNext() {
+        // one file per call - new messages are served in between
+        while (!m_IndexQueue.empty()) {
+            auto path = std::move(m_IndexQueue.front());
+            m_IndexQueue.pop_front();
+            bool open = std::any_of(m_Documents.begin(), m_Documents.end(), [&](auto& e) {
+                return e.second->path == path;
+            });
+            if (open)
+                continue; // the editor content wins
+
+            uint64_t size;
+            auto write_time = GetWriteTime(path, size);
+            std::ifstream file(path, std::ios::binary);
+            m_IndexChanged = true;
+            if (!write_time || !file.is_open()) {
+                m_Index.Remove(path);
+                return;
+            }
+            std::stringstream ss;
+            ss << file.rdbuf();
+            SourceDocument source(path);
+            source.Open(StringUtils::utf8_to_utf16(ss.str()));
+            m_Index.Update(path, source.GetTokens(), *source.GetAST(), write_time, size);
+            if (m_IndexQueue.empty())
+                LOG_INFO("[LSP] Workspace indexed - {} sources", m_Index.GetFileCount());
+            return;
+        }
+
+        if (m_IndexChanged) {
+            m_Index.Write(m_IndexPath);
+            m_IndexChanged = false;
+        }
+    }
+
+    void LanguageServer::IndexDocument(Document& doc) {
+        m_Index.Update(doc.path, doc.source->GetTokens(), *doc.source->GetAST());
+        doc.index_pending = false;
+    }
+
+    void LanguageServer::PublishDiagnostics() {
+        XRT_PROFILE_SCOPE("LanguageServer::PublishDiagnostics");
+        for (auto& [uri, doc] : m_Documents) {
+            if (HasQueued())
+                return; // a newer edit makes these stale
+            if (doc->index_pending)
+                IndexDocument(*doc);
+            if (!doc->diagnostics_pending)
+                continue;
+            doc->diagnostics_pending = false;
+
+            auto diagnostics = Json::Array();
+            for (auto& d : doc->source->GetDiagnostics()) {
+                auto line   = d.line ? d.line - 1 : 0;
+                auto column = d.column ? d.column - 1 : 0;
+                auto range  = Json::Object();
+                range.Set("start", Json::Object().Set("line", line).Set("character", column));
+                range.Set("end", Json::Object().Set("line", line).Set("character", column + 1));
+                auto diagnostic = Json::Object();
+                diagnostic.Set("range", std::move(range))
+                    .Set("severity", d.severity == Diagnostic::Severity::ERROR ? 1 : 2)
+                    .Set("source", "XRT")
+                    .Set("message", d.detail.empty() ? d.message : d.message + ": " + d.detail);
+                diagnostics.Push(std::move(diagnostic));
+            }
+            auto params = Json::Object();
+            params.Set("uri", uri).Set("version", doc->version).Set("diagnostics", std::move(diagnostics));
+            Send(Json::Object().Set("jsonrpc", "2.0").Set("method", "textDocument/publishDiagnostics").Set("params", std::move(params)));
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    // Documents
+
+    LanguageServer::Document* LanguageServer::GetDocument(const Json& params) {
+        auto it = m_Documents.find(params["textDocument"]["uri"].GetString());
+        return it == m_Documents.end() ? nullptr : it->second.get();
+    }
+
+    void LanguageServer::OpenDocument(const Json& params) {
+        auto& item   = params["textDocument"];
+        auto doc     = CreateScope<Document>();
+        doc->uri     = item["uri"].GetString();
+        doc->path    = UriToPath(doc->uri);
+        doc->version = static_cast<int64_t>(item["version"].GetNumber());
+        doc->source  = CreateScope<SourceDocument>(doc->path, &m_IncludeCache);
+        doc->source->Open(StringUtils::utf8_to_utf16(item["text"].GetString()));
+        m_Documents[doc->uri] = std::move(doc);
+    }
+
+    void LanguageServer::ChangeDocument(const Json& params) {
+        auto doc = GetDocument(params);
+        if (!doc)
+            return;
+        doc->version = static_cast<int64_t>(params["textDocument"]["version"].GetNumber());
+        for (auto& change : params["contentChanges"].GetArray()) {
+            auto text   = StringUtils::utf8_to_utf16(change["text"].GetString());
+            auto& range = change["range"];
+            if (range.IsNull()) {
+                doc->source->Open(std::move(text));
+                continue;
+            }
+            auto offset = [&](const Json& position) {
+                return doc->source->GetOffset(position["line"].GetSize() + 1, position["character"].GetSize() + 1);
+            };
+            auto begin = offset(range["start"]);
+            auto end   = std::max(begin, offset(range["end"]));
+            doc->source->Edit(begin, end - begin, text);
+        }
+        doc->diagnostics_pending = true;
+        doc->index_pending       = true;
+    }
+
+    void LanguageServer::CloseDocument(const Json& params) {
+        auto it = m_Documents.find(params["textDocument"]["uri"].GetString());
+        if (it == m_Documents.end())
+            return;
+        auto path = it->second->path;
+        m_Documents.erase(it);
+
+        auto clear = Json::Object();
+        clear.Set("uri", params["textDocument"]["uri"]).Set("diagnostics", Json::Array());
+        Send(Json::Object().Set("jsonrpc", "2.0").Set("method", "textDocument/publishDiagnostics").Set("params", std::move(clear)));
+
+        // back to the saved content
+        m_Index.Remove(path);
+        if (std::filesystem::exists(path))
+            m_IndexQueue.push_front(path);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    // Queries
+
+    LanguageServer::Cursor LanguageServer::GetCursor(Document& doc, const Json& position, bool completion) {
+        for (auto& [uri, other] : m_Documents) {
+            if (other->index_pending)
+                IndexDocument(*other);
+        }
+
+        Cursor cursor;
+        auto& tokens    = cursor.tokens;
+        auto& location  = cursor.location;
+        tokens          = doc.source->GetTokens();
+        location.line   = static_cast<uint32_t>(position["line"].GetSize() + 1);
+        location.column = static_cast<uint32_t>(position["character"].GetSize() + 1);
+
+        // tokens[i - 1] starts at or before the position
+        auto it = std::upper_bound(tokens.begin(), tokens.end(), location, [](SymbolIndex::Location l, const Token* tok) {
+            return l < GetLocation(tok);
+        });
+        auto i       = static_cast<size_t>(it - tokens.begin());
+        auto touches = [&](const Token* tok) {
+            return tok->line == location.line && location.column <= tok->column + tok->value.size();
+        };
+        if (i > 0 && tokens[i - 1]->type == TokenType::IDENTIFIER && touches(tokens[i - 1]))
+            cursor.index = i - 1;
+
+        // A::B::name, or A::B:: followed by the completion position
+        size_t j = cursor.index;
+        if (j == SIZE_MAX && completion && i > 0 && tokens[i - 1]->type == TokenType::RESOLVE && touches(tokens[i - 1]))
+            j = i;
+        std::vector<std::wstring_view> parts;
+        while (j != SIZE_MAX && j >= 2 && tokens[j - 1]->type == TokenType::RESOLVE && tokens[j - 2]->type == TokenType::IDENTIFIER) {
+            parts.push_back(tokens[j - 2]->value);
+            j -= 2;
+        }
+        for (auto part = parts.rbegin(); part != parts.rend(); part++)
+            cursor.qualifier += (cursor.qualifier.empty() ? L"" : L"::") + std::wstring{*part};
+        return cursor;
+    }
+
+    std::vector<SymbolIndex::Match> LanguageServer::Resolve(const Document& doc,
+                                                            std::wstring_view name,
+                                                            const std::wstring& qualifier,
+                                                            SymbolIndex::Location location) {
+        std::vector<SymbolIndex::Match> matches;
+
+        // members of the component around the name
+        auto file = m_Index.GetFile(doc.path);
+        if (file && qualifier.empty()) {
+            if (auto component = m_Index.FindComponent(*file, location)) {
+                for (auto member : m_Index.FindMembers(*file, *component)) {
+                    if (member->name == name)
+                        matches.push_back({file, member});
+                }
+            }
+            if (!matches.empty())
+                return matches;
+        }
+
+        matches = m_Index.FindGlobal(name);
+        if (!qualifier.empty()) {
+            std::vector<SymbolIndex::Match> qualified;
+            for (auto& match : matches) {
+                if (MatchesQualifier(match.symbol->container, qualifier))
+                    qualified.push_back(match);
+            }
+            if (!qualified.empty())
+                return qualified;
+        }
+        return matches;
+    }
+
+    Json LanguageServer::MakeLocation(const std::filesystem::path& path, SymbolIndex::Location location, size_t length) const {
+        auto line   = location.line - 1;
+        auto column = location.column - 1;
+        auto range  = Json::Object();
+        range.Set("start", Json::Object().Set("line", line).Set("character", column));
+        range.Set("end", Json::Object().Set("line", line).Set("character", column + length));
+        return Json::Object().Set("uri", PathToUri(path)).Set("range", std::move(range));
+    }
+
+    Json LanguageServer::Definition(const Json& params) {
+        auto doc = GetDocument(params);
+        if (!doc)
+            return nullptr;
+        auto cursor = GetCursor(*doc, params["position"], false);
+        if (cursor.index == SIZE_MAX)
+            return nullptr;
+
+        auto tok       = cursor.tokens[cursor.index];
+        auto locations = Json::Array();
+        for (auto& match : Resolve(*doc, tok->value, cursor.qualifier, GetLocation(tok)))
+            locations.Push(MakeLocation(match.file->path, match.symbol->location, match.symbol->name.size()));
+        return locations;
+    }
+
+    Json LanguageServer::References(const Json& params) {
+        auto doc = GetDocument(params);
+        if (!doc)
+            return nullptr;
+        auto cursor = GetCursor(*doc, params["position"], false);
+        if (cursor.index == SIZE_MAX)
+            return nullptr;
+
+        auto tok                 = cursor.tokens[cursor.index];
+        bool include_declaration = params["context"]["includeDeclaration"].GetBool(true);
+        auto definitions         = Resolve(*doc, tok->value, cursor.qualifier, GetLocation(tok));
+        auto is_declaration      = [&](const SymbolIndex::FileIndex& file, SymbolIndex::Location location) {
+            return std::any_of(definitions.begin(), definitions.end(), [&](auto& d) {
+                return d.file == &file && d.symbol->location == location;
+            });
+        };
+
+        // members are only visible in their component, everything else is searched in all files
+        const SymbolIndex::FileIndex* scope_file = nullptr;
+        const SymbolIndex::Symbol* scope         = nullptr;
+        if (definitions.size() == 1 && !definitions.front().symbol->IsGlobal()) {
+            scope_file = definitions.front().file;
+            scope      = m_Index.FindComponent(*scope_file, definitions.front().symbol->location);
+        }
+
+        auto locations = Json::Array();
+        m_Index.FindReferences(tok->value, scope_file, [&](const SymbolIndex::FileIndex& file, SymbolIndex::Location location) {
+            if (scope && (location < scope->begin || scope->end < location))
+                return;
+            if (!include_declaration && is_declaration(file, location))
+                return;
+            locations.Push(MakeLocation(file.path, location, tok->value.size()));
+        });
+        return locations;
+    }
+
+    Json LanguageServer::Completion(const Json& params) {
+        auto doc = GetDocument(params);
+        if (!doc)
+            return nullptr;
+        auto cursor = GetCursor(*doc, params["position"], true);
+
+        std::wstring prefix;
+        if (cursor.index != SIZE_MAX) {
+            auto tok = cursor.tokens[cursor.index];
+            prefix   = tok->value.substr(0, std::min<size_t>(cursor.location.column - tok->column, tok->value.size()));
+        }
+
+        auto items      = Json::Array();
+        bool incomplete = false;
+        std::unordered_set<std::wstring> added;
+        auto add = [&](const SymbolIndex::Symbol& sym) {
+            if (!sym.name.starts_with(prefix) || added.contains(sym.name))
+                return true;
+            if (added.size() >= MAX_COMPLETIONS) {
+                incomplete = true;
+                return false;
+            }
+            added.insert(sym.name);
+            auto item = Json::Object();
+            item.Set("label", StringUtils::utf16_to_utf8(sym.name))
+                .Set("kind", GetCompletionKind(sym.kind))
+                .Set("detail", StringUtils::utf16_to_utf8(sym.container));
+            items.Push(std::move(item));
+            return true;
+        };
+
+        if (!cursor.qualifier.empty()) {
+            // members of the namespaces/components the qualifier names
+            auto last = cursor.qualifier.substr(cursor.qualifier.rfind(L':') == std::wstring::npos ? 0 : cursor.qualifier.rfind(L':') + 1);
+            auto head = cursor.qualifier.size() > last.size() ? cursor.qualifier.substr(0, cursor.qualifier.size() - last.size() - 2) : std::wstring{};
+            std::unordered_set<std::wstring> scopes; // a namespace is usually opened in many files
+            for (auto& scope : m_Index.FindGlobal(last)) {
+                if (head.empty() || MatchesQualifier(scope.symbol->container, head))
+                    scopes.insert(scope.symbol->GetQualifiedName());
+            }
+            for (auto& scope : scopes) {
+                for (auto& match : m_Index.FindInContainer(scope)) {
+                    if (!add(*match.symbol))
+                        break;
+                }
+            }
+        } else {
+            auto file = m_Index.GetFile(doc->path);
+            auto comp = file ? m_Index.FindComponent(*file, cursor.location) : nullptr;
+            if (comp) {
+                for (auto member : m_Index.FindMembers(*file, *comp))
+                    add(*member);
+            }
+            m_Index.CompleteGlobal(prefix, [&](const std::wstring& name) {
+                auto matches = m_Index.FindGlobal(name);
+                return matches.empty() || add(*matches.front().symbol);
+            });
+        }
+
+        return Json::Object().Set("isIncomplete", incomplete).Set("items", std::move(items));
+    }
+
+} // namespace XRT
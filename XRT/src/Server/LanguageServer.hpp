@@ -0,0 +1,119 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <Utils.hpp>
+#include "Json.hpp"
+#include "Language/SourceDocument.hpp"
+#include "Language/SymbolIndex.hpp"
+
+namespace XRT {
+
+    /// Language Server Protocol over stdio for .xdl sources - diagnostics, go to definition, find references and completion.
+    /// Open documents are SourceDocuments updated by incremental edits. Other workspace files are only known through the
+    /// SymbolIndex, which is loaded from disk on start and brought up to date in the background between requests.
+    /// Messages are read on a separate thread. A request is dropped if it was cancelled or a newer request of the same kind
+    /// for the same document is already queued, and diagnostics are published once no newer message is waiting.
+    class LanguageServer {
+    public:
+        /// Requests slower than this are logged as warnings
+        static constexpr auto REQUEST_BUDGET = std::chrono::milliseconds(50);
+        static constexpr size_t MAX_COMPLETIONS = 200;
+
+        enum ErrorCode : int {
+            INVALID_REQUEST   = -32600,
+            METHOD_NOT_FOUND  = -32601,
+            REQUEST_CANCELLED = -32800,
+        };
+
+    public:
+        /// index_path - persisted symbol index, empty for <workspace>/.xrt/symbols.xsi
+        LanguageServer(std::filesystem::path index_path);
+        ~LanguageServer();
+
+        LanguageServer(const LanguageServer&)            = delete;
+        LanguageServer& operator=(const LanguageServer&) = delete;
+
+        /// Serve stdin/stdout until exit - returns the process exit code
+        int Run();
+
+    private:
+        struct Document {
+            std::string uri;
+            std::filesystem::path path;
+            Scope<SourceDocument> source;
+            int64_t version          = 0;
+            bool diagnostics_pending = true;
+            bool index_pending       = true;
+        };
+
+        // transport
+        void ReaderMain();
+        bool HasQueued();
+        void Send(const Json& message);
+        void Respond(const Json& id, Json result);
+        void RespondError(const Json& id, int code, const std::string& message);
+
+        void Handle(const Json& message, const std::deque<Json>& later);
+        /// nullopt for an unknown method
+        std::optional<Json> HandleRequest(const std::string& method, const Json& params);
+        void HandleNotification(const std::string& method, const Json& params);
+
+        // lifecycle
+        Json Initialize(const Json& params);
+        void LoadWorkspace();
+        void IndexNext();
+        void IndexDocument(Document& doc);
+        void PublishDiagnostics();
+
+        // documents
+        void OpenDocument(const Json& params);
+        void ChangeDocument(const Json& params);
+        void CloseDocument(const Json& params);
+        Document* GetDocument(const Json& params);
+
+        // queries
+        struct Cursor {
+            std::vector<const Token*> tokens;
+            size_t index = SIZE_MAX; // identifier at the position
+            std::wstring qualifier;  // A::B before the identifier
+            SymbolIndex::Location location;
+        };
+        Cursor GetCursor(Document& doc, const Json& position, bool completion);
+        std::vector<SymbolIndex::Match> Resolve(const Document& doc, std::wstring_view name, const std::wstring& qualifier, SymbolIndex::Location location);
+        Json Definition(const Json& params);
+        Json References(const Json& params);
+        Json Completion(const Json& params);
+
+        Json MakeLocation(const std::filesystem::path& path, SymbolIndex::Location location, size_t length) const;
+
+    private:
+        std::filesystem::path m_IndexPath;
+        std::filesystem::path m_Root;
+        bool m_Initialized = false;
+        bool m_Shutdown    = false;
+        bool m_Exit        = false;
+
+        std::thread m_Reader;
+        std::mutex m_QueueLock;
+        std::condition_variable m_QueueSignal;
+        std::deque<Json> m_Queue;
+        std::unordered_set<std::string> m_Cancelled; // request ids
+        bool m_InputClosed = false;
+
+        IncludeCache m_IncludeCache; // files included by open documents
+        std::unordered_map<std::string, Scope<Document>> m_Documents; // by uri
+        SymbolIndex m_Index;
+        std::deque<std::filesystem::path> m_IndexQueue; // workspace files to (re)index from disk
+        bool m_IndexChanged = false;                    // not yet written to m_IndexPath
+    };
+
+} // namespace XRT
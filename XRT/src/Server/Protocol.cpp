@@ -0,0 +1,113 @@
+#include "Protocol.hpp"
+#include <cstring>
+#if defined(CFXS_PLATFORM_LINUX)
+    #include <cerrno>
+    #include <sys/socket.h>
+    #include <sys/types.h>
+#endif
+
+namespace XRT {
+
+#if defined(CFXS_PLATFORM_LINUX)
+    static bool SendAll(int socket, const void* data, size_t size) {
+        auto ptr = static_cast<const char*>(data);
+        while (size) {
+            auto sent = send(socket, ptr, size, MSG_NOSIGNAL);
+            if (sent < 0 && errno == EINTR)
+                continue;
+            if (sent <= 0)
+                return false;
+            ptr += sent;
+            size -= static_cast<size_t>(sent);
+        }
+        return true;
+    }
+
+    static bool ReceiveAll(int socket, void* data, size_t size) {
+        auto ptr = static_cast<char*>(data);
+        while (size) {
+            auto received = recv(socket, ptr, size, 0);
+            if (received < 0 && errno == EINTR)
+                continue;
+            if (received <= 0)
+                return false;
+            ptr += received;
+            size -= static_cast<size_t>(received);
+        }
+        return true;
+    }
+#else
+    static bool SendAll(int, const void*, size_t) {
+        return false;
+    }
+
+    static bool ReceiveAll(int, void*, size_t) {
+        return false;
+    }
+#endif
+
+    bool Protocol::WriteFrame(int socket, FrameType type, std::string_view payload) {
+        if (payload.size() > MAX_FRAME_SIZE)
+            return false;
+
+        // header and payload in one send - LOG frames are small and frequent
+        std::string frame(5 + payload.size(), '\0');
+        auto size = static_cast<uint32_t>(payload.size());
+        std::memcpy(frame.data(), &size, 4);
+        frame[4] = static_cast<char>(type);
+        std::memcpy(frame.data() + 5, payload.data(), payload.size());
+        return SendAll(socket, frame.data(), frame.size());
+    }
+
+    bool Protocol::ReadFrame(int socket, FrameType& type, std::string& payload) {
+        char header[5];
+        if (!ReceiveAll(socket, header, sizeof(header)))
+            return false;
+
+        uint32_t size;
+        std::memcpy(&size, header, 4);
+        if (size > MAX_FRAME_SIZE)
+            return false;
+        type = static_cast<FrameType>(header[4]);
+        payload.resize(size);
+        return ReceiveAll(socket, payload.data(), size);
+    }
+
+    std::string Protocol::EncodeRequest(const Request& request) {
+        std::string payload;
+        payload += static_cast<char>(request.log_level);
+        payload += request.working_directory;
+        payload += '\0';
+        for (auto& arg : request.arguments) {
+            payload += arg;
+            payload += '\0';
+        }
+        return payload;
+    }
+
+    bool Protocol::DecodeRequest(std::string_view payload, Request& request) {
+        if (payload.empty() || payload.back() != '\0')
+            return false;
+        auto level = static_cast<uint8_t>(payload[0]);
+        if (level >= spdlog::level::n_levels)
+            return false;
+        request.log_level = static_cast<spdlog::level::level_enum>(level);
+
+        payload.remove_prefix(1);
+        request.working_directory.clear();
+        request.arguments.clear();
+        bool first = true;
+        while (!payload.empty()) {
+            auto end = payload.find('\0');
+            if (first) {
+                request.working_directory = payload.substr(0, end);
+                first                     = false;
+            } else {
+                request.arguments.emplace_back(payload.substr(0, end));
+            }
+            payload.remove_prefix(end + 1);
+        }
+        return !first;
+    }
+
+} // namespace XRT
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <Log/Logger.hpp>
+
+namespace XRT {
+
+    /// Compile server wire format - every message is a frame of [u32 payload size][u8 type][payload], native byte order.
+    /// A client sends one REQUEST (or SHUTDOWN) per connection and receives LOG frames until the EXIT frame.
+    class Protocol {
+    public:
+        enum class FrameType : uint8_t {
+            REQUEST  = 1, // [u8 log level][working directory\0][argument\0]...
+            LOG      = 2, // [u8 level][message]
+            EXIT     = 3, // [i32 exit code]
+            SHUTDOWN = 4, // stop the server after this connection
+        };
+
+        static constexpr uint32_t MAX_FRAME_SIZE = 16 * 1024 * 1024;
+
+        struct Request {
+            spdlog::level::level_enum log_level = spdlog::level::trace;
+            std::string working_directory;
+            std::vector<std::string> arguments; // without program name
+        };
+
+    public:
+        /// Blocking write/read of a whole frame on a socket - false on disconnect, error or oversized frame
+        static bool WriteFrame(int socket, FrameType type, std::string_view payload);
+        static bool ReadFrame(int socket, FrameType& type, std::string& payload);
+
+        static std::string EncodeRequest(const Request& request);
+        static bool DecodeRequest(std::string_view payload, Request& request);
+    };
+
+} // namespace XRT
@@ -0,0 +1,175 @@
+#include "Coverage.hpp"
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <Log/Logger.hpp>
+#include "Netlist/CellEval.hpp"
+#include "Waveform/BlockCodec.hpp"
+
+namespace XRT {
+
+    void CoverageDatabase::AddRegister(std::string_view name, uint32_t width, uint64_t rose, uint64_t fell, uint64_t toggles) {
+        auto [it, inserted] = m_RegisterIndex.try_emplace(std::string{name}, static_cast<uint32_t>(m_Registers.size()));
+        if (inserted) {
+            m_Registers.push_back({std::string{name}, width, rose, fell, toggles});
+            return;
+        }
+        auto& reg = m_Registers[it->second];
+        reg.width = std::max(reg.width, width);
+        reg.rose |= rose;
+        reg.fell |= fell;
+        reg.toggles += toggles;
+    }
+
+    void CoverageDatabase::AddBranch(std::string_view name, uint64_t hits) {
+        auto [it, inserted] = m_BranchIndex.try_emplace(std::string{name}, static_cast<uint32_t>(m_Branches.size()));
+        if (inserted) {
+            m_Branches.push_back({std::string{name}, hits});
+            return;
+        }
+        m_Branches[it->second].hits += hits;
+    }
+
+    void CoverageDatabase::Merge(const CoverageDatabase& other) {
+        for (auto& reg : other.m_Registers)
+            AddRegister(reg.name, reg.width, reg.rose, reg.fell, reg.toggles);
+        for (auto& branch : other.m_Branches)
+            AddBranch(branch.name, branch.hits);
+    }
+
+    uint64_t CoverageDatabase::GetCoveredBitCount() const {
+        uint64_t count = 0;
+        for (auto& reg : m_Registers)
+            count += static_cast<uint64_t>(std::popcount(reg.rose & reg.fell & NetMask(reg.width)));
+        return count;
+    }
+
+    uint64_t CoverageDatabase::GetBitCount() const {
+        uint64_t count = 0;
+        for (auto& reg : m_Registers)
+            count += reg.width;
+        return count;
+    }
+
+    uint64_t CoverageDatabase::GetCoveredBranchCount() const {
+        uint64_t count = 0;
+        for (auto& branch : m_Branches)
+            count += branch.hits != 0;
+        return count;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    bool CoverageDatabase::Write(const std::filesystem::path& path) const {
+        using BlockCodec::WriteVarint;
+        std::vector<uint8_t> data(MAGIC, MAGIC + sizeof(MAGIC));
+        auto write_name = [&](const std::string& name) {
+            WriteVarint(data, name.size());
+            data.insert(data.end(), name.begin(), name.end());
+        };
+
+        WriteVarint(data, m_Registers.size());
+        for (auto& reg : m_Registers) {
+            write_name(reg.name);
+            WriteVarint(data, reg.width);
+            WriteVarint(data, reg.rose);
+            WriteVarint(data, reg.fell);
+            WriteVarint(data, reg.toggles);
+        }
+        WriteVarint(data, m_Branches.size());
+        for (auto& branch : m_Branches) {
+            write_name(branch.name);
+            WriteVarint(data, branch.hits);
+        }
+
+        auto file = std::fopen(path.string().c_str(), "wb");
+        if (!file) {
+            LOG_ERROR("Failed to open \"{}\" for writing", path.string());
+            return false;
+        }
+        bool ok = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+        ok &= std::fclose(file) == 0;
+        if (!ok)
+            LOG_ERROR("Failed to write \"{}\"", path.string());
+        return ok;
+    }
+
+    bool CoverageDatabase::Read(const std::filesystem::path& path) {
+        auto file = std::fopen(path.string().c_str(), "rb");
+        if (!file) {
+            LOG_ERROR("Failed to open coverage file \"{}\"", path.string());
+            return false;
+        }
+        std::vector<uint8_t> data;
+        uint8_t chunk[64 * 1024];
+        for (size_t n; (n = std::fread(chunk, 1, sizeof(chunk), file)) > 0;)
+            data.insert(data.end(), chunk, chunk + n);
+        std::fclose(file);
+
+        // parse into a temporary database so a corrupt file leaves this one untouched
+        CoverageDatabase parsed;
+        size_t pos = sizeof(MAGIC);
+        uint64_t count, width, a, b, c;
+        std::string name;
+        auto read_name = [&]() {
+            uint64_t size;
+            if (!BlockCodec::ReadVarint(data, pos, size) || size > data.size() - pos)
+                return false;
+            name.assign(reinterpret_cast<const char*>(data.data() + pos), size);
+            pos += size;
+            return true;
+        };
+        auto fail = [&](const char* reason) {
+            LOG_ERROR("Invalid coverage file \"{}\": {}", path.string(), reason);
+            return false;
+        };
+
+        if (data.size() < sizeof(MAGIC) || std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0)
+            return fail("bad header");
+        if (!BlockCodec::ReadVarint(data, pos, count))
+            return fail("truncated register table");
+        for (uint64_t i = 0; i < count; i++) {
+            if (!read_name() || !BlockCodec::ReadVarint(data, pos, width) || !BlockCodec::ReadVarint(data, pos, a) ||
+                !BlockCodec::ReadVarint(data, pos, b) || !BlockCodec::ReadVarint(data, pos, c) || width > 64)
+                return fail("truncated register table");
+            parsed.AddRegister(name, static_cast<uint32_t>(width), a, b, c);
+        }
+        if (!BlockCodec::ReadVarint(data, pos, count))
+            return fail("truncated branch table");
+        for (uint64_t i = 0; i < count; i++) {
+            if (!read_name() || !BlockCodec::ReadVarint(data, pos, a))
+                return fail("truncated branch table");
+            parsed.AddBranch(name, a);
+        }
+
+        Merge(parsed);
+        return true;
+    }
+
+    void CoverageDatabase::LogSummary() const {
+        auto percent = [](uint64_t covered, uint64_t total) {
+            return total ? 100.0 * static_cast<double>(covered) / static_cast<double>(total) : 100.0;
+        };
+        auto bits     = GetBitCount();
+        auto covered  = GetCoveredBitCount();
+        auto branches = GetCoveredBranchCount();
+        LOG_INFO("Coverage: register toggle {}/{} bits ({:.1f}%), branches {}/{} ({:.1f}%)",
+                 covered,
+                 bits,
+                 percent(covered, bits),
+                 branches,
+                 m_Branches.size(),
+                 percent(branches, m_Branches.size()));
+
+        for (auto& reg : m_Registers) {
+            auto missing = ~(reg.rose & reg.fell) & NetMask(reg.width);
+            if (missing)
+                LOG_INFO("    register {} - bits not toggled: 0x{:X}", reg.name, missing);
+        }
+        for (auto& branch : m_Branches) {
+            if (!branch.hits)
+                LOG_INFO("    branch {} never taken", branch.name);
+        }
+    }
+
+} // namespace XRT
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace XRT {
+
+    /// Register bit toggle and event branch coverage of one or more simulation runs.
+    /// Entries are keyed by hierarchical name so runs of differently optimized builds of a design merge correctly.
+    class CoverageDatabase {
+    public:
+        static constexpr char MAGIC[4] = {'X', 'C', 'V', '1'};
+
+        struct RegisterToggles {
+            std::string name;
+            uint32_t width;
+            uint64_t rose;    // bit mask of bits seen rising
+            uint64_t fell;    // bit mask of bits seen falling
+            uint64_t toggles; // total bit toggles
+        };
+
+        struct BranchHits {
+            std::string name;
+            uint64_t hits;
+        };
+
+    public:
+        void AddRegister(std::string_view name, uint32_t width, uint64_t rose, uint64_t fell, uint64_t toggles);
+        void AddBranch(std::string_view name, uint64_t hits);
+        void Merge(const CoverageDatabase& other);
+
+        const std::vector<RegisterToggles>& GetRegisters() const {
+            return m_Registers;
+        }
+        const std::vector<BranchHits>& GetBranches() const {
+            return m_Branches;
+        }
+
+        /// Register bits seen toggling in both directions / all register bits
+        uint64_t GetCoveredBitCount() const;
+        uint64_t GetBitCount() const;
+        uint64_t GetCoveredBranchCount() const;
+
+        /// Compact varint encoded file
+        bool Write(const std::filesystem::path& path) const;
+        /// Merge a coverage file into this database
+        bool Read(const std::filesystem::path& path);
+
+        /// Log totals and list the uncovered entries
+        void LogSummary() const;
+
+    private:
+        std::vector<RegisterToggles> m_Registers;
+        std::vector<BranchHits> m_Branches;
+        std::unordered_map<std::string, uint32_t> m_RegisterIndex;
+        std::unordered_map<std::string, uint32_t> m_BranchIndex;
+    };
+
+} // namespace XRT
@@ -0,0 +1,603 @@
+#include "CycleSimulator.hpp"
+#include <algorithm>
+#include <bit>
+#include <unordered_map>
+#include <Assert.hpp>
+#include <Log/Logger.hpp>
+#include "Profiler.hpp"
+#include "Partitioner.hpp"
+
+namespace XRT {
+
+    using SimulationError = CycleSimulator::SimulationError;
+
+    CycleSimulator::CycleSimulator(const Netlist& netlist) : m_Netlist(netlist) {
+        Compile();
+
+        auto clock = netlist.FindPort("clock");
+        if (clock != INVALID_ID && netlist.GetPortDirection(clock) == PortDirection::IN)
+            AddClock(clock);
+
+        Reset();
+    }
+
+    void CycleSimulator::Compile() {
+        XRT_PROFILE_SCOPE("CycleSimulator::Compile");
+        auto& nl = m_Netlist;
+
+        if (nl.GetInstanceCount())
+            throw SimulationError("Netlist \"" + std::string{nl.GetName()} + "\" has instances - simulation requires a flat netlist");
+
+        // bit-slice storage
+        uint32_t words     = 0;
+        uint32_t max_width = 1;
+        m_NetOffset.resize(nl.GetNetCount());
+        for (NetID n = 0; n < nl.GetNetCount(); n++) {
+            m_NetOffset[n] = words;
+            words += nl.GetNetWidth(n);
+            max_width = std::max(max_width, nl.GetNetWidth(n));
+        }
+        m_Values.assign(words, 0);
+        m_Scratch.resize(max_width);
+        m_ScratchSize = max_width;
+
+        // levelize - Kahn's algorithm, registers/ports/undriven nets are level 0 sources
+        std::vector<uint32_t> pending(nl.GetCellCount(), 0);
+        std::vector<CellID> level;
+        std::vector<CellID> next_level;
+        for (CellID c = 0; c < nl.GetCellCount(); c++) {
+            for (auto net : nl.GetCellInputs(c)) {
+                if (nl.GetNetDriverKind(net) == DriverKind::CELL)
+                    pending[c]++;
+            }
+            if (!pending[c])
+                level.push_back(c);
+        }
+
+        m_Program.clear();
+        m_Program.reserve(nl.GetCellCount());
+        m_CellInstruction.assign(nl.GetCellCount(), INVALID_ID);
+        m_Levels.clear();
+        while (!level.empty()) {
+            m_Levels.push_back(static_cast<uint32_t>(m_Program.size()));
+            next_level.clear();
+            for (auto c : level) {
+                auto out    = nl.GetCellOutput(c);
+                auto inputs = nl.GetCellInputs(c);
+
+                Instruction ins{nl.GetCellType(c), nl.GetNetWidth(out), m_NetOffset[out], {0, 0, 0}, {0, 0, 0}, nl.GetCellParam(c), INVALID_ID, 0, 0};
+                for (size_t i = 0; i < inputs.size(); i++) {
+                    ins.inputs[i]       = m_NetOffset[inputs[i]];
+                    ins.input_widths[i] = nl.GetNetWidth(inputs[i]);
+                }
+                m_CellInstruction[c] = static_cast<uint32_t>(m_Program.size());
+                m_Program.push_back(ins);
+
+                for (auto user : nl.GetNetFanout(out)) {
+                    if (--pending[user] == 0)
+                        next_level.push_back(user);
+                }
+            }
+            std::swap(level, next_level);
+        }
+
+        if (m_Program.size() != nl.GetCellCount()) {
+            for (CellID c = 0; c < nl.GetCellCount(); c++) {
+                if (pending[c]) {
+                    auto name = nl.GetNetName(nl.GetCellOutput(c));
+                    throw SimulationError("Combinational loop through net n" + std::to_string(nl.GetCellOutput(c)) +
+                                          (name.empty() ? "" : " (" + std::string{name} + ")"));
+                }
+            }
+        }
+
+        // registers
+        std::unordered_map<NetID, uint32_t> clock_index;
+        uint32_t next_words = 0;
+        m_RegisterClock.resize(nl.GetRegisterCount());
+        m_NextOffset.resize(nl.GetRegisterCount());
+        for (RegisterID r = 0; r < nl.GetRegisterCount(); r++) {
+            m_NextOffset[r] = next_words;
+            next_words += nl.GetNetWidth(nl.GetRegisterQ(r));
+
+            auto clock = nl.GetRegisterClock(r);
+            if (clock == INVALID_ID || nl.GetRegisterD(r) == INVALID_ID) {
+                m_RegisterClock[r] = INVALID_ID;
+                continue;
+            }
+            m_ClockedRegisters.push_back(r);
+            auto [it, inserted] = clock_index.try_emplace(clock, static_cast<uint32_t>(m_ClockNets.size()));
+            if (inserted)
+                m_ClockNets.push_back(clock);
+            m_RegisterClock[r] = it->second;
+        }
+        m_NextState.assign(next_words, 0);
+
+#ifdef XRT_SIM_COVERAGE
+        // coverage points sample on their own clock even if no register uses it
+        m_CoverClock.resize(nl.GetCoverPointCount());
+        for (CoverID c = 0; c < nl.GetCoverPointCount(); c++) {
+            auto [it, inserted] = clock_index.try_emplace(nl.GetCoverPointClock(c), static_cast<uint32_t>(m_ClockNets.size()));
+            if (inserted)
+                m_ClockNets.push_back(nl.GetCoverPointClock(c));
+            m_CoverClock[c] = it->second;
+        }
+#endif
+        m_ClockLevel.assign(m_ClockNets.size(), 0);
+        m_Rising.assign(m_ClockNets.size(), 0);
+        m_Falling.assign(m_ClockNets.size(), 0);
+
+        LOG_DEBUG("[Simulator] {}: {} instructions in {} levels, {} state words", nl.GetName(), m_Program.size(), m_Levels.size(), words);
+    }
+
+    void CycleSimulator::Reset() {
+        std::fill(m_Values.begin(), m_Values.end(), 0);
+        for (RegisterID r = 0; r < m_Netlist.GetRegisterCount(); r++) {
+            auto q    = m_Netlist.GetRegisterQ(r);
+            auto init = m_Netlist.GetRegisterInit(r);
+            auto q_v  = GetSlices(q);
+            for (uint32_t k = 0; k < m_Netlist.GetNetWidth(q); k++)
+                q_v[k] = k < 64 && ((init >> k) & 1) ? ~0ull : 0;
+        }
+        Evaluate();
+
+        // current clock levels are the reference for the first edge
+        for (size_t i = 0; i < m_ClockNets.size(); i++)
+            m_ClockLevel[i] = GetSlices(m_ClockNets[i])[0];
+        m_Steps = 0;
+    }
+
+    void CycleSimulator::AddClock(PortID port) {
+        if (std::find(m_ClockPorts.begin(), m_ClockPorts.end(), port) == m_ClockPorts.end())
+            m_ClockPorts.push_back(port);
+    }
+
+    void CycleSimulator::SetInput(PortID port, uint32_t lane, uint64_t value) {
+        auto net  = m_Netlist.GetPortNet(port);
+        auto v    = GetSlices(net);
+        auto mask = 1ull << lane;
+        for (uint32_t k = 0; k < m_Netlist.GetNetWidth(net); k++)
+            v[k] = (v[k] & ~mask) | (((value >> k) & 1) << lane);
+    }
+
+    void CycleSimulator::SetInput(PortID port, uint64_t value) {
+        auto net = m_Netlist.GetPortNet(port);
+        auto v   = GetSlices(net);
+        for (uint32_t k = 0; k < m_Netlist.GetNetWidth(net); k++)
+            v[k] = (value >> k) & 1 ? ~0ull : 0;
+    }
+
+    uint64_t CycleSimulator::GetValue(NetID net, uint32_t lane) const {
+        auto v         = GetSlices(net);
+        uint64_t value = 0;
+        for (uint32_t k = 0; k < m_Netlist.GetNetWidth(net); k++)
+            value |= ((v[k] >> lane) & 1) << k;
+        return value;
+    }
+
+    void CycleSimulator::SetThreadCount(uint32_t count) {
+#ifdef XRT_SIM_COVERAGE
+        CFXS_ASSERT(!m_CoverageEnabled, "Thread count must be set before enabling coverage");
+#endif
+        m_Workers.reset();
+        m_Partitions.clear();
+        for (auto& ins : m_Program)
+            ins.signal = INVALID_ID;
+        count = std::min(count, std::max(1u, m_Netlist.GetCellCount() / MIN_PARTITION_CELLS));
+        if (count <= 1) {
+            m_Scratch.resize(m_ScratchSize);
+            return;
+        }
+
+        Partitioner partitioner(m_Netlist);
+        auto partitions = partitioner.Partition(count);
+        if (partitions.size() <= 1)
+            return;
+
+        auto& nl = m_Netlist;
+        std::vector<uint32_t> cell_partition(nl.GetCellCount());
+        m_Partitions.resize(partitions.size());
+        for (uint32_t p = 0; p < partitions.size(); p++) {
+            auto& part = m_Partitions[p];
+            for (auto c : partitions[p].cells) {
+                cell_partition[c] = p;
+                part.instructions.push_back(m_CellInstruction[c]);
+            }
+            std::sort(part.instructions.begin(), part.instructions.end());
+            for (auto r : partitions[p].registers) {
+                if (m_RegisterClock[r] != INVALID_ID)
+                    part.registers.push_back(r);
+            }
+        }
+
+        // cells read by another partition publish a ready flag, readers wait for it
+        uint32_t flags = 0;
+        m_Waits.clear();
+        for (CellID c = 0; c < nl.GetCellCount(); c++) {
+            auto& ins      = m_Program[m_CellInstruction[c]];
+            ins.wait_begin = static_cast<uint32_t>(m_Waits.size());
+            for (auto in : nl.GetCellInputs(c)) {
+                if (nl.GetNetDriverKind(in) != DriverKind::CELL)
+                    continue;
+                auto driver = nl.GetNetDriver(in);
+                if (cell_partition[driver] == cell_partition[c])
+                    continue;
+                auto& producer = m_Program[m_CellInstruction[driver]];
+                if (producer.signal == INVALID_ID)
+                    producer.signal = flags++;
+                m_Waits.push_back(producer.signal);
+            }
+            ins.wait_end = static_cast<uint32_t>(m_Waits.size());
+        }
+
+        m_Ready = Scope<std::atomic<uint32_t>[]>(new std::atomic<uint32_t>[std::max(flags, 1u)]);
+        for (uint32_t i = 0; i < flags; i++)
+            m_Ready[i].store(m_Epoch, std::memory_order_relaxed);
+        m_Fired.assign(m_Partitions.size(), 0);
+        m_Scratch.resize(m_ScratchSize * m_Partitions.size());
+        m_Workers = CreateScope<WorkerPool>(static_cast<uint32_t>(m_Partitions.size()));
+
+        LOG_DEBUG("[Simulator] {}: {} partitions, {} cross partition signals", nl.GetName(), m_Partitions.size(), flags);
+    }
+
+    void CycleSimulator::Evaluate() {
+        if (!m_Workers) {
+            for (auto& ins : m_Program)
+                Execute(ins, m_Scratch.data());
+            return;
+        }
+
+        m_Epoch++;
+        m_Workers->Run([this](uint32_t worker) {
+            EvaluatePartition(m_Partitions[worker], m_Scratch.data() + m_ScratchSize * worker);
+        });
+    }
+
+    void CycleSimulator::EvaluatePartition(const Partition& partition, uint64_t* scratch) {
+        auto epoch = m_Epoch;
+        for (auto idx : partition.instructions) {
+            auto& ins = m_Program[idx];
+            for (auto i = ins.wait_begin; i < ins.wait_end; i++) {
+                auto& ready = m_Ready[m_Waits[i]];
+                for (uint32_t spins = 0; ready.load(std::memory_order_acquire) != epoch; spins++) {
+                    if (spins > 64)
+                        std::this_thread::yield();
+                }
+            }
+            Execute(ins, scratch);
+            if (ins.signal != INVALID_ID)
+                m_Ready[ins.signal].store(epoch, std::memory_order_release);
+        }
+    }
+
+    void CycleSimulator::Execute(const Instruction& ins, uint64_t* scratch) {
+        auto* out = m_Values.data() + ins.output;
+        auto w    = ins.width;
+        auto bit  = [&](uint32_t i, uint64_t k) -> uint64_t {
+            return k < ins.input_widths[i] ? m_Values[ins.inputs[i] + k] : 0;
+        };
+        auto any = [&](uint32_t i) {
+            uint64_t r = 0;
+            for (uint32_t k = 0; k < ins.input_widths[i]; k++)
+                r |= m_Values[ins.inputs[i] + k];
+            return r;
+        };
+        // a < b per lane - borrow out of a - b
+        auto less = [&](uint32_t a, uint32_t b) {
+            uint64_t borrow = 0;
+            auto n          = std::max(ins.input_widths[0], ins.input_widths[1]);
+            for (uint32_t k = 0; k < n; k++) {
+                auto x = bit(a, k);
+                auto y = bit(b, k);
+                borrow = (~x & y) | (~(x ^ y) & borrow);
+            }
+            return borrow;
+        };
+        // single bit result in bit 0, upper bits cleared
+        auto flag = [&](uint64_t lanes) {
+            out[0] = lanes;
+            std::fill(out + 1, out + w, 0);
+        };
+
+        switch (ins.type) {
+            case CellType::CONST: {
+                for (uint32_t k = 0; k < w; k++)
+                    out[k] = k < 64 && ((ins.param >> k) & 1) ? ~0ull : 0;
+                break;
+            }
+            case CellType::BUF:
+                for (uint32_t k = 0; k < w; k++)
+                    out[k] = bit(0, k);
+                break;
+            case CellType::NOT:
+                for (uint32_t k = 0; k < w; k++)
+                    out[k] = ~bit(0, k);
+                break;
+            case CellType::AND:
+                for (uint32_t k = 0; k < w; k++)
+                    out[k] = bit(0, k) & bit(1, k);
+                break;
+            case CellType::OR:
+                for (uint32_t k = 0; k < w; k++)
+                    out[k] = bit(0, k) | bit(1, k);
+                break;
+            case CellType::XOR:
+                for (uint32_t k = 0; k < w; k++)
+                    out[k] = bit(0, k) ^ bit(1, k);
+                break;
+            case CellType::ADD:
+            case CellType::SUB: {
+                // a - b = a + ~b + 1
+                bool sub       = ins.type == CellType::SUB;
+                uint64_t carry = sub ? ~0ull : 0;
+                for (uint32_t k = 0; k < w; k++) {
+                    auto x = bit(0, k);
+                    auto y = sub ? ~bit(1, k) : bit(1, k);
+                    out[k] = x ^ y ^ carry;
+                    carry  = (x & y) | (carry & (x ^ y));
+                }
+                break;
+            }
+            case CellType::MUL: {
+                // shift and add, only the low w bits are needed
+                auto* acc = scratch;
+                std::fill(acc, acc + w, 0);
+                for (uint32_t j = 0; j < w; j++) {
+                    auto bj = bit(1, j);
+                    if (!bj)
+                        continue;
+                    uint64_t carry = 0;
+                    for (uint32_t k = j; k < w; k++) {
+                        auto x = bit(0, k - j) & bj;
+                        auto s = acc[k] ^ x ^ carry;
+                        carry  = (acc[k] & x) | (carry & (acc[k] ^ x));
+                        acc[k] = s;
+                    }
+                }
+                std::copy(acc, acc + w, out);
+                break;
+            }
+            case CellType::EQ:
+            case CellType::NE: {
+                uint64_t diff = 0;
+                auto n        = std::max(ins.input_widths[0], ins.input_widths[1]);
+                for (uint32_t k = 0; k < n; k++)
+                    diff |= bit(0, k) ^ bit(1, k);
+                flag(ins.type == CellType::EQ ? ~diff : diff);
+                break;
+            }
+            case CellType::LT: flag(less(0, 1)); break;
+            case CellType::LE: flag(~less(1, 0)); break;
+            case CellType::GT: flag(less(1, 0)); break;
+            case CellType::GE: flag(~less(0, 1)); break;
+            case CellType::LSL:
+            case CellType::LSR: {
+                // barrel shifter - one conditional stage per shift amount bit
+                auto n    = std::max(ins.input_widths[0], w);
+                auto* cur = scratch;
+                for (uint32_t k = 0; k < n; k++)
+                    cur[k] = bit(0, k);
+                for (uint32_t s = 0; s < ins.input_widths[1]; s++) {
+                    auto bs = bit(1, s);
+                    if (!bs)
+                        continue;
+                    if (s >= 32 || (1u << s) >= n) {
+                        for (uint32_t k = 0; k < n; k++)
+                            cur[k] &= ~bs;
+                        continue;
+                    }
+                    auto shift = 1u << s;
+                    if (ins.type == CellType::LSL) {
+                        for (uint32_t k = n; k-- > 0;) {
+                            auto src = k >= shift ? cur[k - shift] : 0;
+                            cur[k]   = (bs & src) | (~bs & cur[k]);
+                        }
+                    } else {
+                        for (uint32_t k = 0; k < n; k++) {
+                            auto src = k + shift < n ? cur[k + shift] : 0;
+                            cur[k]   = (bs & src) | (~bs & cur[k]);
+                        }
+                    }
+                }
+                std::copy(cur, cur + w, out);
+                break;
+            }
+            case CellType::MUX: {
+                auto s = any(0);
+                for (uint32_t k = 0; k < w; k++)
+                    out[k] = (s & bit(1, k)) | (~s & bit(2, k));
+                break;
+            }
+            case CellType::SLICE:
+                for (uint32_t k = 0; k < w; k++)
+                    out[k] = bit(0, k + ins.param);
+                break;
+            case CellType::REDUCE_OR: flag(any(0)); break;
+            default: std::fill(out, out + w, 0); break;
+        }
+    }
+
+    void CycleSimulator::Settle() {
+        auto& nl = m_Netlist;
+        for (uint32_t iteration = 0; iteration < MAX_SETTLE_ITERATIONS; iteration++) {
+            Evaluate();
+
+            // per lane clock edges since the last update
+            bool edge = false;
+            for (size_t i = 0; i < m_ClockNets.size(); i++) {
+                auto level      = GetSlices(m_ClockNets[i])[0];
+                m_Rising[i]     = ~m_ClockLevel[i] & level;
+                m_Falling[i]    = m_ClockLevel[i] & ~level;
+                m_ClockLevel[i] = level;
+                edge |= (m_Rising[i] | m_Falling[i]) != 0;
+            }
+            if (!edge)
+                return;
+
+#ifdef XRT_SIM_COVERAGE
+            if (m_CoverageEnabled)
+                SampleCoverPoints();
+#endif
+
+            // compute all next states from current Q before committing any of them
+            bool fired = false;
+            if (m_Workers) {
+                m_Workers->Run([this](uint32_t worker) {
+                    m_Fired[worker] = ComputeNextState(m_Partitions[worker].registers);
+                });
+                fired = std::find(m_Fired.begin(), m_Fired.end(), true) != m_Fired.end();
+            } else {
+                fired = ComputeNextState(m_ClockedRegisters);
+            }
+            if (!fired)
+                return;
+
+            if (m_Workers) {
+                m_Workers->Run([this](uint32_t worker) {
+                    CommitNextState(m_Partitions[worker].registers, worker);
+                });
+            } else {
+                CommitNextState(m_ClockedRegisters, 0);
+            }
+        }
+
+        LOG_WARN("[Simulator] {}: clock network did not settle after {} iterations", nl.GetName(), MAX_SETTLE_ITERATIONS);
+    }
+
+    bool CycleSimulator::ComputeNextState(std::span<const RegisterID> registers) {
+        auto& nl   = m_Netlist;
+        bool fired = false;
+        for (auto r : registers) {
+            auto clock = m_RegisterClock[r];
+            uint64_t mask;
+            switch (nl.GetRegisterEdge(r)) {
+                case ClockEdge::RISING: mask = m_Rising[clock]; break;
+                case ClockEdge::FALLING: mask = m_Falling[clock]; break;
+                default: mask = m_Rising[clock] | m_Falling[clock]; break;
+            }
+
+            auto q     = nl.GetRegisterQ(r);
+            auto d     = nl.GetRegisterD(r);
+            auto q_v   = GetSlices(q);
+            auto d_v   = GetSlices(d);
+            auto d_w   = nl.GetNetWidth(d);
+            auto* next = m_NextState.data() + m_NextOffset[r];
+            for (uint32_t k = 0; k < nl.GetNetWidth(q); k++)
+                next[k] = ((k < d_w ? d_v[k] : 0) & mask) | (q_v[k] & ~mask);
+            fired |= mask != 0;
+        }
+        return fired;
+    }
+
+    void CycleSimulator::CommitNextState(std::span<const RegisterID> registers, [[maybe_unused]] uint32_t worker) {
+#ifdef XRT_SIM_COVERAGE
+        if (m_CoverageEnabled) {
+            CommitNextStateCovered(registers, worker);
+            return;
+        }
+#endif
+        for (auto r : registers) {
+            auto q = m_Netlist.GetRegisterQ(r);
+            std::copy_n(m_NextState.data() + m_NextOffset[r], m_Netlist.GetNetWidth(q), GetSlices(q));
+        }
+    }
+
+#ifdef XRT_SIM_COVERAGE
+    void CycleSimulator::EnableCoverage() {
+        auto& nl          = m_Netlist;
+        m_CoverageEnabled = true;
+        m_CoverageCounters.resize(std::max<size_t>(1, m_Partitions.size()));
+        for (auto& counters : m_CoverageCounters) {
+            counters.rose.assign(nl.GetRegisterCount(), 0);
+            counters.fell.assign(nl.GetRegisterCount(), 0);
+            counters.toggles.assign(nl.GetRegisterCount(), 0);
+            counters.hits.assign(nl.GetCoverPointCount(), 0);
+        }
+        m_CoverLanes.assign(nl.GetCoverPointCount(), 0);
+    }
+
+    void CycleSimulator::CommitNextStateCovered(std::span<const RegisterID> registers, uint32_t worker) {
+        auto& counters = m_CoverageCounters[worker];
+        for (auto r : registers) {
+            auto q     = m_Netlist.GetRegisterQ(r);
+            auto* cur  = GetSlices(q);
+            auto* next = m_NextState.data() + m_NextOffset[r];
+            uint64_t rose = 0, fell = 0, toggles = 0;
+            for (uint32_t k = 0; k < m_Netlist.GetNetWidth(q); k++) {
+                auto diff = cur[k] ^ next[k];
+                if (!diff)
+                    continue;
+                rose |= static_cast<uint64_t>((diff & next[k]) != 0) << k;
+                fell |= static_cast<uint64_t>((diff & cur[k]) != 0) << k;
+                toggles += static_cast<uint64_t>(std::popcount(diff));
+                cur[k] = next[k];
+            }
+            counters.rose[r] |= rose;
+            counters.fell[r] |= fell;
+            counters.toggles[r] += toggles;
+        }
+    }
+
+    void CycleSimulator::SampleCoverPoints() {
+        // sampled with the register inputs on the caller thread - counters of worker 0.
+        // Parents precede their children, so the lane mask of a parent is always ready.
+        auto& nl   = m_Netlist;
+        auto& hits = m_CoverageCounters[0].hits;
+        for (CoverID c = 0; c < m_CoverClock.size(); c++) {
+            auto parent = nl.GetCoverPointParent(c);
+            uint64_t lanes;
+            if (parent != INVALID_ID) {
+                lanes = m_CoverLanes[parent];
+            } else {
+                // root points sample on the edges of their handler, like its registers
+                auto clock = m_CoverClock[c];
+                switch (nl.GetCoverPointEdge(c)) {
+                    case ClockEdge::RISING: lanes = m_Rising[clock]; break;
+                    case ClockEdge::FALLING: lanes = m_Falling[clock]; break;
+                    default: lanes = m_Rising[clock] | m_Falling[clock]; break;
+                }
+            }
+            auto value  = GetSlices(nl.GetCoverPointNet(c))[0];
+            lanes &= nl.GetCoverPointPolarity(c) ? value : ~value;
+            m_CoverLanes[c] = lanes;
+            hits[c] += static_cast<uint64_t>(std::popcount(lanes));
+        }
+    }
+
+    void CycleSimulator::CollectCoverage(CoverageDatabase& database) const {
+        auto& nl = m_Netlist;
+        for (RegisterID r = 0; r < nl.GetRegisterCount(); r++) {
+            uint64_t rose = 0, fell = 0, toggles = 0;
+            for (auto& counters : m_CoverageCounters) {
+                rose |= counters.rose[r];
+                fell |= counters.fell[r];
+                toggles += counters.toggles[r];
+            }
+            database.AddRegister(nl.GetRegisterName(r), nl.GetNetWidth(nl.GetRegisterQ(r)), rose, fell, toggles);
+        }
+        for (CoverID c = 0; c < nl.GetCoverPointCount(); c++) {
+            uint64_t hits = 0;
+            for (auto& counters : m_CoverageCounters)
+                hits += counters.hits[c];
+            database.AddBranch(nl.GetCoverPointName(c), hits);
+        }
+    }
+#endif
+
+    void CycleSimulator::Step() {
+        for (auto port : m_ClockPorts) {
+            auto v = GetSlices(m_Netlist.GetPortNet(port));
+            v[0]   = ~v[0];
+        }
+        Settle();
+        m_Steps++;
+    }
+
+    void CycleSimulator::Cycle(uint64_t count) {
+        for (uint64_t i = 0; i < count; i++) {
+            Step();
+            Step();
+        }
+    }
+
+} // namespace XRT
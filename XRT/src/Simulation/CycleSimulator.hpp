@@ -0,0 +1,192 @@
+#pragma once
+#include <atomic>
+#include <exception>
+#include <span>
+#include <string>
+#include <vector>
+#include <Utils.hpp>
+#include "Netlist/Netlist.hpp"
+#include "Coverage.hpp"
+#include "WorkerPool.hpp"
+
+namespace XRT {
+
+    /// Cycle based simulator over a flat netlist.
+    /// Values are bit-sliced - every net bit is one 64bit word holding that bit for 64 independent lanes,
+    /// so a single pass over the levelized cells evaluates 64 stimulus vectors at once.
+    class CycleSimulator {
+    public:
+        class SimulationError : public std::exception {
+        public:
+            SimulationError(const std::string& reason) : m_Reason(reason) {
+            }
+
+            const char* what() const noexcept override {
+                return m_Reason.c_str();
+            }
+
+        private:
+            std::string m_Reason;
+        };
+
+        static constexpr uint32_t LANE_COUNT = 64;
+
+        /// Max register update rounds per step - derived clocks can ripple through several registers
+        static constexpr uint32_t MAX_SETTLE_ITERATIONS = 64;
+
+        /// Smallest amount of logic worth a thread - barrier overhead dominates below this
+        static constexpr uint32_t MIN_PARTITION_CELLS = 256;
+
+        /// Levelized cell operation on bit-slice word offsets
+        struct Instruction {
+            CellType type;
+            uint32_t width;     // output width
+            uint32_t output;    // word offset
+            uint32_t inputs[3]; // word offsets
+            uint32_t input_widths[3];
+            uint64_t param;
+            // partitioned evaluation - ready flag set after execution, m_Waits range of flags to wait for
+            uint32_t signal;
+            uint32_t wait_begin;
+            uint32_t wait_end;
+        };
+
+    public:
+        /// Netlist must be flat (no instances) and free of combinational loops
+        CycleSimulator(const Netlist& netlist);
+
+        const Netlist& GetNetlist() const {
+            return m_Netlist;
+        }
+
+        /// Load register init values in all lanes
+        void Reset();
+
+#ifdef XRT_SIM_COVERAGE
+        /// Count register bit toggles and coverage point hits in all lanes - set the thread count first
+        void EnableCoverage();
+        bool IsCoverageEnabled() const {
+            return m_CoverageEnabled;
+        }
+        /// Merge the per-thread counters into a coverage database
+        void CollectCoverage(CoverageDatabase& database) const;
+#endif
+
+        /// Evaluate on multiple threads - the netlist is partitioned by clock domain and min-cut.
+        /// Partitions run their cells in level order and wait only for cells of other partitions they read.
+        void SetThreadCount(uint32_t count);
+        uint32_t GetThreadCount() const {
+            return m_Workers ? m_Workers->GetCount() : 1;
+        }
+
+        /// Port toggled by Step - defaults to the "clock" port if present
+        void AddClock(PortID port);
+
+        /// Set an input port value in a single lane / in all lanes
+        void SetInput(PortID port, uint32_t lane, uint64_t value);
+        void SetInput(PortID port, uint64_t value);
+
+        /// Value of any net in a lane
+        uint64_t GetValue(NetID net, uint32_t lane) const;
+        uint64_t GetOutput(PortID port, uint32_t lane) const {
+            return GetValue(m_Netlist.GetPortNet(port), lane);
+        }
+
+        /// Raw bit-slice words of a net (one word per bit, LSB first)
+        const uint64_t* GetSlices(NetID net) const {
+            return m_Values.data() + m_NetOffset[net];
+        }
+        uint64_t* GetSlices(NetID net) {
+            return m_Values.data() + m_NetOffset[net];
+        }
+
+        /// Re-evaluate combinational logic and apply register updates for any clock edges
+        void Settle();
+
+        /// Toggle clock inputs once and settle
+        void Step();
+
+        /// Full clock periods (two steps each)
+        void Cycle(uint64_t count = 1);
+
+        uint64_t GetStepCount() const {
+            return m_Steps;
+        }
+
+        const std::vector<Instruction>& GetProgram() const {
+            return m_Program;
+        }
+        /// Program index of the first instruction of each level
+        const std::vector<uint32_t>& GetLevels() const {
+            return m_Levels;
+        }
+
+    private:
+        struct Partition {
+            std::vector<uint32_t> instructions; // level order
+            std::vector<RegisterID> registers;
+        };
+
+        void Compile();
+        void Evaluate();
+        void EvaluatePartition(const Partition& partition, uint64_t* scratch);
+        void Execute(const Instruction& ins, uint64_t* scratch);
+        /// Next state of registers with a clock edge in any lane - returns false if none fired
+        bool ComputeNextState(std::span<const RegisterID> registers);
+        void CommitNextState(std::span<const RegisterID> registers, uint32_t worker);
+#ifdef XRT_SIM_COVERAGE
+        void CommitNextStateCovered(std::span<const RegisterID> registers, uint32_t worker);
+        void SampleCoverPoints();
+#endif
+
+    private:
+        const Netlist& m_Netlist;
+
+        std::vector<uint32_t> m_NetOffset; // [net] -> m_Values
+        std::vector<uint64_t> m_Values;
+        std::vector<uint64_t> m_Scratch; // max net width words per worker
+        uint32_t m_ScratchSize = 0;
+
+        std::vector<Instruction> m_Program;
+        std::vector<uint32_t> m_Levels;
+        std::vector<uint32_t> m_CellInstruction; // [cell] -> m_Program
+
+        // Registers - next state is computed for all registers before any Q is updated
+        std::vector<uint32_t> m_RegisterClock; // [reg] -> m_ClockNets or INVALID_ID
+        std::vector<uint32_t> m_NextOffset;    // [reg] -> m_NextState
+        std::vector<uint64_t> m_NextState;
+        std::vector<RegisterID> m_ClockedRegisters;
+
+        // Distinct register clock nets and their last seen level per lane
+        std::vector<NetID> m_ClockNets;
+        std::vector<uint64_t> m_ClockLevel;
+        std::vector<uint64_t> m_Rising;
+        std::vector<uint64_t> m_Falling;
+
+        std::vector<PortID> m_ClockPorts;
+        uint64_t m_Steps = 0;
+
+        // Parallel evaluation
+        Scope<WorkerPool> m_Workers;
+        std::vector<Partition> m_Partitions;
+        std::vector<uint32_t> m_Waits;
+        Scope<std::atomic<uint32_t>[]> m_Ready;
+        std::vector<uint8_t> m_Fired; // [partition]
+        uint32_t m_Epoch = 0;
+
+#ifdef XRT_SIM_COVERAGE
+        /// Counters of one worker - lane results are OR/popcount reduced on the fly
+        struct CoverageCounters {
+            std::vector<uint64_t> rose;    // [reg] bit mask
+            std::vector<uint64_t> fell;    // [reg] bit mask
+            std::vector<uint64_t> toggles; // [reg]
+            std::vector<uint64_t> hits;    // [cover point]
+        };
+        bool m_CoverageEnabled = false;
+        std::vector<CoverageCounters> m_CoverageCounters; // [worker]
+        std::vector<uint32_t> m_CoverClock;               // [cover point] -> m_ClockNets
+        std::vector<uint64_t> m_CoverLanes;               // [cover point] lanes hit in the current sample
+#endif
+    };
+
+} // namespace XRT
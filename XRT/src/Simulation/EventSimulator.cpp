@@ -0,0 +1,223 @@
+#include "EventSimulator.hpp"
+#include <limits>
+#include <Log/Logger.hpp>
+#include "Netlist/CellEval.hpp"
+
+namespace XRT {
+
+    using SimulationError = EventSimulator::SimulationError;
+
+    EventSimulator::EventSimulator(const Netlist& netlist) : m_Netlist(netlist) {
+        auto& nl = netlist;
+        if (nl.GetInstanceCount())
+            throw SimulationError("Netlist \"" + std::string{nl.GetName()} + "\" has instances - simulation requires a flat netlist");
+
+        m_Values.resize(nl.GetNetCount());
+        m_Masks.resize(nl.GetNetCount());
+        for (NetID n = 0; n < nl.GetNetCount(); n++)
+            m_Masks[n] = NetMask(nl.GetNetWidth(n));
+        m_Pending.resize(nl.GetNetCount());
+        m_PendingMark.resize(nl.GetNetCount());
+        m_DirtyMark.resize(nl.GetCellCount());
+        m_TriggeredMark.resize(nl.GetRegisterCount());
+
+        // registers by clock net
+        m_ClockUsersOffset.assign(nl.GetNetCount() + 1, 0);
+        for (RegisterID r = 0; r < nl.GetRegisterCount(); r++) {
+            if (nl.GetRegisterClock(r) != INVALID_ID && nl.GetRegisterD(r) != INVALID_ID)
+                m_ClockUsersOffset[nl.GetRegisterClock(r) + 1]++;
+        }
+        for (size_t i = 1; i < m_ClockUsersOffset.size(); i++)
+            m_ClockUsersOffset[i] += m_ClockUsersOffset[i - 1];
+        m_ClockUsers.resize(m_ClockUsersOffset.back());
+        std::vector<uint32_t> fill(m_ClockUsersOffset.begin(), m_ClockUsersOffset.end() - 1);
+        for (RegisterID r = 0; r < nl.GetRegisterCount(); r++) {
+            if (nl.GetRegisterClock(r) != INVALID_ID && nl.GetRegisterD(r) != INVALID_ID)
+                m_ClockUsers[fill[nl.GetRegisterClock(r)]++] = r;
+        }
+
+        Reset();
+    }
+
+    void EventSimulator::Reset() {
+        // drop everything still scheduled
+        while (m_Wheel.Advance(std::numeric_limits<SimTime>::max())) {
+            for (auto ev = m_Wheel.PopCurrent(); ev;) {
+                auto next = ev->next;
+                m_Pool.Free(ev);
+                ev = next;
+            }
+        }
+        m_Wheel = TimingWheel{};
+        m_Time  = 0;
+
+        std::fill(m_Values.begin(), m_Values.end(), 0);
+        for (RegisterID r = 0; r < m_Netlist.GetRegisterCount(); r++) {
+            auto q      = m_Netlist.GetRegisterQ(r);
+            m_Values[q] = m_Netlist.GetRegisterInit(r) & m_Masks[q];
+        }
+
+        // settle all logic at time 0
+        for (CellID c = 0; c < m_Netlist.GetCellCount(); c++) {
+            m_DirtyMark[c] = true;
+            m_Dirty.push_back(c);
+        }
+        ProcessDeltas();
+
+        m_EventCount = 0;
+        m_DeltaCount = 0;
+        for (auto& clock : m_Clocks)
+            clock.level = m_Values[clock.net] & 1;
+        ScheduleClocks();
+    }
+
+    void EventSimulator::AddClock(PortID port, SimTime period, SimTime phase) {
+        if (period < 2)
+            throw SimulationError("Clock period of port \"" + std::string{m_Netlist.GetPortName(port)} + "\" is too short");
+        auto net = m_Netlist.GetPortNet(port);
+        m_Clocks.push_back({net, period / 2, phase, m_Values[net] & 1});
+        ScheduleEvent(m_Time + phase, CLOCK_TOGGLE, static_cast<uint32_t>(m_Clocks.size() - 1), 0);
+    }
+
+    void EventSimulator::ScheduleClocks() {
+        for (uint32_t i = 0; i < m_Clocks.size(); i++)
+            ScheduleEvent(m_Clocks[i].phase, CLOCK_TOGGLE, i, 0);
+    }
+
+    void EventSimulator::ScheduleEvent(SimTime time, EventKind kind, uint32_t target, uint64_t value) {
+        auto ev    = m_Pool.Allocate();
+        ev->time   = time;
+        ev->kind   = kind;
+        ev->target = target;
+        ev->value  = value;
+        m_Wheel.Insert(ev);
+    }
+
+    void EventSimulator::Schedule(NetID net, uint64_t value, SimTime delay) {
+        ScheduleEvent(m_Time + delay, NET_UPDATE, net, value);
+    }
+
+    void EventSimulator::Post(NetID net, uint64_t value) {
+        if (!m_PendingMark[net]) {
+            m_PendingMark[net] = true;
+            m_PendingNets.push_back(net);
+        }
+        m_Pending[net] = value & m_Masks[net];
+    }
+
+    void EventSimulator::EvaluateCell(CellID cell) {
+        auto& nl    = m_Netlist;
+        auto inputs = nl.GetCellInputs(cell);
+        uint64_t v[3]{};
+        for (size_t i = 0; i < inputs.size(); i++)
+            v[i] = m_Values[inputs[i]];
+
+        auto out   = nl.GetCellOutput(cell);
+        auto value = XRT::EvaluateCell(nl.GetCellType(cell), nl.GetCellParam(cell), nl.GetNetWidth(out), v[0], v[1], v[2]);
+        if (value != m_Values[out] || m_PendingMark[out])
+            Post(out, value);
+    }
+
+    void EventSimulator::ProcessDeltas() {
+        auto& nl       = m_Netlist;
+        uint32_t delta = 0;
+        while (true) {
+            // registers sample D once the logic reading the clock has settled - the same post-edge view as CycleSimulator
+            if (m_PendingNets.empty() && m_Dirty.empty()) {
+                if (m_Triggered.empty())
+                    return;
+                for (auto reg : m_Triggered) {
+                    m_TriggeredMark[reg] = false;
+                    Post(nl.GetRegisterQ(reg), m_Values[nl.GetRegisterD(reg)]);
+                }
+                m_Triggered.clear();
+            }
+
+            if (++delta > MAX_DELTA_CYCLES) {
+                LOG_WARN("[Simulator] {}: no stable state after {} delta cycles at {}ps", nl.GetName(), MAX_DELTA_CYCLES, m_Time);
+                for (auto net : m_PendingNets)
+                    m_PendingMark[net] = false;
+                m_PendingNets.clear();
+                for (auto cell : m_Dirty)
+                    m_DirtyMark[cell] = false;
+                m_Dirty.clear();
+                for (auto reg : m_Triggered)
+                    m_TriggeredMark[reg] = false;
+                m_Triggered.clear();
+                return;
+            }
+            m_DeltaCount++;
+
+            // apply all updates of this delta at once
+            m_Changed.clear();
+            for (auto net : m_PendingNets) {
+                m_PendingMark[net] = false;
+                if (m_Pending[net] != m_Values[net]) {
+                    m_Changed.emplace_back(net, m_Values[net]);
+                    m_Values[net] = m_Pending[net];
+                    if (m_OnChange)
+                        m_OnChange(m_Time, net, m_Values[net]);
+                }
+            }
+            m_PendingNets.clear();
+
+            for (auto [net, previous] : m_Changed) {
+                for (auto cell : nl.GetNetFanout(net)) {
+                    if (!m_DirtyMark[cell]) {
+                        m_DirtyMark[cell] = true;
+                        m_Dirty.push_back(cell);
+                    }
+                }
+
+                // clocked registers sample D when this time step has settled
+                auto before = previous & 1;
+                auto after  = m_Values[net] & 1;
+                if (before == after)
+                    continue;
+                for (auto i = m_ClockUsersOffset[net]; i < m_ClockUsersOffset[net + 1]; i++) {
+                    auto reg  = m_ClockUsers[i];
+                    auto edge = nl.GetRegisterEdge(reg);
+                    if ((edge == ClockEdge::BOTH || (edge == ClockEdge::RISING) == (after == 1)) && !m_TriggeredMark[reg]) {
+                        m_TriggeredMark[reg] = true;
+                        m_Triggered.push_back(reg);
+                    }
+                }
+            }
+
+            // re-evaluate cells reading changed nets - results are applied in the next delta
+            for (size_t i = 0; i < m_Dirty.size(); i++) {
+                auto cell         = m_Dirty[i];
+                m_DirtyMark[cell] = false;
+                EvaluateCell(cell);
+            }
+            m_Dirty.clear();
+        }
+    }
+
+    void EventSimulator::RunUntil(SimTime end) {
+        while (m_Wheel.Advance(end)) {
+            m_Time = m_Wheel.GetTime();
+
+            // batch all events of this time step - later updates of the same net replace earlier ones
+            for (auto ev = m_Wheel.PopCurrent(); ev;) {
+                auto next = ev->next;
+                if (ev->kind == CLOCK_TOGGLE) {
+                    auto& clock = m_Clocks[ev->target];
+                    clock.level ^= 1;
+                    Post(clock.net, ((m_PendingMark[clock.net] ? m_Pending[clock.net] : m_Values[clock.net]) & ~1ull) | clock.level);
+                    ev->time += clock.half_period;
+                    m_Wheel.Insert(ev);
+                } else {
+                    Post(ev->target, ev->value);
+                    m_Pool.Free(ev);
+                }
+                m_EventCount++;
+                ev = next;
+            }
+
+            ProcessDeltas();
+        }
+        m_Time = end;
+    }
+
+} // namespace XRT
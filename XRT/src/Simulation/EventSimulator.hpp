@@ -0,0 +1,131 @@
+#pragma once
+#include <exception>
+#include <functional>
+#include <string>
+#include <vector>
+#include "Netlist/Netlist.hpp"
+#include "SimTime.hpp"
+#include "TimingWheel.hpp"
+
+namespace XRT {
+
+    /// Event driven simulator over a flat netlist.
+    /// Timed events are kept in a hierarchical timing wheel; zero delay activity is resolved in delta cycles
+    /// where all updates of one delta are applied together (last write per net wins) before any cell is re-evaluated.
+    /// Registers clocked in a time step sample their inputs after the combinational logic has settled on the new clock level.
+    class EventSimulator {
+    public:
+        class SimulationError : public std::exception {
+        public:
+            SimulationError(const std::string& reason) : m_Reason(reason) {
+            }
+
+            const char* what() const noexcept override {
+                return m_Reason.c_str();
+            }
+
+        private:
+            std::string m_Reason;
+        };
+
+        /// Delta cycle limit per time step - exceeded by oscillating combinational feedback
+        static constexpr uint32_t MAX_DELTA_CYCLES = 1000;
+
+    public:
+        /// Netlist must be flat (no instances)
+        EventSimulator(const Netlist& netlist);
+
+        const Netlist& GetNetlist() const {
+            return m_Netlist;
+        }
+
+        /// Restart at time 0 with register init values - clock generators are kept
+        void Reset();
+
+        /// Toggle an input port every period/2 starting at phase
+        void AddClock(PortID port, SimTime period, SimTime phase = 0);
+
+        /// Assign a net after a delay relative to the current time
+        void Schedule(NetID net, uint64_t value, SimTime delay = 0);
+        void SetInput(PortID port, uint64_t value, SimTime delay = 0) {
+            Schedule(m_Netlist.GetPortNet(port), value, delay);
+        }
+
+        /// Process all events up to and including end
+        void RunUntil(SimTime end);
+
+        SimTime GetTime() const {
+            return m_Time;
+        }
+        uint64_t GetValue(NetID net) const {
+            return m_Values[net];
+        }
+        uint64_t GetOutput(PortID port) const {
+            return m_Values[m_Netlist.GetPortNet(port)];
+        }
+
+        /// Called for every applied net value change (e.g. waveform recording)
+        using ChangeCallback = std::function<void(SimTime time, NetID net, uint64_t value)>;
+        void SetChangeCallback(ChangeCallback callback) {
+            m_OnChange = std::move(callback);
+        }
+
+        uint64_t GetEventCount() const {
+            return m_EventCount;
+        }
+        uint64_t GetDeltaCount() const {
+            return m_DeltaCount;
+        }
+
+    private:
+        enum EventKind : uint32_t {
+            NET_UPDATE,
+            CLOCK_TOGGLE,
+        };
+
+        struct ClockGenerator {
+            NetID net;
+            SimTime half_period;
+            SimTime phase;
+            uint64_t level;
+        };
+
+        void Post(NetID net, uint64_t value);
+        void ScheduleEvent(SimTime time, EventKind kind, uint32_t target, uint64_t value);
+        void ScheduleClocks();
+        void ProcessDeltas();
+        void EvaluateCell(CellID cell);
+
+    private:
+        const Netlist& m_Netlist;
+        EventPool m_Pool;
+        TimingWheel m_Wheel;
+        SimTime m_Time = 0;
+
+        std::vector<uint64_t> m_Values;
+        std::vector<uint64_t> m_Masks;
+
+        // updates of the next delta cycle
+        std::vector<uint64_t> m_Pending;
+        std::vector<uint8_t> m_PendingMark;
+        std::vector<NetID> m_PendingNets;
+        std::vector<std::pair<NetID, uint64_t>> m_Changed; // net, previous value
+
+        std::vector<uint8_t> m_DirtyMark;
+        std::vector<CellID> m_Dirty;
+
+        std::vector<uint32_t> m_ClockUsersOffset; // CSR [net] -> m_ClockUsers
+        std::vector<RegisterID> m_ClockUsers;
+
+        // registers clocked in the current time step - sampled after the combinational logic settles
+        std::vector<uint8_t> m_TriggeredMark;
+        std::vector<RegisterID> m_Triggered;
+
+        std::vector<ClockGenerator> m_Clocks;
+
+        ChangeCallback m_OnChange;
+        uint64_t m_EventCount = 0;
+        uint64_t m_DeltaCount = 0;
+    };
+
+} // namespace XRT
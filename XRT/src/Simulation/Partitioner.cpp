@@ -0,0 +1,241 @@
+#include "Partitioner.hpp"
+#include <algorithm>
+#include <unordered_map>
+#include <Log/Logger.hpp>
+
+namespace XRT {
+
+    std::vector<NetlistPartition> Partitioner::Partition(uint32_t count) {
+        auto& nl = m_Netlist;
+        count    = std::max(count, 1u);
+
+        // clock domains - registers grouped by clock net
+        std::vector<NetlistPartition> groups;
+        std::unordered_map<NetID, uint32_t> domains;
+        for (RegisterID r = 0; r < nl.GetRegisterCount(); r++) {
+            auto [it, inserted] = domains.try_emplace(nl.GetRegisterClock(r), static_cast<uint32_t>(groups.size()));
+            if (inserted)
+                groups.emplace_back();
+            groups[it->second].registers.push_back(r);
+        }
+        groups.emplace_back(); // logic only reaching outputs
+
+        // every cell belongs to the first (largest) domain whose register inputs it feeds
+        std::vector<uint32_t> order(groups.size() - 1);
+        for (uint32_t i = 0; i < order.size(); i++)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return groups[a].registers.size() > groups[b].registers.size();
+        });
+        order.push_back(static_cast<uint32_t>(groups.size() - 1));
+
+        std::vector<uint32_t> cell_group(nl.GetCellCount(), INVALID_ID);
+        std::vector<NetID> stack;
+        auto claim = [&](uint32_t group) {
+            while (!stack.empty()) {
+                auto net = stack.back();
+                stack.pop_back();
+                if (net == INVALID_ID || nl.GetNetDriverKind(net) != DriverKind::CELL)
+                    continue;
+                auto cell = nl.GetNetDriver(net);
+                if (cell_group[cell] != INVALID_ID)
+                    continue;
+                cell_group[cell] = group;
+                for (auto in : nl.GetCellInputs(cell))
+                    stack.push_back(in);
+            }
+        };
+        for (auto g : order) {
+            if (g + 1 == groups.size()) {
+                for (PortID p = 0; p < nl.GetPortCount(); p++) {
+                    if (nl.GetPortDirection(p) != PortDirection::IN)
+                        stack.push_back(nl.GetPortNet(p));
+                }
+            } else {
+                for (auto r : groups[g].registers) {
+                    stack.push_back(nl.GetRegisterD(r));
+                    stack.push_back(nl.GetRegisterClock(r));
+                }
+            }
+            claim(g);
+        }
+        for (CellID c = 0; c < nl.GetCellCount(); c++) {
+            auto g = cell_group[c] == INVALID_ID ? static_cast<uint32_t>(groups.size() - 1) : cell_group[c];
+            groups[g].cells.push_back(c);
+        }
+
+        uint32_t total = 0;
+        for (auto& g : groups) {
+            g.weight = static_cast<uint32_t>(g.cells.size() + g.registers.size());
+            total += g.weight;
+        }
+
+        // split oversized domains
+        auto target = (total + count - 1) / count;
+        std::vector<NetlistPartition> pieces;
+        for (auto& g : groups) {
+            if (!g.weight)
+                continue;
+            if (count > 1 && g.weight > target + target / 2) {
+                auto split = Split(g, std::min(count, (g.weight + target - 1) / target));
+                for (auto& piece : split)
+                    pieces.push_back(std::move(piece));
+            } else {
+                pieces.push_back(std::move(g));
+            }
+        }
+
+        // longest processing time first packing
+        std::stable_sort(pieces.begin(), pieces.end(), [](const NetlistPartition& a, const NetlistPartition& b) {
+            return a.weight > b.weight;
+        });
+        std::vector<NetlistPartition> partitions(std::min(count, std::max<uint32_t>(1, static_cast<uint32_t>(pieces.size()))));
+        for (auto& piece : pieces) {
+            auto& bin = *std::min_element(partitions.begin(), partitions.end(), [](const NetlistPartition& a, const NetlistPartition& b) {
+                return a.weight < b.weight;
+            });
+            bin.cells.insert(bin.cells.end(), piece.cells.begin(), piece.cells.end());
+            bin.registers.insert(bin.registers.end(), piece.registers.begin(), piece.registers.end());
+            bin.weight += piece.weight;
+        }
+        for (auto& p : partitions) {
+            std::sort(p.cells.begin(), p.cells.end());
+            std::sort(p.registers.begin(), p.registers.end());
+        }
+
+        m_CutCount = CountCut(partitions);
+        LOG_DEBUG("[Partitioner] {}: {} clock domains, {} partitions, {} cut nets", nl.GetName(), domains.size(), partitions.size(), m_CutCount);
+        return partitions;
+    }
+
+    std::vector<NetlistPartition> Partitioner::Split(const NetlistPartition& group, uint32_t parts) {
+        auto& nl = m_Netlist;
+
+        std::vector<uint32_t> part(nl.GetCellCount(), INVALID_ID);
+        std::vector<uint8_t> member(nl.GetCellCount(), 0);
+        for (auto c : group.cells)
+            member[c] = true;
+
+        // initial split - consecutive chunks of a walk over the register input cones keep cones together
+        std::vector<CellID> walk;
+        walk.reserve(group.cells.size());
+        std::vector<uint8_t> seen(nl.GetCellCount(), 0);
+        size_t head = 0;
+        auto visit  = [&](NetID net) {
+            if (net == INVALID_ID || nl.GetNetDriverKind(net) != DriverKind::CELL)
+                return;
+            auto cell = nl.GetNetDriver(net);
+            if (member[cell] && !seen[cell]) {
+                seen[cell] = true;
+                walk.push_back(cell);
+            }
+        };
+        auto expand = [&]() {
+            for (; head < walk.size(); head++) {
+                for (auto in : nl.GetCellInputs(walk[head]))
+                    visit(in);
+            }
+        };
+        for (auto r : group.registers) {
+            visit(nl.GetRegisterD(r));
+            expand();
+        }
+        for (auto c : group.cells) {
+            visit(nl.GetCellOutput(c));
+            expand();
+        }
+
+        auto chunk = static_cast<uint32_t>((walk.size() + parts - 1) / parts);
+        std::vector<uint32_t> size(parts, 0);
+        for (size_t i = 0; i < walk.size(); i++) {
+            part[walk[i]] = static_cast<uint32_t>(i / std::max(chunk, 1u));
+            size[part[walk[i]]]++;
+        }
+
+        // greedy refinement - move cells to the part most of their neighbors live in while staying balanced
+        auto limit = chunk + chunk / 20 + 1;
+        std::vector<uint32_t> votes(parts, 0);
+        for (int pass = 0; pass < 4; pass++) {
+            uint32_t moves = 0;
+            for (auto c : walk) {
+                std::fill(votes.begin(), votes.end(), 0);
+                for (auto in : nl.GetCellInputs(c)) {
+                    if (nl.GetNetDriverKind(in) == DriverKind::CELL && member[nl.GetNetDriver(in)])
+                        votes[part[nl.GetNetDriver(in)]]++;
+                }
+                for (auto user : nl.GetNetFanout(nl.GetCellOutput(c))) {
+                    if (member[user])
+                        votes[part[user]]++;
+                }
+                auto current = part[c];
+                auto best    = static_cast<uint32_t>(std::max_element(votes.begin(), votes.end()) - votes.begin());
+                if (best != current && votes[best] > votes[current] && size[best] < limit) {
+                    size[current]--;
+                    size[best]++;
+                    part[c] = best;
+                    moves++;
+                }
+            }
+            if (!moves)
+                break;
+        }
+
+        std::vector<NetlistPartition> result(parts);
+        for (auto c : walk)
+            result[part[c]].cells.push_back(c);
+        for (auto r : group.registers) {
+            auto d = nl.GetRegisterD(r);
+            uint32_t p;
+            if (d != INVALID_ID && nl.GetNetDriverKind(d) == DriverKind::CELL && member[nl.GetNetDriver(d)]) {
+                p = part[nl.GetNetDriver(d)];
+            } else {
+                p = static_cast<uint32_t>(std::min_element(size.begin(), size.end()) - size.begin());
+            }
+            result[p].registers.push_back(r);
+            size[p]++;
+        }
+        for (auto& p : result)
+            p.weight = static_cast<uint32_t>(p.cells.size() + p.registers.size());
+        return result;
+    }
+
+    uint32_t Partitioner::CountCut(const std::vector<NetlistPartition>& partitions) const {
+        auto& nl = m_Netlist;
+        std::vector<uint32_t> cell_part(nl.GetCellCount(), INVALID_ID);
+        std::vector<uint32_t> reg_part(nl.GetRegisterCount(), INVALID_ID);
+        for (uint32_t p = 0; p < partitions.size(); p++) {
+            for (auto c : partitions[p].cells)
+                cell_part[c] = p;
+            for (auto r : partitions[p].registers)
+                reg_part[r] = p;
+        }
+
+        auto driver_part = [&](NetID net) {
+            if (net == INVALID_ID)
+                return INVALID_ID;
+            switch (nl.GetNetDriverKind(net)) {
+                case DriverKind::CELL: return cell_part[nl.GetNetDriver(net)];
+                case DriverKind::REGISTER: return reg_part[nl.GetNetDriver(net)];
+                default: return INVALID_ID;
+            }
+        };
+
+        std::vector<uint8_t> cut(nl.GetNetCount(), 0);
+        for (CellID c = 0; c < nl.GetCellCount(); c++) {
+            for (auto in : nl.GetCellInputs(c)) {
+                auto p = driver_part(in);
+                if (p != INVALID_ID && p != cell_part[c])
+                    cut[in] = true;
+            }
+        }
+        for (RegisterID r = 0; r < nl.GetRegisterCount(); r++) {
+            for (auto net : {nl.GetRegisterD(r), nl.GetRegisterClock(r)}) {
+                auto p = driver_part(net);
+                if (p != INVALID_ID && p != reg_part[r])
+                    cut[net] = true;
+            }
+        }
+        return static_cast<uint32_t>(std::count(cut.begin(), cut.end(), 1));
+    }
+
+} // namespace XRT
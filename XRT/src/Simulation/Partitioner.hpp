@@ -0,0 +1,39 @@
+#pragma once
+#include <vector>
+#include "Netlist/Netlist.hpp"
+
+namespace XRT {
+
+    struct NetlistPartition {
+        std::vector<CellID> cells;
+        std::vector<RegisterID> registers;
+        uint32_t weight = 0;
+    };
+
+    /// Splits a flat netlist into balanced regions for parallel evaluation.
+    /// Logic is first grouped by the clock domain that consumes it, oversized domains are split
+    /// with a greedy min-cut refinement and the pieces are packed into the requested number of partitions.
+    class Partitioner {
+    public:
+        Partitioner(const Netlist& netlist) : m_Netlist(netlist) {
+        }
+
+        std::vector<NetlistPartition> Partition(uint32_t count);
+
+        /// Nets read by cells or registers of another partition than the driver (after Partition)
+        uint32_t GetCutCount() const {
+            return m_CutCount;
+        }
+
+    private:
+        /// Cell IDs of one group split into parts minimizing nets crossing between parts
+        std::vector<NetlistPartition> Split(const NetlistPartition& group, uint32_t parts);
+
+        uint32_t CountCut(const std::vector<NetlistPartition>& partitions) const;
+
+    private:
+        const Netlist& m_Netlist;
+        uint32_t m_CutCount = 0;
+    };
+
+} // namespace XRT
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace XRT {
+
+    /// Simulation time in picoseconds
+    using SimTime = uint64_t;
+
+    /// Parse a time literal ("12ns", "1.5us", "500") - plain numbers are picoseconds
+    static inline std::optional<SimTime> ParseTimeLiteral(std::string_view str) {
+        size_t i         = 0;
+        double value     = 0;
+        double fraction  = 0.1;
+        bool has_digits  = false;
+        bool in_fraction = false;
+        for (; i < str.size(); i++) {
+            auto c = str[i];
+            if (c >= '0' && c <= '9') {
+                if (in_fraction) {
+                    value += (c - '0') * fraction;
+                    fraction /= 10;
+                } else {
+                    value = value * 10 + (c - '0');
+                }
+                has_digits = true;
+            } else if (c == '.' && !in_fraction) {
+                in_fraction = true;
+            } else {
+                break;
+            }
+        }
+        if (!has_digits)
+            return {};
+
+        auto unit = str.substr(i);
+        double scale;
+        if (unit.empty() || unit == "ps") {
+            scale = 1;
+        } else if (unit == "ns") {
+            scale = 1e3;
+        } else if (unit == "us") {
+            scale = 1e6;
+        } else if (unit == "ms") {
+            scale = 1e9;
+        } else if (unit == "s") {
+            scale = 1e12;
+        } else {
+            return {};
+        }
+        return static_cast<SimTime>(value * scale + 0.5);
+    }
+
+} // namespace XRT
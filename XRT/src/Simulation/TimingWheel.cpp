@@ -0,0 +1,121 @@
+#include "TimingWheel.hpp"
+#include <algorithm>
+#include <bit>
+
+namespace XRT {
+
+    void TimingWheel::Link(uint32_t level, uint32_t slot, SimEvent* ev) {
+        auto& s  = m_Levels[level].slots[slot];
+        ev->next = nullptr;
+        if (s.tail) {
+            s.tail->next = ev;
+        } else {
+            s.head = ev;
+            m_Levels[level].occupied[slot / 64] |= 1ull << (slot % 64);
+        }
+        s.tail = ev;
+    }
+
+    SimEvent* TimingWheel::Unlink(uint32_t level, uint32_t slot) {
+        auto& s   = m_Levels[level].slots[slot];
+        auto head = s.head;
+        s.head    = nullptr;
+        s.tail    = nullptr;
+        m_Levels[level].occupied[slot / 64] &= ~(1ull << (slot % 64));
+        return head;
+    }
+
+    uint32_t TimingWheel::FindSlot(uint32_t level, uint32_t from) const {
+        auto& occupied = m_Levels[level].occupied;
+        for (uint32_t word = from / 64; word < occupied.size(); word++) {
+            auto bits = occupied[word];
+            if (word == from / 64)
+                bits &= ~0ull << (from % 64);
+            if (bits)
+                return word * 64 + static_cast<uint32_t>(std::countr_zero(bits));
+        }
+        return SLOT_COUNT;
+    }
+
+    void TimingWheel::Place(SimEvent* ev) {
+        // level is given by the most significant digit that differs from the current time
+        auto diff  = ev->time ^ m_Now;
+        auto level = diff ? static_cast<uint32_t>(std::bit_width(diff) - 1) / SLOT_BITS : 0;
+        if (level >= LEVELS) {
+            m_Overflow.push_back(ev);
+        } else {
+            Link(level, Digit(ev->time, level), ev);
+        }
+    }
+
+    void TimingWheel::Insert(SimEvent* ev) {
+        m_Count++;
+        Place(ev);
+    }
+
+    bool TimingWheel::Advance(SimTime limit) {
+        while (m_Count) {
+            auto slot = FindSlot(0, Digit(m_Now, 0));
+            if (slot < SLOT_COUNT) {
+                auto time = (m_Now & ~static_cast<SimTime>(SLOT_COUNT - 1)) | slot;
+                if (time > limit)
+                    return false;
+                m_Now = time;
+                return true;
+            }
+
+            // nothing left in this level 0 rotation - move to the next occupied slot of a higher level and cascade it down
+            bool cascaded = false;
+            for (uint32_t level = 1; level < LEVELS && !cascaded; level++) {
+                auto digit = Digit(m_Now, level);
+                if (digit + 1 >= SLOT_COUNT)
+                    continue;
+                slot = FindSlot(level, digit + 1);
+                if (slot == SLOT_COUNT)
+                    continue;
+
+                auto upper = (level + 1) * SLOT_BITS;
+                auto time  = ((m_Now >> upper) << upper) | (static_cast<SimTime>(slot) << (level * SLOT_BITS));
+                if (time > limit)
+                    return false;
+                m_Now = time;
+                for (auto ev = Unlink(level, slot); ev;) {
+                    auto next = ev->next;
+                    Place(ev);
+                    ev = next;
+                }
+                cascaded = true;
+            }
+            if (cascaded)
+                continue;
+
+            // only far future events left
+            if (m_Overflow.empty())
+                return false;
+            auto earliest = std::min_element(m_Overflow.begin(), m_Overflow.end(), [](const SimEvent* a, const SimEvent* b) {
+                                return a->time < b->time;
+                            });
+            if ((*earliest)->time > limit)
+                return false;
+            m_Now = (*earliest)->time;
+
+            // keep relative order of same time events
+            std::stable_sort(m_Overflow.begin(), m_Overflow.end(), [](const SimEvent* a, const SimEvent* b) {
+                return a->time < b->time;
+            });
+            auto overflow = std::move(m_Overflow);
+            m_Overflow.clear();
+            for (auto ev : overflow)
+                Place(ev);
+        }
+        return false;
+    }
+
+    SimEvent* TimingWheel::PopCurrent() {
+        auto head = Unlink(0, Digit(m_Now, 0));
+        for (auto ev = head; ev; ev = ev->next)
+            m_Count--;
+        return head;
+    }
+
+} // namespace XRT
@@ -0,0 +1,111 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <Utils.hpp>
+#include "SimTime.hpp"
+
+namespace XRT {
+
+    /// Scheduled net update or internal action
+    struct SimEvent {
+        SimTime time;
+        uint32_t target; // net or clock generator index
+        uint32_t kind;
+        uint64_t value;
+        SimEvent* next;
+    };
+
+    /// Fixed size block allocator for event records - freed records are reused through an intrusive free list
+    class EventPool {
+    public:
+        static constexpr size_t BLOCK_SIZE = 4096;
+
+        SimEvent* Allocate() {
+            if (!m_Free) {
+                auto& block = m_Blocks.emplace_back(new SimEvent[BLOCK_SIZE]);
+                for (size_t i = 0; i < BLOCK_SIZE; i++) {
+                    block[i].next = m_Free;
+                    m_Free        = &block[i];
+                }
+            }
+            auto ev = m_Free;
+            m_Free  = ev->next;
+            return ev;
+        }
+
+        void Free(SimEvent* ev) {
+            ev->next = m_Free;
+            m_Free   = ev;
+        }
+
+        size_t GetCapacity() const {
+            return m_Blocks.size() * BLOCK_SIZE;
+        }
+
+    private:
+        std::vector<Scope<SimEvent[]>> m_Blocks;
+        SimEvent* m_Free = nullptr;
+    };
+
+    /// Hierarchical timing wheel - 4 levels of 256 slots cover 2^32 time units ahead of the current time,
+    /// later events wait in an overflow list. Insert is O(1), finding the next time scans slot occupancy bitmaps.
+    /// Events in a slot keep insertion order.
+    class TimingWheel {
+    public:
+        static constexpr uint32_t LEVELS     = 4;
+        static constexpr uint32_t SLOT_BITS  = 8;
+        static constexpr uint32_t SLOT_COUNT = 1 << SLOT_BITS;
+
+    public:
+        SimTime GetTime() const {
+            return m_Now;
+        }
+
+        bool IsEmpty() const {
+            return m_Count == 0;
+        }
+
+        size_t GetCount() const {
+            return m_Count;
+        }
+
+        /// Event time must not be earlier than the current time
+        void Insert(SimEvent* ev);
+
+        /// Advance the current time to the earliest pending event time (not past limit).
+        /// Returns false if no events are pending up to limit.
+        bool Advance(SimTime limit);
+
+        /// Take all events of the current time in insertion order
+        SimEvent* PopCurrent();
+
+    private:
+        struct Slot {
+            SimEvent* head = nullptr;
+            SimEvent* tail = nullptr;
+        };
+
+        struct Level {
+            std::array<Slot, SLOT_COUNT> slots;
+            std::array<uint64_t, SLOT_COUNT / 64> occupied{};
+        };
+
+        static uint32_t Digit(SimTime time, uint32_t level) {
+            return static_cast<uint32_t>(time >> (level * SLOT_BITS)) & (SLOT_COUNT - 1);
+        }
+
+        void Link(uint32_t level, uint32_t slot, SimEvent* ev);
+        SimEvent* Unlink(uint32_t level, uint32_t slot);
+        /// First occupied slot >= from or SLOT_COUNT
+        uint32_t FindSlot(uint32_t level, uint32_t from) const;
+        void Place(SimEvent* ev);
+
+    private:
+        SimTime m_Now = 0;
+        size_t m_Count = 0;
+        Level m_Levels[LEVELS];
+        std::vector<SimEvent*> m_Overflow;
+    };
+
+} // namespace XRT
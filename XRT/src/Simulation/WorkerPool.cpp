@@ -0,0 +1,34 @@
+#include "WorkerPool.hpp"
+
+namespace XRT {
+
+    WorkerPool::WorkerPool(uint32_t count) : m_Start(std::max<ptrdiff_t>(count, 1)), m_Done(std::max<ptrdiff_t>(count, 1)) {
+        for (uint32_t i = 1; i < count; i++)
+            m_Threads.emplace_back(&WorkerPool::WorkerMain, this, i);
+    }
+
+    WorkerPool::~WorkerPool() {
+        m_Stop = true;
+        m_Start.arrive_and_wait();
+        for (auto& t : m_Threads)
+            t.join();
+    }
+
+    void WorkerPool::Run(const Job& job) {
+        m_Job = &job;
+        m_Start.arrive_and_wait();
+        job(0);
+        m_Done.arrive_and_wait();
+    }
+
+    void WorkerPool::WorkerMain(uint32_t index) {
+        while (true) {
+            m_Start.arrive_and_wait();
+            if (m_Stop)
+                return;
+            (*m_Job)(index);
+            m_Done.arrive_and_wait();
+        }
+    }
+
+} // namespace XRT
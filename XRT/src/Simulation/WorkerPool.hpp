@@ -0,0 +1,40 @@
+#pragma once
+#include <algorithm>
+#include <barrier>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace XRT {
+
+    /// Fixed set of threads running the same job in lockstep - every Run is one barrier synchronized phase
+    class WorkerPool {
+    public:
+        using Job = std::function<void(uint32_t worker)>;
+
+        /// count includes the calling thread
+        WorkerPool(uint32_t count);
+        ~WorkerPool();
+
+        WorkerPool(const WorkerPool&)            = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        uint32_t GetCount() const {
+            return static_cast<uint32_t>(m_Threads.size() + 1);
+        }
+
+        /// Run job(index) on all workers - index 0 runs on the calling thread. Returns when all are done.
+        void Run(const Job& job);
+
+    private:
+        void WorkerMain(uint32_t index);
+
+    private:
+        std::barrier<> m_Start;
+        std::barrier<> m_Done;
+        const Job* m_Job = nullptr;
+        bool m_Stop      = false;
+        std::vector<std::thread> m_Threads;
+    };
+
+} // namespace XRT
@@ -1,86 +1,313 @@
 #include "StringUtils.hpp"
-#include <stdexcept>
+#include <cstdint>
+#include <cstring>
 
-#ifdef _WIN32
-    #include <windows.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define XRT_STRINGUTILS_SSE2
+#endif
+
+namespace {
+
+    constexpr uint32_t REPLACEMENT_CHARACTER = 0xFFFD;
+    constexpr size_t ASCII_BLOCK             = 16; // units per ASCII fast path step
+
+    /// Code point of the UTF-8 sequence at in - returns the sequence size, 0 if the byte at in does not start a valid sequence
+    inline size_t DecodeUTF8(const unsigned char* in, size_t size, uint32_t& code_point) {
+        unsigned char lead = in[0];
+        size_t length;
+        uint32_t min;
+        if (lead < 0x80) {
+            code_point = lead;
+            return 1;
+        } else if (lead < 0xC0) {
+            return 0;
+        } else if (lead < 0xE0) {
+            code_point = lead & 0x1Fu;
+            length     = 2;
+            min        = 0x80;
+        } else if (lead < 0xF0) {
+            code_point = lead & 0x0Fu;
+            length     = 3;
+            min        = 0x800;
+        } else if (lead < 0xF8) {
+            code_point = lead & 0x07u;
+            length     = 4;
+            min        = 0x10000;
+        } else {
+            return 0;
+        }
+
+        if (length > size)
+            return 0;
+        for (size_t i = 1; i < length; i++) {
+            if ((in[i] & 0xC0u) != 0x80)
+                return 0;
+            code_point = (code_point << 6) | (in[i] & 0x3Fu);
+        }
+        // overlong encodings, surrogates and values past the last code point
+        if (code_point < min || code_point > 0x10FFFF || (code_point >= 0xD800 && code_point <= 0xDFFF))
+            return 0;
+        return length;
+    }
+
+    /// Code point of the UTF-16 units at in - returns the units used, 0 if the unit at in is an unpaired surrogate or out of range
+    inline size_t DecodeUTF16(const wchar_t* in, size_t size, uint32_t& code_point) {
+        code_point = static_cast<uint32_t>(in[0]);
+        if (code_point < 0xD800 || (code_point > 0xDFFF && code_point <= 0x10FFFF))
+            return 1;
+        if (code_point <= 0xDBFF && size > 1) {
+            auto low = static_cast<uint32_t>(in[1]);
+            if (low >= 0xDC00 && low <= 0xDFFF) {
+                code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                return 2;
+            }
+        }
+        return 0;
+    }
+
+    inline size_t EncodedSizeUTF8(uint32_t code_point) {
+        return code_point < 0x80 ? 1 : code_point < 0x800 ? 2 : code_point < 0x10000 ? 3 : 4;
+    }
+
+    inline char* EncodeUTF8(uint32_t code_point, char* out) {
+        if (code_point < 0x80) {
+            *out++ = static_cast<char>(code_point);
+        } else if (code_point < 0x800) {
+            *out++ = static_cast<char>(0xC0 | (code_point >> 6));
+            *out++ = static_cast<char>(0x80 | (code_point & 0x3F));
+        } else if (code_point < 0x10000) {
+            *out++ = static_cast<char>(0xE0 | (code_point >> 12));
+            *out++ = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+            *out++ = static_cast<char>(0x80 | (code_point & 0x3F));
+        } else {
+            *out++ = static_cast<char>(0xF0 | (code_point >> 18));
+            *out++ = static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+            *out++ = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+            *out++ = static_cast<char>(0x80 | (code_point & 0x3F));
+        }
+        return out;
+    }
+
+    inline wchar_t* EncodeUTF16(uint32_t code_point, wchar_t* out) {
+        if (code_point < 0x10000) {
+            *out++ = static_cast<wchar_t>(code_point);
+        } else {
+            code_point -= 0x10000;
+            *out++ = static_cast<wchar_t>(0xD800 + (code_point >> 10));
+            *out++ = static_cast<wchar_t>(0xDC00 + (code_point & 0x3FF));
+        }
+        return out;
+    }
+
+    /// Size of the ASCII prefix of in, in whole blocks
+    inline size_t ASCIIPrefix(const char* in, size_t size) {
+        size_t i = 0;
+#ifdef XRT_STRINGUTILS_SSE2
+        for (; i + ASCII_BLOCK <= size; i += ASCII_BLOCK) {
+            if (_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))))
+                break;
+        }
+#else
+        for (; i + ASCII_BLOCK <= size; i += ASCII_BLOCK) {
+            uint64_t low, high;
+            memcpy(&low, in + i, sizeof(low));
+            memcpy(&high, in + i + sizeof(low), sizeof(high));
+            if ((low | high) & 0x8080808080808080ull)
+                break;
+        }
+#endif
+        return i;
+    }
+
+    inline size_t ASCIIPrefix(const wchar_t* in, size_t size) {
+        size_t i = 0;
+#ifdef XRT_STRINGUTILS_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + ASCII_BLOCK <= size; i += ASCII_BLOCK) {
+            auto src = reinterpret_cast<const __m128i*>(in + i);
+            __m128i bits;
+            if constexpr (sizeof(wchar_t) == 2) {
+                bits = _mm_and_si128(_mm_or_si128(_mm_loadu_si128(src), _mm_loadu_si128(src + 1)), _mm_set1_epi16(-0x80));
+            } else {
+                bits = _mm_or_si128(_mm_or_si128(_mm_loadu_si128(src), _mm_loadu_si128(src + 1)),
+                                    _mm_or_si128(_mm_loadu_si128(src + 2), _mm_loadu_si128(src + 3)));
+                bits = _mm_and_si128(bits, _mm_set1_epi32(-0x80));
+            }
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(bits, zero)) != 0xFFFF)
+                break;
+        }
 #else
-    #include <locale>
-    #include <codecvt>
+        for (; i + ASCII_BLOCK <= size; i += ASCII_BLOCK) {
+            uint32_t bits = 0;
+            for (size_t j = 0; j < ASCII_BLOCK; j++)
+                bits |= static_cast<uint32_t>(in[i + j]);
+            if (bits & ~0x7Fu)
+                break;
+        }
 #endif
+        return i;
+    }
 
-std::string StringUtils::utf16_to_utf8(std::wstring_view wstrv) {
-    std::wstring wstr{wstrv};
-    std::string retStr;
-#ifdef _WIN32
-    if (!wstr.empty()) {
-        int sizeRequired = WideCharToMultiByte(CP_UTF8, 0, wstr.data(), -1, NULL, 0, NULL, NULL);
-
-        if (sizeRequired > 0) {
-            std::vector<char> utf8String(sizeRequired);
-            int bytesConverted = WideCharToMultiByte(CP_UTF8, 0, wstr.data(), -1, &utf8String[0], (int)utf8String.size(), NULL, NULL);
-            if (bytesConverted != 0) {
-                retStr = &utf8String[0];
+    /// Widen the ASCII prefix of in to out, in whole blocks - returns the units converted
+    inline size_t WidenASCII(const char* in, size_t size, wchar_t* out) {
+        size_t i = 0;
+#ifdef XRT_STRINGUTILS_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + ASCII_BLOCK <= size; i += ASCII_BLOCK) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+            if (_mm_movemask_epi8(bytes))
+                break;
+            __m128i low  = _mm_unpacklo_epi8(bytes, zero);
+            __m128i high = _mm_unpackhi_epi8(bytes, zero);
+            auto dst     = reinterpret_cast<__m128i*>(out + i);
+            if constexpr (sizeof(wchar_t) == 2) {
+                _mm_storeu_si128(dst, low);
+                _mm_storeu_si128(dst + 1, high);
             } else {
-                throw std::runtime_error("utf16 to utf8 conversion failed");
+                _mm_storeu_si128(dst, _mm_unpacklo_epi16(low, zero));
+                _mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(low, zero));
+                _mm_storeu_si128(dst + 2, _mm_unpacklo_epi16(high, zero));
+                _mm_storeu_si128(dst + 3, _mm_unpackhi_epi16(high, zero));
             }
         }
+#else
+        for (; i + ASCII_BLOCK <= size; i += ASCII_BLOCK) {
+            if (!ASCIIPrefix(in + i, ASCII_BLOCK))
+                break;
+            for (size_t j = 0; j < ASCII_BLOCK; j++)
+                out[i + j] = static_cast<wchar_t>(in[i + j]);
+        }
+#endif
+        return i;
     }
+
+    /// Narrow the ASCII prefix of in to out, in whole blocks - returns the units converted
+    inline size_t NarrowASCII(const wchar_t* in, size_t size, char* out) {
+        size_t i = 0;
+        for (; i + ASCII_BLOCK <= size; i += ASCII_BLOCK) {
+            if (!ASCIIPrefix(in + i, ASCII_BLOCK))
+                break;
+#ifdef XRT_STRINGUTILS_SSE2
+            auto src = reinterpret_cast<const __m128i*>(in + i);
+            __m128i bytes;
+            if constexpr (sizeof(wchar_t) == 2) {
+                bytes = _mm_packus_epi16(_mm_loadu_si128(src), _mm_loadu_si128(src + 1));
+            } else {
+                bytes = _mm_packus_epi16(_mm_packs_epi32(_mm_loadu_si128(src), _mm_loadu_si128(src + 1)),
+                                         _mm_packs_epi32(_mm_loadu_si128(src + 2), _mm_loadu_si128(src + 3)));
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), bytes);
 #else
-    std::wstring_convert<std::codecvt_utf8<wchar_t>, wchar_t> converter;
-    retStr = converter.to_bytes(wstr);
+            for (size_t j = 0; j < ASCII_BLOCK; j++)
+                out[i + j] = static_cast<char>(in[i + j]);
 #endif
-    return retStr;
+        }
+        return i;
+    }
+
+} // namespace
+
+std::string StringUtils::utf16_to_utf8(std::wstring_view wstrv) {
+    std::string utf8;
+    utf8.resize(utf8_length(wstrv));
+    utf16_to_utf8(wstrv, utf8.data());
+    return utf8;
 }
 
 std::wstring StringUtils::utf8_to_utf16(std::string_view utf8) {
-    std::vector<unsigned long> unicode;
-    size_t i = 0;
-    while (i < utf8.size()) {
-        unsigned long uni;
-        size_t todo;
-        unsigned char ch = static_cast<unsigned char>(utf8[i++]);
-        if (ch <= 0x7F) {
-            uni  = ch;
-            todo = 0;
-        } else if (ch <= 0xBF) {
-            throw std::logic_error("not a UTF-8 string");
-        } else if (ch <= 0xDF) {
-            uni  = ch & 0x1F;
-            todo = 1;
-        } else if (ch <= 0xEF) {
-            uni  = ch & 0x0F;
-            todo = 2;
-        } else if (ch <= 0xF7) {
-            uni  = ch & 0x07;
-            todo = 3;
-        } else {
-            throw std::logic_error("not a UTF-8 string");
-        }
-        for (size_t j = 0; j < todo; ++j) {
-            if (i == utf8.size())
-                throw std::logic_error("not a UTF-8 string");
-            unsigned char ch2 = static_cast<unsigned char>(utf8[i++]);
-            if (ch2 < 0x80 || ch2 > 0xBF)
-                throw std::logic_error("not a UTF-8 string");
-            uni <<= 6;
-            uni += ch2 & 0x3F;
+    std::wstring utf16;
+    utf16.resize(utf16_length(utf8));
+    utf8_to_utf16(utf8, utf16.data());
+    return utf16;
+}
+
+StringUtils::ConversionResult StringUtils::utf16_to_utf8(std::wstring_view utf16, char* out) {
+    ConversionResult result;
+    auto begin = out;
+    size_t i   = 0;
+    while (i < utf16.size()) {
+        auto ascii = NarrowASCII(utf16.data() + i, utf16.size() - i, out);
+        i += ascii;
+        out += ascii;
+        if (i == utf16.size())
+            break;
+
+        uint32_t code_point;
+        auto units = DecodeUTF16(utf16.data() + i, utf16.size() - i, code_point);
+        if (!units) {
+            if (result.error == npos)
+                result.error = i;
+            code_point = REPLACEMENT_CHARACTER;
+            units      = 1;
         }
-        if (uni >= 0xD800 && uni <= 0xDFFF)
-            throw std::logic_error("not a UTF-8 string");
-        if (uni > 0x10FFFF)
-            throw std::logic_error("not a UTF-8 string");
-        unicode.push_back(uni);
+        out = EncodeUTF8(code_point, out);
+        i += units;
     }
-    std::wstring utf16;
-    for (size_t j = 0; j < unicode.size(); ++j) {
-        unsigned long uni = unicode[j];
-        if (uni <= 0xFFFF) {
-            utf16 += static_cast<wchar_t>(uni);
-        } else {
-            uni -= 0x10000;
-            utf16 += static_cast<wchar_t>(((uni >> 10) + 0xD800));
-            utf16 += static_cast<wchar_t>(((uni & 0x3FF) + 0xDC00));
+    result.written = static_cast<size_t>(out - begin);
+    return result;
+}
+
+StringUtils::ConversionResult StringUtils::utf8_to_utf16(std::string_view utf8, wchar_t* out) {
+    ConversionResult result;
+    auto begin = out;
+    auto data  = reinterpret_cast<const unsigned char*>(utf8.data());
+    size_t i   = 0;
+    while (i < utf8.size()) {
+        auto ascii = WidenASCII(utf8.data() + i, utf8.size() - i, out);
+        i += ascii;
+        out += ascii;
+        if (i == utf8.size())
+            break;
+
+        uint32_t code_point;
+        auto bytes = DecodeUTF8(data + i, utf8.size() - i, code_point);
+        if (!bytes) {
+            if (result.error == npos)
+                result.error = i;
+            code_point = REPLACEMENT_CHARACTER;
+            bytes      = 1;
         }
+        out = EncodeUTF16(code_point, out);
+        i += bytes;
     }
-    return utf16;
-}
\ No newline at end of file
+    result.written = static_cast<size_t>(out - begin);
+    return result;
+}
+
+size_t StringUtils::utf8_length(std::wstring_view utf16) {
+    size_t length = 0;
+    size_t i      = 0;
+    while (i < utf16.size()) {
+        auto ascii = ASCIIPrefix(utf16.data() + i, utf16.size() - i);
+        i += ascii;
+        length += ascii;
+        if (i == utf16.size())
+            break;
+
+        uint32_t code_point;
+        auto units = DecodeUTF16(utf16.data() + i, utf16.size() - i, code_point);
+        length += units ? EncodedSizeUTF8(code_point) : EncodedSizeUTF8(REPLACEMENT_CHARACTER);
+        i += units ? units : 1;
+    }
+    return length;
+}
+
+size_t StringUtils::utf16_length(std::string_view utf8) {
+    auto data     = reinterpret_cast<const unsigned char*>(utf8.data());
+    size_t length = 0;
+    size_t i      = 0;
+    while (i < utf8.size()) {
+        auto ascii = ASCIIPrefix(utf8.data() + i, utf8.size() - i);
+        i += ascii;
+        length += ascii;
+        if (i == utf8.size())
+            break;
+
+        uint32_t code_point;
+        auto bytes = DecodeUTF8(data + i, utf8.size() - i, code_point);
+        length += bytes == 4 ? 2 : 1; // surrogate pair or a single unit (also for U+FFFD)
+        i += bytes ? bytes : 1;
+    }
+    return length;
+}
@@ -1,9 +1,35 @@
 #pragma once
+#include <cstddef>
 #include <string>
+#include <string_view>
 #include <vector>
 
+/// UTF-8 <-> UTF-16 transcoding. Wide strings hold UTF-16 code units - where wchar_t is 32 bits, units above 0xFFFF are also
+/// accepted as code points. Invalid input does not stop a conversion: each invalid byte or unpaired surrogate is converted
+/// to U+FFFD and the input offset of the first one is reported. Runs of ASCII are converted 16 units at a time.
 class StringUtils {
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    struct ConversionResult {
+        size_t written = 0;    // output units
+        size_t error   = npos; // input offset of the first invalid sequence, npos if the input is valid
+
+        bool IsValid() const {
+            return error == npos;
+        }
+    };
+
 public:
     static std::string utf16_to_utf8(std::wstring_view wstrv);
     static std::wstring utf8_to_utf16(std::string_view utf8);
-};
\ No newline at end of file
+
+    /// Convert into out - out must hold utf8_length(utf16) bytes (4 per input unit is always enough)
+    static ConversionResult utf16_to_utf8(std::wstring_view utf16, char* out);
+    /// Convert into out - out must hold utf16_length(utf8) units (1 per input byte is always enough)
+    static ConversionResult utf8_to_utf16(std::string_view utf8, wchar_t* out);
+
+    /// Exact output size of a conversion
+    static size_t utf8_length(std::wstring_view utf16);
+    static size_t utf16_length(std::string_view utf8);
+};
@@ -0,0 +1,215 @@
+#include "BinaryWaveform.hpp"
+#include <algorithm>
+#include <cstring>
+#include <Log/Logger.hpp>
+#include "BlockCodec.hpp"
+
+namespace XRT {
+
+    using namespace BinaryWaveform;
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Writer
+
+    void BinaryWaveWriter::WriteRaw(const void* data, size_t size) {
+        m_Out << std::string_view{static_cast<const char*>(data), size};
+        m_Offset += size;
+    }
+
+    bool BinaryWaveWriter::Open(const std::filesystem::path& path, const std::vector<WaveSignal>& signals) {
+        if (!m_Out.Open(path))
+            return false;
+
+        m_Offset = 0;
+        m_Index.clear();
+        m_Block.clear();
+        m_Block.reserve(RAW_BLOCK_SIZE + 32);
+        m_BlockStart = 0;
+        m_LastTime   = 0;
+
+        WriteRaw(MAGIC, sizeof(MAGIC));
+        WriteRaw(static_cast<uint32_t>(signals.size()));
+        for (auto& s : signals) {
+            WriteRaw(s.width);
+            WriteRaw(s.initial);
+            WriteRaw(static_cast<uint32_t>(s.name.size()));
+            WriteRaw(s.name.data(), s.name.size());
+        }
+        return true;
+    }
+
+    void BinaryWaveWriter::Change(SimTime time, uint32_t signal, uint64_t value) {
+        if (m_Block.empty()) {
+            m_BlockStart = time;
+            m_LastTime   = time;
+        }
+        BlockCodec::WriteVarint(m_Block, time - m_LastTime);
+        BlockCodec::WriteVarint(m_Block, signal);
+        BlockCodec::WriteVarint(m_Block, value);
+        m_LastTime = time;
+
+        if (m_Block.size() >= RAW_BLOCK_SIZE)
+            FlushBlock();
+    }
+
+    void BinaryWaveWriter::FlushBlock() {
+        if (m_Block.empty())
+            return;
+        BlockCodec::Compress(m_Block, m_Compressed);
+        m_Index.push_back(
+            {m_BlockStart, m_LastTime, m_Offset, static_cast<uint32_t>(m_Compressed.size()), static_cast<uint32_t>(m_Block.size())});
+        WriteRaw(m_Compressed.data(), m_Compressed.size());
+        m_Block.clear();
+    }
+
+    bool BinaryWaveWriter::Close(SimTime end_time) {
+        FlushBlock();
+
+        auto index_offset = m_Offset;
+        WriteRaw(static_cast<uint32_t>(m_Index.size()));
+        for (auto& block : m_Index) {
+            WriteRaw(block.start_time);
+            WriteRaw(block.end_time);
+            WriteRaw(block.offset);
+            WriteRaw(block.compressed_size);
+            WriteRaw(block.raw_size);
+        }
+        WriteRaw(std::max(end_time, m_LastTime));
+        WriteRaw(index_offset);
+        WriteRaw(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+        return m_Out.Close();
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Reader
+
+    BinaryWaveReader::~BinaryWaveReader() {
+        Close();
+    }
+
+    void BinaryWaveReader::Close() {
+        if (m_File) {
+            std::fclose(m_File);
+            m_File = nullptr;
+        }
+    }
+
+    bool BinaryWaveReader::Open(const std::filesystem::path& path) {
+        Close();
+        m_Signals.clear();
+        m_Index.clear();
+
+        m_File = std::fopen(path.string().c_str(), "rb");
+        if (!m_File) {
+            LOG_ERROR("Failed to open waveform \"{}\"", path.string());
+            return false;
+        }
+
+        auto read = [&](void* data, size_t size) {
+            return std::fread(data, 1, size, m_File) == size;
+        };
+        auto fail = [&](const char* reason) {
+            LOG_ERROR("Invalid waveform \"{}\": {}", path.string(), reason);
+            Close();
+            return false;
+        };
+
+        // counts and sizes in the file are untrusted - bounded by the bytes left before anything is allocated
+        auto position = [&]() {
+            return static_cast<uint64_t>(std::max(std::ftell(m_File), 0l));
+        };
+        if (std::fseek(m_File, 0, SEEK_END) != 0)
+            return fail("not seekable");
+        auto file_size = position();
+        std::rewind(m_File);
+        auto remaining = [&]() {
+            return file_size - std::min(position(), file_size);
+        };
+
+        static constexpr uint64_t SIGNAL_HEADER_SIZE = sizeof(WaveSignal::width) + sizeof(WaveSignal::initial) + sizeof(uint32_t);
+        static constexpr uint64_t INDEX_ENTRY_SIZE   = sizeof(SimTime) * 2 + sizeof(uint64_t) + sizeof(uint32_t) * 2;
+        static constexpr uint64_t FOOTER_SIZE        = sizeof(SimTime) + sizeof(uint64_t) + sizeof(INDEX_MAGIC);
+
+        char magic[4];
+        uint32_t count;
+        if (!read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || !read(&count, sizeof(count)))
+            return fail("bad header");
+        if (count > remaining() / SIGNAL_HEADER_SIZE)
+            return fail("signal count exceeds file size");
+        m_Signals.reserve(count);
+        for (uint32_t i = 0; i < count; i++) {
+            WaveSignal s;
+            uint32_t name_size;
+            if (!read(&s.width, sizeof(s.width)) || !read(&s.initial, sizeof(s.initial)) || !read(&name_size, sizeof(name_size)))
+                return fail("truncated signal table");
+            if (name_size > remaining())
+                return fail("truncated signal table");
+            s.name.resize(name_size);
+            if (!read(s.name.data(), name_size))
+                return fail("truncated signal table");
+            m_Signals.push_back(std::move(s));
+        }
+
+        // footer -> index
+        auto blocks_offset = position();
+        uint64_t index_offset;
+        char index_magic[4];
+        if (file_size < blocks_offset + FOOTER_SIZE || std::fseek(m_File, -static_cast<long>(FOOTER_SIZE), SEEK_END) != 0 ||
+            !read(&m_EndTime, sizeof(m_EndTime)) || !read(&index_offset, sizeof(index_offset)) || !read(index_magic, sizeof(index_magic)) ||
+            std::memcmp(index_magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0)
+            return fail("missing index");
+        if (index_offset < blocks_offset || index_offset > file_size - FOOTER_SIZE - sizeof(count) ||
+            std::fseek(m_File, static_cast<long>(index_offset), SEEK_SET) != 0 || !read(&count, sizeof(count)))
+            return fail("bad index offset");
+        if (count > (remaining() - FOOTER_SIZE) / INDEX_ENTRY_SIZE)
+            return fail("block count exceeds file size");
+        m_Index.resize(count);
+        for (auto& block : m_Index) {
+            if (!read(&block.start_time, sizeof(block.start_time)) || !read(&block.end_time, sizeof(block.end_time)) ||
+                !read(&block.offset, sizeof(block.offset)) || !read(&block.compressed_size, sizeof(block.compressed_size)) ||
+                !read(&block.raw_size, sizeof(block.raw_size)))
+                return fail("truncated index");
+            // blocks lie between the signal table and the index
+            if (block.offset < blocks_offset || block.offset > index_offset || block.compressed_size > index_offset - block.offset ||
+                block.raw_size > MAX_BLOCK_SIZE)
+                return fail("block outside of the file");
+        }
+        return true;
+    }
+
+    bool BinaryWaveReader::ReadChanges(SimTime from, SimTime to, const ChangeCallback& callback) {
+        if (!m_File)
+            return false;
+
+        // first block that ends at or after "from"
+        auto it = std::lower_bound(m_Index.begin(), m_Index.end(), from, [](const BlockInfo& block, SimTime time) {
+            return block.end_time < time;
+        });
+
+        std::vector<uint8_t> compressed;
+        std::vector<uint8_t> raw;
+        for (; it != m_Index.end() && it->start_time <= to; ++it) {
+            compressed.resize(it->compressed_size);
+            if (std::fseek(m_File, static_cast<long>(it->offset), SEEK_SET) != 0 ||
+                std::fread(compressed.data(), 1, compressed.size(), m_File) != compressed.size() ||
+                !BlockCodec::Decompress(compressed, it->raw_size, raw))
+                return false;
+
+            size_t pos   = 0;
+            SimTime time = it->start_time;
+            while (pos < raw.size()) {
+                uint64_t delta, signal, value;
+                if (!BlockCodec::ReadVarint(raw, pos, delta) || !BlockCodec::ReadVarint(raw, pos, signal) ||
+                    !BlockCodec::ReadVarint(raw, pos, value) || signal >= m_Signals.size())
+                    return false;
+                time += delta;
+                if (time > to)
+                    return true;
+                if (time >= from)
+                    callback(time, static_cast<uint32_t>(signal), value);
+            }
+        }
+        return true;
+    }
+
+} // namespace XRT
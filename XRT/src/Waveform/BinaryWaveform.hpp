@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdio>
+#include <functional>
+#include "Backend/StreamWriter.hpp"
+#include "WaveformSink.hpp"
+
+namespace XRT {
+
+    /// Compact waveform format - value changes are delta/varint encoded into blocks,
+    /// every block is LZ compressed on its own and listed in a time index at the end of the file.
+    ///
+    /// "XWF1" | signal count | (width, initial, name)... | blocks... | index | end time | index offset | "XWFI"
+    namespace BinaryWaveform {
+        static constexpr char MAGIC[4]         = {'X', 'W', 'F', '1'};
+        static constexpr char INDEX_MAGIC[4]   = {'X', 'W', 'F', 'I'};
+        static constexpr size_t RAW_BLOCK_SIZE = 64 * 1024;
+        static constexpr size_t MAX_BLOCK_SIZE = RAW_BLOCK_SIZE + 32; // a block is flushed after the change that fills it
+
+        struct BlockInfo {
+            SimTime start_time;
+            SimTime end_time;
+            uint64_t offset;
+            uint32_t compressed_size;
+            uint32_t raw_size;
+        };
+    } // namespace BinaryWaveform
+
+    class BinaryWaveWriter : public WaveformSink {
+    public:
+        bool Open(const std::filesystem::path& path, const std::vector<WaveSignal>& signals) override;
+        void Change(SimTime time, uint32_t signal, uint64_t value) override;
+        bool Close(SimTime end_time) override;
+
+    private:
+        void FlushBlock();
+        void WriteRaw(const void* data, size_t size);
+        template<typename T>
+        void WriteRaw(const T& value) {
+            WriteRaw(&value, sizeof(T));
+        }
+
+    private:
+        StreamWriter m_Out;
+        uint64_t m_Offset = 0;
+        std::vector<uint8_t> m_Block;
+        std::vector<uint8_t> m_Compressed;
+        SimTime m_BlockStart = 0;
+        SimTime m_LastTime   = 0;
+        std::vector<BinaryWaveform::BlockInfo> m_Index;
+    };
+
+    class BinaryWaveReader {
+    public:
+        using ChangeCallback = std::function<void(SimTime time, uint32_t signal, uint64_t value)>;
+
+        ~BinaryWaveReader();
+
+        /// Read the signal table and block index - sizes and offsets are checked against the file length
+        bool Open(const std::filesystem::path& path);
+        void Close();
+
+        const std::vector<WaveSignal>& GetSignals() const {
+            return m_Signals;
+        }
+        SimTime GetEndTime() const {
+            return m_EndTime;
+        }
+
+        /// Report all changes in [from, to] - only blocks overlapping the range are read
+        bool ReadChanges(SimTime from, SimTime to, const ChangeCallback& callback);
+
+    private:
+        FILE* m_File = nullptr;
+        std::vector<WaveSignal> m_Signals;
+        std::vector<BinaryWaveform::BlockInfo> m_Index;
+        SimTime m_EndTime = 0;
+    };
+
+} // namespace XRT
@@ -0,0 +1,81 @@
+#include "BlockCodec.hpp"
+#include <cstring>
+
+namespace XRT::BlockCodec {
+
+    static constexpr uint32_t MIN_MATCH  = 4;
+    static constexpr uint32_t HASH_BITS  = 13;
+    static constexpr size_t MAX_DISTANCE = 65535;
+
+    static uint32_t Hash(const uint8_t* p) {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return (v * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    void Compress(std::span<const uint8_t> input, std::vector<uint8_t>& output) {
+        output.clear();
+        output.reserve(input.size() / 2 + 16);
+
+        std::vector<uint32_t> table(1u << HASH_BITS, 0xFFFFFFFF);
+        size_t literal_start = 0;
+        size_t pos           = 0;
+        auto size            = input.size();
+        auto data            = input.data();
+
+        while (pos + MIN_MATCH <= size) {
+            auto h         = Hash(data + pos);
+            auto candidate = table[h];
+            table[h]       = static_cast<uint32_t>(pos);
+
+            if (candidate == 0xFFFFFFFF || pos - candidate > MAX_DISTANCE || std::memcmp(data + candidate, data + pos, MIN_MATCH) != 0) {
+                pos++;
+                continue;
+            }
+
+            auto length = MIN_MATCH;
+            while (pos + length < size && data[candidate + length] == data[pos + length])
+                length++;
+
+            WriteVarint(output, pos - literal_start);
+            output.insert(output.end(), data + literal_start, data + pos);
+            WriteVarint(output, length - MIN_MATCH);
+            WriteVarint(output, pos - candidate);
+
+            pos += length;
+            literal_start = pos;
+        }
+
+        WriteVarint(output, size - literal_start);
+        output.insert(output.end(), data + literal_start, data + size);
+    }
+
+    bool Decompress(std::span<const uint8_t> input, size_t raw_size, std::vector<uint8_t>& output) {
+        output.clear();
+        output.reserve(raw_size);
+
+        size_t pos = 0;
+        while (true) {
+            uint64_t literals;
+            if (!ReadVarint(input, pos, literals) || literals > input.size() - pos || output.size() + literals > raw_size)
+                return false;
+            output.insert(output.end(), input.data() + pos, input.data() + pos + literals);
+            pos += literals;
+            if (output.size() == raw_size)
+                return true;
+
+            uint64_t length;
+            uint64_t distance;
+            if (!ReadVarint(input, pos, length) || !ReadVarint(input, pos, distance))
+                return false;
+            length += MIN_MATCH;
+            if (!distance || distance > output.size() || output.size() + length > raw_size)
+                return false;
+            // byte by byte - matches may overlap their own output
+            auto from = output.size() - distance;
+            for (uint64_t i = 0; i < length; i++)
+                output.push_back(output[from + i]);
+        }
+    }
+
+} // namespace XRT::BlockCodec
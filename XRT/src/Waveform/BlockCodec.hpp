@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace XRT {
+
+    /// Small LZ77 block compressor for waveform data.
+    /// A block is a list of (varint literal count, literals, varint match length - 4, varint offset) sequences,
+    /// the final sequence has no match - decoding needs the raw block size.
+    namespace BlockCodec {
+
+        void Compress(std::span<const uint8_t> input, std::vector<uint8_t>& output);
+
+        /// Returns false on malformed input
+        bool Decompress(std::span<const uint8_t> input, size_t raw_size, std::vector<uint8_t>& output);
+
+        static inline void WriteVarint(std::vector<uint8_t>& out, uint64_t value) {
+            while (value >= 0x80) {
+                out.push_back(static_cast<uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<uint8_t>(value));
+        }
+
+        /// Returns false if the varint runs past the end
+        static inline bool ReadVarint(std::span<const uint8_t> in, size_t& pos, uint64_t& value) {
+            value = 0;
+            for (uint32_t shift = 0; pos < in.size() && shift < 64; shift += 7) {
+                auto b = in[pos++];
+                value |= static_cast<uint64_t>(b & 0x7F) << shift;
+                if (!(b & 0x80))
+                    return true;
+            }
+            return false;
+        }
+
+    } // namespace BlockCodec
+
+} // namespace XRT
@@ -0,0 +1,103 @@
+#include "VCDWriter.hpp"
+#include <algorithm>
+#include <bit>
+
+namespace XRT {
+
+    /// Short identifier from the printable ASCII range
+    static std::string MakeID(uint32_t index) {
+        std::string id;
+        do {
+            id += static_cast<char>('!' + index % 94);
+            index /= 94;
+        } while (index);
+        return id;
+    }
+
+    static std::vector<std::string_view> SplitScope(std::string_view name) {
+        std::vector<std::string_view> parts;
+        size_t start = 0;
+        for (size_t dot; (dot = name.find('.', start)) != std::string_view::npos; start = dot + 1)
+            parts.push_back(name.substr(start, dot - start));
+        parts.push_back(name.substr(start));
+        return parts;
+    }
+
+    bool VCDWriter::Open(const std::filesystem::path& path, const std::vector<WaveSignal>& signals) {
+        if (!m_Out.Open(path))
+            return false;
+
+        m_Widths.clear();
+        m_IDs.clear();
+        for (uint32_t i = 0; i < signals.size(); i++) {
+            m_Widths.push_back(signals[i].width);
+            m_IDs.push_back(MakeID(i));
+        }
+
+        m_Out << "$version CFXS HDL $end\n$timescale " << m_Timescale << " $end\n";
+
+        // scopes from the hierarchical names - signals sorted by name so each scope is opened once
+        std::vector<uint32_t> order(signals.size());
+        for (uint32_t i = 0; i < order.size(); i++)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            auto pa = SplitScope(signals[a].name);
+            auto pb = SplitScope(signals[b].name);
+            return std::lexicographical_compare(pa.begin(), pa.end() - 1, pb.begin(), pb.end() - 1);
+        });
+
+        std::vector<std::string_view> open_scopes;
+        for (auto i : order) {
+            auto parts = SplitScope(signals[i].name);
+            size_t common = 0;
+            while (common < open_scopes.size() && common + 1 < parts.size() && open_scopes[common] == parts[common])
+                common++;
+            for (; open_scopes.size() > common; open_scopes.pop_back())
+                m_Out << "$upscope $end\n";
+            for (; open_scopes.size() + 1 < parts.size(); open_scopes.push_back(parts[open_scopes.size()]))
+                m_Out << "$scope module " << parts[open_scopes.size()] << " $end\n";
+
+            m_Out << "$var wire " << signals[i].width << ' ' << m_IDs[i] << ' ' << parts.back();
+            if (signals[i].width > 1)
+                m_Out << " [" << signals[i].width - 1 << ":0]";
+            m_Out << " $end\n";
+        }
+        for (; !open_scopes.empty(); open_scopes.pop_back())
+            m_Out << "$upscope $end\n";
+        m_Out << "$enddefinitions $end\n#0\n$dumpvars\n";
+        for (uint32_t i = 0; i < signals.size(); i++)
+            WriteValue(i, signals[i].initial);
+        m_Out << "$end\n";
+
+        m_Time = 0;
+        return true;
+    }
+
+    void VCDWriter::WriteValue(uint32_t signal, uint64_t value) {
+        auto width = m_Widths[signal];
+        if (width == 1) {
+            m_Out << static_cast<char>('0' + (value & 1));
+        } else {
+            m_Out << 'b';
+            // no leading zeros
+            uint32_t digits = std::max(1u, static_cast<uint32_t>(64 - std::countl_zero(value)));
+            m_Out.WriteBinary(value, std::min(digits, width)) << ' ';
+        }
+        m_Out << m_IDs[signal] << '\n';
+    }
+
+    void VCDWriter::Change(SimTime time, uint32_t signal, uint64_t value) {
+        if (time != m_Time) {
+            m_Time = time;
+            m_Out << '#' << time << '\n';
+        }
+        WriteValue(signal, value);
+    }
+
+    bool VCDWriter::Close(SimTime end_time) {
+        if (end_time > m_Time)
+            m_Out << '#' << end_time << '\n';
+        return m_Out.Close();
+    }
+
+} // namespace XRT
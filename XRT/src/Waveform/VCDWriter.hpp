@@ -0,0 +1,29 @@
+#pragma once
+#include "Backend/StreamWriter.hpp"
+#include "WaveformSink.hpp"
+
+namespace XRT {
+
+    /// Value Change Dump writer
+    class VCDWriter : public WaveformSink {
+    public:
+        /// Time unit of the SimTime values
+        VCDWriter(std::string_view timescale = "1ps") : m_Timescale(timescale) {
+        }
+
+        bool Open(const std::filesystem::path& path, const std::vector<WaveSignal>& signals) override;
+        void Change(SimTime time, uint32_t signal, uint64_t value) override;
+        bool Close(SimTime end_time) override;
+
+    private:
+        void WriteValue(uint32_t signal, uint64_t value);
+
+    private:
+        StreamWriter m_Out;
+        std::string m_Timescale;
+        std::vector<uint32_t> m_Widths;
+        std::vector<std::string> m_IDs;
+        SimTime m_Time = 0;
+    };
+
+} // namespace XRT
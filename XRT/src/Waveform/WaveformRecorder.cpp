@@ -0,0 +1,169 @@
+#include "WaveformRecorder.hpp"
+#include <bit>
+#include <limits>
+#include <Log/Logger.hpp>
+
+namespace XRT {
+
+    static std::atomic<uint32_t> s_NextRecorderID{1};
+
+    WaveformRecorder::WaveformRecorder(Scope<WaveformSink>&& sink, size_t ring_size) :
+        m_Sink(std::move(sink)), m_RingSize(std::bit_ceil(std::max<size_t>(ring_size, 16))), m_ID(s_NextRecorderID++) {
+    }
+
+    WaveformRecorder::~WaveformRecorder() {
+        if (m_Running)
+            Stop(0);
+    }
+
+    uint32_t WaveformRecorder::AddSignal(std::string_view name, uint32_t width, uint64_t initial) {
+        m_Signals.push_back({std::string{name}, width, initial});
+        return static_cast<uint32_t>(m_Signals.size() - 1);
+    }
+
+    bool WaveformRecorder::Start(const std::filesystem::path& path) {
+        if (!m_Sink->Open(path, m_Signals))
+            return false;
+        m_Stop    = false;
+        m_Running = true;
+        m_Written = 0;
+        m_Writer  = std::thread(&WaveformRecorder::WriterMain, this);
+        return true;
+    }
+
+    WaveformRecorder::Channel& WaveformRecorder::GetChannel() {
+        // per thread cache of the last used recorder channel
+        static thread_local uint32_t t_RecorderID = 0;
+        static thread_local Channel* t_Channel    = nullptr;
+        if (t_RecorderID == m_ID)
+            return *t_Channel;
+
+        std::lock_guard lock(m_ChannelLock);
+        auto id    = std::this_thread::get_id();
+        auto count = m_ChannelCount.load(std::memory_order_relaxed);
+        Channel* channel = nullptr;
+        for (size_t i = 0; i < count && !channel; i++) {
+            if (m_Channels[i]->owner == id)
+                channel = m_Channels[i].get();
+        }
+        if (!channel) {
+            if (count == MAX_CHANNELS)
+                throw std::runtime_error("Too many waveform producer threads");
+            m_Channels[count] = CreateScope<Channel>(m_RingSize, id);
+            channel           = m_Channels[count].get();
+            m_ChannelCount.store(count + 1, std::memory_order_release);
+        }
+
+        t_RecorderID = m_ID;
+        t_Channel    = channel;
+        return *channel;
+    }
+
+    void WaveformRecorder::Change(SimTime time, uint32_t signal, uint64_t value) {
+        auto& ch  = GetChannel();
+        auto head = ch.head.load(std::memory_order_relaxed);
+
+        if (head - ch.tail.load(std::memory_order_acquire) >= ch.records.size()) {
+            // ring full - publish everything up to this time and wait for the writer
+            m_Stalls.fetch_add(1, std::memory_order_relaxed);
+            ch.watermark.store(time, std::memory_order_release);
+            m_Wake.notify_one();
+            while (head - ch.tail.load(std::memory_order_acquire) >= ch.records.size())
+                std::this_thread::yield();
+        }
+
+        ch.records[head & ch.mask] = {time, value, signal};
+        ch.head.store(head + 1, std::memory_order_release);
+        ch.watermark.store(time, std::memory_order_release);
+
+        if (head - ch.tail.load(std::memory_order_relaxed) == ch.records.size() / 2)
+            m_Wake.notify_one();
+    }
+
+    void WaveformRecorder::Advance(SimTime time) {
+        GetChannel().watermark.store(time, std::memory_order_release);
+    }
+
+    size_t WaveformRecorder::Drain(SimTime limit) {
+        auto count = m_ChannelCount.load(std::memory_order_acquire);
+        size_t written = 0;
+        while (true) {
+            // oldest pending record of all channels
+            Channel* next     = nullptr;
+            SimTime next_time = limit;
+            for (size_t i = 0; i < count; i++) {
+                auto& ch  = *m_Channels[i];
+                auto tail = ch.tail.load(std::memory_order_relaxed);
+                if (tail == ch.head.load(std::memory_order_acquire))
+                    continue;
+                auto time = ch.records[tail & ch.mask].time;
+                if (time < next_time || (time == next_time && !next)) {
+                    next      = &ch;
+                    next_time = time;
+                }
+            }
+            if (!next)
+                return written;
+
+            auto tail = next->tail.load(std::memory_order_relaxed);
+            auto& rec = next->records[tail & next->mask];
+            m_Sink->Change(rec.time, rec.signal, rec.value);
+            next->tail.store(tail + 1, std::memory_order_release);
+            written++;
+            m_Written++;
+        }
+    }
+
+    void WaveformRecorder::WriterMain() {
+        while (!m_Stop.load(std::memory_order_acquire)) {
+            {
+                std::unique_lock lock(m_WakeLock);
+                m_Wake.wait_for(lock, std::chrono::milliseconds(1));
+            }
+
+            // no producer records before its watermark - records up to and including the lowest one are final.
+            // Including it lets a producer stalled on a full ring of same-time changes make progress.
+            auto count    = m_ChannelCount.load(std::memory_order_acquire);
+            SimTime limit = std::numeric_limits<SimTime>::max();
+            for (size_t i = 0; i < count; i++)
+                limit = std::min(limit, m_Channels[i]->watermark.load(std::memory_order_acquire));
+            if (count)
+                Drain(limit);
+        }
+    }
+
+    bool WaveformRecorder::Stop(SimTime end_time) {
+        if (!m_Running)
+            return false;
+        m_Stop = true;
+        m_Wake.notify_one();
+        m_Writer.join();
+        m_Running = false;
+
+        Drain(std::numeric_limits<SimTime>::max());
+        return m_Sink->Close(end_time);
+    }
+
+    bool WaveformRecorder::MatchGlob(std::string_view pattern, std::string_view name) {
+        while (!pattern.empty()) {
+            if (pattern[0] == '*') {
+                bool cross = pattern.size() > 1 && pattern[1] == '*';
+                auto rest  = pattern.substr(cross ? 2 : 1);
+                // try every possible length for the star
+                for (size_t n = 0; n <= name.size(); n++) {
+                    if (MatchGlob(rest, name.substr(n)))
+                        return true;
+                    if (n < name.size() && !cross && name[n] == '.')
+                        return false;
+                }
+                return false;
+            }
+            if (name.empty() || (pattern[0] == '?' ? name[0] == '.' : pattern[0] != name[0]))
+                return false;
+            pattern.remove_prefix(1);
+            name.remove_prefix(1);
+        }
+        return name.empty();
+    }
+
+} // namespace XRT
@@ -0,0 +1,97 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <Utils.hpp>
+#include "WaveformSink.hpp"
+
+namespace XRT {
+
+    /// Collects value changes from simulation threads and writes them on a background thread.
+    /// Every producing thread gets its own single producer/single consumer ring buffer - recording never locks,
+    /// producers only wait when their ring is full so memory use stays bounded.
+    class WaveformRecorder {
+    public:
+        static constexpr size_t DEFAULT_RING_SIZE = 64 * 1024; // records per producer thread, power of 2
+        static constexpr size_t MAX_CHANNELS      = 256;       // producer threads
+
+        struct Record {
+            SimTime time;
+            uint64_t value;
+            uint32_t signal;
+        };
+
+    public:
+        WaveformRecorder(Scope<WaveformSink>&& sink, size_t ring_size = DEFAULT_RING_SIZE);
+        ~WaveformRecorder();
+
+        /// Add a signal before Start - returns the signal index used with Change
+        uint32_t AddSignal(std::string_view name, uint32_t width, uint64_t initial = 0);
+        const std::vector<WaveSignal>& GetSignals() const {
+            return m_Signals;
+        }
+
+        bool Start(const std::filesystem::path& path);
+
+        /// Record a value change - time must not decrease per producing thread
+        void Change(SimTime time, uint32_t signal, uint64_t value);
+
+        /// Promise that the calling thread will not record anything before time.
+        /// Changes of all threads are merged by time, so idle producers must advance to let the writer progress.
+        void Advance(SimTime time);
+
+        /// Drain all rings and close the file
+        bool Stop(SimTime end_time);
+
+        uint64_t GetRecordCount() const {
+            return m_Written;
+        }
+        uint64_t GetStallCount() const {
+            return m_Stalls.load(std::memory_order_relaxed);
+        }
+
+        /// Glob match of a hierarchical name - "*" does not cross '.', "**" does, "?" is any single character
+        static bool MatchGlob(std::string_view pattern, std::string_view name);
+
+    private:
+        struct Channel {
+            Channel(size_t size, std::thread::id thread) : records(size), mask(size - 1), owner(thread) {
+            }
+
+            std::vector<Record> records;
+            size_t mask;
+            std::thread::id owner;
+            alignas(64) std::atomic<size_t> head{0}; // written by producer
+            alignas(64) std::atomic<size_t> tail{0}; // written by writer thread
+            alignas(64) std::atomic<SimTime> watermark{0};
+        };
+
+        Channel& GetChannel();
+        void WriterMain();
+        /// Write merged records up to and including limit - returns number written
+        size_t Drain(SimTime limit);
+
+    private:
+        Scope<WaveformSink> m_Sink;
+        size_t m_RingSize;
+        std::vector<WaveSignal> m_Signals;
+
+        std::mutex m_ChannelLock; // channel registration only
+        Scope<Channel> m_Channels[MAX_CHANNELS];
+        std::atomic<size_t> m_ChannelCount{0}; // published after the channel is constructed
+
+        std::thread m_Writer;
+        std::mutex m_WakeLock;
+        std::condition_variable m_Wake;
+        std::atomic<bool> m_Stop{false};
+        bool m_Running = false;
+        uint32_t m_ID;
+
+        uint64_t m_Written = 0;
+        std::atomic<uint64_t> m_Stalls{0};
+    };
+
+} // namespace XRT
@@ -0,0 +1,26 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "Simulation/SimTime.hpp"
+
+namespace XRT {
+
+    struct WaveSignal {
+        std::string name; // hierarchical, '.' separated
+        uint32_t width;
+        uint64_t initial;
+    };
+
+    /// Waveform file format - receives value changes in non-decreasing time order
+    class WaveformSink {
+    public:
+        virtual ~WaveformSink() = default;
+
+        virtual bool Open(const std::filesystem::path& path, const std::vector<WaveSignal>& signals) = 0;
+        virtual void Change(SimTime time, uint32_t signal, uint64_t value)                        = 0;
+        /// Finish the file - returns false if anything failed to write
+        virtual bool Close(SimTime end_time) = 0;
+    };
+
+} // namespace XRT
@@ -1,172 +1,768 @@
 #include <argparse/argparse.hpp> // C++ broken, this needs to be above Lexer
-#include "Language/Lexer.hpp"
-#include "Language/Parser.hpp"
-#include "Language/SourceEntry.hpp"
+#include "Compiler/CompilationSession.hpp"
+#include "Compiler/FileDiscovery.hpp"
+#include "Compiler/FileWatcher.hpp"
+#include "Server/CompileServer.hpp"
+#include "Server/LanguageServer.hpp"
+#include "Netlist/Optimizer/PassManager.hpp"
+#include "Netlist/Timing/TimingAnalysis.hpp"
+#include "MemoryStats.hpp"
+#include "Profiler.hpp"
+#include "Backend/CppModelBackend.hpp"
+#include "Backend/VHDLBackend.hpp"
+#include "Simulation/Coverage.hpp"
+#include "Simulation/CycleSimulator.hpp"
+#include "Simulation/EventSimulator.hpp"
+#include "Waveform/BinaryWaveform.hpp"
+#include "Waveform/VCDWriter.hpp"
+#include "Waveform/WaveformRecorder.hpp"
 #include <exception>
+#include <stdexcept>
 #include <iostream>
 #include <Log/Logger.hpp>
 #include <filesystem>
 #include <fstream>
 #include <StringUtils.hpp>
-#include <regex>
-#include <Log/ANSI.hpp>
+#include <unordered_set>
 #include <regex/ctre.hpp>
 #include <Utils.hpp>
 
 using argparse::ArgumentParser;
 namespace fs = std::filesystem;
 
-void Test(const std::string& source, const std::filesystem::path& sourcePath);
+Scope<XRT::Netlist> FlattenTop(const XRT::Design& design, bool optimize);
 
-int main(int argc, char** argv) {
-    Logger::Initialize();
-    LOG_INFO(CFXS_PROGRAM_NAME);
+/// Profiler summary/trace written when main returns
+struct ProfileReport {
+    std::string trace_path;
+    bool summary = false;
 
-    std::vector<fs::path> files_to_process;
+    ~ProfileReport() {
+        if (summary || !trace_path.empty())
+            XRT::Profiler::LogSummary();
+        if (!trace_path.empty())
+            XRT::Profiler::WriteTrace(trace_path);
+    }
+};
+
+/// Waveform dump settings for the simulation runs
+struct WaveOptions {
+    std::string path;
+    std::vector<std::string> select;
+};
 
+bool Simulate(const XRT::Design& design, uint64_t cycles, uint32_t threads, bool optimize, const WaveOptions& wave, const std::string& coverage);
+bool MergeCoverage(const std::string& output, const std::vector<std::string>& inputs);
+bool SimulateEvents(const XRT::Design& design, XRT::SimTime end, const std::vector<std::string>& clocks, bool optimize, const WaveOptions& wave);
+bool AnalyzeTiming(const XRT::Design& design, uint32_t paths, const std::string& period, const std::string& delay_model, bool optimize);
+
+/// Input set and changed files of a watch mode rebuild
+struct WatchUpdate {
+    std::vector<fs::path> files;
+    std::vector<fs::path> changed;
+};
+
+void AddArguments(ArgumentParser& program);
+bool CollectFiles(ArgumentParser& program, std::vector<fs::path>& files, std::vector<fs::path>& directories);
+int Run(ArgumentParser& program, XRT::CompilationSession& session, const WatchUpdate* update = nullptr);
+int Watch(ArgumentParser& program, XRT::CompilationSession& session);
+
+int main(int argc, char** argv) {
     ArgumentParser program(CFXS_PROGRAM_NAME, CFXS_VERSION_STRING);
-    program.add_argument("files").help("Files to process").remaining();
+    AddArguments(program);
 
     try {
         program.parse_args(argc, argv);
     } catch (const std::runtime_error& e) {
         std::stringstream ss;
         ss << program;
+        Logger::Initialize();
         LOG_ERROR("{}", e.what());
-        LOG_TRACE("{}", ss.str());
+        LOG_INFO("{}", ss.str());
         return -1;
     }
 
-    try {
-        auto files = program.get<std::vector<std::string>>("files");
-        for (auto& path : files) {
-            path.erase(std::remove(path.begin(), path.end(), '"'), path.end());
-
-            auto fp   = fs::path{path}.lexically_normal();
-            auto ext  = fp.extension();
-            auto name = fp.filename();
-            auto dir  = fp.parent_path();
-
-            bool is_cfxs_hdl_source = ctre::match<L"\\.xdl", ctre::case_insensitive>(ext.c_str());
-            if (is_cfxs_hdl_source) {
-                bool is_wildcard = ctre::search<L"\\*">(name.c_str());
-                if (is_wildcard) {
-                    if (fs::is_directory(dir) && fs::exists(dir)) {
-                        std::string match = name.string();
-                        match             = std::regex_replace(match, std::regex("\\."), "\\.");
-                        match             = std::regex_replace(match, std::regex("\\*"), ".*");
-                        std::regex rx(match);
-                        for (const auto& e : fs::directory_iterator(dir)) {
-                            if (!fs::is_regular_file(e))
-                                continue;
-                            auto fileName = e.path().filename().string();
-                            if (std::regex_match(fileName.begin(), fileName.end(), rx)) {
-                                fs::path addFilePath = dir.string() + PATH_SEPARATOR + fileName;
-                                if (fs::exists(addFilePath))
-                                    files_to_process.push_back(addFilePath);
-                            }
-                        }
-                    } else {
-                        LOG_ERROR("Directory not found: \"{}\"", dir.string());
-                    }
-                } else {
-                    files_to_process.push_back(fp);
-                }
+    auto server  = program.get<std::string>("--server");
+    auto connect = program.get<std::string>("--connect");
+    auto lsp     = program.get<bool>("--lsp");
+
+    Logger::Options log_options;
+    auto log_level       = program.get<std::string>("--log-level");
+    log_options.level    = spdlog::level::from_str(log_level);
+    log_options.file     = program.get<std::string>("--log-file");
+    log_options.async    = !program.get<bool>("--log-sync") && server.empty(); // server swaps client sinks between requests
+    log_options.console_stderr = lsp;                                               // stdout carries the protocol
+    bool log_level_valid = log_options.level != spdlog::level::off || log_level == "off";
+    if (!log_level_valid)
+        log_options.level = spdlog::level::trace;
+    Logger::Initialize(log_options);
+    LOG_INFO(CFXS_PROGRAM_NAME);
+    if (!log_level_valid) {
+        LOG_ERROR("Invalid log level \"{}\"", log_level);
+        return -1;
+    }
+
+    if (lsp) {
+        XRT::LanguageServer language_server(program.get<std::string>("--lsp-index"));
+        return language_server.Run();
+    }
+
+    if (!connect.empty()) {
+        if (program.get<bool>("--server-stop"))
+            return XRT::CompileClient::Shutdown(connect) ? 0 : -1;
+
+        // everything except the connection itself is run by the server
+        std::vector<std::string> arguments;
+        for (int i = 1; i < argc; i++) {
+            if (std::string_view{argv[i]} == "--connect") {
+                i++;
+                continue;
             }
+            arguments.emplace_back(argv[i]);
         }
+        return XRT::CompileClient::Run(connect, arguments, log_options.level);
+    }
+
+    // parsed sources and types stay warm in the session between server requests
+    XRT::CompilationSession session;
+    if (!server.empty()) {
+        XRT::CompileServer compile_server([&session](const std::vector<std::string>& arguments) {
+            ArgumentParser request(CFXS_PROGRAM_NAME, CFXS_VERSION_STRING);
+            AddArguments(request);
+            std::vector<std::string> args{"XRT"};
+            args.insert(args.end(), arguments.begin(), arguments.end());
+            try {
+                request.parse_args(args);
+            } catch (const std::runtime_error& e) {
+                LOG_ERROR("{}", e.what());
+                return -1;
+            }
+            if (!request.get<std::string>("--server").empty() || !request.get<std::string>("--connect").empty() || request.get<bool>("--lsp") ||
+                request.get<bool>("--watch")) {
+                LOG_ERROR("--server/--connect/--lsp/--watch are not valid in a server request");
+                return -1;
+            }
+            return Run(request, session);
+        });
+        return compile_server.Run(server) ? 0 : -1;
+    }
+
+    if (program.get<bool>("--watch"))
+        return Watch(program, session);
+    return Run(program, session);
+}
 
-        LOG_TRACE("Files:\n{}", files_to_process);
+/// Command line shared by local runs and server requests
+void AddArguments(ArgumentParser& program) {
+    program.add_argument("--top").help("Top level component to elaborate").default_value(std::string{});
+    program.add_argument("--param").help("Template parameter override NAME=VALUE").append().default_value(std::vector<std::string>{});
+    program.add_argument("--no-optimize").help("Skip netlist optimization passes").default_value(false).implicit_value(true);
+    program.add_argument("--emit-vhdl").help("Write VHDL for all elaborated modules to directory").default_value(std::string{});
+    program.add_argument("--emit-cpp-model").help("Write a standalone C++ simulation model of the top component to directory").default_value(std::string{});
+    program.add_argument("--timing").help("Static timing estimate of top component - report N most critical paths").scan<'u', uint32_t>().default_value(uint32_t{0});
+    program.add_argument("--clock-period").help("Target clock period for --timing (default 10ns)").default_value(std::string{"10ns"});
+    program.add_argument("--delay-model").help("Cell delay overrides for --timing (lines of NAME BASE [PER_BIT])").default_value(std::string{});
+    program.add_argument("--simulate").help("Simulate top component for N clock cycles with random stimulus").scan<'u', uint64_t>().default_value(uint64_t{0});
+    program.add_argument("--sim-threads").help("Worker threads for --simulate").scan<'u', uint32_t>().default_value(uint32_t{1});
+    program.add_argument("--coverage").help("Collect register toggle and branch coverage during --simulate into file").default_value(std::string{});
+    program.add_argument("--merge-coverage").help("Merge coverage files given as inputs into file and exit").default_value(std::string{});
+    program.add_argument("--sim-until").help("Event driven simulation of top component up to a time (e.g. 10us)").default_value(std::string{});
+    program.add_argument("--clock").help("Clock input for --sim-until PORT=PERIOD (default clock=10ns)").append().default_value(std::vector<std::string>{});
+    program.add_argument("--wave-out").help("Dump simulation waveform to file (.vcd or compressed .xwf)").default_value(std::string{});
+    program.add_argument("--wave-select").help("Hierarchical glob of signals to dump (default **)").append().default_value(std::vector<std::string>{});
+    program.add_argument("--profile").help("Log time spent per profiler zone on exit").default_value(false).implicit_value(true);
+    program.add_argument("--trace-out").help("Write profiler zones to file in Chrome trace format (chrome://tracing, ui.perfetto.dev)").default_value(std::string{});
+    program.add_argument("--log-level").help("Minimum log level: trace, debug, info, warning, error, critical or off").default_value(std::string{"trace"});
+    program.add_argument("--log-file").help("Log file path, empty for console only (default XRT.log)").default_value(std::string{"XRT.log"});
+    program.add_argument("--log-sync").help("Write and flush every log message immediately").default_value(false).implicit_value(true);
+    program.add_argument("--server").help("Serve compile requests on a Unix socket, keeping parsed sources warm between requests").default_value(std::string{});
+    program.add_argument("--connect").help("Run this command line on the server listening on a Unix socket").default_value(std::string{});
+    program.add_argument("--server-stop").help("With --connect - stop the server").default_value(false).implicit_value(true);
+    program.add_argument("--lsp").help("Language server on stdin/stdout for editors").default_value(false).implicit_value(true);
+    program.add_argument("--watch").help("Rebuild when input files change, keeping unchanged sources and modules warm").default_value(false).implicit_value(true);
+    program.add_argument("--lsp-index").help("Symbol index file of --lsp (default <workspace>/.xrt/symbols.xsi)").default_value(std::string{});
+    program.add_argument("--exclude").help("Skip files and directories found by wildcards - .gitignore pattern syntax").append().default_value(std::vector<std::string>{});
+    program.add_argument("--exclude-from").help("Read --exclude patterns from a .gitignore style file").default_value(std::string{});
+    program.add_argument("--stats").help("Log wall time and heap use per compile phase, token and AST node counts and peak RSS").default_value(false).implicit_value(true);
+    program.add_argument("--stop-after").help("Last compile phase to run: lex, parse or elab (elaborate without optimization)").default_value(std::string{});
+    program.add_argument("--diagnostics-out").help("Write diagnostics to file as JSON, or as SARIF 2.1.0 if the file name ends in .sarif").default_value(std::string{});
+    program.add_argument("files").help("Files to process - wildcards * ? [...] **, @file reads one input per line").remaining();
+}
+
+/// Expand the input files of the command line - wildcards support * ? [...] and ** for any number of directories,
+/// @file reads inputs from a response file. directories receive the directories of every input and walked by wildcards.
+/// False if no files were given.
+bool CollectFiles(ArgumentParser& program, std::vector<fs::path>& files, std::vector<fs::path>& directories) {
+    std::vector<std::string> inputs;
+    try {
+        for (auto& input : program.get<std::vector<std::string>>("files")) {
+            input.erase(std::remove(input.begin(), input.end(), '"'), input.end());
+            if (!input.starts_with('@')) {
+                inputs.push_back(std::move(input));
+            } else if (!XRT::FileDiscovery::ReadResponseFile(input.substr(1), inputs)) {
+                LOG_ERROR("Failed to read response file \"{}\"", input.substr(1));
+                return false;
+            }
+        }
     } catch (std::logic_error&) {
         LOG_WARN("No files to process");
+        return false;
+    }
+
+    XRT::ExcludeList excludes;
+    for (auto& pattern : program.get<std::vector<std::string>>("--exclude")) {
+        if (!excludes.AddPattern(pattern)) {
+            LOG_ERROR("Invalid exclude pattern \"{}\"", pattern);
+            return false;
+        }
+    }
+    auto exclude_from = program.get<std::string>("--exclude-from");
+    if (!exclude_from.empty() && !excludes.LoadFile(exclude_from)) {
+        LOG_ERROR("Failed to read exclude file \"{}\"", exclude_from);
+        return false;
+    }
+
+    XRT::FileDiscovery discovery;
+    discovery.SetExcludes(&excludes);
+    for (auto& input : inputs) {
+        bool is_cfxs_hdl_source = ctre::match<L"\\.xdl", ctre::case_insensitive>(fs::path{input}.extension().c_str());
+        if (is_cfxs_hdl_source && !discovery.Add(input))
+            return false;
+    }
+
+    files.insert(files.end(), discovery.GetFiles().begin(), discovery.GetFiles().end());
+    directories.insert(directories.end(), discovery.GetDirectories().begin(), discovery.GetDirectories().end());
+    LOG_TRACE("Files:\n{}", files);
+    return true;
+}
+
+/// Compile and run everything requested on the command line - logger is already initialized.
+/// update - input set and changes of a watch mode rebuild, files are collected from the command line if null
+int Run(ArgumentParser& program, XRT::CompilationSession& session, const WatchUpdate* update) {
+    std::vector<fs::path> files_to_process;
+
+    ProfileReport profile_report{program.get<std::string>("--trace-out"), program.get<bool>("--profile")};
+#ifdef XRT_PROFILER
+    XRT::Profiler::SetTraceEnabled(!profile_report.trace_path.empty());
+#else
+    if (profile_report.summary || !profile_report.trace_path.empty()) {
+        LOG_WARN("--profile/--trace-out require a build with BUILD_TRACE_PROFILER");
+        profile_report.trace_path.clear();
+        profile_report.summary = false;
+    }
+#endif
+
+    bool stats = program.get<bool>("--stats");
+    if (stats)
+        XRT::MemoryStats::SetEnabled(true);
+
+    auto merge_coverage = program.get<std::string>("--merge-coverage");
+    if (!merge_coverage.empty()) {
+        auto inputs = program.present<std::vector<std::string>>("files").value_or(std::vector<std::string>{});
+        return MergeCoverage(merge_coverage, inputs) ? 0 : -1;
+    }
+
+    if (update) {
+        files_to_process = update->files;
+    } else {
+        std::vector<fs::path> directories;
+        if (!CollectFiles(program, files_to_process, directories))
+            return -1;
+    }
+
+    XRT::CompileRequest request;
+    request.files    = std::move(files_to_process);
+    if (update)
+        request.changed = update->changed;
+    request.optimize = !program.get<bool>("--no-optimize");
+    request.top      = StringUtils::utf8_to_utf16(program.get<std::string>("--top"));
+
+    auto stop_after = program.get<std::string>("--stop-after");
+    if (stop_after == "lex") {
+        request.stop_after = XRT::CompilePhase::LEX;
+    } else if (stop_after == "parse") {
+        request.stop_after = XRT::CompilePhase::PARSE;
+    } else if (stop_after == "elab") {
+        request.stop_after = XRT::CompilePhase::ELABORATE;
+    } else if (!stop_after.empty()) {
+        LOG_ERROR("Invalid phase \"{}\" - expected lex, parse or elab", stop_after);
         return -1;
     }
 
-    for (const auto& sourcePath : files_to_process) {
-        std::string source;
-        std::ifstream file;
-        file.open(sourcePath.string());
-        if (file.is_open()) {
-            std::stringstream ss;
-            ss << file.rdbuf();
-            source = ss.str();
-            file.close();
-        } else {
-            LOG_ERROR("Failed to open source file");
+    auto coverage = program.get<std::string>("--coverage");
+    if (!coverage.empty()) {
+#ifdef XRT_SIM_COVERAGE
+        request.coverage = true;
+#else
+        LOG_ERROR("--coverage requires a build with BUILD_SIM_COVERAGE");
+        return -1;
+#endif
+    }
+
+    for (auto& param : program.get<std::vector<std::string>>("--param")) {
+        auto eq = param.find('=');
+        if (eq == std::string::npos) {
+            LOG_ERROR("Invalid parameter \"{}\" - expected NAME=VALUE", param);
             return -1;
         }
+        auto value = param.substr(eq + 1);
+        try {
+            size_t end = 0;
+            auto v     = std::stoull(value, &end, 0);
+            if (end != value.size())
+                throw std::invalid_argument(value);
+            request.parameters[StringUtils::utf8_to_utf16(param.substr(0, eq))] = v;
+        } catch (const std::logic_error&) {
+            LOG_ERROR("Invalid parameter value \"{}\" in \"{}\"", value, param);
+            return -1;
+        }
+    }
 
-        Test(source, sourcePath);
+    bool compiled = session.Compile(request);
+    session.LogDiagnostics();
+    auto diagnostics_out = program.get<std::string>("--diagnostics-out");
+    if (!diagnostics_out.empty()) {
+        bool sarif  = ctre::match<L"\\.sarif", ctre::case_insensitive>(fs::path{diagnostics_out}.extension().c_str());
+        auto format = sarif ? XRT::DiagnosticRenderer::Format::SARIF : XRT::DiagnosticRenderer::Format::JSON;
+        if (!session.WriteDiagnostics(diagnostics_out, format))
+            return -1;
+    }
+    if (stats)
+        session.LogStatistics();
+    if (!compiled)
+        return -1;
+    if (request.stop_after != XRT::CompilePhase::ALL)
+        return 0;
+    auto& design = session.GetDesign();
+
+    try {
+        for (XRT::ModuleID m = 0; m < design.GetModuleCount(); m++) {
+            design.GetModule(m).Print();
+        }
+
+        auto vhdl_dir = program.get<std::string>("--emit-vhdl");
+        if (!vhdl_dir.empty()) {
+            XRT::VHDLBackend vhdl(design);
+            if (!vhdl.Emit(vhdl_dir))
+                return -1;
+        }
+
+        auto model_dir = program.get<std::string>("--emit-cpp-model");
+        if (!model_dir.empty()) {
+            if (design.GetTop() == XRT::INVALID_ID) {
+                LOG_ERROR("--emit-cpp-model requires --top");
+                return -1;
+            }
+            auto flat = FlattenTop(design, !program.get<bool>("--no-optimize"));
+            XRT::CppModelBackend model(*flat);
+            if (!model.Emit(model_dir))
+                return -1;
+        }
+
+        auto timing_paths = program.get<uint32_t>("--timing");
+        if (timing_paths) {
+            if (design.GetTop() == XRT::INVALID_ID) {
+                LOG_ERROR("--timing requires --top");
+                return -1;
+            }
+            if (!AnalyzeTiming(
+                    design, timing_paths, program.get<std::string>("--clock-period"), program.get<std::string>("--delay-model"), !program.get<bool>("--no-optimize")))
+                return -1;
+        }
+
+        WaveOptions wave{program.get<std::string>("--wave-out"), program.get<std::vector<std::string>>("--wave-select")};
+        if (wave.select.empty())
+            wave.select.push_back("**");
+
+        auto cycles = program.get<uint64_t>("--simulate");
+        if (cycles) {
+            if (design.GetTop() == XRT::INVALID_ID) {
+                LOG_ERROR("--simulate requires --top");
+                return -1;
+            }
+            if (!Simulate(design, cycles, program.get<uint32_t>("--sim-threads"), !program.get<bool>("--no-optimize"), wave, coverage))
+                return -1;
+        }
+
+        auto sim_until = program.get<std::string>("--sim-until");
+        if (!sim_until.empty()) {
+            if (design.GetTop() == XRT::INVALID_ID) {
+                LOG_ERROR("--sim-until requires --top");
+                return -1;
+            }
+            auto end = XRT::ParseTimeLiteral(sim_until);
+            if (!end) {
+                LOG_ERROR("Invalid time \"{}\"", sim_until);
+                return -1;
+            }
+            if (!SimulateEvents(design, *end, program.get<std::vector<std::string>>("--clock"), !program.get<bool>("--no-optimize"), wave))
+                return -1;
+        }
+    } catch (const XRT::CycleSimulator::SimulationError& e) {
+        LOG_ERROR("{}", e.what());
+        return -1;
+    } catch (const XRT::EventSimulator::SimulationError& e) {
+        LOG_ERROR("{}", e.what());
+        return -1;
+    } catch (const XRT::TimingAnalysis::TimingError& e) {
+        LOG_ERROR("{}", e.what());
+        return -1;
     }
 
     return 0;
 }
 
+/// Build once, then rebuild on every change of an input file or of a file matching an input wildcard.
+/// Only changed sources are reparsed and only components depending on them are elaborated again.
+int Watch(ArgumentParser& program, XRT::CompilationSession& session) {
+    static constexpr auto DEBOUNCE = std::chrono::milliseconds(50); // editors and checkouts write files in bursts
+
+    WatchUpdate update;
+    std::vector<fs::path> directories;
+    if (!CollectFiles(program, update.files, directories))
+        return -1;
+
+    XRT::FileWatcher watcher;
+    std::unordered_set<std::string> watched;
+    auto watch_directories = [&]() {
+        bool ok = true;
+        for (auto& dir : directories) {
+            auto key = dir.lexically_normal().generic_string();
+            if (!watched.contains(key)) {
+                if (watcher.Watch(dir))
+                    watched.insert(std::move(key));
+                else
+                    ok = false;
+            }
+        }
+        return ok;
+    };
+    if (!watch_directories())
+        return -1;
+
+    std::unordered_set<std::string> inputs;
+    auto set_inputs = [&]() {
+        inputs.clear();
+        for (auto& file : update.files)
+            inputs.insert(file.lexically_normal().generic_string());
+    };
+    set_inputs();
+
+    Run(program, session);
+    LOG_INFO("[Watch] Watching {} files in {} directories", update.files.size(), watched.size());
+
+    std::vector<XRT::FileWatcher::Change> changes;
+    while (watcher.Wait(changes, DEBOUNCE)) {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        // new, removed or renamed sources and directories can change the expansion of wildcards
+        bool rescan = false;
+        update.changed.clear();
+        for (auto& change : changes) {
+            if (change.directory) {
+                if (change.removed)
+                    watched.erase(change.path.lexically_normal().generic_string());
+                rescan = true;
+                continue;
+            }
+            if (!ctre::match<L"\\.xdl", ctre::case_insensitive>(change.path.extension().c_str()))
+                continue;
+            auto path = change.path.lexically_normal();
+            rescan |= change.removed || !inputs.contains(path.generic_string());
+            update.changed.push_back(std::move(path));
+        }
+        if (rescan) {
+            std::vector<fs::path> files;
+            std::vector<fs::path> new_directories;
+            if (CollectFiles(program, files, new_directories)) {
+                rescan = files != update.files;
+                update.files = std::move(files);
+                directories  = std::move(new_directories);
+                watch_directories(); // directories that vanished again are skipped until the next rescan
+                set_inputs();
+            } else {
+                LOG_ERROR("[Watch] Failed to collect input files - keeping the previous input set");
+                rescan = false;
+            }
+        }
+        if (update.changed.empty() && !rescan)
+            continue;
+
+        Run(program, session, &update);
+        if (rescan)
+            session.PruneSources();
+
+        auto time = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        LOG_INFO("[Watch] Rebuilt {} changed of {} files in {:.3f}ms", update.changed.size(), update.files.size(), time * 1000.0);
+    }
+    if (!watcher.IsStopped())
+        return -1;
+    LOG_INFO("[Watch] Stopped");
+    return 0;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void Test(const std::string& source, const std::filesystem::path& sourcePath) {
-    const auto source_entry = CreateRef<XRT::SourceEntry>(StringUtils::utf8_to_utf16(source), sourcePath);
-    auto lexer              = CreateScope<XRT::Lexer>(source_entry);
-
-    try {
-        lexer->ProcessSource();
-    } catch (const XRT::Lexer::UnknownTokenException& e) {
-        LOG_ERROR("[{}]:\n{}", e.what(), e.GetSource());
-    } catch (const std::exception& e) {
-        LOG_CRITICAL("{}", e.what());
+/// Flattened top component, optionally optimized
+Scope<XRT::Netlist> FlattenTop(const XRT::Design& design, bool optimize) {
+    auto flat = design.Flatten(design.GetTop());
+    if (optimize) {
+        XRT::PassManager passes;
+        passes.AddDefaultPasses();
+        passes.Run(*flat);
     }
+    return flat;
+}
 
-    auto parser = CreateScope<XRT::Parser>();
-    try {
-        parser->Parse(lexer);
-    } catch (const XRT::Parser::ParseException& e) {
-        LOG_ERROR("{}", e.what());
-        LOG_TRACE("At \"{}:{}:{}\"", source_entry->GetPath(), e.GetLine(), e.GetColumn());
-    } catch (const std::exception& e) {
-        LOG_CRITICAL("{}", e.what());
-    }
-
-    parser->PrintAST();
-
-    auto& tokens = parser->GetTokens();
-    // lex->PrintTokens();
-
-    return;
-
-    std::string out;
-    for (const auto& tok : tokens) {
-        auto content      = StringUtils::utf16_to_utf8(std::wstring(tok->value));
-        std::string color = ANSI_RESET;
-        switch (tok->type) {
-            case XRT::Lexer::TokenType::KEYWORD: color = ANSI_BLUE; break;
-            case XRT::Lexer::TokenType::IDENTIFIER: {
-                if (ctre::match<"bool|unsigned|true|false|unsigned|logic">(content)) {
-                    color = ANSI_MAGENTA;
-                } else if (ctre::match<"std|range_of|EventSource|CFXS|pow|is_integral|clockable|Event">(content)) {
-                    color = "\u001b[33m";
-                } else if (ctre::match<"CascadeClockDivider">(content)) {
-                    color = ANSI_GREEN;
-                } else {
-                    color = ANSI_RESET;
-                }
+/// Create a recorder for all named nets of a flat netlist matching the selection globs.
+/// net_signals maps nets to recorder signal indices (INVALID_ID if not dumped).
+Scope<XRT::WaveformRecorder> OpenWaveform(const XRT::Netlist& flat,
+                                          const WaveOptions& wave,
+                                          const std::function<uint64_t(XRT::NetID)>& initial,
+                                          std::vector<uint32_t>& net_signals) {
+    Scope<XRT::WaveformSink> sink;
+    if (fs::path{wave.path}.extension() == ".vcd")
+        sink = CreateScope<XRT::VCDWriter>();
+    else
+        sink = CreateScope<XRT::BinaryWaveWriter>();
+    auto recorder = CreateScope<XRT::WaveformRecorder>(std::move(sink));
+
+    net_signals.assign(flat.GetNetCount(), XRT::INVALID_ID);
+    std::string name;
+    for (XRT::NetID net = 0; net < flat.GetNetCount(); net++) {
+        if (flat.GetNetName(net).empty())
+            continue;
+        name = fmt::format("{}.{}", flat.GetName(), flat.GetNetName(net));
+        for (auto& pattern : wave.select) {
+            if (XRT::WaveformRecorder::MatchGlob(pattern, name)) {
+                net_signals[net] = recorder->AddSignal(name, flat.GetNetWidth(net), initial(net));
                 break;
             }
+        }
+    }
+
+    if (!recorder->Start(wave.path)) {
+        LOG_ERROR("Failed to open waveform file \"{}\"", wave.path);
+        return nullptr;
+    }
+    LOG_TRACE("[Waveform] Dumping {} signals to \"{}\"", recorder->GetSignals().size(), wave.path);
+    return recorder;
+}
+
+bool CloseWaveform(XRT::WaveformRecorder& recorder, XRT::SimTime end_time) {
+    auto start = std::chrono::high_resolution_clock::now();
+    if (!recorder.Stop(end_time)) {
+        LOG_ERROR("Failed to write waveform file");
+        return false;
+    }
+    auto time = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    LOG_INFO("Waveform: {} changes, {} producer stalls, {:.3f}ms final flush", recorder.GetRecordCount(), recorder.GetStallCount(), time * 1000.0);
+    return true;
+}
+
+/// Estimate register to register timing of the flattened top component
+bool AnalyzeTiming(const XRT::Design& design, uint32_t paths, const std::string& period, const std::string& delay_model, bool optimize) {
+    auto clock_period = XRT::ParseTimeLiteral(period);
+    if (!clock_period || !*clock_period) {
+        LOG_ERROR("Invalid clock period \"{}\"", period);
+        return false;
+    }
+
+    XRT::DelayModel model;
+    if (!delay_model.empty() && !model.Load(delay_model))
+        return false;
+
+    auto flat = FlattenTop(design, optimize);
+    XRT::TimingAnalysis timing(*flat, model);
+    timing.SetClockPeriod(static_cast<XRT::Delay>(*clock_period));
+    timing.Run();
+    timing.Report(paths);
+    return true;
+}
+
+/// Run the flattened top component with independent random stimulus in every lane
+bool Simulate(const XRT::Design& design, uint64_t cycles, uint32_t threads, bool optimize, const WaveOptions& wave, [[maybe_unused]] const std::string& coverage) {
+    XRT_PROFILE_SCOPE("Simulate");
+    auto flat = FlattenTop(design, optimize);
+
+    XRT::CycleSimulator sim(*flat);
+    sim.SetThreadCount(threads);
+#ifdef XRT_SIM_COVERAGE
+    if (!coverage.empty())
+        sim.EnableCoverage();
+#endif
+    auto clock = flat->FindPort("clock");
+
+    // lane 0 is dumped - one clock step is half of a 10ns period
+    static constexpr XRT::SimTime WAVE_STEP_TIME = 5000;
+    std::vector<uint32_t> net_signals;
+    std::vector<std::pair<XRT::NetID, uint64_t>> dumped; // net, last value
+    Scope<XRT::WaveformRecorder> recorder;
+    if (!wave.path.empty()) {
+        recorder = OpenWaveform(
+            *flat, wave, [&](XRT::NetID net) { return sim.GetValue(net, 0); }, net_signals);
+        if (!recorder)
+            return false;
+        for (XRT::NetID net = 0; net < flat->GetNetCount(); net++) {
+            if (net_signals[net] != XRT::INVALID_ID)
+                dumped.emplace_back(net, sim.GetValue(net, 0));
+        }
+    }
+    auto record = [&]() {
+        auto time = sim.GetStepCount() * WAVE_STEP_TIME;
+        for (auto& [net, last] : dumped) {
+            auto value = sim.GetValue(net, 0);
+            if (value != last) {
+                recorder->Change(time, net_signals[net], value);
+                last = value;
+            }
+        }
+    };
 
-            case XRT::Lexer::TokenType::STRING_LITERAL: color = ANSI_CYAN; break;
-            case XRT::Lexer::TokenType::LITERAL: color = ANSI_CYAN; break;
-            case XRT::Lexer::TokenType::PUNCTUATOR: color = ANSI_GRAY; break;
-            case XRT::Lexer::TokenType::COMMENT: color = ANSI_DARK_GREEN; break;
-            case XRT::Lexer::TokenType::SPACE: break;
-            case XRT::Lexer::TokenType::UNKNOWN: color = ANSI_RED; break;
-            default: {
-                if (static_cast<int>(tok->type) > static_cast<int>(XRT::Lexer::TokenType::__SPECIFIED__)) {
-                    color = ANSI_YELLOW;
-                }
+    static constexpr uint64_t MAX_TRACED_CYCLES = 256; // per cycle output log for short runs only
+    uint64_t seed[XRT::CycleSimulator::LANE_COUNT];
+    for (uint32_t lane = 0; lane < XRT::CycleSimulator::LANE_COUNT; lane++)
+        seed[lane] = 0x9E3779B97F4A7C15ull * (lane + 1);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint64_t cycle = 0; cycle < cycles; cycle++) {
+        for (XRT::PortID p = 0; p < flat->GetPortCount(); p++) {
+            if (p == clock || flat->GetPortDirection(p) != XRT::PortDirection::IN)
+                continue;
+            for (uint32_t lane = 0; lane < XRT::CycleSimulator::LANE_COUNT; lane++) {
+                // xorshift64
+                seed[lane] ^= seed[lane] << 13;
+                seed[lane] ^= seed[lane] >> 7;
+                seed[lane] ^= seed[lane] << 17;
+                sim.SetInput(p, lane, seed[lane]);
             }
         }
+        if (recorder) {
+            sim.Step();
+            record();
+            sim.Step();
+            record();
+        } else {
+            sim.Cycle();
+        }
+        if (cycles > MAX_TRACED_CYCLES)
+            continue;
 
-        out += color + content + ANSI_RESET;
+        std::string outputs;
+        for (XRT::PortID p = 0; p < flat->GetPortCount(); p++) {
+            if (flat->GetPortDirection(p) != XRT::PortDirection::IN)
+                outputs += fmt::format(" {}={}", flat->GetPortName(p), sim.GetOutput(p, 0));
+        }
+        LOG_INFO("[Simulate] cycle {}:{}", cycle, outputs);
     }
-    // LOG_TRACE("\n{}", out);
-}
\ No newline at end of file
+    auto time = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+    LOG_INFO("Simulated {} cycles x {} lanes on {} threads in {:.3f}ms ({:.0f} lane-cycles/s)",
+             cycles,
+             XRT::CycleSimulator::LANE_COUNT,
+             sim.GetThreadCount(),
+             time * 1000.0,
+             static_cast<double>(cycles * XRT::CycleSimulator::LANE_COUNT) / time);
+    if (recorder && !CloseWaveform(*recorder, sim.GetStepCount() * WAVE_STEP_TIME))
+        return false;
+
+#ifdef XRT_SIM_COVERAGE
+    if (sim.IsCoverageEnabled()) {
+        XRT::CoverageDatabase database;
+        sim.CollectCoverage(database);
+        database.LogSummary();
+        if (!database.Write(coverage))
+            return false;
+    }
+#endif
+    return true;
+}
+
+/// Combine coverage files of several runs
+bool MergeCoverage(const std::string& output, const std::vector<std::string>& inputs) {
+    if (inputs.empty()) {
+        LOG_ERROR("--merge-coverage requires input files");
+        return false;
+    }
+    XRT::CoverageDatabase database;
+    for (auto& input : inputs) {
+        if (!database.Read(input))
+            return false;
+    }
+    database.LogSummary();
+    return database.Write(output);
+}
+
+/// Event driven run of the flattened top component - clocks from PORT=PERIOD, other inputs get random changes
+bool SimulateEvents(const XRT::Design& design, XRT::SimTime end, const std::vector<std::string>& clocks, bool optimize, const WaveOptions& wave) {
+    XRT_PROFILE_SCOPE("SimulateEvents");
+    auto flat = FlattenTop(design, optimize);
+
+    XRT::EventSimulator sim(*flat);
+    std::vector<XRT::PortID> clock_ports;
+    XRT::SimTime min_period = 10000;
+    for (auto& clock : clocks.empty() ? std::vector<std::string>{"clock=10ns"} : clocks) {
+        auto eq     = clock.find('=');
+        auto port   = flat->FindPort(clock.substr(0, eq));
+        auto period = eq == std::string::npos ? std::nullopt : XRT::ParseTimeLiteral(std::string_view{clock}.substr(eq + 1));
+        if (port == XRT::INVALID_ID || !period) {
+            if (clocks.empty())
+                continue; // no default clock port
+            LOG_ERROR("Invalid clock \"{}\" - expected PORT=PERIOD", clock);
+            return false;
+        }
+        sim.AddClock(port, *period);
+        clock_ports.push_back(port);
+        min_period = std::min(min_period, *period);
+    }
+
+    // random input changes, on average every 3 periods of the fastest clock
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+    auto random   = [&]() {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        return seed;
+    };
+    for (XRT::PortID p = 0; p < flat->GetPortCount(); p++) {
+        if (flat->GetPortDirection(p) != XRT::PortDirection::IN || std::find(clock_ports.begin(), clock_ports.end(), p) != clock_ports.end())
+            continue;
+        for (XRT::SimTime t = random() % (min_period * 3); t <= end; t += 1 + random() % (min_period * 6))
+            sim.SetInput(p, random(), t);
+    }
+
+    std::vector<uint32_t> net_signals;
+    Scope<XRT::WaveformRecorder> recorder;
+    if (!wave.path.empty()) {
+        recorder = OpenWaveform(
+            *flat, wave, [&](XRT::NetID net) { return sim.GetValue(net); }, net_signals);
+        if (!recorder)
+            return false;
+        sim.SetChangeCallback([&](XRT::SimTime time, XRT::NetID net, uint64_t value) {
+            if (net_signals[net] != XRT::INVALID_ID)
+                recorder->Change(time, net_signals[net], value);
+        });
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    sim.RunUntil(end);
+    auto time = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+    std::string outputs;
+    for (XRT::PortID p = 0; p < flat->GetPortCount(); p++) {
+        if (flat->GetPortDirection(p) != XRT::PortDirection::IN)
+            outputs += fmt::format(" {}={}", flat->GetPortName(p), sim.GetOutput(p));
+    }
+    LOG_INFO("Simulated {}ps in {:.3f}ms - {} events, {} delta cycles ({:.0f} events/s), outputs:{}",
+             sim.GetTime(),
+             time * 1000.0,
+             sim.GetEventCount(),
+             sim.GetDeltaCount(),
+             static_cast<double>(sim.GetEventCount()) / time,
+             outputs);
+    if (recorder && !CloseWaveform(*recorder, end))
+        return false;
+    return true;
+}